@@ -9,6 +9,12 @@
 #if !defined(FHOS_H)
 #  define FHOS_H
 
+// NOTE(Patrik): On Linux the implementation uses a few GNU extensions (getdents64, O_DIRECTORY, ...).
+// Include this header before any system header in the file that defines FHOS_IMPLEMENTATION.
+#  if defined(FHOS_IMPLEMENTATION) && defined(__linux__) && !defined(_GNU_SOURCE)
+#    define _GNU_SOURCE
+#  endif
+
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //
@@ -39,12 +45,118 @@
 #  define FHOS_STACK_PATH_CAPACITY 512
 #endif
 
+// NOTE(Patrik): Size of the buffer used to fetch directory entries in bulk.
+// Larger buffers means fewer system calls for big directories.
+#if !defined(FHOS_DIRECTORY_BUFFER_CAPACITY)
+#  define FHOS_DIRECTORY_BUFFER_CAPACITY (64 * 1024)
+#endif
+
+// NOTE(Patrik): How many directories fhos_walk_directory keeps open at once across all threads.
+// Directories found past this limit are reopened by path instead of relative to their parent.
+#if !defined(FHOS_WALK_MAX_OPEN_HANDLES)
+#  define FHOS_WALK_MAX_OPEN_HANDLES 256
+#endif
+
+// NOTE(Patrik): How many directory levels fhos_remove_directory_recursively keeps open at once.
+#if !defined(FHOS_REMOVE_DIRECTORY_MAX_OPEN_HANDLES)
+#  define FHOS_REMOVE_DIRECTORY_MAX_OPEN_HANDLES 64
+#endif
+
+// NOTE(Patrik): Size of the buffer the kernel writes change events into, per watcher on Linux
+// and per watched directory on Windows.
+#if !defined(FHOS_WATCHER_BUFFER_CAPACITY)
+#  define FHOS_WATCHER_BUFFER_CAPACITY (64 * 1024)
+#endif
+
+// NOTE(Patrik): Batches of at least this many paths are stat'ed by several threads at once
+// in fhos_refresh_file_metadata, smaller batches are done on the calling thread.
+#if !defined(FHOS_METADATA_PARALLEL_BATCH_SIZE)
+#  define FHOS_METADATA_PARALLEL_BATCH_SIZE 1024
+#endif
+
+// NOTE(Patrik): Where the data of each file in a pack starts. Page alignment lets a file be mapped on its own.
+#if !defined(FHOS_PACK_DEFAULT_ALIGNMENT)
+#  define FHOS_PACK_DEFAULT_ALIGNMENT 4096
+#endif
+
+// NOTE(Patrik): How much uncompressed data goes into each independently decodable block of a compressed file.
+// Smaller blocks decompress on more threads at once, larger blocks compress a little better.
+#if !defined(FHOS_COMPRESSION_BLOCK_SIZE)
+#  define FHOS_COMPRESSION_BLOCK_SIZE (256 * 1024)
+#endif
+
+// NOTE(Patrik): Direct reads bypass the page cache, so their offsets, sizes and buffers have to be aligned
+// to the sector size of the device. 4096 covers every common device.
+#if !defined(FHOS_DIRECT_IO_ALIGNMENT)
+#  define FHOS_DIRECT_IO_ALIGNMENT 4096
+#endif
+
+#if !defined(FHOS_DIRECT_IO_DEFAULT_BLOCK_SIZE)
+#  define FHOS_DIRECT_IO_DEFAULT_BLOCK_SIZE (1024 * 1024)
+#endif
+
+#if !defined(FHOS_DIRECT_IO_DEFAULT_QUEUE_DEPTH)
+#  define FHOS_DIRECT_IO_DEFAULT_QUEUE_DEPTH 4
+#endif
+
+// NOTE(Patrik): The smallest step a mapped writer grows its file by. Remapping is not free, so steps are
+// large and double with the size of the file.
+#if !defined(FHOS_MAPPED_WRITER_GROW_SIZE)
+#  define FHOS_MAPPED_WRITER_GROW_SIZE (64 * 1024 * 1024)
+#endif
+
+// NOTE(Patrik): With FHOS_ASYNC_LOG defined errors are queued on a ring per thread and printed by a
+// background thread, so logging from a hot loop costs little more than copying the arguments.
+// When a ring is full new messages are dropped and counted, or with FHOS_ASYNC_LOG_BLOCK_WHEN_FULL
+// the caller waits for room.
+#if !defined(FHOS_ASYNC_LOG_RING_CAPACITY)
+#  define FHOS_ASYNC_LOG_RING_CAPACITY (64 * 1024)
+#endif
+
+#if !defined(FHOS_ASYNC_LOG_FLUSH_MILLISECONDS)
+#  define FHOS_ASYNC_LOG_FLUSH_MILLISECONDS 10
+#endif
+
+// NOTE(Patrik): fhos_sleep_until spins for at least this long before a deadline instead of sleeping, on
+// top of how late sleeps have been coming back. Timer slack is set for threads that sleep with it.
+#if !defined(FHOS_SLEEP_SPIN_NANOSECONDS)
+#  define FHOS_SLEEP_SPIN_NANOSECONDS 50000
+#endif
+
+#if !defined(FHOS_SLEEP_TIMER_SLACK_NANOSECONDS)
+#  define FHOS_SLEEP_TIMER_SLACK_NANOSECONDS 1000
+#endif
+
+// NOTE(Patrik): Threads spread their histogram records over this many shards, each about 30 KB. With
+// more recording threads than shards some of them share.
+#if !defined(FHOS_HISTOGRAM_SHARD_COUNT)
+#  define FHOS_HISTOGRAM_SHARD_COUNT 16
+#endif
+
+// NOTE(Patrik): How many rounds a contended FHOS_Spin_Lock spins before its thread goes to sleep on it.
+#if !defined(FHOS_SPIN_LOCK_SPIN_COUNT)
+#  define FHOS_SPIN_LOCK_SPIN_COUNT 128
+#endif
+
+// NOTE(Patrik): How many finished zones each thread keeps until fhos_write_profile collects them, must be a
+// power of two. Zones that end while the buffer is full are dropped and counted.
+#if !defined(FHOS_PROFILE_EVENT_CAPACITY)
+#  define FHOS_PROFILE_EVENT_CAPACITY (64 * 1024)
+#endif
+
 #if !defined(FHOS_LOG_ERROR)
 #  if defined(FUTHARK_LOG)
-#    define FHOS_LOG_ERROR(format, ...) FUTHARK_LOG(ERROR, format, __VA_ARGS__)
+#    define FHOS_LOG_ERROR(format, ...) FUTHARK_LOG(ERROR, format, ##__VA_ARGS__)
+#  elif defined(FHOS_ASYNC_LOG)
+#    if defined(__GNUC__)
+FHOS_API void fhos_log_async(const char *file, int line, const char *format, ...) __attribute__((format(printf, 3, 4)));
+#    else
+FHOS_API void fhos_log_async(const char *file, int line, const char *format, ...);
+#    endif
+#    define FHOS_LOG_ERROR(format, ...) fhos_log_async(__FILE__, __LINE__, format, ##__VA_ARGS__)
 #  else
 #    include <stdio.h>
-#    define FHOS_LOG_ERROR(format, ...) printf(__FILE__ "(%d): [ERROR] " format, __LINE__, __VA_ARGS__)
+#    define FHOS_LOG_ERROR(format, ...) printf(__FILE__ "(%d): [ERROR] " format, __LINE__, ##__VA_ARGS__)
 #  endif
 #endif
 
@@ -81,7 +193,7 @@ path = (char *)(path_data);\
 } else if(path_length >= FHOS_STACK_PATH_CAPACITY) {\
 path = (char *)fhos_context_temp_alloc_non_zero((ctx), (path_length) + 1);\
 }\
-if(path) {\
+if(path && (path_length) >= 0) {\
 for(fhos_i32 i = 0; i < (path_length); i += 1) { path[i] = (path_data)[i]; }\
 path[(path_length)] = 0;\
 }\
@@ -111,10 +223,14 @@ from_path = base_path;\
 to_path = base_path + from_path_length + 1;\
 } else {\
 from_path = stack_path;\
-to_path = base_path + from_path_length + 1;\
+to_path = stack_path + from_path_length + 1;\
 }\
+if(from_path) {\
 for(fhos_i32 i = 0; i < (from_path_length); i += 1) { from_path[i] = (from_path_data)[i]; }\
 for(fhos_i32 i = 0; i < (to_path_length); i += 1) { to_path[i] = (to_path_data)[i]; }\
+from_path[(from_path_length)] = 0;\
+to_path[(to_path_length)] = 0;\
+}\
 }\
 } while(0)
 
@@ -144,6 +260,7 @@ enum {
 
 #if !defined(FHOS_NO_STDINT)
 #  include <stdint.h>
+#  include <stddef.h>
 typedef ptrdiff_t fhos_isize; // NOTE(Patrik): Only used internally
 typedef uint8_t   fhos_u8;
 typedef uint16_t  fhos_u16;
@@ -240,6 +357,528 @@ typedef struct FHOS_Date_And_Time {
 #  define FHOS_Date_And_Time(...) fhos_get_date_and_time(__VA_ARGS__)
 #endif
 
+typedef fhos_u8 FHOS_Directory_Entry_Type;
+enum {
+    FHOS_DIRECTORY_ENTRY_TYPE_UNKNOWN   = 0,
+    FHOS_DIRECTORY_ENTRY_TYPE_FILE      = 1,
+    FHOS_DIRECTORY_ENTRY_TYPE_DIRECTORY = 2,
+    FHOS_DIRECTORY_ENTRY_TYPE_SYMLINK   = 3,
+    FHOS_DIRECTORY_ENTRY_TYPE_OTHER     = 4,
+};
+
+typedef fhos_u32 FHOS_Directory_Flags;
+enum {
+    // NOTE(Patrik): Sizes are free on Windows, but cost one stat per file on Linux.
+    // Without this flag the size of an entry may be negative (unknown).
+    FHOS_DIRECTORY_FLAG_FETCH_SIZE          = (1 << 0),
+    FHOS_DIRECTORY_FLAG_SKIP_FILES          = (1 << 1),
+    FHOS_DIRECTORY_FLAG_SKIP_DIRECTORY      = (1 << 2),
+    FHOS_DIRECTORY_FLAG_SKIP_HIDDEN         = (1 << 3),
+    FHOS_DIRECTORY_FLAG_FETCH_MODIFIED_TIME = (1 << 4),
+};
+
+typedef struct FHOS_Directory_Entry {
+    // NOTE(Patrik): Null terminated. When returned from fhos_next_directory_entry the name
+    // is only valid until the next call.
+    char *name;
+    fhos_i32 name_length;
+    FHOS_Directory_Entry_Type type;
+    fhos_i64 size;
+    // NOTE(Patrik): Nanoseconds since the unix epoch, negative if unknown.
+    fhos_i64 modified_time;
+} FHOS_Directory_Entry;
+
+typedef struct FHOS_Directory_Iterator {
+    FHOS_File_Handle handle;
+    FHOS_Directory_Flags flags;
+    
+    fhos_u8 *buffer;
+    fhos_i32 buffer_offset;
+    fhos_i32 buffer_count;
+    fhos_bool is_done;
+} FHOS_Directory_Iterator;
+
+typedef struct FHOS_Directory_Listing {
+    FHOS_Directory_Entry *entries;
+    FHOS_FIELD_ALIAS(fhos_i64, count, length);
+    
+    // NOTE(Patrik): All entry names are stored in this single block.
+    char *names;
+    fhos_i64 names_length;
+} FHOS_Directory_Listing;
+
+typedef struct FHOS_Walk_Entry {
+    // NOTE(Patrik): The path starts with the root path given to fhos_walk_directory
+    // and the name points into the path. Both are null terminated.
+    char *path;
+    char *name;
+    fhos_i32 path_length;
+    fhos_i32 name_length;
+    fhos_i32 depth;
+    FHOS_Directory_Entry_Type type;
+    fhos_i64 size;
+    fhos_i64 modified_time;
+} FHOS_Walk_Entry;
+
+// NOTE(Patrik): Called from the walking threads, possibly many at once.
+// Returning false for a directory skips everything below it, the return value is ignored for files.
+#define FHOS_WALK_PROC(name) fhos_bool name(void *user_data, fhos_i32 thread_index, FHOS_Walk_Entry *entry)
+typedef fhos_bool FHOS_Walk_Proc(void *user_data, fhos_i32 thread_index, FHOS_Walk_Entry *entry);
+
+// NOTE(Patrik): Gets each chunk of a file in order, offset is where the chunk starts in the file.
+// The data is only valid during the call. Return false to stop reading.
+typedef fhos_bool FHOS_Read_Chunk_Proc(void *user_data, const fhos_u8 *data, fhos_i64 size, fhos_i64 offset);
+
+typedef struct FHOS_Walk_Options {
+    // NOTE(Patrik): Zero or less uses one thread per processor.
+    fhos_i32 thread_count;
+    // NOTE(Patrik): Zero or less has no limit. The entries of the root have depth zero.
+    fhos_i32 max_depth;
+    FHOS_Directory_Flags flags;
+    
+    FHOS_Walk_Proc *proc;
+    void *user_data;
+    
+    // NOTE(Patrik): Store every reported entry in one list per thread.
+    fhos_bool collect_entries;
+    
+    // NOTE(Patrik): Only report files with one of these extensions, compared without case.
+    // Given without the dot, e.g. "png".
+    const char **extensions;
+    fhos_i32 extension_count;
+    
+    // NOTE(Patrik): Only report files modified after this time (nanoseconds since the unix epoch).
+    fhos_i64 modified_after;
+} FHOS_Walk_Options;
+
+typedef struct FHOS_Walk_List {
+    FHOS_Walk_Entry *entries;
+    FHOS_FIELD_ALIAS(fhos_i64, count, length);
+    fhos_i64 capacity;
+    
+    char *paths;
+    fhos_i64 paths_length;
+    fhos_i64 paths_capacity;
+} FHOS_Walk_List;
+
+typedef struct FHOS_Walk_Result {
+    // NOTE(Patrik): One list per thread when collect_entries was set.
+    FHOS_Walk_List *lists;
+    fhos_i32 list_count;
+    
+    fhos_i64 file_count;
+    fhos_i64 directory_count;
+    fhos_i64 error_count;
+} FHOS_Walk_Result;
+
+typedef fhos_u8 FHOS_File_Change_Type;
+enum {
+    FHOS_FILE_CHANGE_TYPE_CREATED  = 1,
+    FHOS_FILE_CHANGE_TYPE_MODIFIED = 2,
+    FHOS_FILE_CHANGE_TYPE_DELETED  = 3,
+    // NOTE(Patrik): The kernel dropped events, everything below the path may have changed.
+    FHOS_FILE_CHANGE_TYPE_OVERFLOW = 4,
+};
+
+typedef struct FHOS_File_Change {
+    char *path;
+    fhos_i32 path_length;
+    FHOS_File_Change_Type type;
+    // NOTE(Patrik): On Windows a removed entry can not be looked at anymore, so it is always a directory.
+    fhos_bool is_directory;
+} FHOS_File_Change;
+
+typedef struct FHOS_File_Changes {
+    FHOS_File_Change *changes;
+    FHOS_FIELD_ALIAS(fhos_i64, count, length);
+    fhos_i64 capacity;
+    
+    char *paths;
+    fhos_i64 paths_length;
+    fhos_i64 paths_capacity;
+} FHOS_File_Changes;
+
+typedef struct FHOS_Watch {
+    // NOTE(Patrik): The inotify watch descriptor on Linux.
+    fhos_i64 id;
+    fhos_i64 path_offset;
+    fhos_i32 path_length;
+    fhos_bool is_recursive;
+    // NOTE(Patrik): Directory handle, overlapped state and event buffer on Windows.
+    void *platform;
+} FHOS_Watch;
+
+// NOTE(Patrik): Zero initialize before the first fhos_watch_directory.
+typedef struct FHOS_Watcher {
+    FHOS_File_Handle handle;
+    fhos_u8 *buffer;
+    fhos_bool is_initialized;
+    
+    // NOTE(Patrik): Sorted by id, inotify hands them out in increasing order.
+    FHOS_Watch *watches;
+    fhos_i64 watch_count;
+    fhos_i64 watch_capacity;
+    
+    char *paths;
+    fhos_i64 paths_length;
+    fhos_i64 paths_capacity;
+} FHOS_Watcher;
+
+typedef struct FHOS_File_Metadata {
+    fhos_bool exists;
+    // NOTE(Patrik): FHOS_DIRECTORY_ENTRY_TYPE_UNKNOWN when the path does not exist. Symbolic links are followed.
+    FHOS_Directory_Entry_Type type;
+    fhos_i64 size;
+    // NOTE(Patrik): Nanoseconds since the unix epoch.
+    fhos_i64 modified_time;
+} FHOS_File_Metadata;
+
+typedef struct FHOS_File_Metadata_Slot {
+    // NOTE(Patrik): Zero marks an empty slot.
+    fhos_u64 hash;
+    fhos_i64 path_offset;
+    fhos_i32 path_length;
+    fhos_bool is_valid;
+    fhos_u32 generation;
+    FHOS_File_Metadata metadata;
+} FHOS_File_Metadata_Slot;
+
+// NOTE(Patrik): Zero initialize before the first use. Not thread safe.
+typedef struct FHOS_File_Metadata_Cache {
+    // NOTE(Patrik): Open addressing, slot_capacity is zero or a power of two.
+    FHOS_File_Metadata_Slot *slots;
+    fhos_i64 slot_count;
+    fhos_i64 slot_capacity;
+    
+    // NOTE(Patrik): Normalized copies of the cached paths, forward slashes and no trailing slash.
+    char *paths;
+    fhos_i64 paths_length;
+    fhos_i64 paths_capacity;
+    
+    // NOTE(Patrik): Slots from an older generation are stale, bumping it invalidates everything at once.
+    fhos_u32 generation;
+    
+    fhos_i64 hit_count;
+    fhos_i64 miss_count;
+} FHOS_File_Metadata_Cache;
+
+typedef struct FHOS_Hash128 {
+    fhos_u64 low;
+    fhos_u64 high;
+} FHOS_Hash128;
+
+// NOTE(Patrik): Initialize with fhos_begin_hash. The data is hashed in blocks of 1024 bytes,
+// whatever does not fill a block is kept in the buffer until the next update.
+typedef struct FHOS_Hash_State {
+    fhos_u64 accumulators[8];
+    fhos_u8 buffer[1024];
+    fhos_i64 buffer_length;
+    fhos_u64 total_length;
+} FHOS_Hash_State;
+
+#define FHOS_PACK_MAGIC 0x4B504846 // NOTE(Patrik): "FHPK"
+#define FHOS_PACK_VERSION 1
+
+// NOTE(Patrik): The layout on disk, little endian. The header is followed by the file data,
+// each file aligned to header.alignment, then the table of contents and the names.
+typedef struct FHOS_Pack_Header {
+    fhos_u32 magic;
+    fhos_u32 version;
+    fhos_u64 entry_count;
+    fhos_u64 alignment;
+    fhos_u64 toc_offset;
+    fhos_u64 names_offset;
+    fhos_u64 names_size;
+} FHOS_Pack_Header;
+
+// NOTE(Patrik): The table of contents is sorted by hash, entries with the same hash are sorted by name.
+typedef struct FHOS_Pack_Entry {
+    fhos_u64 hash;
+    fhos_u64 offset;
+    fhos_u64 size;
+    // NOTE(Patrik): Relative to names_offset, the names use forward slashes and are null terminated.
+    fhos_u32 name_offset;
+    fhos_u32 name_length;
+} FHOS_Pack_Entry;
+
+// NOTE(Patrik): Zero initialize before fhos_begin_pack.
+typedef struct FHOS_Pack_Builder {
+    FHOS_File_Handle handle;
+    fhos_u64 alignment;
+    fhos_u64 offset;
+    fhos_bool has_failed;
+    
+    FHOS_Pack_Entry *entries;
+    FHOS_FIELD_ALIAS(fhos_i64, count, length);
+    fhos_i64 capacity;
+    
+    char *names;
+    fhos_i64 names_length;
+    fhos_i64 names_capacity;
+} FHOS_Pack_Builder;
+
+typedef struct FHOS_Pack {
+    // NOTE(Patrik): The file mapping handle on Windows, unused on Linux.
+    void *mapping;
+    const fhos_u8 *data;
+    fhos_i64 size;
+    
+    const FHOS_Pack_Entry *entries;
+    FHOS_FIELD_ALIAS(fhos_i64, count, length);
+    const char *names;
+    
+    // NOTE(Patrik): Files under this directory are used instead of the packed ones when they exist.
+    char *loose_root;
+    fhos_i32 loose_root_length;
+} FHOS_Pack;
+
+#define FHOS_COMPRESSED_MAGIC 0x315A4846 // NOTE(Patrik): "FHZ1"
+
+// NOTE(Patrik): The layout on disk, little endian. The header is followed by one fhos_u32 per block with
+// the compressed size of the block, the top bit set if the block is stored as is, then the blocks.
+// Every block but the last holds block_size bytes of uncompressed data.
+typedef struct FHOS_Compressed_Header {
+    fhos_u32 magic;
+    fhos_u32 block_size;
+    fhos_u64 content_size;
+    fhos_u64 block_count;
+} FHOS_Compressed_Header;
+
+// NOTE(Patrik): One buffer of a vectored read or write.
+typedef struct FHOS_IO_Vector {
+    fhos_u8 *data;
+    fhos_i64 size;
+} FHOS_IO_Vector;
+
+typedef enum FHOS_Access_Hint {
+    FHOS_ACCESS_HINT_NORMAL     = 0,
+    FHOS_ACCESS_HINT_SEQUENTIAL = 1,
+    FHOS_ACCESS_HINT_RANDOM     = 2,
+    // NOTE(Patrik): The range will be needed soon, start reading it in now.
+    FHOS_ACCESS_HINT_WILLNEED   = 3,
+    // NOTE(Patrik): The range will not be needed again, it can leave the page cache.
+    FHOS_ACCESS_HINT_DONTNEED   = 4,
+} FHOS_Access_Hint;
+
+// NOTE(Patrik): Reads a file front to back in blocks, keeping queue_depth reads in flight at once.
+// One block is handed out at a time while the others are being read into the remaining buffers.
+typedef struct FHOS_Direct_Reader {
+    FHOS_File_Handle handle;
+    fhos_i64 file_size;
+    fhos_i64 block_size;
+    fhos_i32 queue_depth;
+    // NOTE(Patrik): False when the file system does not support direct IO. The reads then go through
+    // the page cache, but each block is dropped from it once the next one is requested.
+    fhos_bool is_direct;
+    
+    fhos_u8 *buffers;
+    void *slots;
+    // NOTE(Patrik): The Linux AIO context, zero when the reads are done synchronously.
+    fhos_u64 queue;
+    
+    fhos_i64 submit_offset;
+    fhos_i64 read_offset;
+    fhos_i32 read_slot;
+    fhos_i32 held_slot;
+} FHOS_Direct_Reader;
+
+// NOTE(Patrik): Writes a file through a read-write mapping. The file is grown ahead of the writes and cut
+// back to size bytes when the writer is closed. Growing can move data, so pointers into it only
+// last until the next push.
+typedef struct FHOS_Mapped_Writer {
+    FHOS_File_Handle handle;
+    // NOTE(Patrik): The file mapping object on Windows, unused on Linux.
+    void *mapping;
+    fhos_u8 *data;
+    fhos_i64 size;
+    fhos_i64 capacity;
+} FHOS_Mapped_Writer;
+
+typedef enum FHOS_Shared_Ring_Mode {
+    FHOS_SHARED_RING_MODE_SPSC = 0,
+    FHOS_SHARED_RING_MODE_MPSC = 1,
+} FHOS_Shared_Ring_Mode;
+
+typedef struct FHOS_Shared_Ring {
+    void *header;
+    fhos_u8 *data;
+    fhos_i64 capacity;
+    fhos_i64 map_size;
+    fhos_i32 mode;
+    fhos_bool is_owner;
+    
+    char *name;
+    fhos_i32 name_length;
+    
+    // NOTE(Patrik): The file mapping and the wakeup semaphores on Windows, unused on Linux.
+    void *mapping;
+    void *data_semaphore;
+    void *space_semaphore;
+} FHOS_Shared_Ring;
+
+typedef struct FHOS_Frame_Pacer {
+    fhos_u64 frame_ticks;
+    fhos_u64 next_deadline;
+    
+    fhos_u64 frame_count;
+    // NOTE(Patrik): Frames whose work ran past the deadline, these did not wait and have no overshoot.
+    fhos_u64 missed_count;
+    fhos_u64 last_overshoot_nanoseconds;
+    fhos_u64 max_overshoot_nanoseconds;
+    fhos_u64 total_overshoot_nanoseconds;
+} FHOS_Frame_Pacer;
+
+typedef enum FHOS_Perf_Counter {
+    FHOS_PERF_COUNTER_CYCLES = 0,
+    FHOS_PERF_COUNTER_INSTRUCTIONS = 1,
+    FHOS_PERF_COUNTER_CACHE_MISSES = 2,
+    FHOS_PERF_COUNTER_BRANCH_MISSES = 3,
+    FHOS_PERF_COUNTER_COUNT = 4,
+} FHOS_Perf_Counter;
+
+// NOTE(Patrik): The counters of one thread. Bit i of available_mask is set when FHOS_Perf_Counter i could be
+// opened, with none of them set only the time is measured.
+typedef struct FHOS_Perf_Counters {
+    fhos_i32 descriptors[FHOS_PERF_COUNTER_COUNT];
+    fhos_i32 leader;
+    fhos_u32 available_mask;
+    fhos_bool is_running;
+    fhos_u64 start_ticks;
+    fhos_u64 stop_ticks;
+} FHOS_Perf_Counters;
+
+typedef struct FHOS_Perf_Sample {
+    fhos_u64 values[FHOS_PERF_COUNTER_COUNT];
+    fhos_u32 valid_mask;
+    fhos_u64 nanoseconds;
+} FHOS_Perf_Sample;
+
+// NOTE(Patrik): A log-linear histogram of fhos_u64 values, usually tick deltas. It takes fixed memory and
+// every value is kept to within 1/64th of itself.
+typedef struct FHOS_Histogram {
+    void *shards;
+} FHOS_Histogram;
+
+typedef struct FHOS_Histogram_Stats {
+    fhos_u64 count;
+    fhos_u64 min;
+    fhos_u64 max;
+    fhos_u64 p50;
+    fhos_u64 p90;
+    fhos_u64 p99;
+    fhos_u64 p999;
+    double mean;
+} FHOS_Histogram_Stats;
+
+// NOTE(Patrik): The values match the GCC and Clang builtin orderings.
+typedef enum FHOS_Memory_Order {
+    FHOS_MEMORY_ORDER_RELAXED = 0,
+    FHOS_MEMORY_ORDER_ACQUIRE = 2,
+    FHOS_MEMORY_ORDER_RELEASE = 3,
+    FHOS_MEMORY_ORDER_ACQ_REL = 4,
+    FHOS_MEMORY_ORDER_SEQ_CST = 5,
+} FHOS_Memory_Order;
+
+typedef struct FHOS_Atomic_I32 {
+    fhos_i32 value;
+} FHOS_Atomic_I32;
+
+typedef struct FHOS_Atomic_I64 {
+    fhos_i64 value;
+} FHOS_Atomic_I64;
+
+typedef struct FHOS_Atomic_Pointer {
+    void *value;
+} FHOS_Atomic_Pointer;
+
+// NOTE(Patrik): Counts the jobs of a group that have not finished yet. Zero it before the first job. Once
+// fhos_wait_for_jobs returns no worker touches it anymore, so it can live on the waiter's stack.
+typedef struct FHOS_Job_Counter {
+    FHOS_Atomic_I64 pending_count;
+} FHOS_Job_Counter;
+
+// NOTE(Patrik): ctx is the context of the thread the job runs on: a worker's own, the one passed to
+// fhos_wait_for_jobs by a thread that helps out, or the submitter's when fhos_run_job runs it right away.
+typedef void FHOS_Job_Proc(FHOS_Context *ctx, void *data);
+typedef void FHOS_Parallel_For_Proc(FHOS_Context *ctx, void *data, fhos_i64 start, fhos_i64 end);
+
+// NOTE(Patrik): The locks, the semaphore and the event below are one or two words that start out zeroed
+// and need no cleanup. They sleep on futexes, so they only work between threads of one process.
+typedef struct FHOS_Mutex {
+    FHOS_Atomic_I32 state;
+} FHOS_Mutex;
+
+typedef struct FHOS_Spin_Lock {
+    FHOS_Atomic_I32 state;
+} FHOS_Spin_Lock;
+
+typedef struct FHOS_Semaphore {
+    FHOS_Atomic_I32 count;
+    FHOS_Atomic_I32 waiter_count;
+} FHOS_Semaphore;
+
+typedef struct FHOS_Event {
+    FHOS_Atomic_I32 state;
+    FHOS_Atomic_I32 waiter_count;
+} FHOS_Event;
+
+
+typedef fhos_u32 FHOS_Task_Graph_Flags;
+enum {
+    // NOTE(Patrik): Of the ready tasks the ones with the most costly chain of tasks waiting on them go first.
+    // Without it ready tasks go in the order they became ready.
+    FHOS_TASK_GRAPH_FLAG_CRITICAL_PATH = (1 << 0),
+};
+
+typedef struct FHOS_Task {
+    const char *name;
+    FHOS_Job_Proc *proc;
+    void *data;
+    // NOTE(Patrik): Only compared against the cost of other tasks, any unit works.
+    fhos_i64 cost;
+    
+    // NOTE(Patrik): Set by fhos_run_task_graph. worker_index is -1 for the calling thread.
+    fhos_i64 priority;
+    fhos_u64 start_ticks;
+    fhos_u64 end_ticks;
+    fhos_i32 worker_index;
+} FHOS_Task;
+
+// NOTE(Patrik): Zero it before the first task is added. Edges are kept as pairs of the task that goes first
+// and the task that waits on it.
+typedef struct FHOS_Task_Graph {
+    FHOS_Task *tasks;
+    fhos_i32 task_count;
+    fhos_i64 task_capacity;
+    
+    fhos_i32 *edges;
+    fhos_i64 edge_count;
+    fhos_i64 edge_capacity;
+} FHOS_Task_Graph;
+
+typedef enum FHOS_Profile_Format {
+    FHOS_PROFILE_FORMAT_CHROME_JSON = 0,
+    FHOS_PROFILE_FORMAT_BINARY = 1,
+} FHOS_Profile_Format;
+
+// NOTE(Patrik): The binary profile is this header, event_count events, a fhos_u32 name count and then the
+// names, each one null terminated. Times are in ticks, start is relative to base_ticks.
+typedef struct FHOS_Profile_Binary_Header {
+    fhos_u32 magic;
+    fhos_u32 version;
+    fhos_u64 tick_frequency;
+    fhos_u64 base_ticks;
+    fhos_u64 event_count;
+    fhos_u64 dropped_count;
+} FHOS_Profile_Binary_Header;
+
+typedef struct FHOS_Profile_Binary_Event {
+    fhos_u32 name_index;
+    fhos_u32 thread_id;
+    fhos_u64 start;
+    fhos_u64 duration;
+} FHOS_Profile_Binary_Event;
+
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //
@@ -251,6 +890,12 @@ FHOS_API void *fhos_reallocate_memory(void *old_data, fhos_i64 size_in_bytes);
 FHOS_API void *fhos_reallocate_memory_non_zero(void *old_data, fhos_i64 size_in_bytes);
 FHOS_API void  fhos_free_memory(void *data);
 
+// NOTE(Patrik): alignment has to be a power of two. On Windows the memory comes straight from VirtualAlloc,
+// so alignments up to 64 KB are free and larger ones are not supported.
+FHOS_API void *fhos_allocate_aligned_memory(fhos_i64 size_in_bytes, fhos_i64 alignment);
+FHOS_API void *fhos_allocate_aligned_memory_non_zero(fhos_i64 size_in_bytes, fhos_i64 alignment);
+FHOS_API void  fhos_free_aligned_memory(void *data);
+
 // NOTE(Patrik): This procedure is not intened for speed or memory compactness.
 // If you just want something quick and dirty, this works perfectly fine.
 // But it is intended to replace it with your own procedure.
@@ -299,19 +944,58 @@ FHOS_API fhos_bool fhos_is_file_handle_valid(FHOS_File_Handle handle);
 FHOS_API fhos_bool fhos_close_file(FHOS_File_Handle handle);
 
 FHOS_API FHOS_File_Handle fhos_open_file_for_reading(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length);
+FHOS_API FHOS_File_Handle fhos_open_file_for_reading_with_hint(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, FHOS_Access_Hint hint);
 FHOS_API FHOS_File_Handle fhos_open_file_for_writing(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length);
+// NOTE(Patrik): Reserves expected_size bytes on disk up front, see fhos_preallocate_file.
+FHOS_API FHOS_File_Handle fhos_open_file_for_writing_with_size_hint(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, fhos_i64 expected_size);
 
 // NOTE(Patrik): A negative return value indicates an error.
 FHOS_API fhos_i64 fhos_get_size_of_file(FHOS_File_Handle handle);
 
+// NOTE(Patrik): Hints are advisory, platforms without an equivalent ignore them and still return true.
+// A length of zero means to the end of the file.
+FHOS_API fhos_bool fhos_advise_file(FHOS_File_Handle handle, fhos_i64 offset, fhos_i64 length, FHOS_Access_Hint hint);
+// NOTE(Patrik): The same hints for a mapped view of a file.
+FHOS_API fhos_bool fhos_advise_memory(const void *data, fhos_i64 length, FHOS_Access_Hint hint);
+
+// NOTE(Patrik): Reserves disk space for the first size bytes so the file can grow into one contiguous
+// allocation. The size of the file does not change, writes extend it as usual.
+// Returns false when the file system cannot preallocate, the file is still usable.
+FHOS_API fhos_bool fhos_preallocate_file(FHOS_File_Handle handle, fhos_i64 size);
+
 // NOTE(Patrik): A negative return value indicates an error.
 // Otherwise the return value is how many bytes were read/written.
 FHOS_API fhos_i64 fhos_read_file(FHOS_Context *ctx, FHOS_File_Handle handle, fhos_u8 *data, fhos_i64 read_amount);
 FHOS_API fhos_i64 fhos_write_file(FHOS_File_Handle handle, const fhos_u8 *data, fhos_i64 write_amount);
 
+// NOTE(Patrik): Reads the rest of the file chunk_size bytes at a time, so any size of file is read in bounded memory.
+// Zero or less for chunk_size uses 1 MB. Returns the number of bytes read, negative on error.
+FHOS_API fhos_i64 fhos_read_file_chunks(FHOS_Context *ctx, FHOS_File_Handle handle, fhos_i64 chunk_size, FHOS_Read_Chunk_Proc *proc, void *user_data);
+
+// NOTE(Patrik): Reads into or writes out of the buffers in order, as if they were one contiguous buffer.
+// The read stops early at the end of the file. Both return the total number of bytes moved, negative on error.
+FHOS_API fhos_i64 fhos_read_file_vectored(FHOS_Context *ctx, FHOS_File_Handle handle, const FHOS_IO_Vector *buffers, fhos_i32 buffer_count);
+FHOS_API fhos_i64 fhos_write_file_vectored(FHOS_File_Handle handle, const FHOS_IO_Vector *buffers, fhos_i32 buffer_count);
+
 FHOS_API FHOS_List fhos_read_entire_file(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, fhos_bool use_temp_allocator);
 FHOS_API fhos_bool fhos_write_entire_file(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, const fhos_u8 *data, fhos_i64 write_amount);
 
+// NOTE(Patrik): Streams a file without going through the page cache. Zero or less for block_size and queue_depth
+// uses the defaults, block_size is rounded up to FHOS_DIRECT_IO_ALIGNMENT and queue_depth is at least two.
+FHOS_API fhos_error fhos_open_direct_reader(FHOS_Context *ctx, FHOS_Direct_Reader *reader, const char *path_data, fhos_i32 path_length, fhos_i64 block_size, fhos_i32 queue_depth);
+// NOTE(Patrik): Points data at the next block and returns its size, zero at the end of the file and a negative value on error.
+// The block stays valid until the next call.
+FHOS_API fhos_i64 fhos_read_next_direct_block(FHOS_Direct_Reader *reader, const fhos_u8 **data);
+FHOS_API void fhos_close_direct_reader(FHOS_Context *ctx, FHOS_Direct_Reader *reader);
+
+// NOTE(Patrik): initial_capacity is only a starting point, zero or less uses FHOS_MAPPED_WRITER_GROW_SIZE.
+FHOS_API fhos_error fhos_open_mapped_writer(FHOS_Context *ctx, FHOS_Mapped_Writer *writer, const char *path_data, fhos_i32 path_length, fhos_i64 initial_capacity);
+// NOTE(Patrik): Makes room for size more bytes and returns where they start, null if the file could not grow.
+FHOS_API fhos_u8 *fhos_push_mapped_writer(FHOS_Mapped_Writer *writer, fhos_i64 size);
+FHOS_API fhos_bool fhos_write_mapped_writer(FHOS_Mapped_Writer *writer, const fhos_u8 *data, fhos_i64 size);
+// NOTE(Patrik): Returns false if the final size could not be set, the file then ends in unwritten zeros.
+FHOS_API fhos_bool fhos_close_mapped_writer(FHOS_Mapped_Writer *writer);
+
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //
@@ -334,6 +1018,168 @@ FHOS_API fhos_error fhos_create_directory_if_new(FHOS_Context *ctx, const char *
 // NOTE(Patrik): If no error, the return value should be treated as a bool.
 FHOS_API fhos_error fhos_remove_directory_recursively(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length);
 
+// NOTE(Patrik): Same as above, but the subtrees are removed by thread_count threads at once.
+// Zero or less uses one thread per processor.
+FHOS_API fhos_error fhos_remove_directory_recursively_parallel(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, fhos_i32 thread_count);
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// DIRECTORY
+//
+FHOS_API fhos_error fhos_open_directory(FHOS_Context *ctx, FHOS_Directory_Iterator *iterator, const char *path_data, fhos_i32 path_length, FHOS_Directory_Flags flags);
+FHOS_API void fhos_close_directory(FHOS_Context *ctx, FHOS_Directory_Iterator *iterator);
+
+// NOTE(Patrik): Returns true if an entry was written, false when there are no more entries,
+// and a negative value on error. The "." and ".." entries are never returned.
+FHOS_API fhos_error fhos_next_directory_entry(FHOS_Directory_Iterator *iterator, FHOS_Directory_Entry *entry);
+
+// NOTE(Patrik): Reads the whole directory into two allocations, one for the entries and one for the names.
+// Free it with fhos_free_directory_listing and the same use_temp_allocator.
+FHOS_API FHOS_Directory_Listing fhos_list_directory(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, FHOS_Directory_Flags flags, fhos_bool use_temp_allocator);
+FHOS_API void fhos_free_directory_listing(FHOS_Context *ctx, FHOS_Directory_Listing *listing, fhos_bool use_temp_allocator);
+
+// NOTE(Patrik): Walks the whole tree below path with walkers on the job system that steal directories from each other.
+// The walking threads allocate from the process heap (fhos_allocate_memory) since the context
+// allocators are not thread safe, free the result with fhos_free_walk_result.
+FHOS_API FHOS_Walk_Result fhos_walk_directory(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, FHOS_Walk_Options *options);
+FHOS_API void fhos_free_walk_result(FHOS_Walk_Result *result);
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// WATCHER
+//
+// NOTE(Patrik): Adds a directory to the watcher. A recursive watch also follows directories created later.
+FHOS_API fhos_error fhos_watch_directory(FHOS_Context *ctx, FHOS_Watcher *watcher, const char *path_data, fhos_i32 path_length, fhos_bool recursive);
+
+// NOTE(Patrik): Never blocks. Replaces the content of changes with everything that happened since the last poll
+// and returns how many changes there were. When nothing changed this is a single system call.
+FHOS_API fhos_i64 fhos_poll_changes(FHOS_Context *ctx, FHOS_Watcher *watcher, FHOS_File_Changes *changes);
+
+FHOS_API void fhos_close_watcher(FHOS_Context *ctx, FHOS_Watcher *watcher);
+FHOS_API void fhos_free_file_changes(FHOS_Context *ctx, FHOS_File_Changes *changes);
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// METADATA CACHE
+//
+// NOTE(Patrik): Returns true if the path exists, false if not, and a negative value on error.
+// With a cache the metadata is only fetched from the file system the first time a path is seen
+// or after it was invalidated. The cache may be null, then nothing is cached.
+FHOS_API fhos_error fhos_get_file_metadata(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache, const char *path_data, fhos_i32 path_length, FHOS_File_Metadata *metadata);
+
+// NOTE(Patrik): Cached versions of fhos_file_exists, fhos_directory_exists and fhos_is_file_newer.
+FHOS_API fhos_bool  fhos_cached_file_exists(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache, const char *path_data, fhos_i32 path_length);
+FHOS_API fhos_bool  fhos_cached_directory_exists(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache, const char *path_data, fhos_i32 path_length);
+FHOS_API fhos_error fhos_cached_is_file_newer(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache, const char *this_path_data, fhos_i32 this_path_length, const char *other_path_data, fhos_i32 other_path_length);
+
+// NOTE(Patrik): Fetches the metadata of many paths at once and stores it in the cache, whether the paths were cached or not.
+// path_lengths may be null when all paths are null terminated. Returns how many of the paths exist.
+FHOS_API fhos_i64 fhos_refresh_file_metadata(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache, const char **paths, const fhos_i32 *path_lengths, fhos_i64 path_count);
+// NOTE(Patrik): Fetches the metadata of every path in the cache again.
+FHOS_API fhos_i64 fhos_refresh_file_metadata_cache(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache);
+
+FHOS_API void fhos_invalidate_file_metadata(FHOS_File_Metadata_Cache *cache, const char *path_data, fhos_i32 path_length);
+FHOS_API void fhos_invalidate_all_file_metadata(FHOS_File_Metadata_Cache *cache);
+
+// NOTE(Patrik): Invalidates everything the changes from fhos_poll_changes may have touched,
+// including the parent directories and anything below a created or deleted directory.
+FHOS_API void fhos_apply_file_changes(FHOS_File_Metadata_Cache *cache, FHOS_File_Changes *changes);
+
+FHOS_API void fhos_free_file_metadata_cache(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache);
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// HASH
+//
+// NOTE(Patrik): A fast 128 bit hash for telling if content changed, not for security.
+// The result is the same on every platform and for every kernel, and does not depend
+// on how the data was split up between calls to fhos_update_hash.
+FHOS_API void fhos_begin_hash(FHOS_Hash_State *state);
+FHOS_API void fhos_update_hash(FHOS_Hash_State *state, const void *data, fhos_i64 size_in_bytes);
+FHOS_API FHOS_Hash128 fhos_end_hash(FHOS_Hash_State *state);
+
+FHOS_API FHOS_Hash128 fhos_hash_memory(const void *data, fhos_i64 size_in_bytes);
+FHOS_API fhos_bool fhos_hashes_are_equal(FHOS_Hash128 a, FHOS_Hash128 b);
+
+// NOTE(Patrik): Maps the file if possible and reads it in large chunks otherwise.
+FHOS_API fhos_error fhos_hash_file(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, FHOS_Hash128 *hash);
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// PACK
+//
+// NOTE(Patrik): Names are relative paths like "textures/stone.png", back slashes count as forward slashes.
+// An alignment of zero or less uses FHOS_PACK_DEFAULT_ALIGNMENT, otherwise it has to be a power of two.
+FHOS_API fhos_error fhos_begin_pack(FHOS_Context *ctx, FHOS_Pack_Builder *builder, const char *path_data, fhos_i32 path_length, fhos_i64 alignment);
+FHOS_API fhos_error fhos_add_data_to_pack(FHOS_Context *ctx, FHOS_Pack_Builder *builder, const char *name_data, fhos_i32 name_length, const fhos_u8 *data, fhos_i64 size_in_bytes);
+FHOS_API fhos_error fhos_add_file_to_pack(FHOS_Context *ctx, FHOS_Pack_Builder *builder, const char *name_data, fhos_i32 name_length, const char *path_data, fhos_i32 path_length);
+// NOTE(Patrik): Writes the table of contents and closes the pack. Also cleans up after a failed build.
+FHOS_API fhos_error fhos_end_pack(FHOS_Context *ctx, FHOS_Pack_Builder *builder);
+
+// NOTE(Patrik): Packs every file below directory_path, named by their path relative to it.
+// Returns how many files were packed, or the error of the first file that could not be added.
+FHOS_API fhos_i64 fhos_build_pack_from_directory(FHOS_Context *ctx, const char *pack_path_data, fhos_i32 pack_path_length, const char *directory_path_data, fhos_i32 directory_path_length, fhos_i64 alignment);
+
+// NOTE(Patrik): Maps the whole pack. loose_root may be null, otherwise files found under it win over the packed ones.
+// Mounting succeeds without a pack file as long as there is a loose root.
+FHOS_API fhos_error fhos_mount_pack(FHOS_Context *ctx, FHOS_Pack *pack, const char *path_data, fhos_i32 path_length, const char *loose_root_data, fhos_i32 loose_root_length);
+FHOS_API void fhos_unmount_pack(FHOS_Context *ctx, FHOS_Pack *pack);
+
+// NOTE(Patrik): Only looks in the pack itself, returns null if the name is not there.
+FHOS_API const FHOS_Pack_Entry *fhos_find_pack_entry(FHOS_Pack *pack, const char *name_data, fhos_i32 name_length);
+
+// NOTE(Patrik): Packed files point straight into the mapping and have a negative capacity, they stay valid until unmounted.
+// Loose files are read with fhos_read_entire_file. Either way free it with fhos_free_pack_file.
+FHOS_API FHOS_List fhos_read_pack_file(FHOS_Context *ctx, FHOS_Pack *pack, const char *name_data, fhos_i32 name_length, fhos_bool use_temp_allocator);
+FHOS_API void fhos_free_pack_file(FHOS_Context *ctx, FHOS_List *file, fhos_bool use_temp_allocator);
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// COMPRESSION
+//
+// NOTE(Patrik): The blocks use the LZ4 block format, fast to compress and much faster to decompress.
+// The largest a block of size_in_bytes can get when compressed.
+FHOS_API fhos_i64 fhos_get_compress_bound(fhos_i64 size_in_bytes);
+
+// NOTE(Patrik): Returns the compressed size, or zero if it does not fit in output_capacity.
+FHOS_API fhos_i64 fhos_compress_block(const fhos_u8 *data, fhos_i64 size_in_bytes, fhos_u8 *output, fhos_i64 output_capacity);
+// NOTE(Patrik): Returns the decompressed size, or a negative value if the data is corrupt or does not fit.
+// Never reads or writes out of bounds, whatever the input.
+FHOS_API fhos_i64 fhos_decompress_block(const fhos_u8 *data, fhos_i64 size_in_bytes, fhos_u8 *output, fhos_i64 output_capacity);
+
+// NOTE(Patrik): Same as fhos_read_entire_file and fhos_write_entire_file, but the file is compressed
+// in blocks of FHOS_COMPRESSION_BLOCK_SIZE. The blocks are compressed and decompressed on one thread per processor.
+FHOS_API FHOS_List fhos_read_entire_file_compressed(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, fhos_bool use_temp_allocator);
+FHOS_API fhos_bool fhos_write_entire_file_compressed(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, const fhos_u8 *data, fhos_i64 write_amount);
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// SHARED RING
+//
+// NOTE(Patrik): A ring of messages in named shared memory, for streaming data between processes.
+// One process creates it, any number open it by name. There is one reader, and either one writer
+// (SPSC) or any number of writers (MPSC). Waiting sleeps on a futex in the ring itself on Linux
+// and on named semaphores on Windows, a side that is keeping up never makes a system call.
+//
+// NOTE(Patrik): A negative timeout waits forever, zero never waits. Creating a ring whose name is still in
+// use returns FHOS_ERROR_ALREADY_EXISTS, the capacity is at most 2 GB.
+FHOS_API fhos_error fhos_create_shared_ring(FHOS_Context *ctx, FHOS_Shared_Ring *ring, const char *name_data, fhos_i32 name_length, fhos_i64 capacity, FHOS_Shared_Ring_Mode mode);
+FHOS_API fhos_error fhos_open_shared_ring(FHOS_Context *ctx, FHOS_Shared_Ring *ring, const char *name_data, fhos_i32 name_length);
+// NOTE(Patrik): Messages are copied in whole, or not at all if the timeout runs out first.
+FHOS_API fhos_error fhos_write_shared_ring(FHOS_Shared_Ring *ring, const void *data, fhos_i64 size, fhos_i64 timeout_milliseconds);
+// NOTE(Patrik): Returns the size of the message. If it does not fit in the buffer, FHOS_ERROR_BUFFER_TOO_SMALL
+// is returned and the message stays in the ring.
+FHOS_API fhos_i64 fhos_read_shared_ring(FHOS_Shared_Ring *ring, void *buffer, fhos_i64 buffer_capacity, fhos_i64 timeout_milliseconds);
+// NOTE(Patrik): Closing the ring in the process that created it removes the name.
+FHOS_API void fhos_close_shared_ring(FHOS_Context *ctx, FHOS_Shared_Ring *ring);
+
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //
@@ -342,6 +1188,175 @@ FHOS_API fhos_error fhos_remove_directory_recursively(FHOS_Context *ctx, const c
 FHOS_API FHOS_Date_And_Time fhos_get_date_and_time(void);
 FHOS_API fhos_u64 fhos_get_unix_timestamp(void);
 
+// NOTE(Patrik): The same in UTC, but read from the clock the scheduler updates on every tick, so only as
+// fine as a few milliseconds and much cheaper. Meant for stamping log lines and events.
+FHOS_API FHOS_Date_And_Time fhos_get_coarse_date_and_time(void);
+FHOS_API fhos_u64 fhos_get_coarse_unix_timestamp(void);
+
+// NOTE(Patrik): A monotonic clock for timing things inside a frame. Ticks only mean something relative to
+// each other, fhos_get_tick_frequency is how many there are per second.
+// Define FHOS_NO_TSC to always use the OS clock instead of the CPU timestamp counter.
+FHOS_API fhos_u64 fhos_get_ticks(void);
+FHOS_API fhos_u64 fhos_get_tick_frequency(void);
+FHOS_API fhos_u64 fhos_ticks_to_nanoseconds(fhos_u64 ticks);
+FHOS_API fhos_u64 fhos_nanoseconds_to_ticks(fhos_u64 nanoseconds);
+
+// NOTE(Patrik): Sleeps while the deadline is far off and spins through the last stretch, so it returns
+// within a few microseconds of the deadline.
+FHOS_API void fhos_sleep_until(fhos_u64 deadline_ticks);
+// NOTE(Patrik): Call fhos_wait_for_next_frame once per frame, it waits for the end of the frame and returns
+// the ticks it woke up at. The pacer keeps the overshoot statistics.
+FHOS_API void fhos_init_frame_pacer(FHOS_Frame_Pacer *pacer, fhos_u64 frame_nanoseconds);
+FHOS_API fhos_u64 fhos_wait_for_next_frame(FHOS_Frame_Pacer *pacer);
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// LOG
+//
+// NOTE(Patrik): Prints everything the log thread has not gotten to yet, see FHOS_ASYNC_LOG. Does nothing
+// when errors are printed right away.
+FHOS_API void fhos_flush_log(void);
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// PROFILE
+//
+// NOTE(Patrik): Zones nest per thread and every FHOS_PROFILE_BEGIN needs its FHOS_PROFILE_END on the same
+// thread. Only the name pointer is kept, so names have to outlive the next fhos_write_profile,
+// string literals are the usual choice. Define FHOS_NO_PROFILE to compile the zones out.
+#if defined(FHOS_NO_PROFILE)
+#  define FHOS_PROFILE_BEGIN(name)
+#  define FHOS_PROFILE_END()
+#else
+#  define FHOS_PROFILE_BEGIN(name) fhos_begin_profile_zone(name)
+#  define FHOS_PROFILE_END() fhos_end_profile_zone()
+#endif
+
+FHOS_API void fhos_begin_profile_zone(const char *name);
+FHOS_API void fhos_end_profile_zone(void);
+// NOTE(Patrik): Writes the zones that ended since the last call and frees their room in the buffers.
+FHOS_API fhos_error fhos_write_profile(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, FHOS_Profile_Format format);
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// PERF COUNTERS
+//
+// NOTE(Patrik): Counts cycles, instructions, cache misses and branch misses of the calling thread in user
+// mode between start and stop, using perf events on Linux. Where the hardware counters can not be
+// opened, and always on Windows, the sample only has the elapsed time and valid_mask is zero.
+// Counters must be started, stopped and read on the thread that opened them.
+FHOS_API fhos_error fhos_open_perf_counters(FHOS_Perf_Counters *counters);
+FHOS_API void fhos_close_perf_counters(FHOS_Perf_Counters *counters);
+FHOS_API void fhos_start_perf_counters(FHOS_Perf_Counters *counters);
+FHOS_API void fhos_stop_perf_counters(FHOS_Perf_Counters *counters);
+FHOS_API fhos_bool fhos_read_perf_counters(FHOS_Perf_Counters *counters, FHOS_Perf_Sample *sample);
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// HISTOGRAM
+//
+// NOTE(Patrik): Any number of threads may record at once. Reading merges the shards and sees the values
+// recorded so far, the percentiles are the largest value of the bucket they fall in.
+FHOS_API fhos_error fhos_init_histogram(FHOS_Context *ctx, FHOS_Histogram *histogram);
+FHOS_API void fhos_free_histogram(FHOS_Context *ctx, FHOS_Histogram *histogram);
+FHOS_API void fhos_reset_histogram(FHOS_Histogram *histogram);
+FHOS_API void fhos_record_histogram(FHOS_Histogram *histogram, fhos_u64 value);
+FHOS_API fhos_bool fhos_get_histogram_stats(FHOS_Histogram *histogram, FHOS_Histogram_Stats *stats);
+// NOTE(Patrik): Writes the stats and the percentile curve as text.
+FHOS_API fhos_error fhos_write_histogram(FHOS_Context *ctx, FHOS_Histogram *histogram, const char *path_data, fhos_i32 path_length);
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// SYNC
+//
+// NOTE(Patrik): Exchange and fetch add return the value from before. A failed compare exchange writes the
+// value it found to expected. Loads take relaxed, acquire or seq_cst and stores relaxed, release or
+// seq_cst, any other order is treated as seq_cst.
+FHOS_API fhos_i32   fhos_atomic_load_i32(FHOS_Atomic_I32 *atomic, FHOS_Memory_Order order);
+FHOS_API void       fhos_atomic_store_i32(FHOS_Atomic_I32 *atomic, fhos_i32 value, FHOS_Memory_Order order);
+FHOS_API fhos_i32   fhos_atomic_exchange_i32(FHOS_Atomic_I32 *atomic, fhos_i32 value, FHOS_Memory_Order order);
+FHOS_API fhos_i32   fhos_atomic_fetch_add_i32(FHOS_Atomic_I32 *atomic, fhos_i32 value, FHOS_Memory_Order order);
+FHOS_API fhos_bool  fhos_atomic_compare_exchange_i32(FHOS_Atomic_I32 *atomic, fhos_i32 *expected, fhos_i32 desired, FHOS_Memory_Order order);
+
+FHOS_API fhos_i64   fhos_atomic_load_i64(FHOS_Atomic_I64 *atomic, FHOS_Memory_Order order);
+FHOS_API void       fhos_atomic_store_i64(FHOS_Atomic_I64 *atomic, fhos_i64 value, FHOS_Memory_Order order);
+FHOS_API fhos_i64   fhos_atomic_exchange_i64(FHOS_Atomic_I64 *atomic, fhos_i64 value, FHOS_Memory_Order order);
+FHOS_API fhos_i64   fhos_atomic_fetch_add_i64(FHOS_Atomic_I64 *atomic, fhos_i64 value, FHOS_Memory_Order order);
+FHOS_API fhos_bool  fhos_atomic_compare_exchange_i64(FHOS_Atomic_I64 *atomic, fhos_i64 *expected, fhos_i64 desired, FHOS_Memory_Order order);
+
+FHOS_API void      *fhos_atomic_load_pointer(FHOS_Atomic_Pointer *atomic, FHOS_Memory_Order order);
+FHOS_API void       fhos_atomic_store_pointer(FHOS_Atomic_Pointer *atomic, void *value, FHOS_Memory_Order order);
+FHOS_API void      *fhos_atomic_exchange_pointer(FHOS_Atomic_Pointer *atomic, void *value, FHOS_Memory_Order order);
+FHOS_API fhos_bool  fhos_atomic_compare_exchange_pointer(FHOS_Atomic_Pointer *atomic, void **expected, void *desired, FHOS_Memory_Order order);
+
+FHOS_API void       fhos_atomic_fence(FHOS_Memory_Order order);
+
+// NOTE(Patrik): The mutex sleeps as soon as it finds the lock taken, the spin lock spins for a while first,
+// which suits locks that are only held for a moment. Neither makes a system call while uncontended.
+FHOS_API void       fhos_lock_mutex(FHOS_Mutex *mutex);
+FHOS_API fhos_bool  fhos_try_lock_mutex(FHOS_Mutex *mutex);
+FHOS_API void       fhos_unlock_mutex(FHOS_Mutex *mutex);
+
+FHOS_API void       fhos_lock_spin_lock(FHOS_Spin_Lock *lock);
+FHOS_API fhos_bool  fhos_try_lock_spin_lock(FHOS_Spin_Lock *lock);
+FHOS_API void       fhos_unlock_spin_lock(FHOS_Spin_Lock *lock);
+
+// NOTE(Patrik): Waits return FHOS_ERROR_TIMED_OUT when the timeout passes first. A negative timeout waits
+// forever and zero only checks.
+FHOS_API fhos_error fhos_wait_semaphore(FHOS_Semaphore *semaphore, fhos_i64 timeout_milliseconds);
+FHOS_API fhos_bool  fhos_try_wait_semaphore(FHOS_Semaphore *semaphore);
+FHOS_API void       fhos_post_semaphore(FHOS_Semaphore *semaphore, fhos_u32 count);
+
+// NOTE(Patrik): An auto-reset event, each set lets one wait through.
+FHOS_API void       fhos_set_event(FHOS_Event *event);
+FHOS_API void       fhos_reset_event(FHOS_Event *event);
+FHOS_API fhos_error fhos_wait_event(FHOS_Event *event, fhos_i64 timeout_milliseconds);
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// JOBS
+//
+// NOTE(Patrik): One scheduler is shared by the whole library, the parallel directory functions and metadata
+// refreshes run on it too. It starts with the first job, fhos_start_job_system only has to be called
+// to pick the number of workers or give them their own contexts. worker_contexts is either null, which
+// gives every worker the default allocators, or holds worker_count contexts, one per worker, so each
+// can have its own temp allocator. worker_count has to be given in that case.
+FHOS_API fhos_bool fhos_start_job_system(const FHOS_Context *worker_contexts, fhos_i32 worker_count);
+FHOS_API void fhos_stop_job_system(void);
+// NOTE(Patrik): The worker the calling thread is, or -1 when it is not one.
+FHOS_API fhos_i32 fhos_get_job_worker_index(void);
+
+// NOTE(Patrik): counter may be null when nobody waits on the job. Jobs queued from a worker go on its own
+// deque and are taken back newest first, idle workers steal the oldest.
+// ctx is only used when the job can not be queued and runs right away on the calling thread.
+FHOS_API void fhos_run_job(FHOS_Context *ctx, FHOS_Job_Proc *proc, void *data, FHOS_Job_Counter *counter);
+// NOTE(Patrik): The waiting thread runs other jobs until the counter is done instead of blocking.
+FHOS_API void fhos_wait_for_jobs(FHOS_Context *ctx, FHOS_Job_Counter *counter);
+// NOTE(Patrik): Calls proc on batches of [start, end) that together cover [0, count).
+FHOS_API void fhos_parallel_for(FHOS_Context *ctx, fhos_i64 count, fhos_i64 batch_size, FHOS_Parallel_For_Proc *proc, void *data);
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// TASK GRAPH
+//
+// NOTE(Patrik): Returns the index of the new task, or a negative value on error. A task starts as soon as
+// every task it depends on is done, on the job system.
+FHOS_API fhos_i32 fhos_add_task(FHOS_Context *ctx, FHOS_Task_Graph *graph, const char *name, FHOS_Job_Proc *proc, void *data, fhos_i64 cost);
+FHOS_API fhos_error fhos_add_task_dependency(FHOS_Context *ctx, FHOS_Task_Graph *graph, fhos_i32 task, fhos_i32 depends_on);
+// NOTE(Patrik): Returns once every task has run, or FHOS_ERROR_INVALID_FORMAT without running any if the
+// dependencies have a cycle. The calling thread runs tasks while it waits. A graph can be run again.
+FHOS_API fhos_error fhos_run_task_graph(FHOS_Context *ctx, FHOS_Task_Graph *graph, FHOS_Task_Graph_Flags flags);
+// NOTE(Patrik): Writes when and on which thread each task of the last run ran as Chrome trace JSON.
+FHOS_API fhos_error fhos_write_task_graph_timings(FHOS_Context *ctx, FHOS_Task_Graph *graph, const char *path_data, fhos_i32 path_length);
+FHOS_API void fhos_free_task_graph(FHOS_Context *ctx, FHOS_Task_Graph *graph);
+
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //
@@ -357,6 +1372,12 @@ enum {
     FHOS_ERROR_OUT_OF_MEMORY = -4,
     FHOS_ERROR_INVALID_FILE_HANDLE = -5,
     FHOS_ERROR_BUFFER_IS_NULL = -6,
+    FHOS_ERROR_NOT_FOUND = -7,
+    FHOS_ERROR_NOT_A_DIRECTORY = -8,
+    FHOS_ERROR_INVALID_FORMAT = -9,
+    FHOS_ERROR_TIMED_OUT = -10,
+    FHOS_ERROR_BUFFER_TOO_SMALL = -11,
+    FHOS_ERROR_ALREADY_EXISTS = -12,
 };
 
 
@@ -382,11 +1403,55 @@ enum {
 #if !defined(FHOS_DO_NOT_INCLUDE_PLATFORM_HEADERS)
 #  if defined(_WIN32) || defined(_WIN64)
 #    include <windows.h>
+#  elif defined(__linux__)
+#    include <stdlib.h>
+#    include <string.h>
+#    include <malloc.h>
+#    include <errno.h>
+#    include <time.h>
+#    include <unistd.h>
+#    include <fcntl.h>
+#    include <dirent.h>
+#    include <sys/stat.h>
+#    include <sys/types.h>
+#    include <sys/syscall.h>
+#    include <sys/sendfile.h>
+#    include <pthread.h>
+#    include <sched.h>
+#    include <sys/inotify.h>
+#    include <sys/mman.h>
+#    include <linux/aio_abi.h>
+#    include <sys/uio.h>
+#    include <linux/futex.h>
+#    include <sys/prctl.h>
+#    include <sys/ioctl.h>
+#    include <linux/perf_event.h>
 #  else
 #    error Unimplemented platform.
 #  endif
 #endif
 
+// NOTE(Patrik): The SSE2 and AVX2 hash kernels. SSE2 is always there on x86-64, AVX2 is checked for at runtime.
+// Define FHOS_NO_SIMD to only use the portable kernel.
+#if !defined(FHOS_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#  define FHOS__HASH_X64 1
+#  include <immintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  endif
+#endif
+
+// NOTE(Patrik): rdtsc and cpuid for the TSC clock in TIME.
+#if defined(__x86_64__) || defined(_M_X64)
+#  define FHOS__TICKS_X64 1
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  else
+#    include <x86intrin.h>
+#    include <cpuid.h>
+#  endif
+#endif
+
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //
@@ -398,6 +1463,8 @@ fhos_allocate_memory(fhos_i64 size_in_bytes) {
     void *result = 0;
 #if defined(_WIN32) || defined(_WIN64)
     result = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, size_in_bytes);
+#elif defined(__linux__)
+    result = calloc(1, (size_t)size_in_bytes);
 #else
 #  error Unimplemented on this platform.
 #endif
@@ -409,6 +1476,8 @@ fhos_allocate_memory_non_zero(fhos_i64 size_in_bytes) {
     if(size_in_bytes <= 0) { return 0; }
 #if defined(_WIN32) || defined(_WIN64)
     void *result = HeapAlloc(GetProcessHeap(), 0, size_in_bytes);
+#elif defined(__linux__)
+    void *result = malloc((size_t)size_in_bytes);
 #else
 #  error Unimplemented on this platform.
 #endif
@@ -425,6 +1494,17 @@ fhos_reallocate_memory(void *old_data, fhos_i64 new_size_in_bytes) {
     } else {
         result = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, new_size_in_bytes);
     }
+#elif defined(__linux__)
+    if(old_data) {
+        // NOTE(Patrik): realloc does not zero the grown part, so do it ourselves.
+        size_t old_size = malloc_usable_size(old_data);
+        result = realloc(old_data, (size_t)new_size_in_bytes);
+        if(result && (size_t)new_size_in_bytes > old_size) {
+            memset((fhos_u8 *)result + old_size, 0, (size_t)new_size_in_bytes - old_size);
+        }
+    } else {
+        result = calloc(1, (size_t)new_size_in_bytes);
+    }
 #else
 #  error Unimplemented on this platform.
 #endif
@@ -441,6 +1521,8 @@ fhos_reallocate_memory_non_zero(void *old_data, fhos_i64 new_size_in_bytes) {
     } else {
         result = HeapAlloc(GetProcessHeap(), 0, new_size_in_bytes);
     }
+#elif defined(__linux__)
+    result = realloc(old_data, (size_t)new_size_in_bytes);
 #else
 #  error Unimplemented on this platform.
 #endif
@@ -452,6 +1534,54 @@ fhos_free_memory(void *data) {
     if(!data) { return; }
 #if defined(_WIN32) || defined(_WIN64)
     HeapFree(GetProcessHeap(), 0, data);
+#elif defined(__linux__)
+    free(data);
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+FHOS_API void *
+fhos_allocate_aligned_memory_non_zero(fhos_i64 size_in_bytes, fhos_i64 alignment) {
+    if(size_in_bytes <= 0) { return 0; }
+    if(alignment <= 0 || (alignment & (alignment - 1)) != 0) {
+        FHOS_LOG_ERROR("The alignment %lld is not a power of two.\n", (long long)alignment);
+        return 0;
+    }
+    
+    void *result = 0;
+#if defined(_WIN32) || defined(_WIN64)
+    if(alignment > 64 * 1024) {
+        FHOS_LOG_ERROR("Alignments larger than 64 KB are not supported.\n");
+        return 0;
+    }
+    result = VirtualAlloc(0, (SIZE_T)size_in_bytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#elif defined(__linux__)
+    if(alignment < (fhos_i64)sizeof(void *)) { alignment = sizeof(void *); }
+    if(posix_memalign(&result, (size_t)alignment, (size_t)size_in_bytes) != 0) { result = 0; }
+#else
+#  error Unimplemented on this platform.
+#endif
+    return result;
+}
+
+FHOS_API void *
+fhos_allocate_aligned_memory(fhos_i64 size_in_bytes, fhos_i64 alignment) {
+    void *result = fhos_allocate_aligned_memory_non_zero(size_in_bytes, alignment);
+#if defined(__linux__)
+    // NOTE(Patrik): VirtualAlloc already hands out zeroed pages.
+    if(result) { memset(result, 0, (size_t)size_in_bytes); }
+#endif
+    return result;
+}
+
+FHOS_API void
+fhos_free_aligned_memory(void *data) {
+    if(!data) { return; }
+#if defined(_WIN32) || defined(_WIN64)
+    VirtualFree(data, 0, MEM_RELEASE);
+#elif defined(__linux__)
+    free(data);
 #else
 #  error Unimplemented on this platform.
 #endif
@@ -730,7 +1860,7 @@ fhos_context_temp_free_all(FHOS_Context *ctx) {
 FHOS_API void *
 fhos_context_maybe_grow(FHOS_Context *ctx, void *data, fhos_i64 *capacity, fhos_i64 new_capacity) {
     if(!capacity) { return 0; }
-    if(*capacity < new_capacity) { return data; }
+    if(*capacity >= new_capacity) { return data; }
     
     if(!data || *capacity <= 0) {
         *capacity = 16;
@@ -745,7 +1875,7 @@ fhos_context_maybe_grow(FHOS_Context *ctx, void *data, fhos_i64 *capacity, fhos_
 FHOS_API void *
 fhos_context_temp_maybe_grow(FHOS_Context *ctx, void *data, fhos_i64 *capacity, fhos_i64 new_capacity) {
     if(!capacity) { return 0; }
-    if(*capacity < new_capacity) { return data; }
+    if(*capacity >= new_capacity) { return data; }
     
     if(!data || *capacity <= 0) {
         *capacity = 16;
@@ -760,727 +1890,8581 @@ fhos_context_temp_maybe_grow(FHOS_Context *ctx, void *data, fhos_i64 *capacity,
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //
-// IO
+// INTERNAL THREADING
 //
-FHOS_API FHOS_File_Handle
-fhos_get_invalid_file_handle(void) {
-#if defined(_WIN32) || defined(_WIN64)
-    FHOS_File_Handle result = { (void *)(fhos_isize)INVALID_HANDLE_VALUE };
+#if defined(_MSC_VER)
+#  pragma comment(lib, "Synchronization.lib")
+#endif
+
+#if defined(_MSC_VER)
+#  define FHOS__THREAD_LOCAL __declspec(thread)
 #else
-#  error Unimplemented on this platform.
+#  define FHOS__THREAD_LOCAL __thread
 #endif
-    return result;
-}
 
-FHOS_API fhos_bool
-fhos_is_file_handle_valid(FHOS_File_Handle handle) {
+// NOTE(Patrik): Tells the core it is in a spin loop, which saves power and frees it up for the other
+// hardware thread.
 #if defined(_WIN32) || defined(_WIN64)
-    return ((HANDLE)handle.data != INVALID_HANDLE_VALUE);
+#  define FHOS__CPU_PAUSE() YieldProcessor()
+#elif defined(__x86_64__) || defined(__i386__)
+#  define FHOS__CPU_PAUSE() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#  define FHOS__CPU_PAUSE() __asm__ __volatile__("yield")
 #else
-#  error Unimplemented on this platform.
+#  define FHOS__CPU_PAUSE() ((void)0)
 #endif
-}
 
-FHOS_API fhos_bool
-fhos_close_file(FHOS_File_Handle handle) {
-    if(!fhos_is_file_handle_valid(handle)) { return FHOS_FALSE; }
-    
+typedef void FHOS__Thread_Proc(void *data);
+
+typedef struct FHOS__Thread {
+    FHOS__Thread_Proc *proc;
+    void *data;
 #if defined(_WIN32) || defined(_WIN64)
-    if(!CloseHandle((HANDLE)handle.data)) {
-        FHOS_LOG_ERROR("Could not close file handle (%lu)\n", GetLastError());
-        return FHOS_FALSE;
-    }
-    return FHOS_TRUE;
+    HANDLE handle;
+#elif defined(__linux__)
+    pthread_t handle;
 #else
 #  error Unimplemented on this platform.
 #endif
+} FHOS__Thread;
+
+#if defined(_WIN32) || defined(_WIN64)
+static DWORD WINAPI
+fhos__thread_entry(LPVOID parameter) {
+    FHOS__Thread *thread = (FHOS__Thread *)parameter;
+    thread->proc(thread->data);
+    return 0;
+}
+#elif defined(__linux__)
+static void *
+fhos__thread_entry(void *parameter) {
+    FHOS__Thread *thread = (FHOS__Thread *)parameter;
+    thread->proc(thread->data);
+    return 0;
 }
+#endif
 
-FHOS_API FHOS_File_Handle
-fhos_open_file_for_reading(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
-    FHOS_File_Handle result = fhos_get_invalid_file_handle();
-    
-    if(!path_data) {
-        FHOS_LOG_ERROR("Trying to read from a file with a null path.\n");
-        return result;
-    }
-    
-    if(path_length == 0) {
-        FHOS_LOG_ERROR("Trying to read from a file with an empty path.\n");
-        return result;
+// NOTE(Patrik): The thread struct is passed to the new thread, so it has to stay alive until joined.
+static fhos_bool
+fhos__thread_start(FHOS__Thread *thread, FHOS__Thread_Proc *proc, void *data) {
+    thread->proc = proc;
+    thread->data = data;
+#if defined(_WIN32) || defined(_WIN64)
+    thread->handle = CreateThread(0, 0, fhos__thread_entry, thread, 0, 0);
+    if(!thread->handle) {
+        FHOS_LOG_ERROR("(%lu) Could not create a thread.\n", GetLastError());
+        return FHOS_FALSE;
     }
-    
-    FHOS__ALLOC_PATH(ctx, path_data, path_length);
-    if(!path) {
-        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
-        return result;
+#elif defined(__linux__)
+    int error = pthread_create(&thread->handle, 0, fhos__thread_entry, thread);
+    if(error != 0) {
+        FHOS_LOG_ERROR("(%d) Could not create a thread.\n", error);
+        return FHOS_FALSE;
     }
-    
-#if defined(_WIN32) || defined(_WIN64)
-    result.data = (void *)CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
-                                      FILE_ATTRIBUTE_NORMAL, 0);
 #else
 #  error Unimplemented on this platform.
 #endif
-    
-    FHOS__FREE_PATH(ctx, path_data, path_length);
-    
-    return result;
+    return FHOS_TRUE;
 }
 
-FHOS_API FHOS_File_Handle
-fhos_open_file_for_writing(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
-    FHOS_File_Handle result = fhos_get_invalid_file_handle();
-    
-    if(!path_data) {
-        FHOS_LOG_ERROR("Trying to write from a file with a null path\n");
-        return result;
-    }
-    
-    if(path_length == 0) {
-        FHOS_LOG_ERROR("Trying to write from a file with an empty path\n");
-        return result;
-    }
-    
-    FHOS__ALLOC_PATH(ctx, path_data, path_length);
-    if(!path) {
-        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
-        return result;
-    }
-    
+static void
+fhos__thread_join(FHOS__Thread *thread) {
 #if defined(_WIN32) || defined(_WIN64)
-    // TODO(Patrik): Flags for file access?
-    result.data = (void *)CreateFileA(path, GENERIC_WRITE, 0, 0, CREATE_ALWAYS,
-                                      FILE_ATTRIBUTE_NORMAL, 0);
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#elif defined(__linux__)
+    pthread_join(thread->handle, 0);
 #else
 #  error Unimplemented on this platform.
 #endif
-    
-    FHOS__FREE_PATH(ctx, path_data, path_length);
-    
-    return result;
 }
 
-FHOS_API fhos_i64
-fhos_get_size_of_file(FHOS_File_Handle handle) {
-    if(!fhos_is_file_handle_valid(handle)) { return FHOS_ERROR_INVALID_FILE_HANDLE; }
-    
+static void
+fhos__thread_yield(void) {
 #if defined(_WIN32) || defined(_WIN64)
-    LARGE_INTEGER file_size;
-    if(!GetFileSizeEx((HANDLE)handle.data, &file_size)) {
-        FHOS_LOG_ERROR("Could not get file size. (%lu)\n", GetLastError());
-        return -1;
-    }
-    return file_size.QuadPart;
+    SwitchToThread();
+#elif defined(__linux__)
+    sched_yield();
 #else
 #  error Unimplemented on this platform.
 #endif
 }
 
-FHOS_API fhos_i64
-fhos_read_file(FHOS_Context *ctx, FHOS_File_Handle handle, fhos_u8 *data, fhos_i64 read_amount) {
-    if(fhos_is_file_handle_valid(handle)) {
-        FHOS_LOG_ERROR("Trying to read from an invalid file handle.\n");
-        return FHOS_ERROR_INVALID_FILE_HANDLE;
-    }
-    
-    if(!data) {
-        FHOS_LOG_ERROR("Trying to fill a null buffer.\n");
-        return FHOS_ERROR_BUFFER_IS_NULL;
-    }
-    
-    if(read_amount < 0) {
-        FHOS_LOG_ERROR("Trying to read negative amount of bytes.\n");
-        return -1;
-    }
-    
-    if(read_amount == 0) { return 0; }
-    
-    fhos_i64 result = 0;
+// NOTE(Patrik): Sleeps while address still holds expected, for at most timeout_milliseconds (negative waits
+// forever). Can return early for no reason, callers check their condition again.
+static void
+fhos__futex_wait(FHOS_Atomic_I32 *address, fhos_i32 expected, fhos_i64 timeout_milliseconds) {
 #if defined(_WIN32) || defined(_WIN64)
-    DWORD bytes_read = 0;
-    
-    if(read_amount > FHOS_I32_MAX) {
-        if(!ReadFile((HANDLE)handle.data, data, FHOS_I32_MAX, &bytes_read, 0)) {
-            FHOS_LOG_ERROR("Could not read file. (%lu)\n", GetLastError());
-            return -1;
-        }
-        
-        data += bytes_read;
-        result += bytes_read;
-        read_amount -= bytes_read;
-        bytes_read = 0;
-    }
-    
-    if(!ReadFile((HANDLE)handle.data, data, (DWORD)read_amount, &bytes_read, 0)) {
-        FHOS_LOG_ERROR("Could not read file. (%lu)\n", GetLastError());
-        return -1;
+    WaitOnAddress((volatile VOID *)&address->value, &expected, sizeof(expected), (timeout_milliseconds < 0) ? INFINITE : (DWORD)timeout_milliseconds);
+#elif defined(__linux__)
+    struct timespec timeout;
+    struct timespec *timeout_pointer = 0;
+    if(timeout_milliseconds >= 0) {
+        timeout.tv_sec = (time_t)(timeout_milliseconds / 1000);
+        timeout.tv_nsec = (long)(timeout_milliseconds % 1000) * 1000000;
+        timeout_pointer = &timeout;
     }
-    
-    result += bytes_read;
+    syscall(SYS_futex, &address->value, FUTEX_WAIT_PRIVATE, expected, timeout_pointer, (fhos_u32 *)0, 0);
 #else
 #  error Unimplemented on this platform.
 #endif
-    
-    return result;
 }
 
-FHOS_API fhos_i64
-fhos_write_file(FHOS_File_Handle handle, const fhos_u8 *data, fhos_i64 write_amount) {
-    if(fhos_is_file_handle_valid(handle)) {
-        FHOS_LOG_ERROR("Trying to write to an invalid file handle.\n");
-        return -1;
-    }
-    
-    if(!data) {
-        FHOS_LOG_ERROR("Trying to read from a null buffer.\n");
-        return -1;
-    }
-    
-    if(write_amount < 0) {
-        FHOS_LOG_ERROR("Trying to write negative amount of bytes.\n");
-        return -1;
-    }
-    
-    if(write_amount == 0) { return 0; }
-    
-    fhos_i64 result = 0;
+static void
+fhos__futex_wake(FHOS_Atomic_I32 *address, fhos_bool wake_all) {
 #if defined(_WIN32) || defined(_WIN64)
-    DWORD bytes_written = 0;
-    
-    if(write_amount > FHOS_I32_MAX) {
-        if(!WriteFile((HANDLE)handle.data, data, FHOS_I32_MAX, &bytes_written, 0)) {
-            FHOS_LOG_ERROR("Could not to write file. (%lu)\n", GetLastError());
-            return -1;
-        }
-        
-        data += bytes_written;
-        result += bytes_written;
-        write_amount -= bytes_written;
-        bytes_written = 0;
-    }
-    
-    if(!WriteFile((HANDLE)handle.data, data, (DWORD)write_amount, &bytes_written, 0)) {
-        FHOS_LOG_ERROR("Could not to write file. (%lu)\n", GetLastError());
-        return -1;
+    if(wake_all) {
+        WakeByAddressAll((PVOID)&address->value);
+    } else {
+        WakeByAddressSingle((PVOID)&address->value);
     }
+#elif defined(__linux__)
+    syscall(SYS_futex, &address->value, FUTEX_WAKE_PRIVATE,
+ (wake_all) ? 0x7FFFFFFF : 1, (struct timespec *)0, (fhos_u32 *)0, 0);
 #else
 #  error Unimplemented on this platform.
 #endif
-    
-    return result;
 }
 
-FHOS_API FHOS_List
-fhos_read_entire_file(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, fhos_bool use_temp_allocator) {
-    FHOS_List result = {0};
-    
-    FHOS_File_Handle handle = fhos_open_file_for_reading(ctx, path_data, path_length);
-    if(!fhos_is_file_handle_valid(handle)) { return result; }
-    
-    result.capacity = fhos_get_size_of_file(handle);
-    
-    if(use_temp_allocator) {
-        result.data = fhos_context_alloc_non_zero(ctx, result.capacity);
-    } else {
-        result.data = fhos_context_temp_alloc_non_zero(ctx, result.capacity);
-    }
-    
-    result.count = fhos_read_file(ctx, handle, result.data, result.capacity);
-    fhos_close_file(handle);
-    
-    return result;
+static fhos_i32
+fhos__get_processor_count(void) {
+    fhos_i32 result = 1;
+#if defined(_WIN32) || defined(_WIN64)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    result = (fhos_i32)info.dwNumberOfProcessors;
+#elif defined(__linux__)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if(count > 0) { result = (fhos_i32)count; }
+#else
+#  error Unimplemented on this platform.
+#endif
+    return (result > 0) ? result : 1;
 }
 
-FHOS_API fhos_bool
-fhos_write_entire_file(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length,
-                       const fhos_u8 *data, fhos_i64 write_amount)
-{
-    if(write_amount <= 0) { return FHOS_FALSE; }
-    
-    FHOS_File_Handle handle = fhos_open_file_for_writing(ctx, path_data, path_length);
-    if(!fhos_is_file_handle_valid(handle)) { return FHOS_FALSE; }
-    
-    fhos_i64 bytes_written = fhos_write_file(handle, data, write_amount);
-    fhos_close_file(handle);
-    
-    return bytes_written == write_amount;
+// NOTE(Patrik): A monotonic clock for timeouts.
+static fhos_i64
+fhos__get_milliseconds(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    return (fhos_i64)GetTickCount64();
+#elif defined(__linux__)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (fhos_i64)now.tv_sec * 1000 + (fhos_i64)now.tv_nsec / 1000000;
+#else
+#  error Unimplemented on this platform.
+#endif
 }
 
-
-//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//
-// PATH
-//
-FHOS_API fhos_bool
-fhos_file_exists(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
-    fhos_bool result = FHOS_FALSE;
-    FHOS__ALLOC_PATH(ctx, path_data, path_length);
-    if(!path) {
-        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
-        return result;
-    }
-    
 #if defined(_WIN32) || defined(_WIN64)
-    DWORD attribute = GetFileAttributesA(path);
-    if(attribute == INVALID_FILE_ATTRIBUTES) {
-        DWORD last_error = GetLastError();
-        if(last_error != ERROR_FILE_NOT_FOUND && last_error != ERROR_PATH_NOT_FOUND) {
-            FHOS_LOG_ERROR("Could not check if file \"%s\" exists. (%lu)\n", path, last_error);
-        }
-    }
-    
-    result = (attribute != INVALID_FILE_ATTRIBUTES);
+#  define FHOS__THREAD_EXIT_PROC(name) void WINAPI name(void *data)
+#elif defined(__linux__)
+#  define FHOS__THREAD_EXIT_PROC(name) void name(void *data)
 #else
 #  error Unimplemented on this platform.
 #endif
-    
-    FHOS__FREE_PATH(ctx, path_data, path_length);
-    return result;
-}
 
-FHOS_API fhos_bool
-fhos_remove_file(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
-    fhos_bool result = FHOS_FALSE;
-    FHOS__ALLOC_PATH(ctx, path_data, path_length);
-    if(!path) {
-        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
-        return result;
-    }
-    
+typedef FHOS__THREAD_EXIT_PROC(FHOS__Thread_Exit_Proc);
+
+enum {
+    FHOS__THREAD_EXIT_HOOK_STATE_NONE = 0,
+    FHOS__THREAD_EXIT_HOOK_STATE_CREATING = 1,
+    FHOS__THREAD_EXIT_HOOK_STATE_READY = 2,
+    FHOS__THREAD_EXIT_HOOK_STATE_FAILED = 3,
+};
+
+// NOTE(Patrik): Zero initialized, the key is created by the first thread that sets data on it.
+typedef struct FHOS__Thread_Exit_Hook {
+    FHOS_Atomic_I32 state;
 #if defined(_WIN32) || defined(_WIN64)
-    BOOL success = DeleteFile(path);
-    if(!success) {
-        DWORD last_error = GetLastError();
-        if(last_error != ERROR_FILE_NOT_FOUND) {
-            FHOS_LOG_ERROR("Could not delete the file \"%s\". (%lu)\n", path, last_error);
-        }
+    DWORD index;
+#elif defined(__linux__)
+    pthread_key_t key;
+#else
+#  error Unimplemented on this platform.
+#endif
+} FHOS__Thread_Exit_Hook;
+
+// NOTE(Patrik): proc is called with data when the calling thread exits. It is not called for the main thread
+// when the process exits, so it is only good for handing per thread buffers back to be reused.
+static fhos_bool
+fhos__set_thread_exit_data(FHOS__Thread_Exit_Hook *hook, FHOS__Thread_Exit_Proc *proc, void *data) {
+    fhos_i32 state = fhos_atomic_load_i32(&hook->state, FHOS_MEMORY_ORDER_ACQUIRE);
+    if(state == FHOS__THREAD_EXIT_HOOK_STATE_NONE &&
+       fhos_atomic_compare_exchange_i32(&hook->state, &state, FHOS__THREAD_EXIT_HOOK_STATE_CREATING, FHOS_MEMORY_ORDER_ACQ_REL)) {
+#if defined(_WIN32) || defined(_WIN64)
+        hook->index = FlsAlloc(proc);
+        fhos_bool has_created = (hook->index != FLS_OUT_OF_INDEXES);
+#elif defined(__linux__)
+        fhos_bool has_created = (pthread_key_create(&hook->key, proc) == 0);
+#else
+#  error Unimplemented on this platform.
+#endif
+        fhos_atomic_store_i32(&hook->state, (has_created) ? FHOS__THREAD_EXIT_HOOK_STATE_READY : FHOS__THREAD_EXIT_HOOK_STATE_FAILED, FHOS_MEMORY_ORDER_RELEASE);
     }
+    while((state = fhos_atomic_load_i32(&hook->state, FHOS_MEMORY_ORDER_ACQUIRE)) == FHOS__THREAD_EXIT_HOOK_STATE_CREATING) { fhos__thread_yield(); }
+    if(state != FHOS__THREAD_EXIT_HOOK_STATE_READY) { return FHOS_FALSE; }
     
-    result = (success != 0);
+#if defined(_WIN32) || defined(_WIN64)
+    return (FlsSetValue(hook->index, data) != 0);
+#elif defined(__linux__)
+    return (pthread_setspecific(hook->key, data) == 0);
 #else
 #  error Unimplemented on this platform.
 #endif
-    
-    FHOS__FREE_PATH(ctx, path_data, path_length);
-    return result;
 }
 
+#define FHOS__MAX_THREAD_COUNT 64
 
-FHOS_API fhos_error
-fhos_move_file(FHOS_Context *ctx, const char *from_path_data, fhos_i32 from_path_length,
-               const char *to_path_data, fhos_i32 to_path_length)
-{
-    if(!from_path_data) {
-        FHOS_LOG_ERROR("fhos_move_file -> The parameter from_path_data is null.\n");
-        return FHOS_ERROR_PATH_IS_NULL;
-    } else if(from_path_length == 0) {
-        FHOS_LOG_ERROR("fhos_move_file -> The parameter from_path_length is zero.\n");
-        return FHOS_ERROR_PATH_IS_EMPTY;
-    }
-    
-    if(!to_path_data) {
-        FHOS_LOG_ERROR("fhos_move_file -> The parameter to_path_data is null.\n");
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// SYNC
+//
+// NOTE(Patrik): GCC and Clang only honour an ordering that is a constant, a value only known at run time
+// is treated as sequentially consistent. So the ordering is switched on and every case passes its
+// own constant to the builtin. Orders that make no sense for an operation, like a release load,
+// become sequentially consistent. MSVC only has full barriers for read-modify-writes, those are
+// stronger than asked but never weaker.
+#if !defined(_MSC_VER)
+#define FHOS__SWITCH_LOAD_ORDER(order, OPERATION) do {\
+switch(order) {\
+case FHOS_MEMORY_ORDER_RELAXED: OPERATION(__ATOMIC_RELAXED); break;\
+case FHOS_MEMORY_ORDER_ACQUIRE: OPERATION(__ATOMIC_ACQUIRE); break;\
+default: OPERATION(__ATOMIC_SEQ_CST); break;\
+}\
+} while(0)
+
+#define FHOS__SWITCH_STORE_ORDER(order, OPERATION) do {\
+switch(order) {\
+case FHOS_MEMORY_ORDER_RELAXED: OPERATION(__ATOMIC_RELAXED); break;\
+case FHOS_MEMORY_ORDER_RELEASE: OPERATION(__ATOMIC_RELEASE); break;\
+default: OPERATION(__ATOMIC_SEQ_CST); break;\
+}\
+} while(0)
+
+// NOTE(Patrik): The second order is for a compare exchange that fails, which only reads.
+#define FHOS__SWITCH_READ_MODIFY_WRITE_ORDER(order, OPERATION) do {\
+switch(order) {\
+case FHOS_MEMORY_ORDER_RELAXED: OPERATION(__ATOMIC_RELAXED, __ATOMIC_RELAXED); break;\
+case FHOS_MEMORY_ORDER_ACQUIRE: OPERATION(__ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE); break;\
+case FHOS_MEMORY_ORDER_RELEASE: OPERATION(__ATOMIC_RELEASE, __ATOMIC_RELAXED); break;\
+case FHOS_MEMORY_ORDER_ACQ_REL: OPERATION(__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE); break;\
+default: OPERATION(__ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); break;\
+}\
+} while(0)
+
+// NOTE(Patrik): The operations use the parameter names every function below shares.
+#define FHOS__ATOMIC_LOAD_WITH(memory_order) result = __atomic_load_n(&atomic->value, memory_order)
+#define FHOS__ATOMIC_STORE_WITH(memory_order) __atomic_store_n(&atomic->value, value, memory_order)
+#define FHOS__ATOMIC_EXCHANGE_WITH(memory_order, failure_order) result = __atomic_exchange_n(&atomic->value, value, memory_order)
+#define FHOS__ATOMIC_FETCH_ADD_WITH(memory_order, failure_order) result = __atomic_fetch_add(&atomic->value, value, memory_order)
+#define FHOS__ATOMIC_COMPARE_EXCHANGE_WITH(memory_order, failure_order) result = __atomic_compare_exchange_n(&atomic->value, expected, desired, 0, memory_order, failure_order)
+#define FHOS__ATOMIC_FENCE_WITH(memory_order, failure_order) __atomic_thread_fence(memory_order)
+#endif
+
+FHOS_API fhos_i32
+fhos_atomic_load_i32(FHOS_Atomic_I32 *atomic, FHOS_Memory_Order order) {
+    fhos_i32 result = 0;
+#if defined(_MSC_VER)
+    if(order == FHOS_MEMORY_ORDER_RELAXED) {
+        result = *(volatile fhos_i32 *)&atomic->value;
+    } else {
+        result = (fhos_i32)InterlockedCompareExchange((volatile LONG *)&atomic->value, 0, 0);
+    }
+#else
+    FHOS__SWITCH_LOAD_ORDER(order, FHOS__ATOMIC_LOAD_WITH);
+#endif
+    return result;
+}
+
+FHOS_API void
+fhos_atomic_store_i32(FHOS_Atomic_I32 *atomic, fhos_i32 value, FHOS_Memory_Order order) {
+#if defined(_MSC_VER)
+    if(order == FHOS_MEMORY_ORDER_RELAXED) {
+        *(volatile fhos_i32 *)&atomic->value = value;
+    } else {
+        InterlockedExchange((volatile LONG *)&atomic->value, (LONG)value);
+    }
+#else
+    FHOS__SWITCH_STORE_ORDER(order, FHOS__ATOMIC_STORE_WITH);
+#endif
+}
+
+FHOS_API fhos_i32
+fhos_atomic_exchange_i32(FHOS_Atomic_I32 *atomic, fhos_i32 value, FHOS_Memory_Order order) {
+    fhos_i32 result = 0;
+#if defined(_MSC_VER)
+    (void)order;
+    result = (fhos_i32)InterlockedExchange((volatile LONG *)&atomic->value, (LONG)value);
+#else
+    FHOS__SWITCH_READ_MODIFY_WRITE_ORDER(order, FHOS__ATOMIC_EXCHANGE_WITH);
+#endif
+    return result;
+}
+
+FHOS_API fhos_i32
+fhos_atomic_fetch_add_i32(FHOS_Atomic_I32 *atomic, fhos_i32 value, FHOS_Memory_Order order) {
+    fhos_i32 result = 0;
+#if defined(_MSC_VER)
+    (void)order;
+    result = (fhos_i32)InterlockedExchangeAdd((volatile LONG *)&atomic->value, (LONG)value);
+#else
+    FHOS__SWITCH_READ_MODIFY_WRITE_ORDER(order, FHOS__ATOMIC_FETCH_ADD_WITH);
+#endif
+    return result;
+}
+
+FHOS_API fhos_bool
+fhos_atomic_compare_exchange_i32(FHOS_Atomic_I32 *atomic, fhos_i32 *expected, fhos_i32 desired, FHOS_Memory_Order order) {
+    fhos_bool result = FHOS_FALSE;
+#if defined(_MSC_VER)
+    (void)order;
+    fhos_i32 previous = (fhos_i32)InterlockedCompareExchange((volatile LONG *)&atomic->value, (LONG)desired, (LONG)*expected);
+    result = (previous == *expected);
+    *expected = previous;
+#else
+    FHOS__SWITCH_READ_MODIFY_WRITE_ORDER(order, FHOS__ATOMIC_COMPARE_EXCHANGE_WITH);
+#endif
+    return result;
+}
+
+FHOS_API fhos_i64
+fhos_atomic_load_i64(FHOS_Atomic_I64 *atomic, FHOS_Memory_Order order) {
+    fhos_i64 result = 0;
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    if(order == FHOS_MEMORY_ORDER_RELAXED) {
+        result = *(volatile fhos_i64 *)&atomic->value;
+    } else {
+        result = (fhos_i64)InterlockedCompareExchange64((volatile LONG64 *)&atomic->value, 0, 0);
+    }
+#elif defined(_MSC_VER)
+    (void)order;
+    result = (fhos_i64)InterlockedCompareExchange64((volatile LONG64 *)&atomic->value, 0, 0);
+#else
+    FHOS__SWITCH_LOAD_ORDER(order, FHOS__ATOMIC_LOAD_WITH);
+#endif
+    return result;
+}
+
+FHOS_API void
+fhos_atomic_store_i64(FHOS_Atomic_I64 *atomic, fhos_i64 value, FHOS_Memory_Order order) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    if(order == FHOS_MEMORY_ORDER_RELAXED) {
+        *(volatile fhos_i64 *)&atomic->value = value;
+    } else {
+        InterlockedExchange64((volatile LONG64 *)&atomic->value, value);
+    }
+#elif defined(_MSC_VER)
+    (void)order;
+    InterlockedExchange64((volatile LONG64 *)&atomic->value, value);
+#else
+    FHOS__SWITCH_STORE_ORDER(order, FHOS__ATOMIC_STORE_WITH);
+#endif
+}
+
+FHOS_API fhos_i64
+fhos_atomic_exchange_i64(FHOS_Atomic_I64 *atomic, fhos_i64 value, FHOS_Memory_Order order) {
+    fhos_i64 result = 0;
+#if defined(_MSC_VER)
+    (void)order;
+    result = (fhos_i64)InterlockedExchange64((volatile LONG64 *)&atomic->value, value);
+#else
+    FHOS__SWITCH_READ_MODIFY_WRITE_ORDER(order, FHOS__ATOMIC_EXCHANGE_WITH);
+#endif
+    return result;
+}
+
+FHOS_API fhos_i64
+fhos_atomic_fetch_add_i64(FHOS_Atomic_I64 *atomic, fhos_i64 value, FHOS_Memory_Order order) {
+    fhos_i64 result = 0;
+#if defined(_MSC_VER)
+    (void)order;
+    result = (fhos_i64)InterlockedExchangeAdd64((volatile LONG64 *)&atomic->value, value);
+#else
+    FHOS__SWITCH_READ_MODIFY_WRITE_ORDER(order, FHOS__ATOMIC_FETCH_ADD_WITH);
+#endif
+    return result;
+}
+
+FHOS_API fhos_bool
+fhos_atomic_compare_exchange_i64(FHOS_Atomic_I64 *atomic, fhos_i64 *expected, fhos_i64 desired, FHOS_Memory_Order order) {
+    fhos_bool result = FHOS_FALSE;
+#if defined(_MSC_VER)
+    (void)order;
+    fhos_i64 previous = (fhos_i64)InterlockedCompareExchange64((volatile LONG64 *)&atomic->value, desired, *expected);
+    result = (previous == *expected);
+    *expected = previous;
+#else
+    FHOS__SWITCH_READ_MODIFY_WRITE_ORDER(order, FHOS__ATOMIC_COMPARE_EXCHANGE_WITH);
+#endif
+    return result;
+}
+
+FHOS_API void *
+fhos_atomic_load_pointer(FHOS_Atomic_Pointer *atomic, FHOS_Memory_Order order) {
+    void *result = 0;
+#if defined(_MSC_VER)
+    if(order == FHOS_MEMORY_ORDER_RELAXED) {
+        result = *(void *volatile *)&atomic->value;
+    } else {
+        result = InterlockedCompareExchangePointer((void *volatile *)&atomic->value, 0, 0);
+    }
+#else
+    FHOS__SWITCH_LOAD_ORDER(order, FHOS__ATOMIC_LOAD_WITH);
+#endif
+    return result;
+}
+
+FHOS_API void
+fhos_atomic_store_pointer(FHOS_Atomic_Pointer *atomic, void *value, FHOS_Memory_Order order) {
+#if defined(_MSC_VER)
+    if(order == FHOS_MEMORY_ORDER_RELAXED) {
+        *(void *volatile *)&atomic->value = value;
+    } else {
+        InterlockedExchangePointer((void *volatile *)&atomic->value, value);
+    }
+#else
+    FHOS__SWITCH_STORE_ORDER(order, FHOS__ATOMIC_STORE_WITH);
+#endif
+}
+
+FHOS_API void *
+fhos_atomic_exchange_pointer(FHOS_Atomic_Pointer *atomic, void *value, FHOS_Memory_Order order) {
+    void *result = 0;
+#if defined(_MSC_VER)
+    (void)order;
+    result = InterlockedExchangePointer((void *volatile *)&atomic->value, value);
+#else
+    FHOS__SWITCH_READ_MODIFY_WRITE_ORDER(order, FHOS__ATOMIC_EXCHANGE_WITH);
+#endif
+    return result;
+}
+
+FHOS_API fhos_bool
+fhos_atomic_compare_exchange_pointer(FHOS_Atomic_Pointer *atomic, void **expected, void *desired, FHOS_Memory_Order order) {
+    fhos_bool result = FHOS_FALSE;
+#if defined(_MSC_VER)
+    (void)order;
+    void *previous = InterlockedCompareExchangePointer((void *volatile *)&atomic->value, desired, *expected);
+    result = (previous == *expected);
+    *expected = previous;
+#else
+    FHOS__SWITCH_READ_MODIFY_WRITE_ORDER(order, FHOS__ATOMIC_COMPARE_EXCHANGE_WITH);
+#endif
+    return result;
+}
+
+FHOS_API void
+fhos_atomic_fence(FHOS_Memory_Order order) {
+#if defined(_MSC_VER)
+    (void)order;
+    MemoryBarrier();
+
+#else
+    FHOS__SWITCH_READ_MODIFY_WRITE_ORDER(order, FHOS__ATOMIC_FENCE_WITH);
+#endif
+}
+
+// NOTE(Patrik): The lock word is 0 when unlocked, 1 when locked and 2 when locked with threads that may be
+// asleep on it. Only unlocking from 2 needs a system call, so a lock nobody waits on never leaves
+// user space. Waiters set 2 themselves, which can cost one wake too many but never a lost one.
+static void
+fhos__lock_word(FHOS_Atomic_I32 *state, fhos_i32 spin_count) {
+    fhos_i32 previous = 0;
+    if(fhos_atomic_compare_exchange_i32(state, &previous, 1, FHOS_MEMORY_ORDER_ACQUIRE)) { return; }
+    
+    for(fhos_i32 i = 0; i < spin_count && previous != 2; i += 1) {
+        FHOS__CPU_PAUSE();
+        previous = fhos_atomic_load_i32(state, FHOS_MEMORY_ORDER_RELAXED);
+        if(previous == 0 && fhos_atomic_compare_exchange_i32(state, &previous, 1, FHOS_MEMORY_ORDER_ACQUIRE)) { return; }
+    }
+    
+    while(fhos_atomic_exchange_i32(state, 2, FHOS_MEMORY_ORDER_ACQUIRE) != 0) { fhos__futex_wait(state, 2, -1); }
+}
+
+static void
+fhos__unlock_word(FHOS_Atomic_I32 *state) {
+    if(fhos_atomic_exchange_i32(state, 0, FHOS_MEMORY_ORDER_RELEASE) == 2) { fhos__futex_wake(state, FHOS_FALSE); }
+}
+
+FHOS_API void
+fhos_lock_mutex(FHOS_Mutex *mutex) {
+    fhos__lock_word(&mutex->state, 0);
+}
+
+FHOS_API fhos_bool
+fhos_try_lock_mutex(FHOS_Mutex *mutex) {
+    fhos_i32 expected = 0;
+    return fhos_atomic_compare_exchange_i32(&mutex->state, &expected, 1, FHOS_MEMORY_ORDER_ACQUIRE);
+}
+
+FHOS_API void
+fhos_unlock_mutex(FHOS_Mutex *mutex) {
+    fhos__unlock_word(&mutex->state);
+}
+
+FHOS_API void
+fhos_lock_spin_lock(FHOS_Spin_Lock *lock) {
+    fhos__lock_word(&lock->state, FHOS_SPIN_LOCK_SPIN_COUNT);
+}
+
+FHOS_API fhos_bool
+fhos_try_lock_spin_lock(FHOS_Spin_Lock *lock) {
+    fhos_i32 expected = 0;
+    return fhos_atomic_compare_exchange_i32(&lock->state, &expected, 1, FHOS_MEMORY_ORDER_ACQUIRE);
+}
+
+FHOS_API void
+fhos_unlock_spin_lock(FHOS_Spin_Lock *lock) {
+    fhos__unlock_word(&lock->state);
+}
+
+// NOTE(Patrik): Waits until state is no longer zero or the deadline passes. The futex sleep can end early
+// for no reason, so the remaining time is worked out again every round.
+static fhos_bool
+fhos__wait_while_zero(FHOS_Atomic_I32 *state, FHOS_Atomic_I32 *waiter_count, fhos_i64 deadline, fhos_i64 timeout_milliseconds) {
+    fhos_i64 remaining = timeout_milliseconds;
+    if(timeout_milliseconds > 0) {
+        remaining = deadline - fhos__get_milliseconds();
+        if(remaining <= 0) { return FHOS_FALSE; }
+    }
+    
+    fhos_atomic_fetch_add_i32(waiter_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+    fhos_atomic_fence(FHOS_MEMORY_ORDER_SEQ_CST);
+    fhos__futex_wait(state, 0, remaining);
+    fhos_atomic_fetch_add_i32(waiter_count, -1, FHOS_MEMORY_ORDER_RELAXED);
+    return FHOS_TRUE;
+}
+
+FHOS_API fhos_bool
+fhos_try_wait_semaphore(FHOS_Semaphore *semaphore) {
+    fhos_i32 count = fhos_atomic_load_i32(&semaphore->count, FHOS_MEMORY_ORDER_RELAXED);
+    while(count > 0) {
+        if(fhos_atomic_compare_exchange_i32(&semaphore->count, &count, count - 1, FHOS_MEMORY_ORDER_ACQUIRE)) { return FHOS_TRUE; }
+    }
+    return FHOS_FALSE;
+}
+
+FHOS_API fhos_error
+fhos_wait_semaphore(FHOS_Semaphore *semaphore, fhos_i64 timeout_milliseconds) {
+    fhos_i64 deadline = (timeout_milliseconds > 0) ? fhos__get_milliseconds() + timeout_milliseconds : 0;
+    for(;;) {
+        if(fhos_try_wait_semaphore(semaphore)) { return FHOS_TRUE; }
+        if(timeout_milliseconds == 0) { return FHOS_ERROR_TIMED_OUT; }
+        if(!fhos__wait_while_zero(&semaphore->count, &semaphore->waiter_count, deadline, timeout_milliseconds)) { return FHOS_ERROR_TIMED_OUT; }
+    }
+}
+
+FHOS_API void
+fhos_post_semaphore(FHOS_Semaphore *semaphore, fhos_u32 count) {
+    if(count == 0) { return; }
+    
+    fhos_atomic_fetch_add_i32(&semaphore->count, (fhos_i32)count, FHOS_MEMORY_ORDER_RELEASE);
+    fhos_atomic_fence(FHOS_MEMORY_ORDER_SEQ_CST);
+    if(fhos_atomic_load_i32(&semaphore->waiter_count, FHOS_MEMORY_ORDER_RELAXED) > 0) { fhos__futex_wake(&semaphore->count, count > 1); }
+}
+
+// NOTE(Patrik): Setting an event that is already set does nothing, one waiter takes it and resets it.
+FHOS_API void
+fhos_set_event(FHOS_Event *event) {
+    if(fhos_atomic_exchange_i32(&event->state, 1, FHOS_MEMORY_ORDER_RELEASE) != 0) { return; }
+    
+    fhos_atomic_fence(FHOS_MEMORY_ORDER_SEQ_CST);
+    if(fhos_atomic_load_i32(&event->waiter_count, FHOS_MEMORY_ORDER_RELAXED) > 0) { fhos__futex_wake(&event->state, FHOS_FALSE); }
+}
+
+FHOS_API void
+fhos_reset_event(FHOS_Event *event) {
+    fhos_atomic_store_i32(&event->state, 0, FHOS_MEMORY_ORDER_RELEASE);
+}
+
+FHOS_API fhos_error
+fhos_wait_event(FHOS_Event *event, fhos_i64 timeout_milliseconds) {
+    fhos_i64 deadline = (timeout_milliseconds > 0) ? fhos__get_milliseconds() + timeout_milliseconds : 0;
+    for(;;) {
+        fhos_i32 expected = 1;
+        if(fhos_atomic_compare_exchange_i32(&event->state, &expected, 0, FHOS_MEMORY_ORDER_ACQUIRE)) { return FHOS_TRUE; }
+        if(timeout_milliseconds == 0) { return FHOS_ERROR_TIMED_OUT; }
+        if(!fhos__wait_while_zero(&event->state, &event->waiter_count, deadline, timeout_milliseconds)) { return FHOS_ERROR_TIMED_OUT; }
+    }
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// JOBS
+//
+// NOTE(Patrik): Every worker owns a Chase-Lev deque. The owner pushes and pops at the bottom without locks,
+// other threads steal from the top and only race on top with a compare exchange. Threads that are
+// not workers hand their jobs to a shared queue behind a mutex instead.
+#define FHOS__JOB_DEQUE_CAPACITY 4096
+
+typedef struct FHOS__Job {
+    FHOS_Job_Proc *proc;
+    void *data;
+    FHOS_Job_Counter *counter;
+} FHOS__Job;
+
+typedef struct FHOS__Job_Worker {
+    FHOS_Atomic_I64 top;
+    fhos_u8 padding0[56];
+    FHOS_Atomic_I64 bottom;
+    fhos_u8 padding1[56];
+    
+    FHOS__Job jobs[FHOS__JOB_DEQUE_CAPACITY];
+    FHOS__Thread thread;
+    FHOS_Context ctx;
+    fhos_i32 index;
+    fhos_u32 random_state;
+} FHOS__Job_Worker;
+
+enum {
+    FHOS__JOBS_STATE_STOPPED = 0,
+    FHOS__JOBS_STATE_STARTING = 1,
+    FHOS__JOBS_STATE_RUNNING = 2,
+    FHOS__JOBS_STATE_STOPPING = 3,
+};
+
+typedef struct FHOS__Job_System {
+    FHOS_Atomic_I32 state;
+    fhos_i32 worker_count;
+    fhos_i32 started_count;
+    FHOS__Job_Worker *workers;
+    
+    FHOS_Mutex shared_mutex;
+    FHOS__Job *shared_jobs;
+    fhos_i64 shared_read;
+    fhos_i64 shared_count;
+    fhos_i64 shared_capacity;
+    FHOS_Atomic_I64 shared_pending;
+    
+    // NOTE(Patrik): Idle workers sleep on wake_sequence, which is only bumped when one of them is asleep.
+    FHOS_Atomic_I32 wake_sequence;
+    FHOS_Atomic_I32 sleeping_count;
+} FHOS__Job_System;
+
+static FHOS__Job_System fhos__jobs;
+
+// NOTE(Patrik): Threads in fhos_wait_for_jobs sleep on one global sequence instead of one in their counter.
+// A counter can be gone the moment its last job brings it to zero, the finishing thread must not
+// touch it after that. These outlive fhos_stop_job_system on purpose.
+static FHOS_Atomic_I32 fhos__job_done_sequence;
+static FHOS_Atomic_I32 fhos__job_waiting_count;
+static FHOS__THREAD_LOCAL FHOS__Job_Worker *fhos__current_job_worker;
+
+static fhos_bool
+fhos__push_job(FHOS__Job_Worker *worker, FHOS__Job *job) {
+    fhos_i64 bottom = fhos_atomic_load_i64(&worker->bottom, FHOS_MEMORY_ORDER_RELAXED);
+    fhos_i64 top = fhos_atomic_load_i64(&worker->top, FHOS_MEMORY_ORDER_ACQUIRE);
+    if(bottom - top >= FHOS__JOB_DEQUE_CAPACITY) { return FHOS_FALSE; }
+    
+    worker->jobs[bottom & (FHOS__JOB_DEQUE_CAPACITY - 1)] = *job;
+    fhos_atomic_store_i64(&worker->bottom, bottom + 1, FHOS_MEMORY_ORDER_RELEASE);
+    return FHOS_TRUE;
+}
+
+// NOTE(Patrik): Taking the last job races with thieves, whoever moves top first gets it.
+static fhos_bool
+fhos__pop_job(FHOS__Job_Worker *worker, FHOS__Job *job) {
+    fhos_i64 bottom = fhos_atomic_load_i64(&worker->bottom, FHOS_MEMORY_ORDER_RELAXED) - 1;
+    fhos_atomic_store_i64(&worker->bottom, bottom, FHOS_MEMORY_ORDER_RELEASE);
+    fhos_atomic_fence(FHOS_MEMORY_ORDER_SEQ_CST);
+    fhos_i64 top = fhos_atomic_load_i64(&worker->top, FHOS_MEMORY_ORDER_ACQUIRE);
+    
+    if(top > bottom) {
+        fhos_atomic_store_i64(&worker->bottom, bottom + 1, FHOS_MEMORY_ORDER_RELEASE);
+        return FHOS_FALSE;
+    }
+    
+    *job = worker->jobs[bottom & (FHOS__JOB_DEQUE_CAPACITY - 1)];
+    if(top == bottom) {
+        fhos_bool is_taken = fhos_atomic_compare_exchange_i64(&worker->top, &top, top + 1, FHOS_MEMORY_ORDER_SEQ_CST);
+        fhos_atomic_store_i64(&worker->bottom, bottom + 1, FHOS_MEMORY_ORDER_RELEASE);
+        return is_taken;
+    }
+    return FHOS_TRUE;
+}
+
+static fhos_bool
+fhos__steal_job(FHOS__Job_Worker *worker, FHOS__Job *job) {
+    fhos_i64 top = fhos_atomic_load_i64(&worker->top, FHOS_MEMORY_ORDER_ACQUIRE);
+    fhos_atomic_fence(FHOS_MEMORY_ORDER_SEQ_CST);
+    fhos_i64 bottom = fhos_atomic_load_i64(&worker->bottom, FHOS_MEMORY_ORDER_ACQUIRE);
+    if(top >= bottom) { return FHOS_FALSE; }
+    
+    *job = worker->jobs[top & (FHOS__JOB_DEQUE_CAPACITY - 1)];
+    return fhos_atomic_compare_exchange_i64(&worker->top, &top, top + 1, FHOS_MEMORY_ORDER_SEQ_CST);
+
+}
+
+static fhos_bool
+fhos__push_shared_job(FHOS__Job *job) {
+    fhos_lock_mutex(&fhos__jobs.shared_mutex);
+    
+    if(fhos__jobs.shared_count == fhos__jobs.shared_capacity && fhos__jobs.shared_read > 0) {
+        fhos_i64 remaining = fhos__jobs.shared_count - fhos__jobs.shared_read;
+        for(fhos_i64 i = 0; i < remaining; i += 1) { fhos__jobs.shared_jobs[i] = fhos__jobs.shared_jobs[fhos__jobs.shared_read + i]; }
+        fhos__jobs.shared_read = 0;
+        fhos__jobs.shared_count = remaining;
+    }
+    if(fhos__jobs.shared_count == fhos__jobs.shared_capacity) {
+        fhos_i64 new_capacity = (fhos__jobs.shared_capacity > 0) ? fhos__jobs.shared_capacity * 2 : 256;
+        FHOS__Job *new_jobs = (FHOS__Job *)fhos_reallocate_memory(fhos__jobs.shared_jobs, new_capacity * sizeof(FHOS__Job));
+        if(!new_jobs) {
+            fhos_unlock_mutex(&fhos__jobs.shared_mutex);
+            return FHOS_FALSE;
+        }
+        fhos__jobs.shared_jobs = new_jobs;
+        fhos__jobs.shared_capacity = new_capacity;
+    }
+    
+    fhos__jobs.shared_jobs[fhos__jobs.shared_count] = *job;
+    fhos__jobs.shared_count += 1;
+    fhos_atomic_fetch_add_i64(&fhos__jobs.shared_pending, 1, FHOS_MEMORY_ORDER_ACQ_REL);
+    
+    fhos_unlock_mutex(&fhos__jobs.shared_mutex);
+    return FHOS_TRUE;
+}
+
+static fhos_bool
+fhos__pop_shared_job(FHOS__Job *job) {
+    if(fhos_atomic_load_i64(&fhos__jobs.shared_pending, FHOS_MEMORY_ORDER_ACQUIRE) <= 0) { return FHOS_FALSE; }
+    
+    fhos_bool result = FHOS_FALSE;
+    fhos_lock_mutex(&fhos__jobs.shared_mutex);
+    if(fhos__jobs.shared_read < fhos__jobs.shared_count) {
+        *job = fhos__jobs.shared_jobs[fhos__jobs.shared_read];
+        fhos__jobs.shared_read += 1;
+        if(fhos__jobs.shared_read == fhos__jobs.shared_count) {
+            fhos__jobs.shared_read = 0;
+            fhos__jobs.shared_count = 0;
+        }
+        fhos_atomic_fetch_add_i64(&fhos__jobs.shared_pending, -1, FHOS_MEMORY_ORDER_ACQ_REL);
+        result = FHOS_TRUE;
+    }
+    fhos_unlock_mutex(&fhos__jobs.shared_mutex);
+    return result;
+}
+
+static fhos_bool
+fhos__has_queued_jobs(void) {
+    if(fhos_atomic_load_i64(&fhos__jobs.shared_pending, FHOS_MEMORY_ORDER_ACQUIRE) > 0) { return FHOS_TRUE; }
+    for(fhos_i32 i = 0; i < fhos__jobs.worker_count; i += 1) {
+        FHOS__Job_Worker *worker = fhos__jobs.workers + i;
+        if(fhos_atomic_load_i64(&worker->bottom, FHOS_MEMORY_ORDER_ACQUIRE) > fhos_atomic_load_i64(&worker->top, FHOS_MEMORY_ORDER_ACQUIRE)) { return FHOS_TRUE; }
+    }
+    return FHOS_FALSE;
+}
+
+static void
+fhos__wake_job_worker(void) {
+    fhos_atomic_fence(FHOS_MEMORY_ORDER_SEQ_CST);
+    if(fhos_atomic_load_i32(&fhos__jobs.sleeping_count, FHOS_MEMORY_ORDER_ACQUIRE) > 0) {
+        fhos_atomic_fetch_add_i32(&fhos__jobs.wake_sequence, 1, FHOS_MEMORY_ORDER_ACQ_REL);
+        fhos__futex_wake(&fhos__jobs.wake_sequence, FHOS_FALSE);
+    }
+}
+
+// NOTE(Patrik): The decrement is the last access to the counter. Waiters are counted before they look at
+// their counter, so either the waiter sees zero or the finisher sees the waiter and wakes it.
+static void
+fhos__finish_job(FHOS__Job *job, FHOS_Context *ctx) {
+    job->proc(ctx, job->data);
+    if(job->counter && fhos_atomic_fetch_add_i64(&job->counter->pending_count, -1, FHOS_MEMORY_ORDER_ACQ_REL) == 1) {
+        if(fhos_atomic_load_i32(&fhos__job_waiting_count, FHOS_MEMORY_ORDER_ACQUIRE) > 0) {
+            fhos_atomic_fetch_add_i32(&fhos__job_done_sequence, 1, FHOS_MEMORY_ORDER_ACQ_REL);
+            fhos__futex_wake(&fhos__job_done_sequence, FHOS_TRUE);
+        }
+    }
+}
+
+// NOTE(Patrik): Own jobs first, newest first while they are still in cache, then the shared queue and last
+// the oldest job of another worker, starting from a random one.
+static fhos_bool
+fhos__run_one_job(FHOS_Context *ctx) {
+    FHOS__Job job;
+    FHOS__Job_Worker *worker = fhos__current_job_worker;
+    if(worker && fhos__pop_job(worker, &job)) {
+        fhos__finish_job(&job, ctx);
+        return FHOS_TRUE;
+    }
+    if(fhos__pop_shared_job(&job)) {
+        fhos__finish_job(&job, ctx);
+        return FHOS_TRUE;
+    }
+    
+    fhos_i32 worker_count = fhos__jobs.worker_count;
+    if(worker_count <= 0) { return FHOS_FALSE; }
+    
+    fhos_u32 random = (fhos_u32)(fhos_isize)&job;
+    if(worker) {
+        worker->random_state = worker->random_state * 1664525u + 1013904223u;
+        random = worker->random_state;
+    }
+    fhos_i32 start = (fhos_i32)((random >> 8) % (fhos_u32)worker_count);
+    for(fhos_i32 i = 0; i < worker_count; i += 1) {
+        FHOS__Job_Worker *victim = fhos__jobs.workers + (start + i) % worker_count;
+        if(victim != worker && fhos__steal_job(victim, &job)) {
+            fhos__finish_job(&job, ctx);
+            return FHOS_TRUE;
+        }
+    }
+    return FHOS_FALSE;
+}
+
+static void
+fhos__job_worker_proc(void *data) {
+    FHOS__Job_Worker *worker = (FHOS__Job_Worker *)data;
+    fhos__current_job_worker = worker;
+    
+    // NOTE(Patrik): Spin a little before yielding and yield a little before sleeping, jobs often come in bursts.
+    fhos_i32 idle_count = 0;
+    while(fhos_atomic_load_i32(&fhos__jobs.state, FHOS_MEMORY_ORDER_ACQUIRE) != FHOS__JOBS_STATE_STOPPING) {
+        if(fhos__run_one_job(&worker->ctx)) {
+            idle_count = 0;
+            continue;
+        }
+        
+        idle_count += 1;
+        if(idle_count < 64) {
+            FHOS__CPU_PAUSE();
+        } else if(idle_count < 128) {
+            fhos__thread_yield();
+        } else {
+            fhos_i32 sequence = fhos_atomic_load_i32(&fhos__jobs.wake_sequence, FHOS_MEMORY_ORDER_ACQUIRE);
+            fhos_atomic_fetch_add_i32(&fhos__jobs.sleeping_count, 1, FHOS_MEMORY_ORDER_ACQ_REL);
+            if(!fhos__has_queued_jobs() && fhos_atomic_load_i32(&fhos__jobs.state, FHOS_MEMORY_ORDER_ACQUIRE) != FHOS__JOBS_STATE_STOPPING) {
+                fhos__futex_wait(&fhos__jobs.wake_sequence, sequence, -1);
+            }
+            fhos_atomic_fetch_add_i32(&fhos__jobs.sleeping_count, -1, FHOS_MEMORY_ORDER_ACQ_REL);
+            idle_count = 0;
+        }
+    }
+    
+    fhos__current_job_worker = 0;
+}
+
+FHOS_API fhos_bool
+fhos_start_job_system(const FHOS_Context *worker_contexts, fhos_i32 worker_count) {
+    if(worker_contexts && worker_count <= 0) {
+        FHOS_LOG_ERROR("fhos_start_job_system -> worker_count has to be given along with worker_contexts.\n");
+        return FHOS_FALSE;
+    }
+    
+    fhos_i32 state = FHOS__JOBS_STATE_STOPPED;
+    if(!fhos_atomic_compare_exchange_i32(&fhos__jobs.state, &state, FHOS__JOBS_STATE_STARTING, FHOS_MEMORY_ORDER_ACQ_REL)) {
+        while(fhos_atomic_load_i32(&fhos__jobs.state, FHOS_MEMORY_ORDER_ACQUIRE) == FHOS__JOBS_STATE_STARTING) { fhos__thread_yield(); }
+        return (fhos_atomic_load_i32(&fhos__jobs.state, FHOS_MEMORY_ORDER_ACQUIRE) == FHOS__JOBS_STATE_RUNNING);
+    }
+    
+    // NOTE(Patrik): The thread that waits on jobs runs them too, so by default there is one worker less than
+    // there are processors. There is always at least one so jobs nobody waits on still run.
+    if(worker_count <= 0) { worker_count = fhos__get_processor_count() - 1; }
+    if(worker_count < 1) { worker_count = 1; }
+    if(worker_count > FHOS__MAX_THREAD_COUNT) { worker_count = FHOS__MAX_THREAD_COUNT; }
+    
+    FHOS__Job_Worker *workers = (FHOS__Job_Worker *)fhos_allocate_memory(worker_count * sizeof(FHOS__Job_Worker));
+    if(!workers) {
+        FHOS_LOG_ERROR("Could not allocate memory for the job workers.\n");
+        fhos_atomic_store_i32(&fhos__jobs.state, FHOS__JOBS_STATE_STOPPED, FHOS_MEMORY_ORDER_RELEASE);
+        return FHOS_FALSE;
+    }
+    
+    fhos__jobs.workers = workers;
+    fhos__jobs.worker_count = worker_count;
+    for(fhos_i32 i = 0; i < worker_count; i += 1) {
+        if(worker_contexts) { workers[i].ctx = worker_contexts[i]; }
+        workers[i].index = i;
+        workers[i].random_state = 0x9E3779B9u * (fhos_u32)(i + 1);
+    }
+    
+    fhos_i32 started_count = 0;
+    for(fhos_i32 i = 0; i < worker_count; i += 1) {
+        if(!fhos__thread_start(&workers[i].thread, fhos__job_worker_proc, workers + i)) { break; }
+        started_count += 1;
+    }
+    
+    // NOTE(Patrik): Workers that did not start keep an empty deque, only its own thread could fill it. Stealing
+    // from it finds nothing and fhos_stop_job_system only joins the ones that started.
+    fhos__jobs.started_count = started_count;
+    if(started_count == 0) {
+        fhos_free_memory(workers);
+        fhos__jobs.workers = 0;
+        fhos__jobs.worker_count = 0;
+        fhos_atomic_store_i32(&fhos__jobs.state, FHOS__JOBS_STATE_STOPPED, FHOS_MEMORY_ORDER_RELEASE);
+        return FHOS_FALSE;
+    }
+    
+    fhos_atomic_store_i32(&fhos__jobs.state, FHOS__JOBS_STATE_RUNNING, FHOS_MEMORY_ORDER_RELEASE);
+    return FHOS_TRUE;
+}
+
+// NOTE(Patrik): Jobs still queued are dropped, wait on their counters first.
+FHOS_API void
+fhos_stop_job_system(void) {
+    fhos_i32 state = FHOS__JOBS_STATE_RUNNING;
+    if(!fhos_atomic_compare_exchange_i32(&fhos__jobs.state, &state, FHOS__JOBS_STATE_STOPPING, FHOS_MEMORY_ORDER_ACQ_REL)) { return; }
+    
+    fhos_atomic_fetch_add_i32(&fhos__jobs.wake_sequence, 1, FHOS_MEMORY_ORDER_ACQ_REL);
+    fhos__futex_wake(&fhos__jobs.wake_sequence, FHOS_TRUE);
+    for(fhos_i32 i = 0; i < fhos__jobs.started_count; i += 1) { fhos__thread_join(&fhos__jobs.workers[i].thread); }
+    
+    fhos_free_memory(fhos__jobs.workers);
+    fhos_free_memory(fhos__jobs.shared_jobs);
+    
+    FHOS__Job_System zero_jobs = {0};
+    fhos__jobs = zero_jobs;
+}
+
+FHOS_API fhos_i32
+fhos_get_job_worker_index(void) {
+    FHOS__Job_Worker *worker = fhos__current_job_worker;
+    return (worker) ? worker->index : -1;
+}
+
+FHOS_API void
+fhos_run_job(FHOS_Context *ctx, FHOS_Job_Proc *proc, void *data, FHOS_Job_Counter *counter) {
+    if(!proc) {
+        FHOS_LOG_ERROR("fhos_run_job -> The parameter proc is null.\n");
+        return;
+    }
+    
+    if(fhos_atomic_load_i32(&fhos__jobs.state, FHOS_MEMORY_ORDER_ACQUIRE) != FHOS__JOBS_STATE_RUNNING) { fhos_start_job_system(0, 0); }
+    if(counter) { fhos_atomic_fetch_add_i64(&counter->pending_count, 1, FHOS_MEMORY_ORDER_ACQ_REL); }
+    
+    FHOS__Job job;
+    job.proc = proc;
+    job.data = data;
+    job.counter = counter;
+    
+    FHOS__Job_Worker *worker = fhos__current_job_worker;
+    fhos_bool is_queued = FHOS_FALSE;
+    if(fhos_atomic_load_i32(&fhos__jobs.state, FHOS_MEMORY_ORDER_ACQUIRE) == FHOS__JOBS_STATE_RUNNING) {
+        is_queued = (worker) ? fhos__push_job(worker, &job) : fhos__push_shared_job(&job);
+    }
+    
+    // NOTE(Patrik): With a full deque, no memory or no workers the job runs right here, with the context of
+    // the thread that submitted it.
+    if(!is_queued) {
+        FHOS_Context zero_ctx = {0};
+        if(!ctx) { ctx = (worker) ? &worker->ctx : &zero_ctx; }
+        fhos__finish_job(&job, ctx);
+        return;
+    }
+    fhos__wake_job_worker();
+}
+
+// NOTE(Patrik): Runs queued jobs while the counter is not done, and only sleeps when there are none to run.
+// The sleep is short so jobs queued meanwhile are still helped with.
+FHOS_API void
+fhos_wait_for_jobs(FHOS_Context *ctx, FHOS_Job_Counter *counter) {
+    if(!counter) { return; }
+    
+    FHOS_Context zero_ctx = {0};
+    if(!ctx) { ctx = &zero_ctx; }
+    
+    fhos_i32 idle_count = 0;
+    while(fhos_atomic_load_i64(&counter->pending_count, FHOS_MEMORY_ORDER_ACQUIRE) > 0) {
+        if(fhos__run_one_job(ctx)) {
+            idle_count = 0;
+            continue;
+        }
+        
+        idle_count += 1;
+        if(idle_count < 64) {
+            FHOS__CPU_PAUSE();
+            continue;
+        }
+        
+        fhos_i32 sequence = fhos_atomic_load_i32(&fhos__job_done_sequence, FHOS_MEMORY_ORDER_ACQUIRE);
+        fhos_atomic_fetch_add_i32(&fhos__job_waiting_count, 1, FHOS_MEMORY_ORDER_ACQ_REL);
+        if(fhos_atomic_load_i64(&counter->pending_count, FHOS_MEMORY_ORDER_ACQUIRE) > 0) { fhos__futex_wait(&fhos__job_done_sequence, sequence, 1); }
+        fhos_atomic_fetch_add_i32(&fhos__job_waiting_count, -1, FHOS_MEMORY_ORDER_ACQ_REL);
+    }
+}
+
+typedef struct FHOS__Parallel_For {
+    FHOS_Parallel_For_Proc *proc;
+    void *data;
+    fhos_i64 count;
+    fhos_i64 batch_size;
+    FHOS_Atomic_I64 next_index;
+} FHOS__Parallel_For;
+
+static void
+fhos__parallel_for_job_proc(FHOS_Context *ctx, void *data) {
+    FHOS__Parallel_For *loop = (FHOS__Parallel_For *)data;
+    for(;;) {
+        fhos_i64 start = fhos_atomic_fetch_add_i64(&loop->next_index, loop->batch_size, FHOS_MEMORY_ORDER_RELAXED);
+        if(start >= loop->count) { break; }
+        
+        fhos_i64 end = (start + loop->batch_size < loop->count) ? start + loop->batch_size : loop->count;
+        loop->proc(ctx, loop->data, start, end);
+    }
+}
+
+// NOTE(Patrik): Batches are handed out from a shared index, so uneven batches even out on their own. One job
+// per worker is enough, the calling thread takes batches as well.
+FHOS_API void
+fhos_parallel_for(FHOS_Context *ctx, fhos_i64 count, fhos_i64 batch_size, FHOS_Parallel_For_Proc *proc, void *data) {
+    if(!proc) {
+        FHOS_LOG_ERROR("fhos_parallel_for -> The parameter proc is null.\n");
+        return;
+    }
+    if(count <= 0) { return; }
+    if(batch_size <= 0) { batch_size = 1; }
+    
+    FHOS_Context zero_ctx = {0};
+    if(!ctx) { ctx = &zero_ctx; }
+    
+    FHOS__Parallel_For loop;
+    loop.proc = proc;
+    loop.data = data;
+    loop.count = count;
+    loop.batch_size = batch_size;
+    fhos_atomic_store_i64(&loop.next_index, 0, FHOS_MEMORY_ORDER_RELAXED);
+    
+    fhos_i64 batch_count = (count + batch_size - 1) / batch_size;
+    if(batch_count == 1) {
+        proc(ctx, data, 0, count);
+        return;
+    }
+    
+    if(fhos_atomic_load_i32(&fhos__jobs.state, FHOS_MEMORY_ORDER_ACQUIRE) != FHOS__JOBS_STATE_RUNNING) { fhos_start_job_system(0, 0); }
+    fhos_i64 job_count = (fhos__jobs.worker_count < batch_count - 1) ? fhos__jobs.worker_count : batch_count - 1;
+    
+    FHOS_Job_Counter counter = {0};
+    for(fhos_i64 i = 0; i < job_count; i += 1) { fhos_run_job(ctx, fhos__parallel_for_job_proc, &loop, &counter); }
+    fhos__parallel_for_job_proc(ctx, &loop);
+    fhos_wait_for_jobs(ctx, &counter);
+}
+
+typedef struct FHOS__Thread_Job {
+    FHOS__Thread_Proc *proc;
+    void *data;
+} FHOS__Thread_Job;
+
+static void
+fhos__thread_job_proc(FHOS_Context *ctx, void *data) {
+    (void)ctx;
+    FHOS__Thread_Job *job = (FHOS__Thread_Job *)data;
+    job->proc(job->data);
+}
+
+// NOTE(Patrik): Runs proc as thread_count jobs at once, the calling thread running one of them, and returns
+// when all of them are done. There are never more running at the same time than there are workers
+// plus the caller, the procs pull their work from a shared index so that does not matter.
+static void
+fhos__run_on_threads(FHOS__Thread_Proc *proc, void *data, fhos_i32 thread_count) {
+    if(thread_count > FHOS__MAX_THREAD_COUNT) { thread_count = FHOS__MAX_THREAD_COUNT; }
+    
+    FHOS__Thread_Job job;
+    job.proc = proc;
+    job.data = data;
+    
+    FHOS_Job_Counter counter = {0};
+    for(fhos_i32 i = 1; i < thread_count; i += 1) { fhos_run_job(0, fhos__thread_job_proc, &job, &counter); }
+    proc(data);
+    fhos_wait_for_jobs(0, &counter);
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// LOG
+//
+#if defined(FHOS_ASYNC_LOG)
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+// NOTE(Patrik): A record is longer than this only when it carries long strings, those get cut short.
+#define FHOS__LOG_MAX_RECORD_SIZE 1024
+
+enum {
+    FHOS__LOG_STATE_STOPPED = 0,
+    FHOS__LOG_STATE_STARTING = 1,
+    FHOS__LOG_STATE_RUNNING = 2,
+    // NOTE(Patrik): The thread could not be started, every call flushes right away instead.
+    FHOS__LOG_STATE_SYNCHRONOUS = 3,
+};
+
+enum {
+    FHOS__LOG_ARGUMENT_NONE,
+    FHOS__LOG_ARGUMENT_INT,
+    FHOS__LOG_ARGUMENT_LONG,
+    FHOS__LOG_ARGUMENT_LONG_LONG,
+    FHOS__LOG_ARGUMENT_SIZE,
+    FHOS__LOG_ARGUMENT_POINTER,
+    FHOS__LOG_ARGUMENT_DOUBLE,
+    FHOS__LOG_ARGUMENT_LONG_DOUBLE,
+    FHOS__LOG_ARGUMENT_STRING,
+};
+
+// NOTE(Patrik): One conversion of a printf format, everything between the % and the conversion character.
+typedef struct FHOS__Log_Conversion {
+    const char *start;
+    const char *end;
+    fhos_bool has_star_width;
+    fhos_bool has_star_precision;
+    fhos_i32 precision;
+    fhos_i32 argument_type;
+} FHOS__Log_Conversion;
+
+// NOTE(Patrik): Written by one thread and read by the log thread. Records are 8 byte aligned and never wrap,
+// a record size of zero means the rest of the ring was skipped. When its thread exits the ring is
+// marked free and the next new thread takes it over, records still in it are printed as usual.
+typedef struct FHOS__Log_Ring {
+    struct FHOS__Log_Ring *next;
+    fhos_u8 *data;
+    FHOS_Atomic_I64 write_position;
+    FHOS_Atomic_I32 is_free;
+    fhos_u8 padding0[36];
+    FHOS_Atomic_I64 read_position;
+    FHOS_Atomic_I32 dropped_count;
+    fhos_u8 padding1[52];
+} FHOS__Log_Ring;
+
+typedef struct FHOS__Log_Record_Header {
+    fhos_u32 size;
+    fhos_u32 line;
+    const char *file;
+    const char *format;
+} FHOS__Log_Record_Header;
+
+static FHOS__THREAD_LOCAL FHOS__Log_Ring *fhos__thread_log_ring;
+static FHOS_Atomic_Pointer fhos__log_rings;
+static FHOS_Atomic_I32 fhos__log_state;
+static FHOS_Atomic_I32 fhos__log_wake_sequence;
+static FHOS_Atomic_I32 fhos__log_is_idle;
+static FHOS__Thread_Exit_Hook fhos__log_exit_hook;
+static FHOS_Mutex fhos__log_mutex;
+static FHOS__Thread fhos__log_thread;
+
+// NOTE(Patrik): Returns where the format continues after the conversion. Only the parts printf needs to know
+// the size of the argument are looked at, the rest is handed to printf as is.
+static const char *
+fhos__parse_log_conversion(const char *format, FHOS__Log_Conversion *conversion) {
+    FHOS__Log_Conversion zero_conversion = {0};
+    *conversion = zero_conversion;
+    conversion->start = format;
+    conversion->precision = -1;
+    
+    const char *at = format + 1;
+    while(*at == '-' || *at == '+' || *at == ' ' || *at == '#' || *at == '0') { at += 1; }
+    if(*at == '*') {
+        conversion->has_star_width = FHOS_TRUE;
+        at += 1;
+    } else {
+        while(*at >= '0' && *at <= '9') { at += 1; }
+    }
+    if(*at == '.') {
+        at += 1;
+        conversion->precision = 0;
+        if(*at == '*') {
+            conversion->has_star_precision = FHOS_TRUE;
+            at += 1;
+        } else {
+            while(*at >= '0' && *at <= '9') { conversion->precision = conversion->precision * 10 + (*at - '0'); at += 1; }
+        }
+    }
+    
+    fhos_i32 integer_type = FHOS__LOG_ARGUMENT_INT;
+    fhos_bool is_long_double = FHOS_FALSE;
+    for(;;) {
+        if(*at == 'h') { at += 1; }
+        else if(*at == 'l' && at[1] == 'l') { integer_type = FHOS__LOG_ARGUMENT_LONG_LONG; at += 2; }
+        else if(*at == 'l') { integer_type = FHOS__LOG_ARGUMENT_LONG; at += 1; }
+        else if(*at == 'z' || *at == 't') { integer_type = FHOS__LOG_ARGUMENT_SIZE; at += 1; }
+        else if(*at == 'j') { integer_type = FHOS__LOG_ARGUMENT_LONG_LONG; at += 1; }
+        else if(*at == 'L') { is_long_double = FHOS_TRUE; at += 1; }
+        else { break; }
+    }
+    
+    switch(*at) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c': {
+            conversion->argument_type = integer_type;
+        } break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+            conversion->argument_type = (is_long_double) ? FHOS__LOG_ARGUMENT_LONG_DOUBLE : FHOS__LOG_ARGUMENT_DOUBLE;
+        } break;
+        case 's': { conversion->argument_type = FHOS__LOG_ARGUMENT_STRING; } break;
+        case 'p': case 'n': { conversion->argument_type = FHOS__LOG_ARGUMENT_POINTER; } break;
+        default: { conversion->argument_type = FHOS__LOG_ARGUMENT_NONE; } break;
+    }
+    
+    if(*at) { at += 1; }
+    conversion->end = at;
+    return at;
+}
+
+static void
+fhos__write_log_output(const FHOS__Log_Record_Header *header, const fhos_u8 *arguments, const fhos_u8 *arguments_end) {
+    char line[FHOS__LOG_MAX_RECORD_SIZE * 2];
+    fhos_i64 length = snprintf(line, sizeof(line), "%s(%u): [ERROR] ", header->file, header->line);
+    fhos_i64 capacity = (fhos_i64)sizeof(line);
+    
+    // NOTE(Patrik): Each conversion is printed on its own, with any * replaced by the number that was stored for it.
+    const char *format = header->format;
+    while(*format && length < capacity - 1) {
+        if(*format != '%' || format[1] == '%') {
+            line[length] = *format;
+            length += 1;
+            format += (*format == '%') ? 2 : 1;
+            continue;
+        }
+        
+        FHOS__Log_Conversion conversion;
+        format = fhos__parse_log_conversion(format, &conversion);
+        
+        char specification[64];
+        fhos_i32 specification_length = 0;
+        for(const char *at = conversion.start; at < conversion.end && specification_length < 40; at += 1) {
+            if(*at == '*' || *at == 'L' || *at == 'n') {
+                if(*at == '*' && arguments + 8 <= arguments_end) {
+                    fhos_i64 value = 0;
+                    for(fhos_i32 i = 0; i < 8; i += 1) { ((fhos_u8 *)&value)[i] = arguments[i]; }
+                    arguments += 8;
+                    specification_length += snprintf(specification + specification_length, 16, "%d", (int)value);
+                }
+                continue;
+            }
+            specification[specification_length] = *at;
+            specification_length += 1;
+        }
+        specification[specification_length] = 0;
+        
+        fhos_i64 remaining = capacity - length;
+        fhos_i64 written = 0;
+        if(conversion.argument_type == FHOS__LOG_ARGUMENT_STRING) {
+            fhos_u32 string_length = 0;
+            if(arguments + 4 <= arguments_end) {
+                for(fhos_i32 i = 0; i < 4; i += 1) { ((fhos_u8 *)&string_length)[i] = arguments[i]; }
+                written = snprintf(line + length, (size_t)remaining, specification, (const char *)arguments + 4);
+                arguments += (4 + string_length + 1 + 7) & ~7;
+            }
+        } else if(conversion.argument_type != FHOS__LOG_ARGUMENT_NONE && arguments + 8 <= arguments_end) {
+            fhos_u64 bits = 0;
+            for(fhos_i32 i = 0; i < 8; i += 1) { ((fhos_u8 *)&bits)[i] = arguments[i]; }
+            arguments += 8;
+            
+            switch(conversion.argument_type) {
+                case FHOS__LOG_ARGUMENT_INT:       { written = snprintf(line + length, (size_t)remaining, specification, (int)bits); } break;
+                case FHOS__LOG_ARGUMENT_LONG:      { written = snprintf(line + length, (size_t)remaining, specification, (long)bits); } break;
+                case FHOS__LOG_ARGUMENT_LONG_LONG: { written = snprintf(line + length, (size_t)remaining, specification, (long long)bits); } break;
+                case FHOS__LOG_ARGUMENT_SIZE:      { written = snprintf(line + length, (size_t)remaining, specification, (size_t)bits); } break;
+                case FHOS__LOG_ARGUMENT_DOUBLE:
+                case FHOS__LOG_ARGUMENT_LONG_DOUBLE: {
+                    double value;
+                    for(fhos_i32 i = 0; i < 8; i += 1) { ((fhos_u8 *)&value)[i] = ((fhos_u8 *)&bits)[i]; }
+                    written = snprintf(line + length, (size_t)remaining, specification, value);
+                } break;
+                case FHOS__LOG_ARGUMENT_POINTER: {
+                    if(conversion.end[-1] == 'p') { written = snprintf(line + length, (size_t)remaining, specification, (void *)(fhos_isize)bits); }
+                } break;
+            }
+        }
+        
+        if(written > 0) { length += (written < remaining) ? written : remaining - 1; }
+    }
+    
+    if(length > capacity - 1) { length = capacity - 1; }
+    fwrite(line, 1, (size_t)length, stdout);
+}
+
+FHOS_API void
+fhos_flush_log(void) {
+    if(fhos_atomic_load_i32(&fhos__log_state, FHOS_MEMORY_ORDER_ACQUIRE) < FHOS__LOG_STATE_RUNNING) { return; }
+    
+    fhos_lock_mutex(&fhos__log_mutex);
+    fhos_bool has_written = FHOS_FALSE;
+    
+    FHOS__Log_Ring *ring = (FHOS__Log_Ring *)fhos_atomic_load_pointer(&fhos__log_rings, FHOS_MEMORY_ORDER_ACQUIRE);
+    for(; ring; ring = ring->next) {
+        fhos_i64 read_position = fhos_atomic_load_i64(&ring->read_position, FHOS_MEMORY_ORDER_RELAXED);
+        fhos_i64 write_position = fhos_atomic_load_i64(&ring->write_position, FHOS_MEMORY_ORDER_ACQUIRE);
+        
+        while(read_position < write_position) {
+            fhos_i64 offset = read_position & (FHOS_ASYNC_LOG_RING_CAPACITY - 1);
+            const FHOS__Log_Record_Header *header = (const FHOS__Log_Record_Header *)(ring->data + offset);
+            if(header->size == 0) {
+                read_position += FHOS_ASYNC_LOG_RING_CAPACITY - offset;
+                continue;
+            }
+            
+            const fhos_u8 *arguments = (const fhos_u8 *)(header + 1);
+            fhos__write_log_output(header, arguments, ring->data + offset + header->size);
+            read_position += header->size;
+            has_written = FHOS_TRUE;
+        }
+        fhos_atomic_store_i64(&ring->read_position, read_position, FHOS_MEMORY_ORDER_RELEASE);
+        
+        fhos_i32 dropped_count = fhos_atomic_load_i32(&ring->dropped_count, FHOS_MEMORY_ORDER_RELAXED);
+        if(dropped_count > 0) {
+            fhos_atomic_fetch_add_i32(&ring->dropped_count, -dropped_count, FHOS_MEMORY_ORDER_RELAXED);
+            fprintf(stdout, "[ERROR] %d log messages were dropped, the log could not keep up.\n", dropped_count);
+            has_written = FHOS_TRUE;
+        }
+    }
+    
+    if(has_written) { fflush(stdout); }
+    fhos_unlock_mutex(&fhos__log_mutex);
+}
+
+static fhos_bool
+fhos__is_log_pending(void) {
+    FHOS__Log_Ring *ring = (FHOS__Log_Ring *)fhos_atomic_load_pointer(&fhos__log_rings, FHOS_MEMORY_ORDER_ACQUIRE);
+    for(; ring; ring = ring->next) {
+        if(fhos_atomic_load_i64(&ring->read_position, FHOS_MEMORY_ORDER_ACQUIRE) != fhos_atomic_load_i64(&ring->write_position, FHOS_MEMORY_ORDER_ACQUIRE)) { return FHOS_TRUE; }
+        if(fhos_atomic_load_i32(&ring->dropped_count, FHOS_MEMORY_ORDER_RELAXED) != 0) { return FHOS_TRUE; }
+    }
+    return FHOS_FALSE;
+}
+
+static void
+fhos__log_thread_proc(void *data) {
+    (void)data;
+    for(;;) {
+        fhos_i32 seen_sequence = fhos_atomic_load_i32(&fhos__log_wake_sequence, FHOS_MEMORY_ORDER_ACQUIRE);
+        fhos_flush_log();
+        
+        // NOTE(Patrik): With nothing left to print the thread sleeps until the first record wakes it, and then
+        // waits as usual so the records after it are printed together. The flag is set before the rings
+        // are looked at and fhos_log_async checks it after writing, so one of them sees the other.
+        // Only that one wake is counted as seen, one for the halfway mark still cuts the wait short.
+        fhos_atomic_store_i32(&fhos__log_is_idle, 1, FHOS_MEMORY_ORDER_RELEASE);
+        fhos_atomic_fence(FHOS_MEMORY_ORDER_SEQ_CST);
+        if(!fhos__is_log_pending()) {
+            fhos__futex_wait(&fhos__log_wake_sequence, seen_sequence, -1);
+            seen_sequence += 1;
+        }
+        fhos_atomic_store_i32(&fhos__log_is_idle, 0, FHOS_MEMORY_ORDER_RELEASE);
+        fhos__futex_wait(&fhos__log_wake_sequence, seen_sequence, FHOS_ASYNC_LOG_FLUSH_MILLISECONDS);
+    }
+}
+
+static void
+fhos__flush_log_at_exit(void) {
+    fhos_flush_log();
+}
+
+static void
+fhos__wake_log_thread(void) {
+    fhos_atomic_fetch_add_i32(&fhos__log_wake_sequence, 1, FHOS_MEMORY_ORDER_ACQ_REL);
+    fhos__futex_wake(&fhos__log_wake_sequence, FHOS_FALSE);
+}
+
+static FHOS__THREAD_EXIT_PROC(fhos__release_thread_log_ring) {
+    FHOS__Log_Ring *ring = (FHOS__Log_Ring *)data;
+    if(fhos__thread_log_ring == ring) { fhos__thread_log_ring = 0; }
+    fhos_atomic_store_i32(&ring->is_free, 1, FHOS_MEMORY_ORDER_RELEASE);
+}
+
+static FHOS__Log_Ring *
+fhos__get_thread_log_ring(void) {
+    fhos_i32 state = fhos_atomic_load_i32(&fhos__log_state, FHOS_MEMORY_ORDER_ACQUIRE);
+    if(state < FHOS__LOG_STATE_RUNNING) {
+        if(state == FHOS__LOG_STATE_STOPPED && fhos_atomic_compare_exchange_i32(&fhos__log_state, &state, FHOS__LOG_STATE_STARTING, FHOS_MEMORY_ORDER_ACQ_REL)) {
+            atexit(fhos__flush_log_at_exit);
+            fhos_atomic_store_i32(&fhos__log_state, FHOS__LOG_STATE_SYNCHRONOUS, FHOS_MEMORY_ORDER_RELEASE);
+            if(fhos__thread_start(&fhos__log_thread, fhos__log_thread_proc, 0)) { fhos_atomic_store_i32(&fhos__log_state, FHOS__LOG_STATE_RUNNING, FHOS_MEMORY_ORDER_RELEASE); }
+        }
+        while(fhos_atomic_load_i32(&fhos__log_state, FHOS_MEMORY_ORDER_ACQUIRE) == FHOS__LOG_STATE_STARTING) { fhos__thread_yield(); }
+    }
+    
+    // NOTE(Patrik): Rings are never freed, the log thread could be reading one when its thread exits. They are
+    // handed to the next new thread instead.
+    FHOS__Log_Ring *ring = fhos__thread_log_ring;
+    if(!ring) {
+        for(ring = (FHOS__Log_Ring *)fhos_atomic_load_pointer(&fhos__log_rings, FHOS_MEMORY_ORDER_ACQUIRE); ring; ring = ring->next) {
+            fhos_i32 is_free = fhos_atomic_load_i32(&ring->is_free, FHOS_MEMORY_ORDER_RELAXED);
+            if(is_free && fhos_atomic_compare_exchange_i32(&ring->is_free, &is_free, 0, FHOS_MEMORY_ORDER_ACQUIRE)) { break; }
+        }
+        
+        if(!ring) {
+            ring = (FHOS__Log_Ring *)fhos_allocate_memory(sizeof(FHOS__Log_Ring) + FHOS_ASYNC_LOG_RING_CAPACITY);
+            if(!ring) { return 0; }
+            ring->data = (fhos_u8 *)(ring + 1);
+            
+            void *head = fhos_atomic_load_pointer(&fhos__log_rings, FHOS_MEMORY_ORDER_RELAXED);
+            do {
+                ring->next = (FHOS__Log_Ring *)head;
+            } while(!fhos_atomic_compare_exchange_pointer(&fhos__log_rings, &head, ring, FHOS_MEMORY_ORDER_RELEASE));
+        }
+        fhos__thread_log_ring = ring;
+        fhos__set_thread_exit_data(&fhos__log_exit_hook, fhos__release_thread_log_ring, ring);
+    }
+    return ring;
+}
+
+FHOS_API void
+fhos_log_async(const char *file, int line, const char *format, ...) {
+    FHOS__Log_Ring *ring = fhos__get_thread_log_ring();
+    if(!ring) { return; }
+    
+    // NOTE(Patrik): Arguments are stored as 8 bytes each, strings are copied since they often live on the
+    // caller's stack. Everything is formatted later on the log thread.
+    fhos_u8 record[FHOS__LOG_MAX_RECORD_SIZE];
+    FHOS__Log_Record_Header *header = (FHOS__Log_Record_Header *)record;
+    header->line = (fhos_u32)line;
+    header->file = file;
+    header->format = format;
+    fhos_i64 size = sizeof(FHOS__Log_Record_Header);
+    
+    va_list arguments;
+    va_start(arguments, format);
+    for(const char *at = format; *at; ) {
+        if(*at != '%') { at += 1; continue; }
+        if(at[1] == '%') { at += 2; continue; }
+        
+        FHOS__Log_Conversion conversion;
+        at = fhos__parse_log_conversion(at, &conversion);
+        
+        fhos_i32 star_count = (conversion.has_star_width) + (conversion.has_star_precision);
+        for(fhos_i32 i = 0; i < star_count; i += 1) {
+            fhos_i64 value = va_arg(arguments, int);
+            if(i == star_count - 1 && conversion.has_star_precision) { conversion.precision = (fhos_i32)value; }
+            if(size + 8 <= FHOS__LOG_MAX_RECORD_SIZE) { for(fhos_i32 j = 0; j < 8; j += 1) { record[size + j] = ((fhos_u8 *)&value)[j]; } }
+            size += 8;
+        }
+        
+        fhos_u64 bits = 0;
+        switch(conversion.argument_type) {
+            case FHOS__LOG_ARGUMENT_NONE: { continue; } break;
+            case FHOS__LOG_ARGUMENT_INT:       { bits = (fhos_u64)(fhos_i64)va_arg(arguments, int); } break;
+            case FHOS__LOG_ARGUMENT_LONG:      { bits = (fhos_u64)(fhos_i64)va_arg(arguments, long); } break;
+            case FHOS__LOG_ARGUMENT_LONG_LONG: { bits = (fhos_u64)va_arg(arguments, long long); } break;
+            case FHOS__LOG_ARGUMENT_SIZE:      { bits = (fhos_u64)va_arg(arguments, size_t); } break;
+            case FHOS__LOG_ARGUMENT_POINTER:   { bits = (fhos_u64)(fhos_isize)va_arg(arguments, void *); } break;
+            case FHOS__LOG_ARGUMENT_DOUBLE: {
+                double value = va_arg(arguments, double);
+                for(fhos_i32 i = 0; i < 8; i += 1) { ((fhos_u8 *)&bits)[i] = ((fhos_u8 *)&value)[i]; }
+            } break;
+            case FHOS__LOG_ARGUMENT_LONG_DOUBLE: {
+                // NOTE(Patrik): Stored and printed as a double, the L is left out of the format when printing.
+                double value = (double)va_arg(arguments, long double);
+                for(fhos_i32 i = 0; i < 8; i += 1) { ((fhos_u8 *)&bits)[i] = ((fhos_u8 *)&value)[i]; }
+            } break;
+            case FHOS__LOG_ARGUMENT_STRING: {
+                const char *string = va_arg(arguments, const char *);
+                if(!string) { string = "(null)"; }
+                
+                // NOTE(Patrik): With a precision the string does not have to be terminated, so never read past it.
+                fhos_i64 budget = FHOS__LOG_MAX_RECORD_SIZE - size - 5;
+                fhos_u32 string_length = 0;
+                while((conversion.precision < 0 || (fhos_i32)string_length < conversion.precision) &&
+                      (fhos_i64)string_length < budget && string[string_length]) {
+                    string_length += 1;
+                }
+                if(budget >= 0) {
+                    for(fhos_i32 j = 0; j < 4; j += 1) { record[size + j] = ((fhos_u8 *)&string_length)[j]; }
+                    for(fhos_u32 j = 0; j < string_length; j += 1) { record[size + 4 + j] = (fhos_u8)string[j]; }
+                    record[size + 4 + string_length] = 0;
+                }
+                size += (4 + string_length + 1 + 7) & ~7;
+            } continue;
+        }
+        
+        if(size + 8 <= FHOS__LOG_MAX_RECORD_SIZE) { for(fhos_i32 j = 0; j < 8; j += 1) { record[size + j] = ((fhos_u8 *)&bits)[j]; } }
+        size += 8;
+    }
+    va_end(arguments);
+    
+    if(size > FHOS__LOG_MAX_RECORD_SIZE) { size = FHOS__LOG_MAX_RECORD_SIZE; }
+    size = (size + 7) & ~(fhos_i64)7;
+    header->size = (fhos_u32)size;
+    
+    // NOTE(Patrik): A record that does not fit before the end of the ring skips ahead to the start.
+    fhos_i64 position = fhos_atomic_load_i64(&ring->write_position, FHOS_MEMORY_ORDER_RELAXED);
+    fhos_i64 offset = position & (FHOS_ASYNC_LOG_RING_CAPACITY - 1);
+    fhos_i64 skip_size = (offset + size > FHOS_ASYNC_LOG_RING_CAPACITY) ? FHOS_ASYNC_LOG_RING_CAPACITY - offset : 0;
+    while(position + skip_size + size - fhos_atomic_load_i64(&ring->read_position, FHOS_MEMORY_ORDER_ACQUIRE) > FHOS_ASYNC_LOG_RING_CAPACITY) {
+#if defined(FHOS_ASYNC_LOG_BLOCK_WHEN_FULL)
+        if(fhos_atomic_load_i32(&fhos__log_state, FHOS_MEMORY_ORDER_ACQUIRE) == FHOS__LOG_STATE_SYNCHRONOUS) {
+            fhos_flush_log();
+        } else {
+            fhos__wake_log_thread();
+            fhos__thread_yield();
+        }
+#else
+        fhos_atomic_fetch_add_i32(&ring->dropped_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+        fhos__wake_log_thread();
+        return;
+#endif
+    }
+    
+    if(skip_size > 0) {
+        *(fhos_u32 *)(ring->data + offset) = 0;
+        position += skip_size;
+        offset = 0;
+    }
+    for(fhos_i64 i = 0; i < size; i += 1) { ring->data[offset + i] = record[i]; }
+    fhos_atomic_store_i64(&ring->write_position, position + size, FHOS_MEMORY_ORDER_RELEASE);
+    
+    if(fhos_atomic_load_i32(&fhos__log_state, FHOS_MEMORY_ORDER_ACQUIRE) == FHOS__LOG_STATE_SYNCHRONOUS) {
+        fhos_flush_log();
+    } else {
+        // NOTE(Patrik): An idle log thread is woken by the first record after it went to sleep. Otherwise only
+        // the record that crosses the halfway mark wakes it, the ones after it would just pay for
+        // another system call.
+        fhos_atomic_fence(FHOS_MEMORY_ORDER_SEQ_CST);
+        fhos_i64 used = position + size - fhos_atomic_load_i64(&ring->read_position, FHOS_MEMORY_ORDER_ACQUIRE);
+        fhos_i64 half = FHOS_ASYNC_LOG_RING_CAPACITY / 2;
+        if(fhos_atomic_load_i32(&fhos__log_is_idle, FHOS_MEMORY_ORDER_ACQUIRE) && fhos_atomic_exchange_i32(&fhos__log_is_idle, 0, FHOS_MEMORY_ORDER_ACQ_REL)) {
+            fhos__wake_log_thread();
+        } else if(used > half && used - size - skip_size <= half) {
+            fhos__wake_log_thread();
+        }
+    }
+}
+#else
+FHOS_API void
+fhos_flush_log(void) {
+}
+#endif
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// IO
+//
+FHOS_API FHOS_File_Handle
+fhos_get_invalid_file_handle(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    FHOS_File_Handle result = { (void *)(fhos_isize)INVALID_HANDLE_VALUE };
+#elif defined(__linux__)
+    FHOS_File_Handle result = { (void *)(fhos_isize)-1 };
+#else
+#  error Unimplemented on this platform.
+#endif
+    return result;
+}
+
+FHOS_API fhos_bool
+fhos_is_file_handle_valid(FHOS_File_Handle handle) {
+#if defined(_WIN32) || defined(_WIN64)
+    return ((HANDLE)handle.data != INVALID_HANDLE_VALUE);
+#elif defined(__linux__)
+    return ((fhos_isize)handle.data >= 0);
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+FHOS_API fhos_bool
+fhos_close_file(FHOS_File_Handle handle) {
+    if(!fhos_is_file_handle_valid(handle)) { return FHOS_FALSE; }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    if(!CloseHandle((HANDLE)handle.data)) {
+        FHOS_LOG_ERROR("Could not close file handle (%lu)\n", GetLastError());
+        return FHOS_FALSE;
+    }
+    return FHOS_TRUE;
+#elif defined(__linux__)
+    if(close((int)(fhos_isize)handle.data) != 0) {
+        FHOS_LOG_ERROR("Could not close file handle (%d)\n", errno);
+        return FHOS_FALSE;
+    }
+    return FHOS_TRUE;
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+FHOS_API FHOS_File_Handle
+fhos_open_file_for_reading(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
+    return fhos_open_file_for_reading_with_hint(ctx, path_data, path_length, FHOS_ACCESS_HINT_NORMAL);
+}
+
+FHOS_API FHOS_File_Handle
+fhos_open_file_for_reading_with_hint(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, FHOS_Access_Hint hint) {
+    FHOS_File_Handle result = fhos_get_invalid_file_handle();
+    
+    if(!path_data) {
+        FHOS_LOG_ERROR("Trying to read from a file with a null path.\n");
+        return result;
+    }
+    
+    if(path_length == 0) {
+        FHOS_LOG_ERROR("Trying to read from a file with an empty path.\n");
+        return result;
+    }
+    
+    FHOS__ALLOC_PATH(ctx, path_data, path_length);
+    if(!path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return result;
+    }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    // NOTE(Patrik): Windows only takes the readahead hints when the file is opened.
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if(hint == FHOS_ACCESS_HINT_SEQUENTIAL) { flags |= FILE_FLAG_SEQUENTIAL_SCAN; }
+    if(hint == FHOS_ACCESS_HINT_RANDOM) { flags |= FILE_FLAG_RANDOM_ACCESS; }
+    result.data = (void *)CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+                                      flags, 0);
+#elif defined(__linux__)
+    result.data = (void *)(fhos_isize)open(path, O_RDONLY | O_CLOEXEC);
+    if(hint != FHOS_ACCESS_HINT_NORMAL && fhos_is_file_handle_valid(result)) { fhos_advise_file(result, 0, 0, hint); }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    FHOS__FREE_PATH(ctx, path_data, path_length);
+    
+    return result;
+}
+
+FHOS_API FHOS_File_Handle
+fhos_open_file_for_writing_with_size_hint(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, fhos_i64 expected_size) {
+    FHOS_File_Handle result = fhos_open_file_for_writing(ctx, path_data, path_length);
+    if(expected_size > 0 && fhos_is_file_handle_valid(result)) { fhos_preallocate_file(result, expected_size); }
+    return result;
+}
+
+FHOS_API FHOS_File_Handle
+fhos_open_file_for_writing(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
+    FHOS_File_Handle result = fhos_get_invalid_file_handle();
+    
+    if(!path_data) {
+        FHOS_LOG_ERROR("Trying to write from a file with a null path\n");
+        return result;
+    }
+    
+    if(path_length == 0) {
+        FHOS_LOG_ERROR("Trying to write from a file with an empty path\n");
+        return result;
+    }
+    
+    FHOS__ALLOC_PATH(ctx, path_data, path_length);
+    if(!path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return result;
+    }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    // TODO(Patrik): Flags for file access?
+    result.data = (void *)CreateFileA(path, GENERIC_WRITE, 0, 0, CREATE_ALWAYS,
+                                      FILE_ATTRIBUTE_NORMAL, 0);
+#elif defined(__linux__)
+    result.data = (void *)(fhos_isize)open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    FHOS__FREE_PATH(ctx, path_data, path_length);
+    
+    return result;
+}
+
+FHOS_API fhos_i64
+fhos_get_size_of_file(FHOS_File_Handle handle) {
+    if(!fhos_is_file_handle_valid(handle)) { return FHOS_ERROR_INVALID_FILE_HANDLE; }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    LARGE_INTEGER file_size;
+    if(!GetFileSizeEx((HANDLE)handle.data, &file_size)) {
+        FHOS_LOG_ERROR("Could not get file size. (%lu)\n", GetLastError());
+        return -1;
+    }
+    return file_size.QuadPart;
+#elif defined(__linux__)
+    struct stat file_stat;
+    if(fstat((int)(fhos_isize)handle.data, &file_stat) != 0) {
+        FHOS_LOG_ERROR("Could not get file size. (%d)\n", errno);
+        return -1;
+    }
+    return (fhos_i64)file_stat.st_size;
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+FHOS_API fhos_bool
+fhos_advise_file(FHOS_File_Handle handle, fhos_i64 offset, fhos_i64 length, FHOS_Access_Hint hint) {
+    if(!fhos_is_file_handle_valid(handle)) { return FHOS_FALSE; }
+    if(offset < 0 || length < 0) {
+        FHOS_LOG_ERROR("fhos_advise_file -> The range is negative.\n");
+        return FHOS_FALSE;
+    }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    // NOTE(Patrik): There is no way to change the hints of an open handle, see fhos_open_file_for_reading_with_hint.
+    return FHOS_TRUE;
+#elif defined(__linux__)
+    int advice = POSIX_FADV_NORMAL;
+    switch(hint) {
+        case FHOS_ACCESS_HINT_NORMAL:     advice = POSIX_FADV_NORMAL;     break;
+        case FHOS_ACCESS_HINT_SEQUENTIAL: advice = POSIX_FADV_SEQUENTIAL; break;
+        case FHOS_ACCESS_HINT_RANDOM:     advice = POSIX_FADV_RANDOM;     break;
+        case FHOS_ACCESS_HINT_WILLNEED:   advice = POSIX_FADV_WILLNEED;   break;
+        case FHOS_ACCESS_HINT_DONTNEED:   advice = POSIX_FADV_DONTNEED;   break;
+        default: {
+            FHOS_LOG_ERROR("fhos_advise_file -> Unknown hint %d.\n", (int)hint);
+            return FHOS_FALSE;
+        }
+    }
+    
+    int error = posix_fadvise((int)(fhos_isize)handle.data, (off_t)offset, (off_t)length, advice);
+    if(error != 0) {
+        FHOS_LOG_ERROR("(%d) Could not advise the file.\n", error);
+        return FHOS_FALSE;
+    }
+    return FHOS_TRUE;
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+#if defined(__linux__)
+// NOTE(Patrik): Returns 0 or the errno. posix_fallocate is not used since it falls back to writing zeros,
+// which costs a full extra write.
+static int
+fhos__fallocate(int fd, fhos_i64 size) {
+    int error = 0;
+    do {
+        error = (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)size) == 0) ? 0 : errno;
+    } while(error == EINTR);
+    return error;
+}
+#endif
+
+FHOS_API fhos_bool
+fhos_preallocate_file(FHOS_File_Handle handle, fhos_i64 size) {
+    if(!fhos_is_file_handle_valid(handle)) { return FHOS_FALSE; }
+    if(size <= 0) { return FHOS_TRUE; }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    FILE_ALLOCATION_INFO allocation_info;
+    allocation_info.AllocationSize.QuadPart = size;
+    if(!SetFileInformationByHandle((HANDLE)handle.data, FileAllocationInfo, &allocation_info, sizeof(allocation_info))) {
+        FHOS_LOG_ERROR("(%lu) Could not preallocate the file.\n", GetLastError());
+        return FHOS_FALSE;
+    }
+    return FHOS_TRUE;
+#elif defined(__linux__)
+    int error = fhos__fallocate((int)(fhos_isize)handle.data, size);
+    if(error != 0) {
+        if(error != EOPNOTSUPP && error != ENOSYS) { FHOS_LOG_ERROR("(%d) Could not preallocate the file.\n", error); }
+        return FHOS_FALSE;
+    }
+    return FHOS_TRUE;
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+FHOS_API fhos_bool
+fhos_advise_memory(const void *data, fhos_i64 length, FHOS_Access_Hint hint) {
+    if(!data) {
+        FHOS_LOG_ERROR("fhos_advise_memory -> The parameter data is null.\n");
+        return FHOS_FALSE;
+    }
+    if(length <= 0) { return FHOS_TRUE; }
+    
+#if defined(_WIN32) || defined(_WIN64)
+#  if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+    if(hint == FHOS_ACCESS_HINT_WILLNEED) {
+        WIN32_MEMORY_RANGE_ENTRY range = { (void *)data, (SIZE_T)length };
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#  endif
+    return FHOS_TRUE;
+#elif defined(__linux__)
+    int advice = MADV_NORMAL;
+    switch(hint) {
+        case FHOS_ACCESS_HINT_NORMAL:     advice = MADV_NORMAL;     break;
+        case FHOS_ACCESS_HINT_SEQUENTIAL: advice = MADV_SEQUENTIAL; break;
+        case FHOS_ACCESS_HINT_RANDOM:     advice = MADV_RANDOM;     break;
+        case FHOS_ACCESS_HINT_WILLNEED:   advice = MADV_WILLNEED;   break;
+        case FHOS_ACCESS_HINT_DONTNEED:   advice = MADV_DONTNEED;   break;
+        default: {
+            FHOS_LOG_ERROR("fhos_advise_memory -> Unknown hint %d.\n", (int)hint);
+            return FHOS_FALSE;
+        }
+    }
+    
+    // NOTE(Patrik): madvise wants a page aligned start, round down and grow the length to match.
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = (size_t)data & ~(page_size - 1);
+    size_t end = (size_t)data + (size_t)length;
+    if(madvise((void *)start, end - start, advice) != 0) {
+        FHOS_LOG_ERROR("(%d) Could not advise the memory.\n", errno);
+        return FHOS_FALSE;
+    }
+    return FHOS_TRUE;
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+FHOS_API fhos_i64
+fhos_read_file(FHOS_Context *ctx, FHOS_File_Handle handle, fhos_u8 *data, fhos_i64 read_amount) {
+    if(!fhos_is_file_handle_valid(handle)) {
+        FHOS_LOG_ERROR("Trying to read from an invalid file handle.\n");
+        return FHOS_ERROR_INVALID_FILE_HANDLE;
+    }
+    
+    if(!data) {
+        FHOS_LOG_ERROR("Trying to fill a null buffer.\n");
+        return FHOS_ERROR_BUFFER_IS_NULL;
+    }
+    
+    if(read_amount < 0) {
+        FHOS_LOG_ERROR("Trying to read negative amount of bytes.\n");
+        return -1;
+    }
+    
+    if(read_amount == 0) { return 0; }
+    
+    (void)ctx;
+    
+    // NOTE(Patrik): A single call reads at most FHOS_I32_MAX bytes and may come back short, so keep going
+    // until everything is read or the end of the file is hit.
+    fhos_i64 result = 0;
+#if defined(_WIN32) || defined(_WIN64)
+    while(read_amount > 0) {
+        DWORD to_read = (read_amount > FHOS_I32_MAX) ? FHOS_I32_MAX : (DWORD)read_amount;
+        DWORD bytes_read = 0;
+        if(!ReadFile((HANDLE)handle.data, data, to_read, &bytes_read, 0)) {
+            FHOS_LOG_ERROR("Could not read file. (%lu)\n", GetLastError());
+            return -1;
+        }
+        if(bytes_read == 0) { break; }
+        
+        data += bytes_read;
+        result += bytes_read;
+        read_amount -= bytes_read;
+    }
+#elif defined(__linux__)
+    int fd = (int)(fhos_isize)handle.data;
+    while(read_amount > 0) {
+        fhos_i64 to_read = (read_amount > FHOS_I32_MAX) ? FHOS_I32_MAX : read_amount;
+        ssize_t bytes_read = read(fd, data, (size_t)to_read);
+        if(bytes_read < 0) {
+            if(errno == EINTR) { continue; }
+            FHOS_LOG_ERROR("Could not read file. (%d)\n", errno);
+            return -1;
+        }
+        if(bytes_read == 0) { break; }
+        
+        data += bytes_read;
+        result += bytes_read;
+        read_amount -= bytes_read;
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    return result;
+}
+
+FHOS_API fhos_i64
+fhos_write_file(FHOS_File_Handle handle, const fhos_u8 *data, fhos_i64 write_amount) {
+    if(!fhos_is_file_handle_valid(handle)) {
+        FHOS_LOG_ERROR("Trying to write to an invalid file handle.\n");
+        return -1;
+    }
+    
+    if(!data) {
+        FHOS_LOG_ERROR("Trying to read from a null buffer.\n");
+        return -1;
+    }
+    
+    if(write_amount < 0) {
+        FHOS_LOG_ERROR("Trying to write negative amount of bytes.\n");
+        return -1;
+    }
+    
+    if(write_amount == 0) { return 0; }
+    
+    fhos_i64 result = 0;
+#if defined(_WIN32) || defined(_WIN64)
+    while(write_amount > 0) {
+        DWORD to_write = (write_amount > FHOS_I32_MAX) ? FHOS_I32_MAX : (DWORD)write_amount;
+        DWORD bytes_written = 0;
+        if(!WriteFile((HANDLE)handle.data, data, to_write, &bytes_written, 0)) {
+            FHOS_LOG_ERROR("Could not to write file. (%lu)\n", GetLastError());
+            return -1;
+        }
+        // NOTE(Patrik): Nothing written without an error would never finish the loop.
+        if(bytes_written == 0) {
+            FHOS_LOG_ERROR("Could not to write file, no bytes were written.\n");
+            return -1;
+        }
+        
+        data += bytes_written;
+        result += bytes_written;
+        write_amount -= bytes_written;
+    }
+#elif defined(__linux__)
+    int fd = (int)(fhos_isize)handle.data;
+    while(write_amount > 0) {
+        fhos_i64 to_write = (write_amount > FHOS_I32_MAX) ? FHOS_I32_MAX : write_amount;
+        ssize_t bytes_written = write(fd, data, (size_t)to_write);
+        if(bytes_written < 0) {
+            if(errno == EINTR) { continue; }
+            FHOS_LOG_ERROR("Could not to write file. (%d)\n", errno);
+            return -1;
+        }
+        if(bytes_written == 0) {
+            FHOS_LOG_ERROR("Could not to write file, no bytes were written.\n");
+            return -1;
+        }
+        
+        data += bytes_written;
+        result += bytes_written;
+        write_amount -= bytes_written;
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    return result;
+}
+
+FHOS_API fhos_i64
+fhos_read_file_chunks(FHOS_Context *ctx, FHOS_File_Handle handle, fhos_i64 chunk_size, FHOS_Read_Chunk_Proc *proc, void *user_data) {
+    if(!fhos_is_file_handle_valid(handle)) {
+        FHOS_LOG_ERROR("Trying to read from an invalid file handle.\n");
+        return FHOS_ERROR_INVALID_FILE_HANDLE;
+    }
+    if(!proc) {
+        FHOS_LOG_ERROR("fhos_read_file_chunks -> The parameter proc is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    if(chunk_size <= 0) { chunk_size = 1024 * 1024; }
+    fhos_u8 *buffer = (fhos_u8 *)fhos_context_temp_alloc_non_zero(ctx, chunk_size);
+    if(!buffer) {
+        FHOS_LOG_ERROR("Could not allocate memory for reading the file in chunks.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    fhos_i64 result = 0;
+    for(;;) {
+        fhos_i64 bytes_read = fhos_read_file(ctx, handle, buffer, chunk_size);
+        if(bytes_read < 0) { result = bytes_read; }
+        if(bytes_read <= 0) { break; }
+        
+        fhos_bool should_continue = proc(user_data, buffer, bytes_read, result);
+        result += bytes_read;
+        if(!should_continue || bytes_read < chunk_size) { break; }
+    }
+    
+    fhos_context_temp_free(ctx, buffer);
+    return result;
+}
+
+#if defined(__linux__)
+// NOTE(Patrik): How many buffers go into one readv or writev, the kernel takes at most IOV_MAX.
+#  define FHOS__IO_VECTOR_BATCH_COUNT 256
+
+static fhos_i64
+fhos__transfer_file_vectored(int fd, const FHOS_IO_Vector *buffers, fhos_i32 buffer_count, fhos_bool is_writing) {
+    struct iovec io_vectors[FHOS__IO_VECTOR_BATCH_COUNT];
+    fhos_i64 result = 0;
+    fhos_i32 buffer_index = 0;
+    fhos_i64 buffer_offset = 0;
+    
+    while(buffer_index < buffer_count) {
+        int io_vector_count = 0;
+        for(fhos_i32 i = buffer_index; i < buffer_count && io_vector_count < FHOS__IO_VECTOR_BATCH_COUNT; i += 1) {
+            fhos_i64 offset = (i == buffer_index) ? buffer_offset : 0;
+            if(buffers[i].size - offset <= 0) { continue; }
+            io_vectors[io_vector_count].iov_base = buffers[i].data + offset;
+            io_vectors[io_vector_count].iov_len = (size_t)(buffers[i].size - offset);
+            io_vector_count += 1;
+        }
+        if(io_vector_count == 0) { break; }
+        
+        ssize_t bytes_moved = (is_writing) ? writev(fd, io_vectors, io_vector_count) : readv(fd, io_vectors, io_vector_count);
+        if(bytes_moved < 0) {
+            if(errno == EINTR) { continue; }
+            FHOS_LOG_ERROR("Could not %s the file. (%d)\n", (is_writing) ? "write" : "read", errno);
+            return -1;
+        }
+        if(bytes_moved == 0) { break; }
+        result += bytes_moved;
+        
+        // NOTE(Patrik): The call can stop partway through any buffer, so step forward by exactly what was moved.
+        fhos_i64 remaining = (fhos_i64)bytes_moved;
+        while(remaining > 0 && buffer_index < buffer_count) {
+            fhos_i64 left_in_buffer = buffers[buffer_index].size - buffer_offset;
+            if(remaining < left_in_buffer) {
+                buffer_offset += remaining;
+                remaining = 0;
+            } else {
+                remaining -= left_in_buffer;
+                buffer_index += 1;
+                buffer_offset = 0;
+            }
+        }
+    }
+    
+    return result;
+}
+#endif
+
+FHOS_API fhos_i64
+fhos_read_file_vectored(FHOS_Context *ctx, FHOS_File_Handle handle, const FHOS_IO_Vector *buffers, fhos_i32 buffer_count) {
+    if(!fhos_is_file_handle_valid(handle)) {
+        FHOS_LOG_ERROR("Trying to read from an invalid file handle.\n");
+        return FHOS_ERROR_INVALID_FILE_HANDLE;
+    }
+    if(buffer_count <= 0) { return 0; }
+    if(!buffers) {
+        FHOS_LOG_ERROR("fhos_read_file_vectored -> The parameter buffers is null.\n");
+        return FHOS_ERROR_BUFFER_IS_NULL;
+    }
+    for(fhos_i32 i = 0; i < buffer_count; i += 1) {
+        if(buffers[i].size < 0 || (!buffers[i].data && buffers[i].size > 0)) {
+            FHOS_LOG_ERROR("fhos_read_file_vectored -> Buffer %d is invalid.\n", i);
+            return FHOS_ERROR_BUFFER_IS_NULL;
+        }
+    }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    // NOTE(Patrik): ReadFileScatter only works on unbuffered handles with page sized buffers, so this reads them one by one.
+    fhos_i64 result = 0;
+    for(fhos_i32 i = 0; i < buffer_count; i += 1) {
+        fhos_i64 bytes_read = fhos_read_file(ctx, handle, buffers[i].data, buffers[i].size);
+        if(bytes_read < 0) { return bytes_read; }
+        result += bytes_read;
+        if(bytes_read < buffers[i].size) { break; }
+    }
+    return result;
+#elif defined(__linux__)
+    (void)ctx;
+    return fhos__transfer_file_vectored((int)(fhos_isize)handle.data, buffers, buffer_count, FHOS_FALSE);
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+FHOS_API fhos_i64
+fhos_write_file_vectored(FHOS_File_Handle handle, const FHOS_IO_Vector *buffers, fhos_i32 buffer_count) {
+    if(!fhos_is_file_handle_valid(handle)) {
+        FHOS_LOG_ERROR("Trying to write to an invalid file handle.\n");
+        return FHOS_ERROR_INVALID_FILE_HANDLE;
+    }
+    if(buffer_count <= 0) { return 0; }
+    if(!buffers) {
+        FHOS_LOG_ERROR("fhos_write_file_vectored -> The parameter buffers is null.\n");
+        return FHOS_ERROR_BUFFER_IS_NULL;
+    }
+    for(fhos_i32 i = 0; i < buffer_count; i += 1) {
+        if(buffers[i].size < 0 || (!buffers[i].data && buffers[i].size > 0)) {
+            FHOS_LOG_ERROR("fhos_write_file_vectored -> Buffer %d is invalid.\n", i);
+            return FHOS_ERROR_BUFFER_IS_NULL;
+        }
+    }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    // NOTE(Patrik): WriteFileGather has the same restrictions as ReadFileScatter.
+    fhos_i64 result = 0;
+    for(fhos_i32 i = 0; i < buffer_count; i += 1) {
+        fhos_i64 bytes_written = fhos_write_file(handle, buffers[i].data, buffers[i].size);
+        if(bytes_written < 0) { return bytes_written; }
+        result += bytes_written;
+    }
+    return result;
+#elif defined(__linux__)
+    return fhos__transfer_file_vectored((int)(fhos_isize)handle.data, buffers, buffer_count, FHOS_TRUE);
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+static fhos_bool
+fhos__resize_mapped_writer(FHOS_Mapped_Writer *writer, fhos_i64 new_capacity) {
+#if defined(_WIN32) || defined(_WIN64)
+    // NOTE(Patrik): A view can not be resized, so it is dropped and the file mapped again at the new size.
+    if(writer->data) { UnmapViewOfFile(writer->data); }
+    if(writer->mapping) { CloseHandle((HANDLE)writer->mapping); }
+    writer->data = 0;
+    writer->mapping = 0;
+    writer->capacity = 0;
+    if((fhos_u64)new_capacity > (fhos_u64)(SIZE_T)-1) { return FHOS_FALSE; }
+    
+    // NOTE(Patrik): Mapping past the end of the file makes it grow to the size of the mapping.
+    HANDLE mapping = CreateFileMappingA((HANDLE)writer->handle.data, 0, PAGE_READWRITE,
+                                        (DWORD)((fhos_u64)new_capacity >> 32), (DWORD)new_capacity, 0);
+    if(!mapping) {
+        FHOS_LOG_ERROR("(%lu) Could not map the file for writing.\n", GetLastError());
+        return FHOS_FALSE;
+    }
+    
+    writer->data = (fhos_u8 *)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, (SIZE_T)new_capacity);
+    if(!writer->data) {
+        FHOS_LOG_ERROR("(%lu) Could not map the file for writing.\n", GetLastError());
+        CloseHandle(mapping);
+        return FHOS_FALSE;
+    }
+    writer->mapping = (void *)mapping;
+    writer->capacity = new_capacity;
+    return FHOS_TRUE;
+#elif defined(__linux__)
+    if((fhos_u64)new_capacity > (fhos_u64)(size_t)-1) { return FHOS_FALSE; }
+    
+    // NOTE(Patrik): Running out of disk space while writing through a mapping raises SIGBUS instead of
+    // returning an error, so the blocks are reserved now while the failure can still be reported.
+    // Only file systems that can not preallocate at all are let through.
+    int fd = (int)(fhos_isize)writer->handle.data;
+    int error = fhos__fallocate(fd, new_capacity);
+    if(error != 0 && error != EOPNOTSUPP && error != ENOSYS) {
+        FHOS_LOG_ERROR("(%d) Could not reserve space to grow the file.\n", error);
+        return FHOS_FALSE;
+    }
+    
+    while(ftruncate(fd, (off_t)new_capacity) != 0) {
+        if(errno == EINTR) { continue; }
+        FHOS_LOG_ERROR("(%d) Could not grow the file.\n", errno);
+        return FHOS_FALSE;
+    }
+    
+    void *view = MAP_FAILED;
+    if(writer->data) {
+        view = mremap(writer->data, (size_t)writer->capacity, (size_t)new_capacity, MREMAP_MAYMOVE);
+    } else {
+        view = mmap(0, (size_t)new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if(view == MAP_FAILED) {
+        FHOS_LOG_ERROR("(%d) Could not map the file for writing.\n", errno);
+        return FHOS_FALSE;
+    }
+    
+    writer->data = (fhos_u8 *)view;
+    writer->capacity = new_capacity;
+    return FHOS_TRUE;
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+FHOS_API fhos_error
+fhos_open_mapped_writer(FHOS_Context *ctx, FHOS_Mapped_Writer *writer, const char *path_data, fhos_i32 path_length, fhos_i64 initial_capacity) {
+    if(!writer) {
+        FHOS_LOG_ERROR("fhos_open_mapped_writer -> The parameter writer is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    FHOS_Mapped_Writer zero_writer = {0};
+    *writer = zero_writer;
+    writer->handle = fhos_get_invalid_file_handle();
+    
+    if(!path_data) {
+        FHOS_LOG_ERROR("fhos_open_mapped_writer -> The parameter path_data is null.\n");
+        return FHOS_ERROR_PATH_IS_NULL;
+    } else if(path_length == 0) {
+        FHOS_LOG_ERROR("fhos_open_mapped_writer -> The parameter path_length is zero.\n");
+        return FHOS_ERROR_PATH_IS_EMPTY;
+    }
+    
+    FHOS__ALLOC_PATH(ctx, path_data, path_length);
+    if(!path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    // NOTE(Patrik): The handle has to be readable as well, write only handles can not be mapped.
+#if defined(_WIN32) || defined(_WIN64)
+    writer->handle.data = (void *)CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    if(!fhos_is_file_handle_valid(writer->handle)) {
+        FHOS_LOG_ERROR("(%lu) Could not open \"%s\" for mapped writing.\n", GetLastError(), path);
+    }
+#elif defined(__linux__)
+    writer->handle.data = (void *)(fhos_isize)open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(!fhos_is_file_handle_valid(writer->handle)) {
+        FHOS_LOG_ERROR("(%d) Could not open \"%s\" for mapped writing.\n", errno, path);
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    FHOS__FREE_PATH(ctx, path_data, path_length);
+    if(!fhos_is_file_handle_valid(writer->handle)) { return FHOS_ERROR_INVALID_FILE_HANDLE; }
+    
+    if(initial_capacity <= 0) { initial_capacity = FHOS_MAPPED_WRITER_GROW_SIZE; }
+    if(!fhos__resize_mapped_writer(writer, initial_capacity)) {
+        fhos_close_mapped_writer(writer);
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    return FHOS_TRUE;
+}
+
+FHOS_API fhos_u8 *
+fhos_push_mapped_writer(FHOS_Mapped_Writer *writer, fhos_i64 size) {
+    if(!writer || !writer->data || size < 0) { return 0; }
+    
+    if(size > writer->capacity - writer->size) {
+        fhos_i64 new_capacity = writer->capacity + ((writer->capacity > FHOS_MAPPED_WRITER_GROW_SIZE) ? writer->capacity : FHOS_MAPPED_WRITER_GROW_SIZE);
+        if(new_capacity < writer->size + size) { new_capacity = writer->size + size; }
+        if(!fhos__resize_mapped_writer(writer, new_capacity)) { return 0; }
+    }
+    
+    fhos_u8 *result = writer->data + writer->size;
+    writer->size += size;
+    return result;
+}
+
+FHOS_API fhos_bool
+fhos_write_mapped_writer(FHOS_Mapped_Writer *writer, const fhos_u8 *data, fhos_i64 size) {
+    if(!data && size > 0) { return FHOS_FALSE; }
+    
+    fhos_u8 *destination = fhos_push_mapped_writer(writer, size);
+    if(!destination) { return FHOS_FALSE; }
+    
+    for(fhos_i64 i = 0; i < size; i += 1) { destination[i] = data[i]; }
+    return FHOS_TRUE;
+}
+
+FHOS_API fhos_bool
+fhos_close_mapped_writer(FHOS_Mapped_Writer *writer) {
+    if(!writer) { return FHOS_FALSE; }
+    
+    fhos_bool result = FHOS_TRUE;
+    if(fhos_is_file_handle_valid(writer->handle)) {
+#if defined(_WIN32) || defined(_WIN64)
+        if(writer->data) { UnmapViewOfFile(writer->data); }
+        if(writer->mapping) { CloseHandle((HANDLE)writer->mapping); }
+        
+        LARGE_INTEGER end_of_file;
+        end_of_file.QuadPart = writer->size;
+        if(!SetFilePointerEx((HANDLE)writer->handle.data, end_of_file, 0, FILE_BEGIN) || !SetEndOfFile((HANDLE)writer->handle.data)) {
+            FHOS_LOG_ERROR("(%lu) Could not set the final size of the file.\n", GetLastError());
+            result = FHOS_FALSE;
+        }
+#elif defined(__linux__)
+        if(writer->data) { munmap(writer->data, (size_t)writer->capacity); }
+        
+        int fd = (int)(fhos_isize)writer->handle.data;
+        int error = 0;
+        do {
+            error = (ftruncate(fd, (off_t)writer->size) == 0) ? 0 : errno;
+        } while(error == EINTR);
+        if(error != 0) {
+            FHOS_LOG_ERROR("(%d) Could not set the final size of the file.\n", error);
+            result = FHOS_FALSE;
+        }
+#else
+#  error Unimplemented on this platform.
+#endif
+        fhos_close_file(writer->handle);
+    }
+    
+    FHOS_Mapped_Writer zero_writer = {0};
+    *writer = zero_writer;
+    writer->handle = fhos_get_invalid_file_handle();
+    return result;
+}
+
+FHOS_API FHOS_List
+fhos_read_entire_file(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, fhos_bool use_temp_allocator) {
+    FHOS_List result = {0};
+    
+    FHOS_File_Handle handle = fhos_open_file_for_reading_with_hint(ctx, path_data, path_length, FHOS_ACCESS_HINT_SEQUENTIAL);
+    if(!fhos_is_file_handle_valid(handle)) { return result; }
+    
+    fhos_i64 file_size = fhos_get_size_of_file(handle);
+    if(file_size < 0) {
+        fhos_close_file(handle);
+        return result;
+    }
+    
+    // NOTE(Patrik): Empty files still get a buffer so that a null data always means failure.
+    result.capacity = (file_size > 0) ? file_size : 1;
+    if(use_temp_allocator) {
+        result.data = (fhos_u8 *)fhos_context_temp_alloc_non_zero(ctx, result.capacity);
+    } else {
+        result.data = (fhos_u8 *)fhos_context_alloc_non_zero(ctx, result.capacity);
+    }
+    if(!result.data) {
+        FHOS_LOG_ERROR("Could not allocate %lld bytes for reading the file.\n", (long long)result.capacity);
+        fhos_close_file(handle);
+        FHOS_List zero_result = {0};
+        return zero_result;
+    }
+    
+    // NOTE(Patrik): Fewer bytes than the size only happens if the file shrank while being read, what was there is kept.
+    result.count = fhos_read_file(ctx, handle, result.data, file_size);
+    fhos_close_file(handle);
+    
+    if(result.count < 0) {
+        if(use_temp_allocator) {
+            fhos_context_temp_free(ctx, result.data);
+        } else {
+            fhos_context_free(ctx, result.data);
+        }
+        FHOS_List zero_result = {0};
+        return zero_result;
+    }
+    
+    return result;
+}
+
+FHOS_API fhos_bool
+fhos_write_entire_file(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length,
+                       const fhos_u8 *data, fhos_i64 write_amount)
+{
+    if(write_amount <= 0) { return FHOS_FALSE; }
+    
+    FHOS_File_Handle handle = fhos_open_file_for_writing_with_size_hint(ctx, path_data, path_length, write_amount);
+    if(!fhos_is_file_handle_valid(handle)) { return FHOS_FALSE; }
+    
+    fhos_i64 bytes_written = fhos_write_file(handle, data, write_amount);
+    fhos_close_file(handle);
+    
+    return bytes_written == write_amount;
+}
+
+typedef struct FHOS__Direct_Slot {
+    fhos_i64 offset;
+    fhos_i64 result;
+    fhos_bool is_pending;
+#if defined(_WIN32) || defined(_WIN64)
+    OVERLAPPED overlapped;
+#elif defined(__linux__)
+    struct iocb control_block;
+#endif
+} FHOS__Direct_Slot;
+
+static void
+fhos__submit_direct_read(FHOS_Direct_Reader *reader, fhos_i32 slot_index) {
+    FHOS__Direct_Slot *slot = (FHOS__Direct_Slot *)reader->slots + slot_index;
+    fhos_u8 *buffer = reader->buffers + slot_index * reader->block_size;
+    slot->offset = reader->submit_offset;
+    slot->result = 0;
+    slot->is_pending = FHOS_TRUE;
+    reader->submit_offset += reader->block_size;
+    
+    // NOTE(Patrik): The whole block is always requested, reads at the end of the file just come back short.
+#if defined(_WIN32) || defined(_WIN64)
+    slot->overlapped.Offset = (DWORD)slot->offset;
+    slot->overlapped.OffsetHigh = (DWORD)((fhos_u64)slot->offset >> 32);
+    ResetEvent(slot->overlapped.hEvent);
+    if(!ReadFile((HANDLE)reader->handle.data, buffer, (DWORD)reader->block_size, 0, &slot->overlapped)) {
+        DWORD last_error = GetLastError();
+        if(last_error != ERROR_IO_PENDING) {
+            slot->result = (last_error == ERROR_HANDLE_EOF) ? 0 : -1;
+            slot->is_pending = FHOS_FALSE;
+            if(slot->result < 0) { FHOS_LOG_ERROR("(%lu) Could not start reading the file.\n", last_error); }
+        }
+    }
+#elif defined(__linux__)
+    if(reader->queue) {
+        struct iocb *control_block = &slot->control_block;
+        struct iocb zero_control_block = {0};
+        *control_block = zero_control_block;
+        control_block->aio_data = (fhos_u64)slot_index;
+        control_block->aio_lio_opcode = IOCB_CMD_PREAD;
+        control_block->aio_fildes = (fhos_u32)(fhos_isize)reader->handle.data;
+        control_block->aio_buf = (fhos_u64)(fhos_isize)buffer;
+        control_block->aio_nbytes = (fhos_u64)reader->block_size;
+        control_block->aio_offset = slot->offset;
+        
+        long submitted = 0;
+        do {
+            submitted = syscall(SYS_io_submit, (aio_context_t)reader->queue, 1L, &control_block);
+        } while(submitted < 0 && (errno == EINTR || errno == EAGAIN));
+        
+        if(submitted != 1) {
+            FHOS_LOG_ERROR("(%d) Could not start reading the file.\n", errno);
+            slot->result = -1;
+            slot->is_pending = FHOS_FALSE;
+        }
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+static void
+fhos__wait_for_direct_read(FHOS_Direct_Reader *reader, fhos_i32 slot_index) {
+    FHOS__Direct_Slot *slots = (FHOS__Direct_Slot *)reader->slots;
+    FHOS__Direct_Slot *slot = slots + slot_index;
+    
+#if defined(_WIN32) || defined(_WIN64)
+    if(slot->is_pending) {
+        DWORD bytes_read = 0;
+        if(GetOverlappedResult((HANDLE)reader->handle.data, &slot->overlapped, &bytes_read, TRUE)) {
+            slot->result = (fhos_i64)bytes_read;
+        } else {
+            DWORD last_error = GetLastError();
+            slot->result = (last_error == ERROR_HANDLE_EOF) ? 0 : -1;
+            if(slot->result < 0) { FHOS_LOG_ERROR("(%lu) Could not read the file.\n", last_error); }
+        }
+        slot->is_pending = FHOS_FALSE;
+    }
+#elif defined(__linux__)
+    if(!reader->queue && slot->is_pending) {
+        // NOTE(Patrik): Without AIO the read happens here, the queue is then only one deep.
+        int fd = (int)(fhos_isize)reader->handle.data;
+        fhos_u8 *buffer = reader->buffers + slot_index * reader->block_size;
+        while(slot->result < reader->block_size) {
+            ssize_t bytes_read = pread(fd, buffer + slot->result, (size_t)(reader->block_size - slot->result), slot->offset + slot->result);
+            if(bytes_read < 0 && errno == EINTR) { continue; }
+            if(bytes_read < 0) {
+                FHOS_LOG_ERROR("(%d) Could not read the file.\n", errno);
+                slot->result = -1;
+            }
+            if(bytes_read <= 0) { break; }
+            slot->result += bytes_read;
+        }
+        slot->is_pending = FHOS_FALSE;
+    }
+    
+    // NOTE(Patrik): Completions come in any order, keep collecting them until the one we want is in.
+    while(slot->is_pending) {
+        struct io_event events[16];
+        long event_count = syscall(SYS_io_getevents, (aio_context_t)reader->queue, 1L, 16L, events, (struct timespec *)0);
+        if(event_count < 0) {
+            if(errno == EINTR) { continue; }
+            FHOS_LOG_ERROR("(%d) Could not wait for the file reads.\n", errno);
+            slot->result = -1;
+            slot->is_pending = FHOS_FALSE;
+            break;
+        }
+        
+        for(long i = 0; i < event_count; i += 1) {
+            FHOS__Direct_Slot *done_slot = slots + events[i].data;
+            done_slot->result = events[i].res;
+            done_slot->is_pending = FHOS_FALSE;
+            if(done_slot->result < 0) {
+                FHOS_LOG_ERROR("(%d) Could not read the file.\n", (int)-done_slot->result);
+                done_slot->result = -1;
+            }
+        }
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+FHOS_API fhos_error
+fhos_open_direct_reader(FHOS_Context *ctx, FHOS_Direct_Reader *reader, const char *path_data, fhos_i32 path_length,
+                        fhos_i64 block_size, fhos_i32 queue_depth)
+{
+    if(!reader) {
+        FHOS_LOG_ERROR("fhos_open_direct_reader -> The parameter reader is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    FHOS_Direct_Reader zero_reader = {0};
+    *reader = zero_reader;
+    reader->handle = fhos_get_invalid_file_handle();
+    reader->held_slot = -1;
+    
+    if(!path_data) {
+        FHOS_LOG_ERROR("fhos_open_direct_reader -> The parameter path_data is null.\n");
+        return FHOS_ERROR_PATH_IS_NULL;
+    } else if(path_length == 0) {
+        FHOS_LOG_ERROR("fhos_open_direct_reader -> The parameter path_length is zero.\n");
+        return FHOS_ERROR_PATH_IS_EMPTY;
+    }
+    
+    if(block_size <= 0) { block_size = FHOS_DIRECT_IO_DEFAULT_BLOCK_SIZE; }
+    if(queue_depth <= 0) { queue_depth = FHOS_DIRECT_IO_DEFAULT_QUEUE_DEPTH; }
+    if(queue_depth < 2) { queue_depth = 2; }
+    reader->block_size = (block_size + FHOS_DIRECT_IO_ALIGNMENT - 1) & ~(fhos_i64)(FHOS_DIRECT_IO_ALIGNMENT - 1);
+    reader->queue_depth = queue_depth;
+    
+    FHOS__ALLOC_PATH(ctx, path_data, path_length);
+    if(!path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    reader->is_direct = FHOS_TRUE;
+    DWORD flags = FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN;
+    reader->handle.data = (void *)CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, flags, 0);
+    if(!fhos_is_file_handle_valid(reader->handle)) {
+        FHOS_LOG_ERROR("(%lu) Could not open \"%s\" for direct reading.\n", GetLastError(), path);
+    }
+#elif defined(__linux__)
+    reader->is_direct = FHOS_TRUE;
+    int fd = open(path, O_RDONLY | O_DIRECT | O_CLOEXEC);
+    if(fd < 0 && errno == EINVAL) {
+        reader->is_direct = FHOS_FALSE;
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if(fd >= 0) { posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL); }
+    }
+    if(fd < 0) { FHOS_LOG_ERROR("(%d) Could not open \"%s\" for direct reading.\n", errno, path); }
+    reader->handle.data = (void *)(fhos_isize)fd;
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    FHOS__FREE_PATH(ctx, path_data, path_length);
+    if(!fhos_is_file_handle_valid(reader->handle)) { return FHOS_ERROR_INVALID_FILE_HANDLE; }
+    
+    reader->file_size = fhos_get_size_of_file(reader->handle);
+    reader->buffers = (fhos_u8 *)fhos_allocate_aligned_memory_non_zero(reader->block_size * queue_depth, FHOS_DIRECT_IO_ALIGNMENT);
+    reader->slots = fhos_context_alloc(ctx, queue_depth * sizeof(FHOS__Direct_Slot));
+    if(reader->file_size < 0 || !reader->buffers || !reader->slots) {
+        // NOTE(Patrik): Closing zeroes the reader, so the error is picked before.
+        fhos_error error = FHOS_ERROR_GENERIC_ERROR;
+        if(reader->file_size >= 0) {
+            FHOS_LOG_ERROR("Could not allocate memory for the direct reader.\n");
+            error = FHOS_ERROR_OUT_OF_MEMORY;
+        }
+        fhos_close_direct_reader(ctx, reader);
+        return error;
+    }
+    
+    FHOS__Direct_Slot *slots = (FHOS__Direct_Slot *)reader->slots;
+#if defined(_WIN32) || defined(_WIN64)
+    for(fhos_i32 i = 0; i < queue_depth; i += 1) {
+        slots[i].overlapped.hEvent = CreateEventA(0, TRUE, FALSE, 0);
+        if(!slots[i].overlapped.hEvent) {
+            FHOS_LOG_ERROR("(%lu) Could not create an event for the direct reader.\n", GetLastError());
+            fhos_close_direct_reader(ctx, reader);
+            return FHOS_ERROR_GENERIC_ERROR;
+        }
+    }
+#elif defined(__linux__)
+    (void)slots;
+    aio_context_t queue = 0;
+    if(syscall(SYS_io_setup, (long)queue_depth, &queue) == 0) { reader->queue = (fhos_u64)queue; }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    for(fhos_i32 i = 0; i < queue_depth && reader->submit_offset < reader->file_size; i += 1) { fhos__submit_direct_read(reader, i); }
+    return FHOS_TRUE;
+}
+
+FHOS_API fhos_i64
+fhos_read_next_direct_block(FHOS_Direct_Reader *reader, const fhos_u8 **data) {
+    if(!reader || !data) {
+        FHOS_LOG_ERROR("fhos_read_next_direct_block -> The parameter reader or data is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    if(!fhos_is_file_handle_valid(reader->handle) || !reader->slots) { return FHOS_ERROR_INVALID_FILE_HANDLE; }
+    
+    // NOTE(Patrik): The caller is done with the block from the last call, so its buffer can take the next read.
+    if(reader->held_slot >= 0) {
+#if defined(__linux__)
+        if(!reader->is_direct) {
+            FHOS__Direct_Slot *held_slot = (FHOS__Direct_Slot *)reader->slots + reader->held_slot;
+            posix_fadvise((int)(fhos_isize)reader->handle.data, held_slot->offset, reader->block_size, POSIX_FADV_DONTNEED);
+        }
+#endif
+        if(reader->submit_offset < reader->file_size) { fhos__submit_direct_read(reader, reader->held_slot); }
+        reader->held_slot = -1;
+    }
+    
+    *data = 0;
+    if(reader->read_offset >= reader->file_size) { return 0; }
+    
+    fhos_i32 slot_index = reader->read_slot;
+    FHOS__Direct_Slot *slot = (FHOS__Direct_Slot *)reader->slots + slot_index;
+    fhos__wait_for_direct_read(reader, slot_index);
+    
+    // NOTE(Patrik): Anything but a full block, or the rest of the file for the last one, means the file changed under us.
+    fhos_i64 expected_size = reader->file_size - slot->offset;
+    if(expected_size > reader->block_size) { expected_size = reader->block_size; }
+    if(slot->result != expected_size) {
+        if(slot->result >= 0) { FHOS_LOG_ERROR("Read %lld bytes instead of %lld.\n", (long long)slot->result, (long long)expected_size); }
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    reader->held_slot = slot_index;
+    reader->read_slot = (slot_index + 1) % reader->queue_depth;
+    reader->read_offset += reader->block_size;
+    *data = reader->buffers + slot_index * reader->block_size;
+    return slot->result;
+}
+
+FHOS_API void
+fhos_close_direct_reader(FHOS_Context *ctx, FHOS_Direct_Reader *reader) {
+    if(!reader) { return; }
+    
+    // NOTE(Patrik): The reads still in flight write into the buffers, so they have to finish before the buffers go.
+    FHOS__Direct_Slot *slots = (FHOS__Direct_Slot *)reader->slots;
+#if defined(_WIN32) || defined(_WIN64)
+    if(slots) {
+        for(fhos_i32 i = 0; i < reader->queue_depth; i += 1) {
+            if(slots[i].is_pending) {
+                DWORD bytes_read = 0;
+                CancelIoEx((HANDLE)reader->handle.data, &slots[i].overlapped);
+                GetOverlappedResult((HANDLE)reader->handle.data, &slots[i].overlapped, &bytes_read, TRUE);
+            }
+            if(slots[i].overlapped.hEvent) { CloseHandle(slots[i].overlapped.hEvent); }
+        }
+    }
+#elif defined(__linux__)
+    (void)slots;
+    // NOTE(Patrik): io_destroy blocks until every outstanding read is done.
+    if(reader->queue) { syscall(SYS_io_destroy, (aio_context_t)reader->queue); }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    if(fhos_is_file_handle_valid(reader->handle)) { fhos_close_file(reader->handle); }
+    if(reader->buffers) { fhos_free_aligned_memory(reader->buffers); }
+    if(reader->slots) { fhos_context_free(ctx, reader->slots); }
+    
+    FHOS_Direct_Reader zero_reader = {0};
+    *reader = zero_reader;
+    reader->handle = fhos_get_invalid_file_handle();
+    reader->held_slot = -1;
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// PATH
+//
+FHOS_API fhos_bool
+fhos_file_exists(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
+    fhos_bool result = FHOS_FALSE;
+    FHOS__ALLOC_PATH(ctx, path_data, path_length);
+    if(!path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return result;
+    }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    DWORD attribute = GetFileAttributesA(path);
+    if(attribute == INVALID_FILE_ATTRIBUTES) {
+        DWORD last_error = GetLastError();
+        if(last_error != ERROR_FILE_NOT_FOUND && last_error != ERROR_PATH_NOT_FOUND) {
+            FHOS_LOG_ERROR("Could not check if file \"%s\" exists. (%lu)\n", path, last_error);
+        }
+    }
+    
+    result = (attribute != INVALID_FILE_ATTRIBUTES);
+#elif defined(__linux__)
+    if(access(path, F_OK) == 0) {
+        result = FHOS_TRUE;
+    } else if(errno != ENOENT && errno != ENOTDIR) {
+        FHOS_LOG_ERROR("Could not check if file \"%s\" exists. (%d)\n", path, errno);
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    FHOS__FREE_PATH(ctx, path_data, path_length);
+    return result;
+}
+
+FHOS_API fhos_bool
+fhos_remove_file(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
+    fhos_bool result = FHOS_FALSE;
+    FHOS__ALLOC_PATH(ctx, path_data, path_length);
+    if(!path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return result;
+    }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    BOOL success = DeleteFile(path);
+    if(!success) {
+        DWORD last_error = GetLastError();
+        if(last_error != ERROR_FILE_NOT_FOUND) {
+            FHOS_LOG_ERROR("Could not delete the file \"%s\". (%lu)\n", path, last_error);
+        }
+    }
+    
+    result = (success != 0);
+#elif defined(__linux__)
+    if(unlink(path) == 0) {
+        result = FHOS_TRUE;
+    } else if(errno != ENOENT) {
+        FHOS_LOG_ERROR("Could not delete the file \"%s\". (%d)\n", path, errno);
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    FHOS__FREE_PATH(ctx, path_data, path_length);
+    return result;
+}
+
+
+FHOS_API fhos_error
+fhos_move_file(FHOS_Context *ctx, const char *from_path_data, fhos_i32 from_path_length,
+               const char *to_path_data, fhos_i32 to_path_length)
+{
+    if(!from_path_data) {
+        FHOS_LOG_ERROR("fhos_move_file -> The parameter from_path_data is null.\n");
+        return FHOS_ERROR_PATH_IS_NULL;
+    } else if(from_path_length == 0) {
+        FHOS_LOG_ERROR("fhos_move_file -> The parameter from_path_length is zero.\n");
+        return FHOS_ERROR_PATH_IS_EMPTY;
+    }
+    
+    if(!to_path_data) {
+        FHOS_LOG_ERROR("fhos_move_file -> The parameter to_path_data is null.\n");
+        return FHOS_ERROR_PATH_IS_NULL;
+    } else if(to_path_length == 0) {
+        FHOS_LOG_ERROR("fhos_move_file -> The parameter to_path_length is zero.\n");
+        return FHOS_ERROR_PATH_IS_EMPTY;
+    }
+    
+    FHOS__ALLOC_FROM_TO_PATH(ctx, from_path_data, from_path_length, to_path_data, to_path_length);
+    if(!from_path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    fhos_error result = FHOS_FALSE;
+    
+#if defined(_WIN32) || defined(_WIN64)
+    DWORD move_flags = (MOVEFILE_COPY_ALLOWED | MOVEFILE_REPLACE_EXISTING);
+    if(MoveFileExA(from_path, to_path, move_flags)) {
+        result = FHOS_TRUE;
+    } else {
+        DWORD last_error = GetLastError();
+        FHOS_LOG_ERROR("(%lu) Could not move \"%s\" to \"%s\".\n", last_error, from_path, to_path);
+        result = -1;
+    }
+#elif defined(__linux__)
+    if(rename(from_path, to_path) == 0) {
+        result = FHOS_TRUE;
+    } else if(errno == EXDEV) {
+        // NOTE(Patrik): Same as MOVEFILE_COPY_ALLOWED, fall back to a copy when moving across devices.
+        result = fhos_copy_file(ctx, from_path, -1, to_path, -1);
+        if(result == FHOS_TRUE && unlink(from_path) != 0) {
+            FHOS_LOG_ERROR("(%d) Could not remove \"%s\" after copying it.\n", errno, from_path);
+            result = -1;
+        }
+    } else {
+        FHOS_LOG_ERROR("(%d) Could not move \"%s\" to \"%s\".\n", errno, from_path, to_path);
+        result = -1;
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    FHOS__FREE_FROM_TO_PATH(ctx, from_path_data, from_path_length, to_path_data, to_path_length);
+    return result;
+}
+
+FHOS_API fhos_error
+fhos_copy_file(FHOS_Context *ctx, const char *from_path_data, fhos_i32 from_path_length,
+               const char *to_path_data, fhos_i32 to_path_length)
+{
+    if(!from_path_data) {
+        FHOS_LOG_ERROR("fhos_move_file -> The parameter from_path_data is null.\n");
+        return -1;
+    } else if(from_path_length == 0) {
+        FHOS_LOG_ERROR("fhos_move_file -> The parameter from_path_length is zero.\n");
+        return -1;
+    }
+    
+    if(!to_path_data) {
+        FHOS_LOG_ERROR("fhos_move_file -> The parameter to_path_data is null.\n");
+        return -1;
+    } else if(to_path_length == 0) {
+        FHOS_LOG_ERROR("fhos_move_file -> The parameter to_path_length is zero.\n");
+        return -1;
+    }
+    
+    FHOS__ALLOC_FROM_TO_PATH(ctx, from_path_data, from_path_length, to_path_data, to_path_length);
+    if(!from_path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return -1;
+    }
+    
+    fhos_error result = FHOS_FALSE;
+    
+#if defined(_WIN32) || defined(_WIN64)
+    if(CopyFileA(from_path, to_path, 0)) {
+        result = FHOS_TRUE;
+    } else {
+        DWORD last_error = GetLastError();
+        FHOS_LOG_ERROR("(%lu) Could not move \"%s\" to \"%s\".\n", last_error, from_path, to_path);
+        result = -1;
+    }
+#elif defined(__linux__)
+    int from_fd = open(from_path, O_RDONLY | O_CLOEXEC);
+    struct stat from_stat;
+    if(from_fd < 0 || fstat(from_fd, &from_stat) != 0) {
+        FHOS_LOG_ERROR("(%d) Could not open \"%s\" for copying.\n", errno, from_path);
+        if(from_fd >= 0) { close(from_fd); }
+        result = -1;
+    } else {
+        int to_fd = open(to_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, from_stat.st_mode & 0777);
+        if(to_fd < 0) {
+            FHOS_LOG_ERROR("(%d) Could not open \"%s\" for copying.\n", errno, to_path);
+            result = -1;
+        } else {
+            // NOTE(Patrik): sendfile copies inside the kernel, so the data never passes through user space.
+            result = FHOS_TRUE;
+            fhos_i64 remaining = (fhos_i64)from_stat.st_size;
+            while(remaining > 0) {
+                ssize_t copied = sendfile(to_fd, from_fd, 0, (size_t)((remaining > FHOS_I32_MAX) ? FHOS_I32_MAX : remaining));
+                if(copied < 0 && errno == EINTR) { continue; }
+                if(copied <= 0) {
+                    if(copied < 0) {
+                        FHOS_LOG_ERROR("(%d) Could not copy \"%s\" to \"%s\".\n", errno, from_path, to_path);
+                        result = -1;
+                    }
+                    break;
+                }
+                remaining -= copied;
+            }
+            close(to_fd);
+        }
+        close(from_fd);
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    FHOS__FREE_FROM_TO_PATH(ctx, from_path_data, from_path_length, to_path_data, to_path_length);
+    return result;
+}
+
+FHOS_API fhos_error
+fhos_is_file_newer(FHOS_Context *ctx, const char *this_path_data, fhos_i32 this_path_length,
+                   const char *other_path_data, fhos_i32 other_path_length)
+{
+    if(!this_path_data) {
+        FHOS_LOG_ERROR("fhos_is_file_newer -> The parameter this_path_data is null.\n");
+        return -1;
+    } else if(this_path_length == 0) {
+        FHOS_LOG_ERROR("fhos_is_file_newer -> The parameter this_path_length is zero.\n");
+        return -1;
+    }
+    
+    if(!other_path_data) {
+        FHOS_LOG_ERROR("fhos_is_file_newer -> The parameter other_path_data is null.\n");
+        return -1;
+    } else if(other_path_length == 0) {
+        FHOS_LOG_ERROR("fhos_is_file_newer -> The parameter other_path_length is zero.\n");
+        return -1;
+    }
+    
+    FHOS__ALLOC_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
+    if(!from_path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return -1;
+    }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE other_handle = CreateFileA(to_path, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_READONLY, 0);
+    if(other_handle == INVALID_HANDLE_VALUE) {
+        FHOS__FREE_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
+        
+        DWORD last_error = GetLastError();
+        if(last_error != ERROR_FILE_NOT_FOUND) {
+            FHOS_LOG_ERROR("Could not open other_path..\n");
+            return -1;
+        }
+        return FHOS_TRUE;
+    }
+    
+    HANDLE this_handle = CreateFileA(from_path, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_READONLY, 0);
+    if(this_handle == INVALID_HANDLE_VALUE) {
+        DWORD last_error = GetLastError();
+        FHOS__FREE_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
+        
+        if(last_error != ERROR_FILE_NOT_FOUND) {
+            FHOS_LOG_ERROR("Could not open this_path..\n");
+            return -1;
+        }
+        return FHOS_TRUE;
+    }
+    
+    FILETIME other_time = {0};
+    if(!GetFileTime(to_path, 0, 0, &other_time)) {
+        DWORD last_error = GetLastError();
+        FHOS__FREE_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
+        
+        FHOS_LOG_ERROR("Could not get filetime of other_path.\n");
+        CloseHandle(this_handle);
+        CloseHandle(other_handle);
+        return -1;
+    }
+    
+    FILETIME this_time = {0};
+    if(!GetFileTime(from_path, 0, 0, &this_time)) {
+        DWORD last_error = GetLastError();
+        FHOS__FREE_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
+        
+        FHOS_LOG_ERROR("Could not get filetime of this_path.\n");
+        CloseHandle(this_handle);
+        CloseHandle(other_handle);
+        return -1;
+    }
+    
+    FHOS__FREE_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
+    CloseHandle(this_handle);
+    CloseHandle(other_handle);
+    
+    return (CompareFileTime(&this_time, &other_time) > 0);
+#elif defined(__linux__)
+    struct stat other_stat;
+    if(stat(to_path, &other_stat) != 0) {
+        int last_error = errno;
+        FHOS__FREE_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
+        
+        if(last_error != ENOENT) {
+            FHOS_LOG_ERROR("Could not stat other_path. (%d)\n", last_error);
+            return -1;
+        }
+        return FHOS_TRUE;
+    }
+    
+    struct stat this_stat;
+    if(stat(from_path, &this_stat) != 0) {
+        int last_error = errno;
+        FHOS__FREE_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
+        
+        if(last_error != ENOENT) {
+            FHOS_LOG_ERROR("Could not stat this_path. (%d)\n", last_error);
+            return -1;
+        }
+        return FHOS_TRUE;
+    }
+    
+    FHOS__FREE_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
+    
+    if(this_stat.st_mtim.tv_sec != other_stat.st_mtim.tv_sec) {
+        return (this_stat.st_mtim.tv_sec > other_stat.st_mtim.tv_sec);
+    }
+    return (this_stat.st_mtim.tv_nsec > other_stat.st_mtim.tv_nsec);
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+//
+
+FHOS_API fhos_bool
+fhos_directory_exists(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
+    fhos_bool result = FHOS_FALSE;
+    FHOS__ALLOC_PATH(ctx, path_data, path_length);
+    if(!path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return result;
+    }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    WIN32_FILE_ATTRIBUTE_DATA attribute = {0};
+    if(GetFileAttributesExA(path, GetFileExInfoStandard, &attribute)) {
+        if((attribute.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY) {
+            result = FHOS_TRUE;
+        }
+    }
+    
+#elif defined(__linux__)
+    struct stat path_stat;
+    if(stat(path, &path_stat) == 0 && S_ISDIR(path_stat.st_mode)) {
+        result = FHOS_TRUE;
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    FHOS__FREE_PATH(ctx, path_data, path_length);
+    return result;
+}
+
+FHOS_API fhos_i32
+fhos_count_directory_files(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
+    if(!path_data) {
+        FHOS_LOG_ERROR("Cannot count the files of a directory with a null path.\n");
+        return -1;
+    }
+    
+    FHOS_Directory_Iterator iterator = {0};
+    fhos_error error = fhos_open_directory(ctx, &iterator, path_data, path_length, FHOS_DIRECTORY_FLAG_SKIP_DIRECTORY);
+    if(error < 0) { return error; }
+    
+    fhos_i32 result = 0;
+    FHOS_Directory_Entry entry;
+    while((error = fhos_next_directory_entry(&iterator, &entry)) > 0) { result += 1; }
+    fhos_close_directory(ctx, &iterator);
+    
+    if(error < 0) { return error; }
+    return result;
+}
+
+FHOS_API fhos_error
+fhos_create_directory_if_new(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
+    fhos_error result = 0;
+    FHOS__ALLOC_PATH(ctx, path_data, path_length);
+    if(!path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return -1;
+    }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    result = (fhos_error)CreateDirectoryA(path, 0);
+    if(!result) {
+        DWORD last_error = GetLastError();
+        if(last_error != ERROR_ALREADY_EXISTS) {
+            FHOS_LOG_ERROR("(%lu) Could not create directory %s\n", last_error, path);
+            result = -((fhos_error)last_error);
+        }
+    }
+#elif defined(__linux__)
+    if(mkdir(path, 0755) == 0) {
+        result = FHOS_TRUE;
+    } else if(errno != EEXIST) {
+        FHOS_LOG_ERROR("(%d) Could not create directory %s\n", errno, path);
+        result = -((fhos_error)errno);
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    FHOS__FREE_PATH(ctx, path_data, path_length);
+    return result;
+}
+
+#if defined(__linux__)
+static fhos_error fhos__open_directory_from_fd(FHOS_Context *ctx, FHOS_Directory_Iterator *iterator, int fd);
+
+typedef struct FHOS__Remove_Frame {
+    FHOS_Directory_Iterator iterator;
+    fhos_i64 name_offset;
+    fhos_i32 name_length;
+} FHOS__Remove_Frame;
+
+// NOTE(Patrik): Removes everything inside the directory fd, but not the directory itself, and takes ownership of fd.
+// Every removal is relative to an open directory, so no paths are built and the depth is only limited by memory.
+// At most FHOS_REMOVE_DIRECTORY_MAX_OPEN_HANDLES directories are kept open, the ones above that are closed
+// and later reopened through ".." and read again from the start (what was already removed is gone by then).
+static fhos_error
+fhos__remove_directory_contents_at(FHOS_Context *ctx, int fd) {
+    fhos_i64 frame_count = 0;
+    fhos_i64 frame_capacity = 0;
+    FHOS__Remove_Frame *frames = 0;
+    FHOS_List names = {0};
+    
+    // NOTE(Patrik): Frames below lowest_open have their directory closed.
+    fhos_i64 lowest_open = 0;
+    fhos_i64 open_count = 1;
+    
+    frames = (FHOS__Remove_Frame *)fhos_context_temp_maybe_grow(ctx, frames, &frame_capacity, 16 * sizeof(FHOS__Remove_Frame));
+    if(!frames) {
+        FHOS_LOG_ERROR("Could not allocate memory for removing a directory.\n");
+        close(fd);
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    FHOS__Remove_Frame zero_frame = {0};
+    frames[0] = zero_frame;
+    fhos_error error = fhos__open_directory_from_fd(ctx, &frames[0].iterator, fd);
+    if(error < 0) {
+        fhos_context_temp_free(ctx, frames);
+        return error;
+    }
+    frame_count = 1;
+    error = 0;
+    
+    while(frame_count > 0 && error >= 0) {
+        FHOS__Remove_Frame *frame = frames + frame_count - 1;
+        int frame_fd = (int)(fhos_isize)frame->iterator.handle.data;
+        
+        FHOS_Directory_Entry entry;
+        fhos_error next = fhos_next_directory_entry(&frame->iterator, &entry);
+        if(next > 0) {
+            if(entry.type != FHOS_DIRECTORY_ENTRY_TYPE_DIRECTORY) {
+                if(unlinkat(frame_fd, entry.name, 0) != 0 && errno != ENOENT) {
+                    FHOS_LOG_ERROR("(%d) Could not remove the file: \"%s\"\n", errno, entry.name);
+                    error = -1;
+                }
+                continue;
+            }
+            
+            int child_fd = openat(frame_fd, entry.name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if(child_fd < 0) {
+                FHOS_LOG_ERROR("(%d) Could not open the directory: \"%s\"\n", errno, entry.name);
+                error = -1;
+                break;
+            }
+            
+            fhos_i64 name_offset = names.length;
+            void *new_names = fhos_context_temp_maybe_grow(ctx, names.data, &names.capacity, name_offset + entry.name_length + 1);
+            void *new_frames = fhos_context_temp_maybe_grow(ctx, frames, &frame_capacity, (frame_count + 1) * sizeof(FHOS__Remove_Frame));
+            if(new_names) { names.data = (fhos_u8 *)new_names; }
+            if(new_frames) { frames = (FHOS__Remove_Frame *)new_frames; }
+            if(!new_names || !new_frames) {
+                FHOS_LOG_ERROR("Could not allocate memory for removing a directory.\n");
+                close(child_fd);
+                error = FHOS_ERROR_OUT_OF_MEMORY;
+                break;
+            }
+            
+            // NOTE(Patrik): The name has to be copied, the parent buffer is gone if the parent gets closed below.
+            for(fhos_i32 i = 0; i <= entry.name_length; i += 1) { names.data[name_offset + i] = (fhos_u8)entry.name[i]; }
+            names.length += entry.name_length + 1;
+            
+            if(open_count >= FHOS_REMOVE_DIRECTORY_MAX_OPEN_HANDLES) {
+                fhos_close_directory(ctx, &frames[lowest_open].iterator);
+                lowest_open += 1;
+                open_count -= 1;
+            }
+            
+            FHOS__Remove_Frame *child = frames + frame_count;
+            *child = zero_frame;
+            child->name_offset = name_offset;
+            child->name_length = entry.name_length;
+            if(fhos__open_directory_from_fd(ctx, &child->iterator, child_fd) < 0) {
+                error = FHOS_ERROR_OUT_OF_MEMORY;
+                break;
+            }
+            frame_count += 1;
+            open_count += 1;
+            continue;
+        }
+        
+        if(next < 0) {
+            error = next;
+            break;
+        }
+        
+        // NOTE(Patrik): The directory is empty, close it and remove it from its parent.
+        frame_count -= 1;
+        if(frame_count == 0) {
+            fhos_close_directory(ctx, &frame->iterator);
+            open_count -= 1;
+            break;
+        }
+        
+        FHOS__Remove_Frame *parent = frames + frame_count - 1;
+        if(frame_count - 1 < lowest_open) {
+            int parent_fd = openat(frame_fd, "..", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            fhos_close_directory(ctx, &frame->iterator);
+            open_count -= 1;
+            if(parent_fd < 0 || fhos__open_directory_from_fd(ctx, &parent->iterator, parent_fd) < 0) {
+                FHOS_LOG_ERROR("(%d) Could not reopen a parent directory.\n", errno);
+                error = -1;
+                break;
+            }
+            lowest_open = frame_count - 1;
+            open_count += 1;
+        } else {
+            fhos_close_directory(ctx, &frame->iterator);
+            open_count -= 1;
+        }
+        
+        char *name = (char *)names.data + frame->name_offset;
+        if(unlinkat((int)(fhos_isize)parent->iterator.handle.data, name, AT_REMOVEDIR) != 0) {
+            FHOS_LOG_ERROR("(%d) Could not remove the directory: \"%s\"\n", errno, name);
+            error = -1;
+        }
+        names.length = frame->name_offset;
+    }
+    
+    for(fhos_i64 i = lowest_open; i < frame_count; i += 1) { fhos_close_directory(ctx, &frames[i].iterator); }
+    if(names.data) { fhos_context_temp_free(ctx, names.data); }
+    fhos_context_temp_free(ctx, frames);
+    return error;
+}
+#endif
+
+FHOS_API fhos_error
+fhos_remove_directory_recursively(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
+    if(!path_data) {
+        FHOS_LOG_ERROR("Cannot remove a directory with a null path.\n");
+        return -1;
+    }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    if(path_length < 0) {
+        path_length = 0;
+        while(path_data[path_length]) { path_length += 1; }
+    }
+    
+    FHOS_List path = {0};
+    path.capacity = 256;
+    while(path_length + 3 >= path.capacity) { path.capacity += 256; }
+    path.data = (fhos_u8 *)fhos_context_temp_alloc(ctx, path.capacity);
+    if(!path.data) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return -1;
+    }
+    
+    for(fhos_i32 i = 0; i < path_length; i += 1) {
+        if(path_data[i] == '/') {
+            path.data[i] = '\\';
+        } else {
+            path.data[i] = ((fhos_u8 *)path_data)[i];
+        }
+        path.length += 1;
+    }
+    path.data[path.length] = 0;
+    
+    DWORD attributes = GetFileAttributesA((char *)path.data);
+    if((attributes & FILE_ATTRIBUTE_DIRECTORY) != FILE_ATTRIBUTE_DIRECTORY) {
+        FHOS_LOG_ERROR("The path \"%s\" is not a directory.\n", (char *)path.data);
+        fhos_context_temp_free(ctx, path.data);
+        return -1;
+    }
+    
+    if(path.data[path.length - 1] != '/' && path.data[path.length - 1] != '\\') {
+        path.data[path.length] = '\\';
+        path.length += 1;
+    }
+    path.data[path.length] = '*';
+    path.data[path.length + 1] = 0;
+    path_length = (fhos_i32)path.length;
+    
+    // NOTE(Patrik): One find handle per directory level, grown as needed so there is no depth limit.
+    fhos_i32 handle_count = 1;
+    fhos_i32 handle_capacity = 64;
+    HANDLE *handle_stack = (HANDLE *)fhos_context_temp_alloc_non_zero(ctx, handle_capacity * sizeof(HANDLE));
+    if(!handle_stack) {
+        FHOS_LOG_ERROR("Could not allocate memory for the directory handles.\n");
+        fhos_context_temp_free(ctx, path.data);
+        return -1;
+    }
+    
+    WIN32_FIND_DATAA find_data = {0};
+    handle_stack[0] = FindFirstFileA((char *)path.data, &find_data);
+    
+    if(handle_stack[0] == INVALID_HANDLE_VALUE) {
+        DWORD last_error = GetLastError();
+        FHOS_LOG_ERROR("(%lu) Could not find the first file in the directory %s\n", last_error, path.data);
+        fhos_context_temp_free(ctx, handle_stack);
+        fhos_context_temp_free(ctx, path.data);
+        return -1;
+    }
+    
+    fhos_error error = 1;
+    while(handle_count > 0) {
+        fhos_bool should_process = FHOS_TRUE;
+        if(find_data.cFileName[0] == '.' &&
+           (find_data.cFileName[1] == 0 || (find_data.cFileName[1] == '.' && find_data.cFileName[2] == 0)))
+        {
+            should_process = FHOS_FALSE;
+        }
+        
+        if(should_process) {
+            fhos_i32 ntstring_length = 0;
+            while(find_data.cFileName[ntstring_length]) { ntstring_length += 1; }
+            
+            if(path.length + ntstring_length + 3 >= path.capacity) {
+                while(path.length + ntstring_length >= path.capacity) { path.capacity += 256; }
+                path.data = (fhos_u8 *)fhos_context_temp_realloc(ctx, path.data, path.capacity);
+            }
+            
+            for(fhos_i32 i = 0; i < ntstring_length; i += 1) { path.data[path.length + i] = find_data.cFileName[i]; }
+            
+            if((find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY) {
+                path.length += ntstring_length;
+                path.data[path.length] = '\\';
+                path.data[path.length + 1] = '*';
+                path.data[path.length + 2] = 0;
+                path.length += 1;
+                
+                if(handle_count >= handle_capacity) {
+                    HANDLE *new_handle_stack = (HANDLE *)fhos_context_temp_realloc_non_zero(ctx, handle_stack, handle_capacity * 2 * sizeof(HANDLE));
+                    if(!new_handle_stack) {
+                        FHOS_LOG_ERROR("Could not allocate memory for the directory handles.\n");
+                        for(fhos_i32 i = 0; i < handle_count; i += 1) { FindClose(handle_stack[i]); }
+                        fhos_context_temp_free(ctx, handle_stack);
+                        fhos_context_temp_free(ctx, path.data);
+                        return -1;
+                    }
+                    handle_stack = new_handle_stack;
+                    handle_capacity *= 2;
+                }
+                
+                handle_stack[handle_count] = FindFirstFileA((char *)path.data, &find_data);
+                handle_count += 1;
+                continue;
+            } else {
+                path.data[path.length + ntstring_length] = 0;
+                DeleteFile((char *)path.data);
+            }
+        }
+        
+        while(!FindNextFileA(handle_stack[handle_count - 1], &find_data)) {
+            FindClose(handle_stack[handle_count - 1]);
+            handle_count -= 1;
+            
+            path.data[path.length] = 0;
+            if(!RemoveDirectory((char *)path.data)) {
+                FHOS_LOG_ERROR("(%lu) Could not remove the directory: \"%s\"\n", GetLastError(), path.data);
+                error = -1;
+                
+                for(fhos_i32 i = 0; i < handle_count; i += 1) { FindClose(handle_stack[i]); }
+                handle_count = 0;
+            }
+            
+            if(handle_count <= 0) { break; }
+            
+            // NOTE(Patrik): The last character is '/' or '\\' so we don't count it
+            for(fhos_i64 i = path.length - 2; i >= 0; i -= 1) {
+                if(path.data[i] == '\\' || path.data[i] == '/') {
+                    path.length = i + 1;
+                    break;
+                }
+            }
+        }
+    }
+    
+    fhos_context_temp_free(ctx, handle_stack);
+    fhos_context_temp_free(ctx, path.data);
+    return error;
+#elif defined(__linux__)
+    FHOS__ALLOC_PATH(ctx, path_data, path_length);
+    if(!path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return -1;
+    }
+    
+    fhos_error error = 1;
+    int fd = open(path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if(fd < 0) {
+        FHOS_LOG_ERROR("(%d) The path \"%s\" is not a directory.\n", errno, path);
+        error = -1;
+    } else if(fhos__remove_directory_contents_at(ctx, fd) < 0) {
+        error = -1;
+    } else if(rmdir(path) != 0) {
+        FHOS_LOG_ERROR("(%d) Could not remove the directory: \"%s\"\n", errno, path);
+        error = -1;
+    }
+    
+    FHOS__FREE_PATH(ctx, path_data, path_length);
+    return error;
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+typedef struct FHOS__Remove_Parallel_State {
+    char *paths;
+    fhos_i64 *offsets;
+    fhos_i64 count;
+    fhos_i32 root_length;
+    FHOS_File_Handle root_handle;
+    FHOS_Atomic_I64 next_index;
+    FHOS_Atomic_I64 error_count;
+} FHOS__Remove_Parallel_State;
+
+static void
+fhos__remove_parallel_thread_proc(void *data) {
+    FHOS__Remove_Parallel_State *state = (FHOS__Remove_Parallel_State *)data;
+    for(;;) {
+        fhos_i64 index = fhos_atomic_fetch_add_i64(&state->next_index, 1, FHOS_MEMORY_ORDER_ACQ_REL);
+        if(index >= state->count) { break; }
+        
+        char *path = state->paths + state->offsets[index];
+#if defined(_WIN32) || defined(_WIN64)
+        if(fhos_remove_directory_recursively(0, path, -1) < 0) { fhos_atomic_fetch_add_i64(&state->error_count, 1, FHOS_MEMORY_ORDER_RELAXED); }
+#elif defined(__linux__)
+        int root_fd = (int)(fhos_isize)state->root_handle.data;
+        char *relative_path = path + state->root_length + 1;
+        int fd = openat(root_fd, relative_path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if(fd < 0 || fhos__remove_directory_contents_at(0, fd) < 0 || unlinkat(root_fd, relative_path, AT_REMOVEDIR) != 0) {
+            FHOS_LOG_ERROR("(%d) Could not remove the directory: \"%s\"\n", errno, path);
+            fhos_atomic_fetch_add_i64(&state->error_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+        }
+#else
+#  error Unimplemented on this platform.
+#endif
+    }
+}
+
+FHOS_API fhos_error
+fhos_remove_directory_recursively_parallel(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, fhos_i32 thread_count) {
+    if(!path_data) {
+        FHOS_LOG_ERROR("Cannot remove a directory with a null path.\n");
+        return -1;
+    }
+    
+    if(path_length < 0) { FHOS__GET_NTSTRING_LENGTH(path_data, path_length); }
+    while(path_length > 1 && (path_data[path_length - 1] == '/' || path_data[path_length - 1] == '\\')) { path_length -= 1; }
+    if(thread_count <= 0) { thread_count = fhos__get_processor_count(); }
+    if(thread_count == 1) { return fhos_remove_directory_recursively(ctx, path_data, path_length); }
+    
+    // NOTE(Patrik): Split the tree into enough subtrees to keep every thread busy by listing the top levels.
+    // The threads remove the subtrees and what is left above them is removed on this thread.
+    FHOS__Remove_Parallel_State state = {0};
+    state.root_length = path_length;
+    state.root_handle = fhos_get_invalid_file_handle();
+    
+    fhos_i64 paths_length = 0;
+    fhos_i64 paths_capacity = 0;
+    fhos_i64 offsets_capacity = 0;
+    fhos_i64 level_start = 0;
+    
+    state.paths = (char *)fhos_context_maybe_grow(ctx, 0, &paths_capacity, path_length + 1);
+    state.offsets = (fhos_i64 *)fhos_context_maybe_grow(ctx, 0, &offsets_capacity, sizeof(fhos_i64));
+    if(!state.paths || !state.offsets) {
+        if(state.paths) { fhos_context_free(ctx, state.paths); }
+        if(state.offsets) { fhos_context_free(ctx, state.offsets); }
+        return fhos_remove_directory_recursively(ctx, path_data, path_length);
+    }
+    for(fhos_i32 i = 0; i < path_length; i += 1) { state.paths[i] = path_data[i]; }
+    state.paths[path_length] = 0;
+    state.offsets[0] = 0;
+    state.count = 1;
+    paths_length = path_length + 1;
+    
+    fhos_bool out_of_memory = FHOS_FALSE;
+    for(fhos_i32 depth = 0; depth < 3 && !out_of_memory && state.count - level_start < thread_count * 4; depth += 1) {
+        fhos_i64 level_end = state.count;
+        for(fhos_i64 i = level_start; i < level_end && !out_of_memory; i += 1) {
+            FHOS_Directory_Listing listing = fhos_list_directory(ctx, state.paths + state.offsets[i], -1, FHOS_DIRECTORY_FLAG_SKIP_FILES, FHOS_TRUE);
+            for(fhos_i64 j = 0; j < listing.count; j += 1) {
+                FHOS_Directory_Entry *entry = listing.entries + j;
+                fhos_i64 parent_length = 0;
+                while(state.paths[state.offsets[i] + parent_length]) { parent_length += 1; }
+                
+                void *new_paths = fhos_context_maybe_grow(ctx, state.paths, &paths_capacity, paths_length + parent_length + entry->name_length + 2);
+                void *new_offsets = fhos_context_maybe_grow(ctx, state.offsets, &offsets_capacity, (state.count + 1) * sizeof(fhos_i64));
+                if(new_paths) { state.paths = (char *)new_paths; }
+                if(new_offsets) { state.offsets = (fhos_i64 *)new_offsets; }
+                if(!new_paths || !new_offsets) {
+                    out_of_memory = FHOS_TRUE;
+                    break;
+                }
+                
+                char *parent = state.paths + state.offsets[i];
+                char *child = state.paths + paths_length;
+                for(fhos_i64 k = 0; k < parent_length; k += 1) { child[k] = parent[k]; }
+                child[parent_length] = '/';
+                for(fhos_i32 k = 0; k <= entry->name_length; k += 1) { child[parent_length + 1 + k] = entry->name[k]; }
+                
+                state.offsets[state.count] = paths_length;
+                state.count += 1;
+                paths_length += parent_length + entry->name_length + 2;
+            }
+            fhos_free_directory_listing(ctx, &listing, FHOS_TRUE);
+        }
+        level_start = level_end;
+    }
+    
+    // NOTE(Patrik): Only the deepest level is handed to the threads, the levels above it
+    // are only shells once those are gone.
+    FHOS__Remove_Parallel_State thread_state = state;
+    thread_state.offsets = state.offsets + level_start;
+    thread_state.count = state.count - level_start;
+    
+#if defined(__linux__)
+    thread_state.root_handle.data = (void *)(fhos_isize)open(state.paths, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(!fhos_is_file_handle_valid(thread_state.root_handle)) { thread_state.count = 0; }
+#endif
+    
+    if(level_start > 0 && thread_state.count > 0) { fhos__run_on_threads(fhos__remove_parallel_thread_proc, &thread_state, thread_count); }
+    
+    if(fhos_is_file_handle_valid(thread_state.root_handle)) { fhos_close_file(thread_state.root_handle); }
+    fhos_context_free(ctx, state.paths);
+    fhos_context_free(ctx, state.offsets);
+    
+    fhos_error result = fhos_remove_directory_recursively(ctx, path_data, path_length);
+    if(fhos_atomic_load_i64(&thread_state.error_count, FHOS_MEMORY_ORDER_RELAXED) > 0) { return -1; }
+    return result;
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// DIRECTORY
+//
+#if defined(__linux__)
+// NOTE(Patrik): The layout the kernel writes with getdents64.
+typedef struct FHOS__Linux_Dirent64 {
+    fhos_u64 inode;
+    fhos_i64 offset;
+    fhos_u16 record_length;
+    fhos_u8  type;
+    char     name[1];
+} FHOS__Linux_Dirent64;
+
+static FHOS_Directory_Entry_Type
+fhos__directory_entry_type_from_mode(mode_t mode) {
+    if(S_ISREG(mode)) { return FHOS_DIRECTORY_ENTRY_TYPE_FILE; }
+    if(S_ISDIR(mode)) { return FHOS_DIRECTORY_ENTRY_TYPE_DIRECTORY; }
+    if(S_ISLNK(mode)) { return FHOS_DIRECTORY_ENTRY_TYPE_SYMLINK; }
+    return FHOS_DIRECTORY_ENTRY_TYPE_OTHER;
+}
+
+// NOTE(Patrik): Takes ownership of fd, it is closed on failure.
+static fhos_error
+fhos__open_directory_from_fd(FHOS_Context *ctx, FHOS_Directory_Iterator *iterator, int fd) {
+    iterator->buffer = (fhos_u8 *)fhos_context_temp_alloc_non_zero(ctx, FHOS_DIRECTORY_BUFFER_CAPACITY);
+    if(!iterator->buffer) {
+        FHOS_LOG_ERROR("Could not allocate memory for the directory iterator.\n");
+        close(fd);
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    iterator->handle.data = (void *)(fhos_isize)fd;
+    iterator->buffer_offset = 0;
+    iterator->buffer_count = 0;
+    iterator->is_done = FHOS_FALSE;
+    return FHOS_TRUE;
+}
+#endif
+
+FHOS_API fhos_error
+fhos_open_directory(FHOS_Context *ctx, FHOS_Directory_Iterator *iterator,
+                    const char *path_data, fhos_i32 path_length, FHOS_Directory_Flags flags)
+{
+    if(!iterator) {
+        FHOS_LOG_ERROR("fhos_open_directory -> The parameter iterator is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    FHOS_Directory_Iterator zero_iterator = {0};
+    *iterator = zero_iterator;
+    iterator->handle = fhos_get_invalid_file_handle();
+    iterator->flags = flags;
+    iterator->is_done = FHOS_TRUE;
+    
+    if(!path_data) {
+        FHOS_LOG_ERROR("fhos_open_directory -> The parameter path_data is null.\n");
+        return FHOS_ERROR_PATH_IS_NULL;
+    } else if(path_length == 0) {
+        FHOS_LOG_ERROR("fhos_open_directory -> The parameter path_length is zero.\n");
+        return FHOS_ERROR_PATH_IS_EMPTY;
+    }
+    
+    if(path_length < 0) { FHOS__GET_NTSTRING_LENGTH(path_data, path_length); }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    // NOTE(Patrik): Room for the "\\*" pattern, the find data is stored after the path.
+    fhos_i64 path_capacity = path_length + 3;
+    iterator->buffer = (fhos_u8 *)fhos_context_temp_alloc_non_zero(ctx, path_capacity + sizeof(WIN32_FIND_DATAA));
+    if(!iterator->buffer) {
+        FHOS_LOG_ERROR("Could not allocate memory for the directory iterator.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    // NOTE(Patrik): The pattern gets its own length, errors are logged with the caller's path.
+    char *path = (char *)iterator->buffer;
+    fhos_i32 pattern_length = path_length;
+    for(fhos_i32 i = 0; i < path_length; i += 1) { path[i] = path_data[i]; }
+    if(path[pattern_length - 1] != '/' && path[pattern_length - 1] != '\\') {
+        path[pattern_length] = '\\';
+        pattern_length += 1;
+    }
+    path[pattern_length] = '*';
+    path[pattern_length + 1] = 0;
+    
+    // NOTE(Patrik): FIND_FIRST_EX_LARGE_FETCH makes the kernel return the entries in big batches
+    // and FindExInfoBasic skips the short (8.3) names.
+    WIN32_FIND_DATAA *find_data = (WIN32_FIND_DATAA *)(iterator->buffer + path_capacity);
+    HANDLE find_handle = FindFirstFileExA(path, FindExInfoBasic, find_data, FindExSearchNameMatch,
+                                          0, FIND_FIRST_EX_LARGE_FETCH);
+    if(find_handle == INVALID_HANDLE_VALUE) {
+        DWORD last_error = GetLastError();
+        fhos_context_temp_free(ctx, iterator->buffer);
+        iterator->buffer = 0;
+        
+        if(last_error == ERROR_FILE_NOT_FOUND) {
+            // NOTE(Patrik): Not even "." was found, so the directory is empty.
+            return FHOS_TRUE;
+        }
+        
+        FHOS_LOG_ERROR("(%lu) Could not open the directory \"%.*s\"\n", last_error, path_length, path_data);
+        if(last_error == ERROR_PATH_NOT_FOUND) { return FHOS_ERROR_NOT_FOUND; }
+        if(last_error == ERROR_DIRECTORY) { return FHOS_ERROR_NOT_A_DIRECTORY; }
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    iterator->handle.data = (void *)find_handle;
+    iterator->buffer_offset = (fhos_i32)path_capacity;
+    iterator->buffer_count = 1;
+    iterator->is_done = FHOS_FALSE;
+#elif defined(__linux__)
+    FHOS__ALLOC_PATH(ctx, path_data, path_length);
+    if(!path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    int last_error = errno;
+    FHOS__FREE_PATH(ctx, path_data, path_length);
+    
+    if(fd < 0) {
+        FHOS_LOG_ERROR("(%d) Could not open the directory \"%.*s\"\n", last_error, path_length, path_data);
+        if(last_error == ENOENT) { return FHOS_ERROR_NOT_FOUND; }
+        if(last_error == ENOTDIR) { return FHOS_ERROR_NOT_A_DIRECTORY; }
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    return fhos__open_directory_from_fd(ctx, iterator, fd);
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    return FHOS_TRUE;
+}
+
+FHOS_API void
+fhos_close_directory(FHOS_Context *ctx, FHOS_Directory_Iterator *iterator) {
+    if(!iterator) { return; }
+    
+    if(fhos_is_file_handle_valid(iterator->handle)) {
+#if defined(_WIN32) || defined(_WIN64)
+        FindClose((HANDLE)iterator->handle.data);
+#elif defined(__linux__)
+        close((int)(fhos_isize)iterator->handle.data);
+#else
+#  error Unimplemented on this platform.
+#endif
+    }
+    
+    if(iterator->buffer) { fhos_context_temp_free(ctx, iterator->buffer); }
+    
+    iterator->handle = fhos_get_invalid_file_handle();
+    iterator->buffer = 0;
+    iterator->buffer_offset = 0;
+    iterator->buffer_count = 0;
+    iterator->is_done = FHOS_TRUE;
+}
+
+FHOS_API fhos_error
+fhos_next_directory_entry(FHOS_Directory_Iterator *iterator, FHOS_Directory_Entry *entry) {
+    if(!iterator || !entry) {
+        FHOS_LOG_ERROR("fhos_next_directory_entry -> The parameter iterator or entry is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    while(!iterator->is_done) {
+#if defined(_WIN32) || defined(_WIN64)
+        WIN32_FIND_DATAA *find_data = (WIN32_FIND_DATAA *)(iterator->buffer + iterator->buffer_offset);
+        if(iterator->buffer_count == 0) {
+            if(!FindNextFileA((HANDLE)iterator->handle.data, find_data)) {
+                DWORD last_error = GetLastError();
+                iterator->is_done = FHOS_TRUE;
+                if(last_error != ERROR_NO_MORE_FILES) {
+                    FHOS_LOG_ERROR("(%lu) Could not read the next directory entry.\n", last_error);
+                    return FHOS_ERROR_GENERIC_ERROR;
+                }
+                return FHOS_FALSE;
+            }
+        }
+        iterator->buffer_count = 0;
+        
+        char *name = find_data->cFileName;
+        if(name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0))) { continue; }
+        
+        DWORD attributes = find_data->dwFileAttributes;
+        FHOS_Directory_Entry_Type type = FHOS_DIRECTORY_ENTRY_TYPE_FILE;
+        if(attributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+            type = FHOS_DIRECTORY_ENTRY_TYPE_SYMLINK;
+        } else if(attributes & FILE_ATTRIBUTE_DIRECTORY) {
+            type = FHOS_DIRECTORY_ENTRY_TYPE_DIRECTORY;
+        } else if(attributes & FILE_ATTRIBUTE_DEVICE) {
+            type = FHOS_DIRECTORY_ENTRY_TYPE_OTHER;
+        }
+        
+        fhos_bool is_hidden = ((attributes & FILE_ATTRIBUTE_HIDDEN) == FILE_ATTRIBUTE_HIDDEN);
+        fhos_i64 size = (((fhos_i64)find_data->nFileSizeHigh) << 32) | (fhos_i64)find_data->nFileSizeLow;
+        fhos_i64 file_time = (((fhos_i64)find_data->ftLastWriteTime.dwHighDateTime) << 32) | (fhos_i64)find_data->ftLastWriteTime.dwLowDateTime;
+        fhos_i64 modified_time = (file_time - 116444736000000000LL) * 100;
+#elif defined(__linux__)
+        int fd = (int)(fhos_isize)iterator->handle.data;
+        if(iterator->buffer_offset >= iterator->buffer_count) {
+            long bytes_read = syscall(SYS_getdents64, fd, iterator->buffer, FHOS_DIRECTORY_BUFFER_CAPACITY);
+            if(bytes_read <= 0) {
+                iterator->is_done = FHOS_TRUE;
+                if(bytes_read < 0) {
+                    FHOS_LOG_ERROR("(%d) Could not read the next directory entries.\n", errno);
+                    return FHOS_ERROR_GENERIC_ERROR;
+                }
+                return FHOS_FALSE;
+            }
+            iterator->buffer_offset = 0;
+            iterator->buffer_count = (fhos_i32)bytes_read;
+        }
+        
+        FHOS__Linux_Dirent64 *dirent = (FHOS__Linux_Dirent64 *)(iterator->buffer + iterator->buffer_offset);
+        iterator->buffer_offset += dirent->record_length;
+        
+        char *name = dirent->name;
+        if(name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0))) { continue; }
+        
+        FHOS_Directory_Entry_Type type = FHOS_DIRECTORY_ENTRY_TYPE_OTHER;
+        switch(dirent->type) {
+            case DT_REG: type = FHOS_DIRECTORY_ENTRY_TYPE_FILE; break;
+            case DT_DIR: type = FHOS_DIRECTORY_ENTRY_TYPE_DIRECTORY; break;
+            case DT_LNK: type = FHOS_DIRECTORY_ENTRY_TYPE_SYMLINK; break;
+            case DT_UNKNOWN: type = FHOS_DIRECTORY_ENTRY_TYPE_UNKNOWN; break;
+        }
+        
+        fhos_bool is_hidden = (name[0] == '.');
+        fhos_i64 size = -1;
+        fhos_i64 modified_time = -1;
+        
+        // NOTE(Patrik): Only stat when we have to, some file systems do not fill in the type.
+        if(type == FHOS_DIRECTORY_ENTRY_TYPE_UNKNOWN ||
+           (iterator->flags & FHOS_DIRECTORY_FLAG_FETCH_MODIFIED_TIME) ||
+           (type == FHOS_DIRECTORY_ENTRY_TYPE_FILE && (iterator->flags & FHOS_DIRECTORY_FLAG_FETCH_SIZE)))
+        {
+            struct stat entry_stat;
+            if(fstatat(fd, name, &entry_stat, AT_SYMLINK_NOFOLLOW) == 0) {
+                type = fhos__directory_entry_type_from_mode(entry_stat.st_mode);
+                if(type == FHOS_DIRECTORY_ENTRY_TYPE_FILE) { size = (fhos_i64)entry_stat.st_size; }
+                modified_time = (fhos_i64)entry_stat.st_mtim.tv_sec * 1000000000LL + (fhos_i64)entry_stat.st_mtim.tv_nsec;
+            }
+        }
+#else
+#  error Unimplemented on this platform.
+#endif
+        
+        if(is_hidden && (iterator->flags & FHOS_DIRECTORY_FLAG_SKIP_HIDDEN)) { continue; }
+        if(type == FHOS_DIRECTORY_ENTRY_TYPE_DIRECTORY) {
+            if(iterator->flags & FHOS_DIRECTORY_FLAG_SKIP_DIRECTORY) { continue; }
+        } else if(iterator->flags & FHOS_DIRECTORY_FLAG_SKIP_FILES) {
+            continue;
+        }
+        
+        entry->name = name;
+        entry->name_length = 0;
+        while(name[entry->name_length]) { entry->name_length += 1; }
+        entry->type = type;
+        entry->size = (type == FHOS_DIRECTORY_ENTRY_TYPE_DIRECTORY) ? 0 : size;
+        entry->modified_time = modified_time;
+        return FHOS_TRUE;
+    }
+    
+    return FHOS_FALSE;
+}
+
+FHOS_API FHOS_Directory_Listing
+fhos_list_directory(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length,
+                    FHOS_Directory_Flags flags, fhos_bool use_temp_allocator)
+{
+    FHOS_Directory_Listing result = {0};
+    
+    FHOS_Directory_Iterator iterator;
+    if(fhos_open_directory(ctx, &iterator, path_data, path_length, flags) < 0) { return result; }
+    
+    fhos_i64 entry_capacity = 0;
+    fhos_i64 names_capacity = 0;
+    FHOS_Directory_Entry entry;
+    fhos_error error = 0;
+    while((error = fhos_next_directory_entry(&iterator, &entry)) > 0) {
+        fhos_i64 new_entry_capacity = (result.count + 1) * (fhos_i64)sizeof(FHOS_Directory_Entry);
+        fhos_i64 new_names_capacity = result.names_length + entry.name_length + 1;
+        
+        void *new_entries = result.entries;
+        void *new_names = result.names;
+        if(use_temp_allocator) {
+            new_entries = fhos_context_temp_maybe_grow(ctx, result.entries, &entry_capacity, new_entry_capacity);
+            if(new_entries) { new_names = fhos_context_temp_maybe_grow(ctx, result.names, &names_capacity, new_names_capacity); }
+        } else {
+            new_entries = fhos_context_maybe_grow(ctx, result.entries, &entry_capacity, new_entry_capacity);
+            if(new_entries) { new_names = fhos_context_maybe_grow(ctx, result.names, &names_capacity, new_names_capacity); }
+        }
+        if(new_entries) { result.entries = (FHOS_Directory_Entry *)new_entries; }
+        if(!new_entries || !new_names) {
+            FHOS_LOG_ERROR("Could not allocate memory for the directory listing.\n");
+            error = FHOS_ERROR_OUT_OF_MEMORY;
+            break;
+        }
+        result.names = (char *)new_names;
+        
+        // NOTE(Patrik): The names can move when growing, so store the offset and patch the pointers at the end.
+        FHOS_Directory_Entry *new_entry = result.entries + result.count;
+        *new_entry = entry;
+        new_entry->name = (char *)(fhos_isize)result.names_length;
+        for(fhos_i32 i = 0; i <= entry.name_length; i += 1) { result.names[result.names_length + i] = entry.name[i]; }
+        result.names_length += entry.name_length + 1;
+        result.count += 1;
+    }
+    fhos_close_directory(ctx, &iterator);
+    
+    if(error < 0) {
+        fhos_free_directory_listing(ctx, &result, use_temp_allocator);
+        return result;
+    }
+    
+    for(fhos_i64 i = 0; i < result.count; i += 1) {
+        result.entries[i].name = result.names + (fhos_isize)result.entries[i].name;
+    }
+    
+    return result;
+}
+
+FHOS_API void
+fhos_free_directory_listing(FHOS_Context *ctx, FHOS_Directory_Listing *listing, fhos_bool use_temp_allocator) {
+    if(!listing) { return; }
+    
+    if(use_temp_allocator) {
+        if(listing->entries) { fhos_context_temp_free(ctx, listing->entries); }
+        if(listing->names) { fhos_context_temp_free(ctx, listing->names); }
+    } else {
+        if(listing->entries) { fhos_context_free(ctx, listing->entries); }
+        if(listing->names) { fhos_context_free(ctx, listing->names); }
+    }
+    
+    FHOS_Directory_Listing zero_listing = {0};
+    *listing = zero_listing;
+}
+
+//
+
+typedef struct FHOS__Walk_Item {
+    char *path;
+    fhos_i32 path_length;
+    fhos_i32 depth;
+    // NOTE(Patrik): Already opened relative to the parent when there was room for it, otherwise invalid.
+    FHOS_File_Handle handle;
+} FHOS__Walk_Item;
+
+// NOTE(Patrik): The owner pushes and pops at the tail, thieves take from the head,
+// so stolen directories tend to be the big ones near the root.
+typedef struct FHOS__Walk_Queue {
+    FHOS_Mutex mutex;
+    FHOS__Walk_Item *items;
+    fhos_i64 head;
+    fhos_i64 count;
+    fhos_i64 capacity;
+} FHOS__Walk_Queue;
+
+typedef struct FHOS__Walk_State {
+    FHOS_Walk_Options *options;
+    FHOS_Walk_Result *result;
+    FHOS__Walk_Queue *queues;
+    fhos_i32 thread_count;
+    fhos_i32 root_length;
+    FHOS_File_Handle root_handle;
+    
+    FHOS_Atomic_I64 pending_count;
+    FHOS_Atomic_I64 open_handle_count;
+    FHOS_Atomic_I64 file_count;
+    FHOS_Atomic_I64 directory_count;
+    FHOS_Atomic_I64 error_count;
+    
+    // NOTE(Patrik): Walkers that ran out of work sleep on the sequence, it changes when work is pushed or the walk ends.
+    FHOS_Atomic_I32 wake_sequence;
+    FHOS_Atomic_I32 sleeping_count;
+} FHOS__Walk_State;
+
+typedef struct FHOS__Walk_Thread {
+    FHOS__Walk_State *state;
+    fhos_i32 index;
+    FHOS_List path;
+} FHOS__Walk_Thread;
+
+static fhos_bool
+fhos__walk_push(FHOS__Walk_Queue *queue, FHOS__Walk_Item *item) {
+    fhos_bool result = FHOS_TRUE;
+    fhos_lock_mutex(&queue->mutex);
+    if(queue->count >= queue->capacity) {
+        fhos_i64 new_capacity = (queue->capacity > 0) ? queue->capacity * 2 : 64;
+        FHOS__Walk_Item *new_items = (FHOS__Walk_Item *)fhos_allocate_memory_non_zero(new_capacity * sizeof(FHOS__Walk_Item));
+        if(new_items) {
+            for(fhos_i64 i = 0; i < queue->count; i += 1) {
+                new_items[i] = queue->items[(queue->head + i) % queue->capacity];
+            }
+            fhos_free_memory(queue->items);
+            queue->items = new_items;
+            queue->head = 0;
+            queue->capacity = new_capacity;
+        } else {
+            result = FHOS_FALSE;
+        }
+    }
+    if(result) {
+        queue->items[(queue->head + queue->count) % queue->capacity] = *item;
+        queue->count += 1;
+    }
+    fhos_unlock_mutex(&queue->mutex);
+    return result;
+}
+
+static fhos_bool
+fhos__walk_pop(FHOS__Walk_Queue *queue, FHOS__Walk_Item *item, fhos_bool from_head) {
+    fhos_bool result = FHOS_FALSE;
+    fhos_lock_mutex(&queue->mutex);
+    if(queue->count > 0) {
+        if(from_head) {
+            *item = queue->items[queue->head];
+            queue->head = (queue->head + 1) % queue->capacity;
+        } else {
+            *item = queue->items[(queue->head + queue->count - 1) % queue->capacity];
+        }
+        queue->count -= 1;
+        result = FHOS_TRUE;
+    }
+    fhos_unlock_mutex(&queue->mutex);
+    return result;
+}
+
+// NOTE(Patrik): The fence pairs with the one in fhos__walk_thread_proc, either the sleeper sees the new work
+// or the waker sees the sleeper.
+static void
+fhos__walk_wake(FHOS__Walk_State *state, fhos_bool wake_all) {
+    fhos_atomic_fence(FHOS_MEMORY_ORDER_SEQ_CST);
+    if(fhos_atomic_load_i32(&state->sleeping_count, FHOS_MEMORY_ORDER_ACQUIRE) > 0) {
+        fhos_atomic_fetch_add_i32(&state->wake_sequence, 1, FHOS_MEMORY_ORDER_ACQ_REL);
+        fhos__futex_wake(&state->wake_sequence, wake_all);
+    }
+}
+
+static fhos_bool
+fhos__walk_has_queued(FHOS__Walk_State *state) {
+    fhos_bool result = FHOS_FALSE;
+    for(fhos_i32 i = 0; i < state->thread_count && !result; i += 1) {
+        FHOS__Walk_Queue *queue = state->queues + i;
+        fhos_lock_mutex(&queue->mutex);
+        result = (queue->count > 0);
+        fhos_unlock_mutex(&queue->mutex);
+    }
+    return result;
+}
+
+static fhos_bool
+fhos__walk_has_extension(FHOS_Walk_Options *options, const char *name, fhos_i32 name_length) {
+    if(options->extension_count <= 0) { return FHOS_TRUE; }
+    
+    fhos_i32 dot = name_length - 1;
+    while(dot >= 0 && name[dot] != '.') { dot -= 1; }
+    if(dot < 0) { return FHOS_FALSE; }
+    
+    const char *extension = name + dot + 1;
+    fhos_i32 extension_length = name_length - dot - 1;
+    for(fhos_i32 i = 0; i < options->extension_count; i += 1) {
+        const char *it = options->extensions[i];
+        if(!it) { continue; }
+        if(it[0] == '.') { it += 1; }
+        
+        fhos_i32 j = 0;
+        for(; j < extension_length && it[j]; j += 1) {
+            char a = extension[j];
+            char b = it[j];
+            if(a >= 'A' && a <= 'Z') { a += 'a' - 'A'; }
+            if(b >= 'A' && b <= 'Z') { b += 'a' - 'A'; }
+            if(a != b) { break; }
+        }
+        if(j == extension_length && !it[j]) { return FHOS_TRUE; }
+    }
+    return FHOS_FALSE;
+}
+
+static fhos_bool
+fhos__walk_collect(FHOS_Walk_List *list, FHOS_Walk_Entry *entry) {
+    if(list->count >= list->capacity) {
+        fhos_i64 new_capacity = (list->capacity > 0) ? list->capacity * 2 : 256;
+        FHOS_Walk_Entry *new_entries = (FHOS_Walk_Entry *)fhos_reallocate_memory_non_zero(list->entries, new_capacity * sizeof(FHOS_Walk_Entry));
+        if(!new_entries) {
+            FHOS_LOG_ERROR("Could not allocate memory for the walk entries.\n");
+            return FHOS_FALSE;
+        }
+        list->entries = new_entries;
+        list->capacity = new_capacity;
+    }
+    
+    if(list->paths_length + entry->path_length + 1 > list->paths_capacity) {
+        fhos_i64 new_capacity = (list->paths_capacity > 0) ? list->paths_capacity : 4096;
+        while(list->paths_length + entry->path_length + 1 > new_capacity) { new_capacity *= 2; }
+        char *new_paths = (char *)fhos_reallocate_memory_non_zero(list->paths, new_capacity);
+        if(!new_paths) {
+            FHOS_LOG_ERROR("Could not allocate memory for the walk entries.\n");
+            return FHOS_FALSE;
+        }
+        list->paths = new_paths;
+        list->paths_capacity = new_capacity;
+    }
+    
+    // NOTE(Patrik): Store offsets while the paths can still move, fhos_walk_directory patches them at the end.
+    FHOS_Walk_Entry *new_entry = list->entries + list->count;
+    *new_entry = *entry;
+    new_entry->path = (char *)(fhos_isize)list->paths_length;
+    new_entry->name = (char *)(fhos_isize)(list->paths_length + (entry->name - entry->path));
+    for(fhos_i32 i = 0; i <= entry->path_length; i += 1) { list->paths[list->paths_length + i] = entry->path[i]; }
+    list->paths_length += entry->path_length + 1;
+    list->count += 1;
+    return FHOS_TRUE;
+}
+
+static void
+fhos__walk_process(FHOS__Walk_Thread *thread, FHOS__Walk_Item *item) {
+    FHOS__Walk_State *state = thread->state;
+    FHOS_Walk_Options *options = state->options;
+    
+    FHOS_Directory_Flags flags = options->flags & ~(FHOS_DIRECTORY_FLAG_SKIP_FILES | FHOS_DIRECTORY_FLAG_SKIP_DIRECTORY);
+    if(options->modified_after > 0) { flags |= FHOS_DIRECTORY_FLAG_FETCH_MODIFIED_TIME; }
+    
+    FHOS_Directory_Iterator iterator = {0};
+    fhos_error error = 0;
+#if defined(_WIN32) || defined(_WIN64)
+    error = fhos_open_directory(0, &iterator, item->path, item->path_length, flags);
+#elif defined(__linux__)
+    iterator.flags = flags;
+    int fd = (int)(fhos_isize)item->handle.data;
+    if(fd < 0) {
+        const char *relative_path = (item->depth > 0) ? item->path + state->root_length + 1 : ".";
+        fd = openat((int)(fhos_isize)state->root_handle.data, relative_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    } else {
+        fhos_atomic_fetch_add_i64(&state->open_handle_count, -1, FHOS_MEMORY_ORDER_ACQ_REL);
+    }
+    
+    if(fd < 0) {
+        FHOS_LOG_ERROR("(%d) Could not open the directory \"%s\"\n", errno, item->path);
+        error = FHOS_ERROR_GENERIC_ERROR;
+    } else {
+        error = fhos__open_directory_from_fd(0, &iterator, fd);
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    if(error < 0) {
+        fhos_atomic_fetch_add_i64(&state->error_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+        return;
+    }
+    
+    FHOS_List *path = &thread->path;
+    FHOS_Directory_Entry directory_entry;
+    while((error = fhos_next_directory_entry(&iterator, &directory_entry)) > 0) {
+        fhos_i64 path_length = item->path_length + 1 + directory_entry.name_length;
+        if(path_length + 1 > path->capacity) {
+            fhos_i64 new_capacity = (path->capacity > 0) ? path->capacity : 1024;
+            while(path_length + 1 > new_capacity) { new_capacity *= 2; }
+            fhos_u8 *new_data = (fhos_u8 *)fhos_reallocate_memory_non_zero(path->data, new_capacity);
+            if(!new_data) {
+                fhos_atomic_fetch_add_i64(&state->error_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+                continue;
+            }
+            path->data = new_data;
+            path->capacity = new_capacity;
+        }
+        
+        for(fhos_i32 i = 0; i < item->path_length; i += 1) { path->data[i] = (fhos_u8)item->path[i]; }
+        path->data[item->path_length] = '/';
+        for(fhos_i32 i = 0; i <= directory_entry.name_length; i += 1) {
+            path->data[item->path_length + 1 + i] = (fhos_u8)directory_entry.name[i];
+        }
+        path->length = path_length;
+        
+        FHOS_Walk_Entry entry;
+        entry.path = (char *)path->data;
+        entry.name = entry.path + item->path_length + 1;
+        entry.path_length = (fhos_i32)path_length;
+        entry.name_length = directory_entry.name_length;
+        entry.depth = item->depth;
+        entry.type = directory_entry.type;
+        entry.size = directory_entry.size;
+        entry.modified_time = directory_entry.modified_time;
+        
+        FHOS_Walk_List *list = (options->collect_entries) ? state->result->lists + thread->index : 0;
+        
+        if(entry.type == FHOS_DIRECTORY_ENTRY_TYPE_DIRECTORY) {
+            fhos_atomic_fetch_add_i64(&state->directory_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+            
+            if(!(options->flags & FHOS_DIRECTORY_FLAG_SKIP_DIRECTORY)) {
+                if(options->proc && !options->proc(options->user_data, thread->index, &entry)) { continue; }
+                if(list && !fhos__walk_collect(list, &entry)) { fhos_atomic_fetch_add_i64(&state->error_count, 1, FHOS_MEMORY_ORDER_RELAXED); }
+            }
+            
+            if(options->max_depth > 0 && item->depth + 1 >= options->max_depth) { continue; }
+            
+            FHOS__Walk_Item child = {0};
+            child.path = (char *)fhos_allocate_memory_non_zero(path_length + 1);
+            if(!child.path) {
+                fhos_atomic_fetch_add_i64(&state->error_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+                continue;
+            }
+            for(fhos_i64 i = 0; i <= path_length; i += 1) { child.path[i] = (char)path->data[i]; }
+            child.path_length = (fhos_i32)path_length;
+            child.depth = item->depth + 1;
+            child.handle = fhos_get_invalid_file_handle();
+            
+#if defined(__linux__)
+            // NOTE(Patrik): Opening relative to the directory we already have open skips the full path lookup.
+            if(fhos_atomic_fetch_add_i64(&state->open_handle_count, 1, FHOS_MEMORY_ORDER_ACQ_REL) < FHOS_WALK_MAX_OPEN_HANDLES) {
+                int child_fd = openat(fd, directory_entry.name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+                if(child_fd >= 0) {
+                    child.handle.data = (void *)(fhos_isize)child_fd;
+                } else {
+                    fhos_atomic_fetch_add_i64(&state->open_handle_count, -1, FHOS_MEMORY_ORDER_ACQ_REL);
+                }
+            } else {
+                fhos_atomic_fetch_add_i64(&state->open_handle_count, -1, FHOS_MEMORY_ORDER_ACQ_REL);
+            }
+#endif
+            
+            fhos_atomic_fetch_add_i64(&state->pending_count, 1, FHOS_MEMORY_ORDER_ACQ_REL);
+            if(!fhos__walk_push(state->queues + thread->index, &child)) {
+                fhos_atomic_fetch_add_i64(&state->pending_count, -1, FHOS_MEMORY_ORDER_ACQ_REL);
+                fhos_atomic_fetch_add_i64(&state->error_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+                if(fhos_is_file_handle_valid(child.handle)) {
+                    fhos_close_file(child.handle);
+#if defined(__linux__)
+                    fhos_atomic_fetch_add_i64(&state->open_handle_count, -1, FHOS_MEMORY_ORDER_ACQ_REL);
+#endif
+                }
+                fhos_free_memory(child.path);
+            } else {
+                fhos__walk_wake(state, FHOS_FALSE);
+            }
+        } else {
+            if(options->flags & FHOS_DIRECTORY_FLAG_SKIP_FILES) { continue; }
+            if(!fhos__walk_has_extension(options, entry.name, entry.name_length)) { continue; }
+            if(options->modified_after > 0 && entry.modified_time <= options->modified_after) { continue; }
+            
+            fhos_atomic_fetch_add_i64(&state->file_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+            if(options->proc) { options->proc(options->user_data, thread->index, &entry); }
+            if(list && !fhos__walk_collect(list, &entry)) { fhos_atomic_fetch_add_i64(&state->error_count, 1, FHOS_MEMORY_ORDER_RELAXED); }
+        }
+    }
+    
+    if(error < 0) { fhos_atomic_fetch_add_i64(&state->error_count, 1, FHOS_MEMORY_ORDER_RELAXED); }
+    fhos_close_directory(0, &iterator);
+}
+
+static void
+fhos__walk_thread_proc(void *data) {
+    FHOS__Walk_Thread *thread = (FHOS__Walk_Thread *)data;
+    FHOS__Walk_State *state = thread->state;
+    
+    fhos_i32 idle_count = 0;
+    for(;;) {
+        FHOS__Walk_Item item;
+        fhos_bool found = fhos__walk_pop(state->queues + thread->index, &item, FHOS_FALSE);
+        for(fhos_i32 i = 1; !found && i < state->thread_count; i += 1) {
+            found = fhos__walk_pop(state->queues + ((thread->index + i) % state->thread_count), &item, FHOS_TRUE);
+        }
+        
+        if(found) {
+            fhos__walk_process(thread, &item);
+            fhos_free_memory(item.path);
+            if(fhos_atomic_fetch_add_i64(&state->pending_count, -1, FHOS_MEMORY_ORDER_ACQ_REL) == 1) { fhos__walk_wake(state, FHOS_TRUE); }
+            idle_count = 0;
+            continue;
+        }
+        
+        // NOTE(Patrik): Pending counts both queued and in-flight directories,
+        // so when it hits zero nobody can push more work.
+        if(fhos_atomic_load_i64(&state->pending_count, FHOS_MEMORY_ORDER_ACQUIRE) == 0) { break; }
+        
+        idle_count += 1;
+        if(idle_count < 64) {
+            FHOS__CPU_PAUSE();
+            continue;
+        }
+        
+        // NOTE(Patrik): Registered before looking again, so work pushed after the look wakes this thread.
+        fhos_i32 sequence = fhos_atomic_load_i32(&state->wake_sequence, FHOS_MEMORY_ORDER_ACQUIRE);
+        fhos_atomic_fetch_add_i32(&state->sleeping_count, 1, FHOS_MEMORY_ORDER_ACQ_REL);
+        fhos_atomic_fence(FHOS_MEMORY_ORDER_SEQ_CST);
+        if(fhos_atomic_load_i64(&state->pending_count, FHOS_MEMORY_ORDER_ACQUIRE) > 0 && !fhos__walk_has_queued(state)) {
+            fhos__futex_wait(&state->wake_sequence, sequence, -1);
+        }
+        fhos_atomic_fetch_add_i32(&state->sleeping_count, -1, FHOS_MEMORY_ORDER_ACQ_REL);
+    }
+}
+
+static void
+fhos__walk_job_proc(FHOS_Context *ctx, void *data) {
+    (void)ctx;
+    fhos__walk_thread_proc(data);
+}
+
+FHOS_API FHOS_Walk_Result
+fhos_walk_directory(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, FHOS_Walk_Options *options) {
+    FHOS_Walk_Result result = {0};
+    
+    if(!path_data) {
+        FHOS_LOG_ERROR("fhos_walk_directory -> The parameter path_data is null.\n");
+        result.error_count = 1;
+        return result;
+    } else if(path_length == 0) {
+        FHOS_LOG_ERROR("fhos_walk_directory -> The parameter path_length is zero.\n");
+        result.error_count = 1;
+        return result;
+    }
+    
+    FHOS_Walk_Options default_options = {0};
+    if(!options) { options = &default_options; }
+    
+    if(path_length < 0) { FHOS__GET_NTSTRING_LENGTH(path_data, path_length); }
+    while(path_length > 1 && (path_data[path_length - 1] == '/' || path_data[path_length - 1] == '\\')) { path_length -= 1; }
+    
+    fhos_i32 thread_count = (options->thread_count > 0) ? options->thread_count : fhos__get_processor_count();
+    
+    FHOS__Walk_State state = {0};
+    state.options = options;
+    state.result = &result;
+    state.thread_count = thread_count;
+    state.root_length = path_length;
+    state.root_handle = fhos_get_invalid_file_handle();
+    
+    FHOS__Walk_Item root = {0};
+    root.path = (char *)fhos_allocate_memory_non_zero(path_length + 1);
+    state.queues = (FHOS__Walk_Queue *)fhos_allocate_memory(thread_count * sizeof(FHOS__Walk_Queue));
+    FHOS__Walk_Thread *threads = (FHOS__Walk_Thread *)fhos_allocate_memory(thread_count * sizeof(FHOS__Walk_Thread));
+    if(options->collect_entries) {
+        result.lists = (FHOS_Walk_List *)fhos_allocate_memory(thread_count * sizeof(FHOS_Walk_List));
+        result.list_count = (result.lists) ? thread_count : 0;
+    }
+    
+    if(!root.path || !state.queues || !threads || (options->collect_entries && !result.lists)) {
+        FHOS_LOG_ERROR("Could not allocate memory for the directory walk.\n");
+        fhos_free_memory(root.path);
+        fhos_free_memory(state.queues);
+        fhos_free_memory(threads);
+        fhos_free_walk_result(&result);
+        result.error_count = 1;
+        return result;
+    }
+    
+    for(fhos_i32 i = 0; i < path_length; i += 1) { root.path[i] = path_data[i]; }
+    root.path[path_length] = 0;
+    root.path_length = path_length;
+    root.handle = fhos_get_invalid_file_handle();
+    
+#if defined(__linux__)
+    // NOTE(Patrik): Kept open for the whole walk, directories that could not be opened relative
+    // to their parent are opened relative to this instead.
+    state.root_handle.data = (void *)(fhos_isize)open(root.path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(!fhos_is_file_handle_valid(state.root_handle)) {
+        FHOS_LOG_ERROR("(%d) Could not open the directory \"%s\"\n", errno, root.path);
+        fhos_free_memory(root.path);
+        fhos_free_memory(state.queues);
+        fhos_free_memory(threads);
+        fhos_free_walk_result(&result);
+        result.error_count = 1;
+        return result;
+    }
+#endif
+    
+    for(fhos_i32 i = 0; i < thread_count; i += 1) {
+        threads[i].state = &state;
+        threads[i].index = i;
+    }
+    
+    fhos_atomic_store_i64(&state.pending_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+    fhos__walk_push(state.queues, &root);
+    
+    // NOTE(Patrik): The calling thread is walker zero, the others are jobs. A walker that only gets to run
+    // after the walk is done finds nothing pending and returns right away.
+    FHOS_Job_Counter counter = {0};
+    for(fhos_i32 i = 1; i < thread_count; i += 1) { fhos_run_job(ctx, fhos__walk_job_proc, threads + i, &counter); }
+    fhos__walk_thread_proc(threads);
+    fhos_wait_for_jobs(ctx, &counter);
+    
+    for(fhos_i32 i = 0; i < thread_count; i += 1) {
+        fhos_free_memory(state.queues[i].items);
+        fhos_free_memory(threads[i].path.data);
+    }
+    fhos_free_memory(state.queues);
+    fhos_free_memory(threads);
+    if(fhos_is_file_handle_valid(state.root_handle)) { fhos_close_file(state.root_handle); }
+    
+    for(fhos_i32 i = 0; i < result.list_count; i += 1) {
+        FHOS_Walk_List *list = result.lists + i;
+        for(fhos_i64 j = 0; j < list->count; j += 1) {
+            list->entries[j].path = list->paths + (fhos_isize)list->entries[j].path;
+            list->entries[j].name = list->paths + (fhos_isize)list->entries[j].name;
+        }
+    }
+    
+    result.file_count = fhos_atomic_load_i64(&state.file_count, FHOS_MEMORY_ORDER_RELAXED);
+    result.directory_count = fhos_atomic_load_i64(&state.directory_count, FHOS_MEMORY_ORDER_RELAXED);
+    result.error_count = fhos_atomic_load_i64(&state.error_count, FHOS_MEMORY_ORDER_RELAXED);
+    return result;
+}
+
+FHOS_API void
+fhos_free_walk_result(FHOS_Walk_Result *result) {
+    if(!result) { return; }
+    
+    for(fhos_i32 i = 0; i < result->list_count; i += 1) {
+        fhos_free_memory(result->lists[i].entries);
+        fhos_free_memory(result->lists[i].paths);
+    }
+    fhos_free_memory(result->lists);
+    
+    FHOS_Walk_Result zero_result = {0};
+    *result = zero_result;
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// WATCHER
+//
+#if defined(_WIN32) || defined(_WIN64)
+typedef struct FHOS__Windows_Watch {
+    HANDLE directory;
+    OVERLAPPED overlapped;
+    DWORD buffer[FHOS_WATCHER_BUFFER_CAPACITY / sizeof(DWORD)];
+} FHOS__Windows_Watch;
+
+static fhos_bool
+fhos__windows_watch_read(FHOS__Windows_Watch *watch, fhos_bool recursive) {
+    DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE;
+    ZeroMemory(&watch->overlapped, sizeof(watch->overlapped));
+    return ReadDirectoryChangesW(watch->directory, watch->buffer, sizeof(watch->buffer), recursive, filter, 0, &watch->overlapped, 0) != 0;
+}
+#endif
+
+static FHOS_Watch *
+fhos__find_watch(FHOS_Watcher *watcher, fhos_i64 id) {
+    fhos_i64 low = 0;
+    fhos_i64 high = watcher->watch_count - 1;
+    while(low <= high) {
+        fhos_i64 middle = low + (high - low) / 2;
+        fhos_i64 middle_id = watcher->watches[middle].id;
+        if(middle_id == id) { return watcher->watches + middle; }
+        if(middle_id < id) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return 0;
+}
+
+static FHOS_Watch *
+fhos__add_watch(FHOS_Context *ctx, FHOS_Watcher *watcher, fhos_i64 id, const char *path, fhos_i32 path_length, fhos_bool recursive) {
+    void *new_watches = fhos_context_maybe_grow(ctx, watcher->watches, &watcher->watch_capacity, (watcher->watch_count + 1) * sizeof(FHOS_Watch));
+    if(new_watches) { watcher->watches = (FHOS_Watch *)new_watches; }
+    void *new_paths = fhos_context_maybe_grow(ctx, watcher->paths, &watcher->paths_capacity, watcher->paths_length + path_length + 1);
+    if(new_paths) { watcher->paths = (char *)new_paths; }
+    if(!new_watches || !new_paths) {
+        FHOS_LOG_ERROR("Could not allocate memory for the watch.\n");
+        return 0;
+    }
+    
+    // NOTE(Patrik): Keep the watches sorted, new ids are almost always the largest so this rarely moves anything.
+    fhos_i64 index = watcher->watch_count;
+    while(index > 0 && watcher->watches[index - 1].id > id) {
+        watcher->watches[index] = watcher->watches[index - 1];
+        index -= 1;
+    }
+    
+    FHOS_Watch *watch = watcher->watches + index;
+    watch->id = id;
+    watch->path_offset = watcher->paths_length;
+    watch->path_length = path_length;
+    watch->is_recursive = recursive;
+    watch->platform = 0;
+    for(fhos_i32 i = 0; i < path_length; i += 1) { watcher->paths[watcher->paths_length + i] = path[i]; }
+    watcher->paths[watcher->paths_length + path_length] = 0;
+    watcher->paths_length += path_length + 1;
+    watcher->watch_count += 1;
+    return watch;
+}
+
+static void
+fhos__push_file_change(FHOS_Context *ctx, FHOS_File_Changes *changes, FHOS_File_Change_Type type, fhos_bool is_directory,
+                       const char *path, fhos_i32 path_length, const char *name, fhos_i32 name_length)
+{
+    fhos_i32 total_length = path_length + ((name_length > 0) ? name_length + 1 : 0);
+    
+    // NOTE(Patrik): Writers often produce a burst of the same event, only keep the first one in a row.
+    if(changes->count > 0) {
+        FHOS_File_Change *last = changes->changes + changes->count - 1;
+        if(last->type == type && last->path_length == total_length) {
+            char *last_path = changes->paths + (fhos_isize)last->path;
+            fhos_bool is_same = FHOS_TRUE;
+            for(fhos_i32 i = 0; i < path_length && is_same; i += 1) { is_same = (last_path[i] == path[i]); }
+            for(fhos_i32 i = 0; i < name_length && is_same; i += 1) { is_same = (last_path[path_length + 1 + i] == name[i]); }
+            if(is_same) { return; }
+        }
+    }
+    
+    void *new_changes = fhos_context_maybe_grow(ctx, changes->changes, &changes->capacity, (changes->count + 1) * sizeof(FHOS_File_Change));
+    if(new_changes) { changes->changes = (FHOS_File_Change *)new_changes; }
+    void *new_paths = fhos_context_maybe_grow(ctx, changes->paths, &changes->paths_capacity, changes->paths_length + total_length + 1);
+    if(new_paths) { changes->paths = (char *)new_paths; }
+    if(!new_changes || !new_paths) {
+        FHOS_LOG_ERROR("Could not allocate memory for the file changes.\n");
+        return;
+    }
+    
+    // NOTE(Patrik): Offsets until the end of the poll, the paths can still move.
+    FHOS_File_Change *change = changes->changes + changes->count;
+    change->path = (char *)(fhos_isize)changes->paths_length;
+    change->path_length = total_length;
+    change->type = type;
+    change->is_directory = is_directory;
+    
+    char *change_path = changes->paths + changes->paths_length;
+    for(fhos_i32 i = 0; i < path_length; i += 1) { change_path[i] = path[i]; }
+    if(name_length > 0) {
+        change_path[path_length] = '/';
+        for(fhos_i32 i = 0; i < name_length; i += 1) { change_path[path_length + 1 + i] = name[i]; }
+    }
+    change_path[total_length] = 0;
+    changes->paths_length += total_length + 1;
+    changes->count += 1;
+}
+
+#if defined(__linux__)
+static fhos_error
+fhos__inotify_add_watch(FHOS_Context *ctx, FHOS_Watcher *watcher, const char *path, fhos_i32 path_length, fhos_bool recursive) {
+    fhos_u32 mask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+    int wd = inotify_add_watch((int)(fhos_isize)watcher->handle.data, path, mask);
+    if(wd < 0) {
+        FHOS_LOG_ERROR("(%d) Could not watch the directory \"%s\"\n", errno, path);
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    // NOTE(Patrik): Watching the same directory twice gives back the same descriptor.
+    if(fhos__find_watch(watcher, wd)) { return FHOS_FALSE; }
+    if(!fhos__add_watch(ctx, watcher, wd, path, path_length, recursive)) { return FHOS_ERROR_OUT_OF_MEMORY; }
+    return FHOS_TRUE;
+}
+
+// NOTE(Patrik): A moved directory keeps its watches, they would go on reporting under the old path.
+// So the watch of path and of every directory below it is dropped, and the new place is watched again.
+static void
+fhos__inotify_remove_subtree(FHOS_Watcher *watcher, const char *path, fhos_i32 path_length) {
+    int fd = (int)(fhos_isize)watcher->handle.data;
+    fhos_i64 kept_count = 0;
+    for(fhos_i64 i = 0; i < watcher->watch_count; i += 1) {
+        FHOS_Watch *watch = watcher->watches + i;
+        const char *watch_path = watcher->paths + watch->path_offset;
+        fhos_bool is_below = (watch->path_length == path_length || (watch->path_length > path_length && watch_path[path_length] == '/'));
+        for(fhos_i32 j = 0; j < path_length && is_below; j += 1) { is_below = (watch_path[j] == path[j]); }
+        
+        if(is_below) {
+            inotify_rm_watch(fd, (int)watch->id);
+        } else {
+            watcher->watches[kept_count] = *watch;
+            kept_count += 1;
+        }
+    }
+    watcher->watch_count = kept_count;
+}
+
+// NOTE(Patrik): Returns path/name in stack_path, or in temp memory when it does not fit there.
+static char *
+fhos__join_watch_path(FHOS_Context *ctx, char *stack_path, const char *path, fhos_i32 path_length, const char *name, fhos_i32 name_length) {
+    fhos_i32 length = path_length + 1 + name_length;
+    char *result = stack_path;
+    if(length >= FHOS_STACK_PATH_CAPACITY) { result = (char *)fhos_context_temp_alloc_non_zero(ctx, length + 1); }
+    if(!result) { return 0; }
+    
+    for(fhos_i32 i = 0; i < path_length; i += 1) { result[i] = path[i]; }
+    result[path_length] = '/';
+    for(fhos_i32 i = 0; i < name_length; i += 1) { result[path_length + 1 + i] = name[i]; }
+    result[length] = 0;
+    return result;
+}
+
+// NOTE(Patrik): Watches every directory below path. When report_changes is set the entries found are
+// reported as created, this is used for directories that show up after the watch started,
+// since things can be created in them before the watch is in place.
+static void
+fhos__inotify_add_subtree(FHOS_Context *ctx, FHOS_Watcher *watcher, const char *path, fhos_i32 path_length,
+                          FHOS_File_Changes *changes, fhos_i32 thread_count)
+{
+    FHOS_Walk_Options options = {0};
+    options.thread_count = thread_count;
+    options.collect_entries = FHOS_TRUE;
+    if(!changes) { options.flags |= FHOS_DIRECTORY_FLAG_SKIP_FILES; }
+    
+    FHOS_Walk_Result result = fhos_walk_directory(ctx, path, path_length, &options);
+    for(fhos_i32 i = 0; i < result.list_count; i += 1) {
+        FHOS_Walk_List *list = result.lists + i;
+        for(fhos_i64 j = 0; j < list->count; j += 1) {
+            FHOS_Walk_Entry *entry = list->entries + j;
+            fhos_bool is_directory = (entry->type == FHOS_DIRECTORY_ENTRY_TYPE_DIRECTORY);
+            if(is_directory) { fhos__inotify_add_watch(ctx, watcher, entry->path, entry->path_length, FHOS_TRUE); }
+            if(changes) {
+                fhos__push_file_change(ctx, changes, FHOS_FILE_CHANGE_TYPE_CREATED, is_directory, entry->path, entry->path_length, 0, 0);
+            }
+        }
+    }
+    fhos_free_walk_result(&result);
+}
+#endif
+
+FHOS_API fhos_error
+fhos_watch_directory(FHOS_Context *ctx, FHOS_Watcher *watcher, const char *path_data, fhos_i32 path_length, fhos_bool recursive) {
+    if(!watcher) {
+        FHOS_LOG_ERROR("fhos_watch_directory -> The parameter watcher is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    if(!path_data) {
+        FHOS_LOG_ERROR("fhos_watch_directory -> The parameter path_data is null.\n");
+        return FHOS_ERROR_PATH_IS_NULL;
+    } else if(path_length == 0) {
+        FHOS_LOG_ERROR("fhos_watch_directory -> The parameter path_length is zero.\n");
+        return FHOS_ERROR_PATH_IS_EMPTY;
+    }
+    
+    if(path_length < 0) { FHOS__GET_NTSTRING_LENGTH(path_data, path_length); }
+    while(path_length > 1 && (path_data[path_length - 1] == '/' || path_data[path_length - 1] == '\\')) { path_length -= 1; }
+    
+    if(!watcher->is_initialized) {
+        watcher->handle = fhos_get_invalid_file_handle();
+#if defined(__linux__)
+        int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if(fd < 0) {
+            FHOS_LOG_ERROR("(%d) Could not create the inotify instance.\n", errno);
+            return FHOS_ERROR_GENERIC_ERROR;
+        }
+        
+        watcher->buffer = (fhos_u8 *)fhos_context_alloc_non_zero(ctx, FHOS_WATCHER_BUFFER_CAPACITY);
+        if(!watcher->buffer) {
+            FHOS_LOG_ERROR("Could not allocate memory for the watcher.\n");
+            close(fd);
+            return FHOS_ERROR_OUT_OF_MEMORY;
+        }
+        watcher->handle.data = (void *)(fhos_isize)fd;
+#endif
+        watcher->is_initialized = FHOS_TRUE;
+    }
+    
+    FHOS__ALLOC_PATH(ctx, path_data, path_length);
+    if(!path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    fhos_error result = FHOS_TRUE;
+#if defined(_WIN32) || defined(_WIN64)
+    // NOTE(Patrik): ReadDirectoryChangesW watches whole subtrees by itself.
+    FHOS__Windows_Watch *windows_watch = (FHOS__Windows_Watch *)fhos_context_alloc(ctx, sizeof(FHOS__Windows_Watch));
+    if(!windows_watch) {
+        FHOS_LOG_ERROR("Could not allocate memory for the watch.\n");
+        result = FHOS_ERROR_OUT_OF_MEMORY;
+    } else {
+        windows_watch->directory = CreateFileA(path, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0,
+                                               OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, 0);
+        if(windows_watch->directory == INVALID_HANDLE_VALUE || !fhos__windows_watch_read(windows_watch, recursive)) {
+            FHOS_LOG_ERROR("(%lu) Could not watch the directory \"%s\"\n", GetLastError(), path);
+            if(windows_watch->directory != INVALID_HANDLE_VALUE) { CloseHandle(windows_watch->directory); }
+            fhos_context_free(ctx, windows_watch);
+            result = FHOS_ERROR_GENERIC_ERROR;
+        } else {
+            fhos_i64 id = (watcher->watch_count > 0) ? watcher->watches[watcher->watch_count - 1].id + 1 : 1;
+            FHOS_Watch *watch = fhos__add_watch(ctx, watcher, id, path, path_length, recursive);
+            if(watch) {
+                watch->platform = windows_watch;
+            } else {
+                CancelIo(windows_watch->directory);
+                CloseHandle(windows_watch->directory);
+                fhos_context_free(ctx, windows_watch);
+                result = FHOS_ERROR_OUT_OF_MEMORY;
+            }
+        }
+    }
+#elif defined(__linux__)
+    // NOTE(Patrik): inotify only watches a single directory, so a recursive watch is one watch per directory.
+    result = fhos__inotify_add_watch(ctx, watcher, path, path_length, recursive);
+    if(result >= 0 && recursive) { fhos__inotify_add_subtree(ctx, watcher, path, path_length, 0, 0); }
+    if(result >= 0) { result = FHOS_TRUE; }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    FHOS__FREE_PATH(ctx, path_data, path_length);
+    return result;
+}
+
+FHOS_API fhos_i64
+fhos_poll_changes(FHOS_Context *ctx, FHOS_Watcher *watcher, FHOS_File_Changes *changes) {
+    if(!watcher || !changes) {
+        FHOS_LOG_ERROR("fhos_poll_changes -> The parameter watcher or changes is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    changes->count = 0;
+    changes->paths_length = 0;
+    if(!watcher->is_initialized) { return 0; }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    for(fhos_i64 i = 0; i < watcher->watch_count; i += 1) {
+        FHOS_Watch *watch = watcher->watches + i;
+        FHOS__Windows_Watch *windows_watch = (FHOS__Windows_Watch *)watch->platform;
+        if(!windows_watch) { continue; }
+        
+        DWORD bytes_returned = 0;
+        if(!GetOverlappedResult(windows_watch->directory, &windows_watch->overlapped, &bytes_returned, FALSE)) {
+            DWORD last_error = GetLastError();
+            if(last_error != ERROR_IO_INCOMPLETE) {
+                FHOS_LOG_ERROR("(%lu) Could not read the changes of \"%s\"\n", last_error, watcher->paths + watch->path_offset);
+                fhos__push_file_change(ctx, changes, FHOS_FILE_CHANGE_TYPE_OVERFLOW, FHOS_TRUE, watcher->paths + watch->path_offset, watch->path_length, 0, 0);
+                fhos__windows_watch_read(windows_watch, watch->is_recursive);
+            }
+            continue;
+        }
+        
+        if(bytes_returned == 0) {
+            fhos__push_file_change(ctx, changes, FHOS_FILE_CHANGE_TYPE_OVERFLOW, FHOS_TRUE, watcher->paths + watch->path_offset, watch->path_length, 0, 0);
+        }
+        
+        fhos_u8 *at = (fhos_u8 *)windows_watch->buffer;
+        while(bytes_returned > 0) {
+            FILE_NOTIFY_INFORMATION *information = (FILE_NOTIFY_INFORMATION *)at;
+            
+            char name[1024];
+            int name_length = WideCharToMultiByte(CP_UTF8, 0, information->FileName, (int)(information->FileNameLength / sizeof(WCHAR)),
+                                                  name, sizeof(name), 0, 0);
+            for(int j = 0; j < name_length; j += 1) { if(name[j] == '\\') { name[j] = '/'; } }
+            
+            FHOS_File_Change_Type type = FHOS_FILE_CHANGE_TYPE_MODIFIED;
+            switch(information->Action) {
+                case FILE_ACTION_ADDED:
+                case FILE_ACTION_RENAMED_NEW_NAME: type = FHOS_FILE_CHANGE_TYPE_CREATED; break;
+                case FILE_ACTION_REMOVED:
+                case FILE_ACTION_RENAMED_OLD_NAME: type = FHOS_FILE_CHANGE_TYPE_DELETED; break;
+            }
+            fhos_i64 change_count = changes->count;
+            fhos__push_file_change(ctx, changes, type, FHOS_TRUE, watcher->paths + watch->path_offset, watch->path_length, name, name_length);
+            
+            // NOTE(Patrik): Windows does not say what kind of entry changed, so it is looked at while it still exists.
+            // A removed one stays a directory, that only invalidates more of a metadata cache.
+            if(changes->count > change_count && type != FHOS_FILE_CHANGE_TYPE_DELETED) {
+                FHOS_File_Change *change = changes->changes + change_count;
+                DWORD attributes = GetFileAttributesA(changes->paths + (fhos_isize)change->path);
+                if(attributes != INVALID_FILE_ATTRIBUTES) { change->is_directory = ((attributes & FILE_ATTRIBUTE_DIRECTORY) != 0); }
+            }
+            
+            if(information->NextEntryOffset == 0) { break; }
+            at += information->NextEntryOffset;
+        }
+        
+        fhos__windows_watch_read(windows_watch, watch->is_recursive);
+    }
+#elif defined(__linux__)
+    int fd = (int)(fhos_isize)watcher->handle.data;
+    for(;;) {
+        ssize_t bytes_read = read(fd, watcher->buffer, FHOS_WATCHER_BUFFER_CAPACITY);
+        if(bytes_read < 0) {
+            if(errno == EINTR) { continue; }
+            if(errno != EAGAIN) { FHOS_LOG_ERROR("(%d) Could not read the file changes.\n", errno); }
+            break;
+        }
+        if(bytes_read == 0) { break; }
+        
+        for(fhos_u8 *at = watcher->buffer; at < watcher->buffer + bytes_read;) {
+            struct inotify_event *event = (struct inotify_event *)at;
+            at += sizeof(struct inotify_event) + event->len;
+            
+            if(event->mask & IN_Q_OVERFLOW) {
+                for(fhos_i64 i = 0; i < watcher->watch_count; i += 1) {
+                    FHOS_Watch *watch = watcher->watches + i;
+                    fhos__push_file_change(ctx, changes, FHOS_FILE_CHANGE_TYPE_OVERFLOW, FHOS_TRUE, watcher->paths + watch->path_offset, watch->path_length, 0, 0);
+                }
+                continue;
+            }
+            
+            FHOS_Watch *watch = fhos__find_watch(watcher, event->wd);
+            if(!watch) { continue; }
+            
+            if(event->mask & IN_IGNORED) {
+                // NOTE(Patrik): The directory is gone, the kernel already dropped the watch.
+                // Its path is left in the path block until the watcher is closed.
+                fhos_i64 index = watch - watcher->watches;
+                for(fhos_i64 i = index; i < watcher->watch_count - 1; i += 1) { watcher->watches[i] = watcher->watches[i + 1]; }
+                watcher->watch_count -= 1;
+                continue;
+            }
+            
+            const char *watch_path = watcher->paths + watch->path_offset;
+            fhos_i32 watch_path_length = watch->path_length;
+            fhos_bool is_directory = ((event->mask & IN_ISDIR) == IN_ISDIR);
+            fhos_bool is_recursive = watch->is_recursive;
+            
+            if(event->mask & IN_MOVE_SELF) {
+                // NOTE(Patrik): A directory moved inside a recursive watch already lost its watches to the
+                // IN_MOVED_FROM of its parent, so this is a directory watched on its own. Where it went is
+                // unknown, so it is reported as deleted and no longer watched.
+                fhos__push_file_change(ctx, changes, FHOS_FILE_CHANGE_TYPE_DELETED, FHOS_TRUE, watch_path, watch_path_length, 0, 0);
+                fhos__inotify_remove_subtree(watcher, watch_path, watch_path_length);
+                continue;
+            }
+            
+            fhos_i32 name_length = 0;
+            if(event->len > 0) { while(name_length < (fhos_i32)event->len && event->name[name_length]) { name_length += 1; } }
+            
+            // NOTE(Patrik): Adding watches can move the path block, so the path of a subdirectory is copied first.
+            char stack_path[FHOS_STACK_PATH_CAPACITY];
+            char *child_path = 0;
+            fhos_i32 child_path_length = watch_path_length + 1 + name_length;
+            if(is_directory && is_recursive && (event->mask & (IN_CREATE | IN_MOVED_TO | IN_MOVED_FROM))) {
+                child_path = fhos__join_watch_path(ctx, stack_path, watch_path, watch_path_length, event->name, name_length);
+            }
+            
+            if(event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                fhos__push_file_change(ctx, changes, FHOS_FILE_CHANGE_TYPE_CREATED, is_directory, watch_path, watch_path_length, event->name, name_length);
+                if(child_path && fhos__inotify_add_watch(ctx, watcher, child_path, child_path_length, FHOS_TRUE) > 0) {
+                    fhos__inotify_add_subtree(ctx, watcher, child_path, child_path_length, changes, 1);
+                }
+            } else if(event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                fhos__push_file_change(ctx, changes, FHOS_FILE_CHANGE_TYPE_DELETED, is_directory, watch_path, watch_path_length, event->name, name_length);
+                if(child_path && (event->mask & IN_MOVED_FROM)) { fhos__inotify_remove_subtree(watcher, child_path, child_path_length); }
+            } else if(event->mask & IN_CLOSE_WRITE) {
+                fhos__push_file_change(ctx, changes, FHOS_FILE_CHANGE_TYPE_MODIFIED, is_directory, watch_path, watch_path_length, event->name, name_length);
+            }
+            if(child_path && child_path != stack_path) { fhos_context_temp_free(ctx, child_path); }
+        }
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    for(fhos_i64 i = 0; i < changes->count; i += 1) {
+        changes->changes[i].path = changes->paths + (fhos_isize)changes->changes[i].path;
+    }
+    return changes->count;
+}
+
+FHOS_API void
+fhos_close_watcher(FHOS_Context *ctx, FHOS_Watcher *watcher) {
+    if(!watcher || !watcher->is_initialized) { return; }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    for(fhos_i64 i = 0; i < watcher->watch_count; i += 1) {
+        FHOS__Windows_Watch *windows_watch = (FHOS__Windows_Watch *)watcher->watches[i].platform;
+        if(!windows_watch) { continue; }
+        
+        DWORD bytes_returned = 0;
+        CancelIoEx(windows_watch->directory, &windows_watch->overlapped);
+        GetOverlappedResult(windows_watch->directory, &windows_watch->overlapped, &bytes_returned, TRUE);
+        CloseHandle(windows_watch->directory);
+        fhos_context_free(ctx, windows_watch);
+    }
+#elif defined(__linux__)
+    // NOTE(Patrik): Closing the inotify instance removes all of its watches.
+    if(fhos_is_file_handle_valid(watcher->handle)) { fhos_close_file(watcher->handle); }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    if(watcher->buffer) { fhos_context_free(ctx, watcher->buffer); }
+    if(watcher->watches) { fhos_context_free(ctx, watcher->watches); }
+    if(watcher->paths) { fhos_context_free(ctx, watcher->paths); }
+    
+    FHOS_Watcher zero_watcher = {0};
+    *watcher = zero_watcher;
+}
+
+FHOS_API void
+fhos_free_file_changes(FHOS_Context *ctx, FHOS_File_Changes *changes) {
+    if(!changes) { return; }
+    
+    if(changes->changes) { fhos_context_free(ctx, changes->changes); }
+    if(changes->paths) { fhos_context_free(ctx, changes->paths); }
+    
+    FHOS_File_Changes zero_changes = {0};
+    *changes = zero_changes;
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// METADATA CACHE
+//
+// NOTE(Patrik): Trailing slashes are ignored and back slashes count as forward slashes,
+// so "a\\b/" and "a/b" are the same path.
+static fhos_i32
+fhos__trim_path(const char *path, fhos_i32 path_length) {
+    while(path_length > 1 && (path[path_length - 1] == '/' || path[path_length - 1] == '\\')) { path_length -= 1; }
+    return path_length;
+}
+
+static fhos_u64
+fhos__hash_path(const char *path, fhos_i32 path_length) {
+    // NOTE(Patrik): FNV-1a, the paths are short so anything fancier does not pay off.
+    // Pack files store these hashes, so this can not change without bumping FHOS_PACK_VERSION.
+    fhos_u64 hash = 14695981039346656037ULL;
+    for(fhos_i32 i = 0; i < path_length; i += 1) {
+        char c = (path[i] == '\\') ? '/' : path[i];
+        hash ^= (fhos_u8)c;
+        hash *= 1099511628211ULL;
+    }
+    return (hash != 0) ? hash : 1;
+}
+
+static fhos_bool
+fhos__is_same_path(const char *cached_path, const char *path, fhos_i32 path_length) {
+    for(fhos_i32 i = 0; i < path_length; i += 1) {
+        char c = (path[i] == '\\') ? '/' : path[i];
+        if(cached_path[i] != c) { return FHOS_FALSE; }
+    }
+    return FHOS_TRUE;
+}
+
+static FHOS_File_Metadata_Slot *
+fhos__find_metadata_slot(FHOS_File_Metadata_Cache *cache, fhos_u64 hash, const char *path, fhos_i32 path_length) {
+    if(cache->slot_capacity == 0) { return 0; }
+    
+    fhos_u64 mask = (fhos_u64)cache->slot_capacity - 1;
+    for(fhos_u64 index = hash & mask;; index = (index + 1) & mask) {
+        FHOS_File_Metadata_Slot *slot = cache->slots + index;
+        if(slot->hash == 0) { return 0; }
+        if(slot->hash == hash && slot->path_length == path_length &&
+           fhos__is_same_path(cache->paths + slot->path_offset, path, path_length))
+        {
+            return slot;
+        }
+    }
+}
+
+static FHOS_File_Metadata_Slot *
+fhos__insert_metadata_slot(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache, fhos_u64 hash, const char *path, fhos_i32 path_length) {
+    FHOS_File_Metadata_Slot *slot = fhos__find_metadata_slot(cache, hash, path, path_length);
+    if(slot) { return slot; }
+    
+    // NOTE(Patrik): Keep the table at most half full so the probes stay short.
+    if((cache->slot_count + 1) * 2 > cache->slot_capacity) {
+        fhos_i64 new_capacity = (cache->slot_capacity > 0) ? cache->slot_capacity * 2 : 256;
+        FHOS_File_Metadata_Slot *new_slots = (FHOS_File_Metadata_Slot *)fhos_context_alloc(ctx, new_capacity * sizeof(FHOS_File_Metadata_Slot));
+        if(!new_slots) {
+            FHOS_LOG_ERROR("Could not allocate memory for the metadata cache.\n");
+            return 0;
+        }
+        
+        fhos_u64 mask = (fhos_u64)new_capacity - 1;
+        for(fhos_i64 i = 0; i < cache->slot_capacity; i += 1) {
+            FHOS_File_Metadata_Slot *old_slot = cache->slots + i;
+            if(old_slot->hash == 0) { continue; }
+            
+            fhos_u64 index = old_slot->hash & mask;
+            while(new_slots[index].hash != 0) { index = (index + 1) & mask; }
+            new_slots[index] = *old_slot;
+        }
+        
+        if(cache->slots) { fhos_context_free(ctx, cache->slots); }
+        cache->slots = new_slots;
+        cache->slot_capacity = new_capacity;
+    }
+    
+    void *new_paths = fhos_context_maybe_grow(ctx, cache->paths, &cache->paths_capacity, cache->paths_length + path_length + 1);
+    if(!new_paths) {
+        FHOS_LOG_ERROR("Could not allocate memory for the metadata cache.\n");
+        return 0;
+    }
+    cache->paths = (char *)new_paths;
+    
+    fhos_u64 mask = (fhos_u64)cache->slot_capacity - 1;
+    fhos_u64 index = hash & mask;
+    while(cache->slots[index].hash != 0) { index = (index + 1) & mask; }
+    
+    slot = cache->slots + index;
+    slot->hash = hash;
+    slot->path_offset = cache->paths_length;
+    slot->path_length = path_length;
+    slot->is_valid = FHOS_FALSE;
+    
+    char *cached_path = cache->paths + cache->paths_length;
+    for(fhos_i32 i = 0; i < path_length; i += 1) { cached_path[i] = (path[i] == '\\') ? '/' : path[i]; }
+    cached_path[path_length] = 0;
+    cache->paths_length += path_length + 1;
+    cache->slot_count += 1;
+    return slot;
+}
+
+static void
+fhos__store_metadata(FHOS_File_Metadata_Cache *cache, FHOS_File_Metadata_Slot *slot, FHOS_File_Metadata *metadata) {
+    slot->metadata = *metadata;
+    slot->generation = cache->generation;
+    slot->is_valid = FHOS_TRUE;
+}
+
+// NOTE(Patrik): Fetches the metadata of a single null terminated path straight from the file system.
+static fhos_error
+fhos__stat_path(const char *path, FHOS_File_Metadata *metadata) {
+    FHOS_File_Metadata zero_metadata = {0};
+    *metadata = zero_metadata;
+    metadata->size = -1;
+    metadata->modified_time = -1;
+    
+#if defined(_WIN32) || defined(_WIN64)
+    WIN32_FILE_ATTRIBUTE_DATA attribute = {0};
+    if(!GetFileAttributesExA(path, GetFileExInfoStandard, &attribute)) {
+        DWORD last_error = GetLastError();
+        if(last_error == ERROR_FILE_NOT_FOUND || last_error == ERROR_PATH_NOT_FOUND) { return FHOS_FALSE; }
+        FHOS_LOG_ERROR("(%lu) Could not get the metadata of \"%s\".\n", last_error, path);
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    fhos_i64 file_time = ((fhos_i64)attribute.ftLastWriteTime.dwHighDateTime << 32) | (fhos_i64)attribute.ftLastWriteTime.dwLowDateTime;
+    metadata->exists = FHOS_TRUE;
+    metadata->type = (attribute.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? FHOS_DIRECTORY_ENTRY_TYPE_DIRECTORY : FHOS_DIRECTORY_ENTRY_TYPE_FILE;
+    metadata->size = ((fhos_i64)attribute.nFileSizeHigh << 32) | (fhos_i64)attribute.nFileSizeLow;
+    metadata->modified_time = (file_time - 116444736000000000LL) * 100;
+#elif defined(__linux__)
+    fhos_u32 mode = 0;
+#  if defined(STATX_BASIC_STATS)
+    // NOTE(Patrik): statx only fills in what was asked for, which saves work on some file systems. Several
+    // threads can find out it is missing at the same time, so the flag is atomic.
+    static FHOS_Atomic_I32 has_statx = { 1 };
+    if(fhos_atomic_load_i32(&has_statx, FHOS_MEMORY_ORDER_RELAXED)) {
+        struct statx path_statx;
+        if(statx(AT_FDCWD, path, 0, STATX_TYPE | STATX_SIZE | STATX_MTIME, &path_statx) == 0) {
+            mode = path_statx.stx_mode;
+            metadata->size = (fhos_i64)path_statx.stx_size;
+            metadata->modified_time = (fhos_i64)path_statx.stx_mtime.tv_sec * 1000000000LL + (fhos_i64)path_statx.stx_mtime.tv_nsec;
+        } else if(errno == ENOSYS) {
+            fhos_atomic_store_i32(&has_statx, 0, FHOS_MEMORY_ORDER_RELAXED);
+        } else if(errno == ENOENT || errno == ENOTDIR) {
+            return FHOS_FALSE;
+        } else {
+            FHOS_LOG_ERROR("(%d) Could not get the metadata of \"%s\".\n", errno, path);
+            return FHOS_ERROR_GENERIC_ERROR;
+        }
+    }
+    if(!fhos_atomic_load_i32(&has_statx, FHOS_MEMORY_ORDER_RELAXED))
+#  endif
+    {
+        struct stat path_stat;
+        if(stat(path, &path_stat) != 0) {
+            if(errno == ENOENT || errno == ENOTDIR) { return FHOS_FALSE; }
+            FHOS_LOG_ERROR("(%d) Could not get the metadata of \"%s\".\n", errno, path);
+            return FHOS_ERROR_GENERIC_ERROR;
+        }
+        mode = path_stat.st_mode;
+        metadata->size = (fhos_i64)path_stat.st_size;
+        metadata->modified_time = (fhos_i64)path_stat.st_mtim.tv_sec * 1000000000LL + (fhos_i64)path_stat.st_mtim.tv_nsec;
+    }
+    
+    metadata->exists = FHOS_TRUE;
+    if(S_ISREG(mode)) {
+        metadata->type = FHOS_DIRECTORY_ENTRY_TYPE_FILE;
+    } else if(S_ISDIR(mode)) {
+        metadata->type = FHOS_DIRECTORY_ENTRY_TYPE_DIRECTORY;
+    } else {
+        metadata->type = FHOS_DIRECTORY_ENTRY_TYPE_OTHER;
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    return FHOS_TRUE;
+}
+
+typedef struct FHOS__Stat_Batch {
+    char **paths;
+    FHOS_File_Metadata *metadata;
+    fhos_error *errors;
+    fhos_i64 count;
+    FHOS_Atomic_I64 next;
+} FHOS__Stat_Batch;
+
+static void
+fhos__stat_batch_proc(void *data) {
+    FHOS__Stat_Batch *batch = (FHOS__Stat_Batch *)data;
+    for(;;) {
+        // NOTE(Patrik): Small chunks keep the threads busy when some paths are much slower than others.
+        fhos_i64 first = fhos_atomic_fetch_add_i64(&batch->next, 64, FHOS_MEMORY_ORDER_RELAXED);
+        if(first >= batch->count) { break; }
+        
+        fhos_i64 last = (first + 64 < batch->count) ? first + 64 : batch->count;
+        for(fhos_i64 i = first; i < last; i += 1) { batch->errors[i] = fhos__stat_path(batch->paths[i], batch->metadata + i); }
+    }
+}
+
+// NOTE(Patrik): Stat'ing is mostly waiting on the file system, so big batches are spread over threads even
+// when there are few processors. The results are written back by the calling thread.
+static void
+fhos__stat_paths(FHOS__Stat_Batch *batch) {
+    fhos_i32 thread_count = 1;
+    if(batch->count >= FHOS_METADATA_PARALLEL_BATCH_SIZE) {
+        thread_count = fhos__get_processor_count();
+        if(thread_count < 4) { thread_count = 4; }
+    }
+    
+    fhos__run_on_threads(fhos__stat_batch_proc, batch, thread_count);
+}
+
+FHOS_API fhos_error
+fhos_get_file_metadata(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache, const char *path_data, fhos_i32 path_length, FHOS_File_Metadata *metadata) {
+    if(!path_data) {
+        FHOS_LOG_ERROR("fhos_get_file_metadata -> The parameter path_data is null.\n");
+        return FHOS_ERROR_PATH_IS_NULL;
+    } else if(path_length == 0) {
+        FHOS_LOG_ERROR("fhos_get_file_metadata -> The parameter path_length is zero.\n");
+        return FHOS_ERROR_PATH_IS_EMPTY;
+    }
+    
+    if(path_length < 0) { FHOS__GET_NTSTRING_LENGTH(path_data, path_length); }
+    path_length = fhos__trim_path(path_data, path_length);
+    
+    FHOS_File_Metadata_Slot *slot = 0;
+    fhos_u64 hash = 0;
+    if(cache) {
+        hash = fhos__hash_path(path_data, path_length);
+        slot = fhos__find_metadata_slot(cache, hash, path_data, path_length);
+        if(slot && slot->is_valid && slot->generation == cache->generation) {
+            cache->hit_count += 1;
+            if(metadata) { *metadata = slot->metadata; }
+            return slot->metadata.exists;
+        }
+        cache->miss_count += 1;
+    }
+    
+    FHOS__ALLOC_PATH(ctx, path_data, path_length);
+    if(!path) {
+        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    FHOS_File_Metadata path_metadata;
+    fhos_error result = fhos__stat_path(path, &path_metadata);
+    FHOS__FREE_PATH(ctx, path_data, path_length);
+    if(result < 0) { return result; }
+    
+    if(cache) {
+        if(!slot) { slot = fhos__insert_metadata_slot(ctx, cache, hash, path_data, path_length); }
+        if(slot) { fhos__store_metadata(cache, slot, &path_metadata); }
+    }
+    
+    if(metadata) { *metadata = path_metadata; }
+    return result;
+}
+
+FHOS_API fhos_bool
+fhos_cached_file_exists(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache, const char *path_data, fhos_i32 path_length) {
+    return (fhos_get_file_metadata(ctx, cache, path_data, path_length, 0) == FHOS_TRUE);
+}
+
+FHOS_API fhos_bool
+fhos_cached_directory_exists(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache, const char *path_data, fhos_i32 path_length) {
+    FHOS_File_Metadata metadata;
+    if(fhos_get_file_metadata(ctx, cache, path_data, path_length, &metadata) != FHOS_TRUE) { return FHOS_FALSE; }
+    return (metadata.type == FHOS_DIRECTORY_ENTRY_TYPE_DIRECTORY);
+}
+
+FHOS_API fhos_error
+fhos_cached_is_file_newer(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache, const char *this_path_data, fhos_i32 this_path_length,
+                          const char *other_path_data, fhos_i32 other_path_length)
+{
+    // NOTE(Patrik): Same rules as fhos_is_file_newer, a missing file counts as newer so it gets rebuilt.
+    FHOS_File_Metadata other_metadata;
+    fhos_error result = fhos_get_file_metadata(ctx, cache, other_path_data, other_path_length, &other_metadata);
+    if(result != FHOS_TRUE) { return (result < 0) ? result : FHOS_TRUE; }
+    
+    FHOS_File_Metadata this_metadata;
+    result = fhos_get_file_metadata(ctx, cache, this_path_data, this_path_length, &this_metadata);
+    if(result != FHOS_TRUE) { return (result < 0) ? result : FHOS_TRUE; }
+    
+    return (this_metadata.modified_time > other_metadata.modified_time);
+}
+
+static fhos_i64
+fhos__refresh_metadata_slots(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache, fhos_i64 *slot_indices, fhos_i64 slot_count) {
+    FHOS__Stat_Batch batch = {0};
+    batch.count = slot_count;
+    batch.paths = (char **)fhos_context_temp_alloc_non_zero(ctx, slot_count * sizeof(char *));
+    batch.metadata = (FHOS_File_Metadata *)fhos_context_temp_alloc_non_zero(ctx, slot_count * sizeof(FHOS_File_Metadata));
+    batch.errors = (fhos_error *)fhos_context_temp_alloc_non_zero(ctx, slot_count * sizeof(fhos_error));
+    
+    fhos_i64 result = FHOS_ERROR_OUT_OF_MEMORY;
+    if(batch.paths && batch.metadata && batch.errors) {
+        for(fhos_i64 i = 0; i < slot_count; i += 1) { batch.paths[i] = cache->paths + cache->slots[slot_indices[i]].path_offset; }
+        fhos__stat_paths(&batch);
+        
+        result = 0;
+        for(fhos_i64 i = 0; i < slot_count; i += 1) {
+            FHOS_File_Metadata_Slot *slot = cache->slots + slot_indices[i];
+            if(batch.errors[i] < 0) {
+                slot->is_valid = FHOS_FALSE;
+                continue;
+            }
+            fhos__store_metadata(cache, slot, batch.metadata + i);
+            result += batch.metadata[i].exists;
+        }
+    } else {
+        FHOS_LOG_ERROR("Could not allocate memory for refreshing the metadata.\n");
+    }
+    
+    if(batch.paths) { fhos_context_temp_free(ctx, batch.paths); }
+    if(batch.metadata) { fhos_context_temp_free(ctx, batch.metadata); }
+    if(batch.errors) { fhos_context_temp_free(ctx, batch.errors); }
+    return result;
+}
+
+FHOS_API fhos_i64
+fhos_refresh_file_metadata(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache, const char **paths, const fhos_i32 *path_lengths, fhos_i64 path_count) {
+    if(!cache || !paths) {
+        FHOS_LOG_ERROR("fhos_refresh_file_metadata -> The parameter cache or paths is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    if(path_count <= 0) { return 0; }
+    
+    // NOTE(Patrik): Insert everything first, the slots move when the table grows.
+    for(fhos_i64 i = 0; i < path_count; i += 1) {
+        if(!paths[i]) { continue; }
+        fhos_i32 path_length = (path_lengths) ? path_lengths[i] : -1;
+        if(path_length < 0) { FHOS__GET_NTSTRING_LENGTH(paths[i], path_length); }
+        path_length = fhos__trim_path(paths[i], path_length);
+        if(path_length == 0) { continue; }
+        
+        if(!fhos__insert_metadata_slot(ctx, cache, fhos__hash_path(paths[i], path_length), paths[i], path_length)) {
+            return FHOS_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    
+    fhos_i64 *slot_indices = (fhos_i64 *)fhos_context_temp_alloc_non_zero(ctx, path_count * sizeof(fhos_i64));
+    if(!slot_indices) {
+        FHOS_LOG_ERROR("Could not allocate memory for refreshing the metadata.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    fhos_i64 slot_count = 0;
+    for(fhos_i64 i = 0; i < path_count; i += 1) {
+        if(!paths[i]) { continue; }
+        fhos_i32 path_length = (path_lengths) ? path_lengths[i] : -1;
+        if(path_length < 0) { FHOS__GET_NTSTRING_LENGTH(paths[i], path_length); }
+        path_length = fhos__trim_path(paths[i], path_length);
+        if(path_length == 0) { continue; }
+        
+        FHOS_File_Metadata_Slot *slot = fhos__find_metadata_slot(cache, fhos__hash_path(paths[i], path_length), paths[i], path_length);
+        slot_indices[slot_count] = slot - cache->slots;
+        slot_count += 1;
+    }
+    
+    fhos_i64 result = fhos__refresh_metadata_slots(ctx, cache, slot_indices, slot_count);
+    fhos_context_temp_free(ctx, slot_indices);
+    return result;
+}
+
+FHOS_API fhos_i64
+fhos_refresh_file_metadata_cache(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache) {
+    if(!cache) {
+        FHOS_LOG_ERROR("fhos_refresh_file_metadata_cache -> The parameter cache is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    if(cache->slot_count == 0) { return 0; }
+    
+    fhos_i64 *slot_indices = (fhos_i64 *)fhos_context_temp_alloc_non_zero(ctx, cache->slot_count * sizeof(fhos_i64));
+    if(!slot_indices) {
+        FHOS_LOG_ERROR("Could not allocate memory for refreshing the metadata.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    fhos_i64 slot_count = 0;
+    for(fhos_i64 i = 0; i < cache->slot_capacity; i += 1) {
+        if(cache->slots[i].hash == 0) { continue; }
+        slot_indices[slot_count] = i;
+        slot_count += 1;
+    }
+    
+    fhos_i64 result = fhos__refresh_metadata_slots(ctx, cache, slot_indices, slot_count);
+    fhos_context_temp_free(ctx, slot_indices);
+    return result;
+}
+
+FHOS_API void
+fhos_invalidate_file_metadata(FHOS_File_Metadata_Cache *cache, const char *path_data, fhos_i32 path_length) {
+    if(!cache || !path_data) { return; }
+    
+    if(path_length < 0) { FHOS__GET_NTSTRING_LENGTH(path_data, path_length); }
+    path_length = fhos__trim_path(path_data, path_length);
+    
+    FHOS_File_Metadata_Slot *slot = fhos__find_metadata_slot(cache, fhos__hash_path(path_data, path_length), path_data, path_length);
+    if(slot) { slot->is_valid = FHOS_FALSE; }
+}
+
+FHOS_API void
+fhos_invalidate_all_file_metadata(FHOS_File_Metadata_Cache *cache) {
+    if(!cache) { return; }
+    cache->generation += 1;
+}
+
+FHOS_API void
+fhos_apply_file_changes(FHOS_File_Metadata_Cache *cache, FHOS_File_Changes *changes) {
+    if(!cache || !changes || cache->slot_count == 0) { return; }
+    
+    for(fhos_i64 i = 0; i < changes->count; i += 1) {
+        FHOS_File_Change *change = changes->changes + i;
+        if(change->type == FHOS_FILE_CHANGE_TYPE_OVERFLOW) {
+            fhos_invalidate_all_file_metadata(cache);
+            return;
+        }
+        
+        fhos_i32 path_length = fhos__trim_path(change->path, change->path_length);
+        fhos_invalidate_file_metadata(cache, change->path, path_length);
+        if(change->type == FHOS_FILE_CHANGE_TYPE_MODIFIED) { continue; }
+        
+        // NOTE(Patrik): Creating or deleting an entry changes the modified time of its parent.
+        fhos_i32 parent_length = path_length - 1;
+        while(parent_length > 0 && change->path[parent_length] != '/' && change->path[parent_length] != '\\') { parent_length -= 1; }
+        if(parent_length > 0) { fhos_invalidate_file_metadata(cache, change->path, parent_length); }
+        
+        if(!change->is_directory) { continue; }
+        
+        // NOTE(Patrik): A directory that was moved in or out only gives one event, but everything below it changed too.
+        for(fhos_i64 j = 0; j < cache->slot_capacity; j += 1) {
+            FHOS_File_Metadata_Slot *slot = cache->slots + j;
+            if(slot->hash == 0 || slot->path_length <= path_length) { continue; }
+            
+            char *cached_path = cache->paths + slot->path_offset;
+            if(cached_path[path_length] == '/' && fhos__is_same_path(cached_path, change->path, path_length)) {
+                slot->is_valid = FHOS_FALSE;
+            }
+        }
+    }
+}
+
+FHOS_API void
+fhos_free_file_metadata_cache(FHOS_Context *ctx, FHOS_File_Metadata_Cache *cache) {
+    if(!cache) { return; }
+    
+    if(cache->slots) { fhos_context_free(ctx, cache->slots); }
+    if(cache->paths) { fhos_context_free(ctx, cache->paths); }
+    
+    FHOS_File_Metadata_Cache zero_cache = {0};
+    *cache = zero_cache;
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// HASH
+//
+// NOTE(Patrik): Each 64 byte stripe is mixed into eight 64 bit accumulators with a 32x32->64 bit multiply per lane,
+// which maps directly onto _mm_mul_epu32/_mm256_mul_epu32. Every 16 stripes (one block) the accumulators
+// are scrambled so that a lane can not cancel itself out over long inputs.
+#define FHOS__HASH_STRIPE_SIZE 64
+#define FHOS__HASH_BLOCK_STRIPES 16
+#define FHOS__HASH_BLOCK_SIZE (FHOS__HASH_STRIPE_SIZE * FHOS__HASH_BLOCK_STRIPES)
+#define FHOS__HASH_PRIME32 0x9E3779B1ULL
+#define FHOS__HASH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define FHOS__HASH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+
+// NOTE(Patrik): Stripe n of a block uses the keys n to n + 7, the scramble uses the last eight.
+static const fhos_u64 fhos__hash_keys[FHOS__HASH_BLOCK_STRIPES + 8] = {
+    0xA9A93C5C634B070EULL, 0xF2658813CCC8BEB1ULL, 0x06E98E210F3971AAULL, 0x5A7540B37D821DCDULL,
+    0x28869E419646C979ULL, 0xA4EEE6D84AC5E547ULL, 0x944FA9956EE35F95ULL, 0x5DDC167E0AD51235ULL,
+    0x8A3D3FAA31393640ULL, 0x81070B162FD5A5B5ULL, 0x05FA5E77958A306CULL, 0x59CCF95887225823ULL,
+    0x603793ADE95577B5ULL, 0x8098383BDC31373EULL, 0xE1AF737B84E5979AULL, 0xDA61660F96EC5E74ULL,
+    0x4C83D0D486C4DE43ULL, 0xAAFDE5E0BC02BDEDULL, 0x017CE711457A9EFAULL, 0x882788DE8F909315ULL,
+    0xB2060275B3859519ULL, 0x76916092133D104DULL, 0xD1DEA8069945BFACULL, 0xC16E25D6267A10E0ULL,
+};
+
+typedef void FHOS__Hash_Accumulate_Proc(fhos_u64 *accumulators, const fhos_u8 *data, fhos_i64 stripe_count, fhos_i64 first_stripe);
+typedef void FHOS__Hash_Scramble_Proc(fhos_u64 *accumulators);
+
+static fhos_u64
+fhos__read_u64_le(const fhos_u8 *data) {
+    return ((fhos_u64)data[0])       | ((fhos_u64)data[1] << 8)  | ((fhos_u64)data[2] << 16) | ((fhos_u64)data[3] << 24) |
+           ((fhos_u64)data[4] << 32) | ((fhos_u64)data[5] << 40) | ((fhos_u64)data[6] << 48) | ((fhos_u64)data[7] << 56);
+}
+
+static void
+fhos__hash_accumulate_scalar(fhos_u64 *accumulators, const fhos_u8 *data, fhos_i64 stripe_count, fhos_i64 first_stripe) {
+    for(fhos_i64 stripe = 0; stripe < stripe_count; stripe += 1) {
+        const fhos_u64 *keys = fhos__hash_keys + first_stripe + stripe;
+        const fhos_u8 *at = data + stripe * FHOS__HASH_STRIPE_SIZE;
+        for(fhos_i32 i = 0; i < 8; i += 1) {
+            fhos_u64 value = fhos__read_u64_le(at + i * 8);
+            fhos_u64 keyed = value ^ keys[i];
+            accumulators[i ^ 1] += value;
+            accumulators[i] += (keyed & 0xFFFFFFFFULL) * (keyed >> 32);
+        }
+    }
+}
+
+static void
+fhos__hash_scramble_scalar(fhos_u64 *accumulators) {
+    const fhos_u64 *keys = fhos__hash_keys + FHOS__HASH_BLOCK_STRIPES;
+    for(fhos_i32 i = 0; i < 8; i += 1) {
+        fhos_u64 value = accumulators[i];
+        value ^= value >> 47;
+        value ^= keys[i];
+        accumulators[i] = value * FHOS__HASH_PRIME32;
+    }
+}
+
+#if defined(FHOS__HASH_X64)
+static void
+fhos__hash_accumulate_sse2(fhos_u64 *accumulators, const fhos_u8 *data, fhos_i64 stripe_count, fhos_i64 first_stripe) {
+    __m128i *lanes = (__m128i *)accumulators;
+    __m128i acc0 = _mm_loadu_si128(lanes + 0);
+    __m128i acc1 = _mm_loadu_si128(lanes + 1);
+    __m128i acc2 = _mm_loadu_si128(lanes + 2);
+    __m128i acc3 = _mm_loadu_si128(lanes + 3);
+    
+    for(fhos_i64 stripe = 0; stripe < stripe_count; stripe += 1) {
+        const __m128i *keys = (const __m128i *)(fhos__hash_keys + first_stripe + stripe);
+        const __m128i *at = (const __m128i *)(data + stripe * FHOS__HASH_STRIPE_SIZE);
+        
+#define FHOS__HASH_SSE2_LANE(acc, index) do {\
+__m128i value = _mm_loadu_si128(at + (index));\
+__m128i keyed = _mm_xor_si128(value, _mm_loadu_si128(keys + (index)));\
+__m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));\
+(acc) = _mm_add_epi64((acc), _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2)));\
+(acc) = _mm_add_epi64((acc), product);\
+} while(0)
+        FHOS__HASH_SSE2_LANE(acc0, 0);
+        FHOS__HASH_SSE2_LANE(acc1, 1);
+        FHOS__HASH_SSE2_LANE(acc2, 2);
+        FHOS__HASH_SSE2_LANE(acc3, 3);
+#undef FHOS__HASH_SSE2_LANE
+    }
+    
+    _mm_storeu_si128(lanes + 0, acc0);
+    _mm_storeu_si128(lanes + 1, acc1);
+    _mm_storeu_si128(lanes + 2, acc2);
+    _mm_storeu_si128(lanes + 3, acc3);
+}
+
+static void
+fhos__hash_scramble_sse2(fhos_u64 *accumulators) {
+    __m128i *lanes = (__m128i *)accumulators;
+    const __m128i *keys = (const __m128i *)(fhos__hash_keys + FHOS__HASH_BLOCK_STRIPES);
+    __m128i prime = _mm_set1_epi32((int)FHOS__HASH_PRIME32);
+    for(fhos_i32 i = 0; i < 4; i += 1) {
+        __m128i value = _mm_loadu_si128(lanes + i);
+        value = _mm_xor_si128(value, _mm_srli_epi64(value, 47));
+        value = _mm_xor_si128(value, _mm_loadu_si128(keys + i));
+        
+        // NOTE(Patrik): A 64x32 bit multiply out of two 32x32 bit ones.
+        __m128i low = _mm_mul_epu32(value, prime);
+        __m128i high = _mm_mul_epu32(_mm_srli_epi64(value, 32), prime);
+        _mm_storeu_si128(lanes + i, _mm_add_epi64(low, _mm_slli_epi64(high, 32)));
+    }
+}
+
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    define FHOS__TARGET_AVX2
+#  else
+#    define FHOS__TARGET_AVX2 __attribute__((target("avx2")))
+#  endif
+
+FHOS__TARGET_AVX2 static void
+fhos__hash_accumulate_avx2(fhos_u64 *accumulators, const fhos_u8 *data, fhos_i64 stripe_count, fhos_i64 first_stripe) {
+    __m256i *lanes = (__m256i *)accumulators;
+    __m256i acc0 = _mm256_loadu_si256(lanes + 0);
+    __m256i acc1 = _mm256_loadu_si256(lanes + 1);
+    
+    for(fhos_i64 stripe = 0; stripe < stripe_count; stripe += 1) {
+        const __m256i *keys = (const __m256i *)(fhos__hash_keys + first_stripe + stripe);
+        const __m256i *at = (const __m256i *)(data + stripe * FHOS__HASH_STRIPE_SIZE);
+        
+#define FHOS__HASH_AVX2_LANE(acc, index) do {\
+__m256i value = _mm256_loadu_si256(at + (index));\
+__m256i keyed = _mm256_xor_si256(value, _mm256_loadu_si256(keys + (index)));\
+__m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));\
+(acc) = _mm256_add_epi64((acc), _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2)));\
+(acc) = _mm256_add_epi64((acc), product);\
+} while(0)
+        FHOS__HASH_AVX2_LANE(acc0, 0);
+        FHOS__HASH_AVX2_LANE(acc1, 1);
+#undef FHOS__HASH_AVX2_LANE
+    }
+    
+    _mm256_storeu_si256(lanes + 0, acc0);
+    _mm256_storeu_si256(lanes + 1, acc1);
+}
+
+FHOS__TARGET_AVX2 static void
+fhos__hash_scramble_avx2(fhos_u64 *accumulators) {
+    __m256i *lanes = (__m256i *)accumulators;
+    const __m256i *keys = (const __m256i *)(fhos__hash_keys + FHOS__HASH_BLOCK_STRIPES);
+    __m256i prime = _mm256_set1_epi32((int)FHOS__HASH_PRIME32);
+    for(fhos_i32 i = 0; i < 2; i += 1) {
+        __m256i value = _mm256_loadu_si256(lanes + i);
+        value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 47));
+        value = _mm256_xor_si256(value, _mm256_loadu_si256(keys + i));
+        
+        __m256i low = _mm256_mul_epu32(value, prime);
+        __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(value, 32), prime);
+        _mm256_storeu_si256(lanes + i, _mm256_add_epi64(low, _mm256_slli_epi64(high, 32)));
+    }
+}
+
+static fhos_bool
+fhos__cpu_has_avx2(void) {
+#  if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7) { return FHOS_FALSE; }
+    
+    // NOTE(Patrik): The OS also has to save the YMM registers on context switches.
+    __cpuid(info, 1);
+    fhos_bool has_osxsave = ((info[2] & (1 << 27)) != 0);
+    fhos_bool has_avx = ((info[2] & (1 << 28)) != 0);
+    if(!has_osxsave || !has_avx || (_xgetbv(0) & 6) != 6) { return FHOS_FALSE; }
+    
+    __cpuidex(info, 7, 0);
+    return ((info[1] & (1 << 5)) != 0);
+#  else
+    __builtin_cpu_init();
+    return (__builtin_cpu_supports("avx2") != 0);
+#  endif
+}
+#endif
+
+typedef struct FHOS__Hash_Kernel {
+    FHOS__Hash_Accumulate_Proc *accumulate;
+    FHOS__Hash_Scramble_Proc *scramble;
+} FHOS__Hash_Kernel;
+
+static const FHOS__Hash_Kernel fhos__hash_kernel_scalar = { fhos__hash_accumulate_scalar, fhos__hash_scramble_scalar };
+#if defined(FHOS__HASH_X64)
+static const FHOS__Hash_Kernel fhos__hash_kernel_sse2 = { fhos__hash_accumulate_sse2, fhos__hash_scramble_sse2 };
+static const FHOS__Hash_Kernel fhos__hash_kernel_avx2 = { fhos__hash_accumulate_avx2, fhos__hash_scramble_avx2 };
+#endif
+
+static FHOS_Atomic_Pointer fhos__hash_kernel;
+
+// NOTE(Patrik): Both procs are published together as one pointer so a thread never sees one without the
+// other. Picking the kernel more than once from different threads is harmless, they all pick the same.
+static const FHOS__Hash_Kernel *
+fhos__get_hash_kernel(void) {
+    const FHOS__Hash_Kernel *kernel = (const FHOS__Hash_Kernel *)fhos_atomic_load_pointer(&fhos__hash_kernel, FHOS_MEMORY_ORDER_ACQUIRE);
+    if(kernel) { return kernel; }
+    
+    kernel = &fhos__hash_kernel_scalar;
+#if defined(FHOS__HASH_X64)
+    if(fhos__cpu_has_avx2()) {
+        kernel = &fhos__hash_kernel_avx2;
+    } else {
+        kernel = &fhos__hash_kernel_sse2;
+    }
+#endif
+    
+    fhos_atomic_store_pointer(&fhos__hash_kernel, (void *)kernel, FHOS_MEMORY_ORDER_RELEASE);
+    return kernel;
+}
+
+static void
+fhos__hash_blocks(fhos_u64 *accumulators, const fhos_u8 *data, fhos_i64 block_count) {
+    const FHOS__Hash_Kernel *kernel = fhos__get_hash_kernel();
+    for(fhos_i64 i = 0; i < block_count; i += 1) {
+        kernel->accumulate(accumulators, data + i * FHOS__HASH_BLOCK_SIZE, FHOS__HASH_BLOCK_STRIPES, 0);
+        kernel->scramble(accumulators);
+    }
+}
+
+static fhos_u64
+fhos__hash_mix_u64(fhos_u64 value) {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+FHOS_API void
+fhos_begin_hash(FHOS_Hash_State *state) {
+    fhos__get_hash_kernel();
+    
+    for(fhos_i32 i = 0; i < 8; i += 1) { state->accumulators[i] = fhos__hash_keys[i] ^ FHOS__HASH_PRIME64_1; }
+    state->buffer_length = 0;
+    state->total_length = 0;
+}
+
+FHOS_API void
+fhos_update_hash(FHOS_Hash_State *state, const void *data, fhos_i64 size_in_bytes) {
+    if(!state || !data || size_in_bytes <= 0) { return; }
+    
+    const fhos_u8 *at = (const fhos_u8 *)data;
+    state->total_length += (fhos_u64)size_in_bytes;
+    
+    if(state->buffer_length > 0) {
+        fhos_i64 to_copy = FHOS__HASH_BLOCK_SIZE - state->buffer_length;
+        if(to_copy > size_in_bytes) { to_copy = size_in_bytes; }
+        for(fhos_i64 i = 0; i < to_copy; i += 1) { state->buffer[state->buffer_length + i] = at[i]; }
+        state->buffer_length += to_copy;
+        at += to_copy;
+        size_in_bytes -= to_copy;
+        
+        if(state->buffer_length < FHOS__HASH_BLOCK_SIZE) { return; }
+        fhos__hash_blocks(state->accumulators, state->buffer, 1);
+        state->buffer_length = 0;
+    }
+    
+    // NOTE(Patrik): Whole blocks are hashed straight from the input, only the tail is copied.
+    fhos_i64 block_count = size_in_bytes / FHOS__HASH_BLOCK_SIZE;
+    fhos__hash_blocks(state->accumulators, at, block_count);
+    at += block_count * FHOS__HASH_BLOCK_SIZE;
+    size_in_bytes -= block_count * FHOS__HASH_BLOCK_SIZE;
+    
+    for(fhos_i64 i = 0; i < size_in_bytes; i += 1) { state->buffer[i] = at[i]; }
+    state->buffer_length = size_in_bytes;
+}
+
+FHOS_API FHOS_Hash128
+fhos_end_hash(FHOS_Hash_State *state) {
+    FHOS_Hash128 result = {0};
+    if(!state) { return result; }
+    
+    fhos_u64 accumulators[8];
+    for(fhos_i32 i = 0; i < 8; i += 1) { accumulators[i] = state->accumulators[i]; }
+    
+    const FHOS__Hash_Kernel *kernel = fhos__get_hash_kernel();
+    fhos_i64 stripe_count = state->buffer_length / FHOS__HASH_STRIPE_SIZE;
+    kernel->accumulate(accumulators, state->buffer, stripe_count, 0);
+    
+    // NOTE(Patrik): The last partial stripe is padded with zeros, the length is mixed in below so padding can not collide.
+    fhos_i64 tail_length = state->buffer_length - stripe_count * FHOS__HASH_STRIPE_SIZE;
+    if(tail_length > 0) {
+        fhos_u8 stripe[FHOS__HASH_STRIPE_SIZE] = {0};
+        for(fhos_i64 i = 0; i < tail_length; i += 1) { stripe[i] = state->buffer[stripe_count * FHOS__HASH_STRIPE_SIZE + i]; }
+        kernel->accumulate(accumulators, stripe, 1, stripe_count);
+    }
+    
+    fhos_u64 low = state->total_length * FHOS__HASH_PRIME64_1;
+    fhos_u64 high = ~state->total_length * FHOS__HASH_PRIME64_2;
+    for(fhos_i32 i = 0; i < 8; i += 1) {
+        low += fhos__hash_mix_u64(accumulators[i] ^ fhos__hash_keys[i]);
+        low = ((low << 27) | (low >> 37)) * FHOS__HASH_PRIME64_1;
+        high ^= fhos__hash_mix_u64(accumulators[i] + fhos__hash_keys[23 - i]);
+        high = ((high << 31) | (high >> 33)) * FHOS__HASH_PRIME64_2;
+    }
+    
+    result.low = fhos__hash_mix_u64(low + high);
+    result.high = fhos__hash_mix_u64(high + result.low);
+    return result;
+}
+
+FHOS_API FHOS_Hash128
+fhos_hash_memory(const void *data, fhos_i64 size_in_bytes) {
+    FHOS_Hash_State state;
+    fhos_begin_hash(&state);
+    fhos_update_hash(&state, data, size_in_bytes);
+    return fhos_end_hash(&state);
+}
+
+FHOS_API fhos_bool
+fhos_hashes_are_equal(FHOS_Hash128 a, FHOS_Hash128 b) {
+    return (a.low == b.low && a.high == b.high);
+}
+
+static fhos_bool
+fhos__hash_file_chunk(void *user_data, const fhos_u8 *data, fhos_i64 size, fhos_i64 offset) {
+    // NOTE(Patrik): Chunks come in file order, the hash state already knows how far along it is.
+    (void)offset;
+    fhos_update_hash((FHOS_Hash_State *)user_data, data, size);
+    return FHOS_TRUE;
+}
+
+FHOS_API fhos_error
+fhos_hash_file(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, FHOS_Hash128 *hash) {
+    if(!hash) {
+        FHOS_LOG_ERROR("fhos_hash_file -> The parameter hash is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    FHOS_File_Handle handle = fhos_open_file_for_reading_with_hint(ctx, path_data, path_length, FHOS_ACCESS_HINT_SEQUENTIAL);
+    if(!fhos_is_file_handle_valid(handle)) { return FHOS_ERROR_INVALID_FILE_HANDLE; }
+    
+    fhos_i64 file_size = fhos_get_size_of_file(handle);
+    if(file_size < 0) {
+        fhos_close_file(handle);
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    FHOS_Hash_State state;
+    fhos_begin_hash(&state);
+    
+    // NOTE(Patrik): Mapping avoids copying the file through a buffer, so the hash runs at the speed of the page cache.
+    fhos_bool is_hashed = (file_size == 0);
+#if defined(_WIN32) || defined(_WIN64)
+    if(!is_hashed && (fhos_u64)file_size <= (fhos_u64)(SIZE_T)-1) {
+        HANDLE mapping = CreateFileMappingA((HANDLE)handle.data, 0, PAGE_READONLY, 0, 0, 0);
+        if(mapping) {
+            void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if(view) {
+                fhos_update_hash(&state, view, file_size);
+                UnmapViewOfFile(view);
+                is_hashed = FHOS_TRUE;
+            }
+            CloseHandle(mapping);
+        }
+    }
+#elif defined(__linux__)
+    if(!is_hashed && (fhos_u64)file_size <= (fhos_u64)(size_t)-1) {
+        void *view = mmap(0, (size_t)file_size, PROT_READ, MAP_PRIVATE, (int)(fhos_isize)handle.data, 0);
+        if(view != MAP_FAILED) {
+            fhos_advise_memory(view, file_size, FHOS_ACCESS_HINT_SEQUENTIAL);
+            fhos_advise_memory(view, file_size, FHOS_ACCESS_HINT_WILLNEED);
+            fhos_update_hash(&state, view, file_size);
+            munmap(view, (size_t)file_size);
+            is_hashed = FHOS_TRUE;
+        }
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    fhos_error result = FHOS_TRUE;
+    if(!is_hashed) {
+        fhos_i64 bytes_read = fhos_read_file_chunks(ctx, handle, 0, fhos__hash_file_chunk, &state);
+        if(bytes_read < 0) { result = (fhos_error)bytes_read; }
+    }
+    
+    fhos_close_file(handle);
+    if(result < 0) { return result; }
+    
+    *hash = fhos_end_hash(&state);
+    return FHOS_TRUE;
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// PACK
+//
+typedef fhos_bool FHOS__Is_Less_Proc(void *context, fhos_i64 a, fhos_i64 b);
+
+// NOTE(Patrik): Bottom up merge sort of indices, stable so equal keys keep the order they were added in.
+static void
+fhos__sort_indices(fhos_i64 *indices, fhos_i64 *temp, fhos_i64 count, FHOS__Is_Less_Proc *is_less, void *context) {
+    fhos_i64 *from = indices;
+    fhos_i64 *to = temp;
+    for(fhos_i64 width = 1; width < count; width *= 2) {
+        for(fhos_i64 start = 0; start < count; start += 2 * width) {
+            fhos_i64 middle = (start + width < count) ? start + width : count;
+            fhos_i64 end = (start + 2 * width < count) ? start + 2 * width : count;
+            fhos_i64 left = start;
+            fhos_i64 right = middle;
+            for(fhos_i64 i = start; i < end; i += 1) {
+                if(left < middle && (right >= end || !is_less(context, from[right], from[left]))) {
+                    to[i] = from[left];
+                    left += 1;
+                } else {
+                    to[i] = from[right];
+                    right += 1;
+                }
+            }
+        }
+        fhos_i64 *swap = from;
+        from = to;
+        to = swap;
+    }
+    
+    if(from != indices) {
+        for(fhos_i64 i = 0; i < count; i += 1) { indices[i] = from[i]; }
+    }
+}
+
+static fhos_i32
+fhos__compare_pack_names(const char *a, fhos_i32 a_length, const char *b, fhos_i32 b_length) {
+    fhos_i32 length = (a_length < b_length) ? a_length : b_length;
+    for(fhos_i32 i = 0; i < length; i += 1) {
+        if(a[i] != b[i]) { return ((fhos_u8)a[i] < (fhos_u8)b[i]) ? -1 : 1; }
+    }
+    return (a_length < b_length) ? -1 : (a_length > b_length) ? 1 : 0;
+}
+
+static fhos_bool
+fhos__is_pack_entry_less(void *context, fhos_i64 a, fhos_i64 b) {
+    FHOS_Pack_Builder *builder = (FHOS_Pack_Builder *)context;
+    FHOS_Pack_Entry *entry_a = builder->entries + a;
+    FHOS_Pack_Entry *entry_b = builder->entries + b;
+    if(entry_a->hash != entry_b->hash) { return entry_a->hash < entry_b->hash; }
+    return fhos__compare_pack_names(builder->names + entry_a->name_offset, entry_a->name_length,
+                                    builder->names + entry_b->name_offset, entry_b->name_length) < 0;
+}
+
+// NOTE(Patrik): Names are stored without leading or trailing slashes.
+static const char *
+fhos__trim_pack_name(const char *name, fhos_i32 *name_length) {
+    if(*name_length < 0) { FHOS__GET_NTSTRING_LENGTH(name, *name_length); }
+    while(*name_length > 0 && (name[0] == '/' || name[0] == '\\')) {
+        name += 1;
+        *name_length -= 1;
+    }
+    while(*name_length > 0 && (name[*name_length - 1] == '/' || name[*name_length - 1] == '\\')) { *name_length -= 1; }
+    return name;
+}
+
+static fhos_bool
+fhos__write_file_at(FHOS_File_Handle handle, fhos_u64 offset, const fhos_u8 *data, fhos_i64 write_amount) {
+#if defined(_WIN32) || defined(_WIN64)
+    while(write_amount > 0) {
+        OVERLAPPED overlapped = {0};
+        overlapped.Offset = (DWORD)offset;
+        overlapped.OffsetHigh = (DWORD)(offset >> 32);
+        DWORD to_write = (write_amount > FHOS_I32_MAX) ? FHOS_I32_MAX : (DWORD)write_amount;
+        DWORD bytes_written = 0;
+        if(!WriteFile((HANDLE)handle.data, data, to_write, &bytes_written, &overlapped) || bytes_written == 0) {
+            FHOS_LOG_ERROR("Could not write file. (%lu)\n", GetLastError());
+            return FHOS_FALSE;
+        }
+        data += bytes_written;
+        offset += bytes_written;
+        write_amount -= bytes_written;
+    }
+#elif defined(__linux__)
+    int fd = (int)(fhos_isize)handle.data;
+    while(write_amount > 0) {
+        fhos_i64 to_write = (write_amount > FHOS_I32_MAX) ? FHOS_I32_MAX : write_amount;
+        ssize_t bytes_written = pwrite(fd, data, (size_t)to_write, (off_t)offset);
+        if(bytes_written < 0 && errno == EINTR) { continue; }
+        if(bytes_written <= 0) {
+            FHOS_LOG_ERROR("Could not write file. (%d)\n", errno);
+            return FHOS_FALSE;
+        }
+        data += bytes_written;
+        offset += bytes_written;
+        write_amount -= bytes_written;
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    return FHOS_TRUE;
+}
+
+static void
+fhos__write_pack(FHOS_Pack_Builder *builder, const void *data, fhos_i64 size_in_bytes) {
+    if(builder->has_failed || size_in_bytes <= 0) { return; }
+    
+    if(fhos_write_file(builder->handle, (const fhos_u8 *)data, size_in_bytes) != size_in_bytes) {
+        builder->has_failed = FHOS_TRUE;
+        return;
+    }
+    builder->offset += (fhos_u64)size_in_bytes;
+}
+
+static void
+fhos__pad_pack(FHOS_Pack_Builder *builder, fhos_u64 alignment) {
+    static const fhos_u8 zeros[4096] = {0};
+    fhos_u64 aligned_offset = (builder->offset + alignment - 1) & ~(alignment - 1);
+    while(builder->offset < aligned_offset && !builder->has_failed) {
+        fhos_u64 padding = aligned_offset - builder->offset;
+        fhos__write_pack(builder, zeros, (fhos_i64)((padding > sizeof(zeros)) ? sizeof(zeros) : padding));
+    }
+}
+
+// NOTE(Patrik): Pads to the alignment and adds the entry for data that is about to be written.
+static FHOS_Pack_Entry *
+fhos__push_pack_entry(FHOS_Context *ctx, FHOS_Pack_Builder *builder, const char *name_data, fhos_i32 name_length) {
+    if(builder->has_failed) { return 0; }
+    
+    name_data = fhos__trim_pack_name(name_data, &name_length);
+    if(name_length == 0) {
+        FHOS_LOG_ERROR("Trying to add a file with an empty name to a pack.\n");
+        return 0;
+    }
+    
+    void *new_entries = fhos_context_maybe_grow(ctx, builder->entries, &builder->capacity, (builder->count + 1) * sizeof(FHOS_Pack_Entry));
+    if(new_entries) { builder->entries = (FHOS_Pack_Entry *)new_entries; }
+    void *new_names = fhos_context_maybe_grow(ctx, builder->names, &builder->names_capacity, builder->names_length + name_length + 1);
+    if(new_names) { builder->names = (char *)new_names; }
+    if(!new_entries || !new_names) {
+        FHOS_LOG_ERROR("Could not allocate memory for the pack entry.\n");
+        builder->has_failed = FHOS_TRUE;
+        return 0;
+    }
+    
+    fhos__pad_pack(builder, builder->alignment);
+    
+    FHOS_Pack_Entry *entry = builder->entries + builder->count;
+    entry->hash = fhos__hash_path(name_data, name_length);
+    entry->offset = builder->offset;
+    entry->size = 0;
+    entry->name_offset = (fhos_u32)builder->names_length;
+    entry->name_length = (fhos_u32)name_length;
+    
+    char *name = builder->names + builder->names_length;
+    for(fhos_i32 i = 0; i < name_length; i += 1) { name[i] = (name_data[i] == '\\') ? '/' : name_data[i]; }
+    name[name_length] = 0;
+    builder->names_length += name_length + 1;
+    builder->count += 1;
+    return entry;
+}
+
+FHOS_API fhos_error
+fhos_begin_pack(FHOS_Context *ctx, FHOS_Pack_Builder *builder, const char *path_data, fhos_i32 path_length, fhos_i64 alignment) {
+    if(!builder) {
+        FHOS_LOG_ERROR("fhos_begin_pack -> The parameter builder is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    if(alignment <= 0) { alignment = FHOS_PACK_DEFAULT_ALIGNMENT; }
+    if((alignment & (alignment - 1)) != 0) {
+        FHOS_LOG_ERROR("fhos_begin_pack -> The alignment %lld is not a power of two.\n", (long long)alignment);
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    FHOS_Pack_Builder zero_builder = {0};
+    *builder = zero_builder;
+    builder->alignment = (fhos_u64)alignment;
+    builder->handle = fhos_open_file_for_writing(ctx, path_data, path_length);
+    if(!fhos_is_file_handle_valid(builder->handle)) { return FHOS_ERROR_INVALID_FILE_HANDLE; }
+    
+    // NOTE(Patrik): The header is written last, once the table of contents is known.
+    FHOS_Pack_Header header = {0};
+    fhos__write_pack(builder, &header, sizeof(header));
+    if(builder->has_failed) {
+        // NOTE(Patrik): fhos_end_pack is not called when beginning failed, so the file is closed here.
+        fhos_close_file(builder->handle);
+        builder->handle = fhos_get_invalid_file_handle();
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    return FHOS_TRUE;
+}
+
+FHOS_API fhos_error
+fhos_add_data_to_pack(FHOS_Context *ctx, FHOS_Pack_Builder *builder, const char *name_data, fhos_i32 name_length,
+                      const fhos_u8 *data, fhos_i64 size_in_bytes)
+{
+    if(!builder || !name_data || (!data && size_in_bytes > 0)) {
+        FHOS_LOG_ERROR("fhos_add_data_to_pack -> The parameter builder, name_data or data is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    FHOS_Pack_Entry *entry = fhos__push_pack_entry(ctx, builder, name_data, name_length);
+    if(!entry) { return FHOS_ERROR_GENERIC_ERROR; }
+    
+    fhos__write_pack(builder, data, size_in_bytes);
+    entry->size = (size_in_bytes > 0) ? (fhos_u64)size_in_bytes : 0;
+    if(builder->has_failed) { return FHOS_ERROR_GENERIC_ERROR; }
+    return FHOS_TRUE;
+}
+
+FHOS_API fhos_error
+fhos_add_file_to_pack(FHOS_Context *ctx, FHOS_Pack_Builder *builder, const char *name_data, fhos_i32 name_length,
+                      const char *path_data, fhos_i32 path_length)
+{
+    if(!builder || !name_data) {
+        FHOS_LOG_ERROR("fhos_add_file_to_pack -> The parameter builder or name_data is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    if(builder->has_failed) { return FHOS_ERROR_GENERIC_ERROR; }
+    
+    FHOS_File_Handle handle = fhos_open_file_for_reading_with_hint(ctx, path_data, path_length, FHOS_ACCESS_HINT_SEQUENTIAL);
+    if(!fhos_is_file_handle_valid(handle)) { return FHOS_ERROR_INVALID_FILE_HANDLE; }
+    
+    fhos_i64 buffer_capacity = 1024 * 1024;
+    fhos_u8 *buffer = (fhos_u8 *)fhos_context_temp_alloc_non_zero(ctx, buffer_capacity);
+    if(!buffer) {
+        FHOS_LOG_ERROR("Could not allocate memory for copying the file into the pack.\n");
+        fhos_close_file(handle);
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    fhos_error result = FHOS_TRUE;
+    FHOS_Pack_Entry *entry = fhos__push_pack_entry(ctx, builder, name_data, name_length);
+    if(!entry) {
+        result = FHOS_ERROR_GENERIC_ERROR;
+    } else {
+        // NOTE(Patrik): Large inputs are reserved in one go so the pack does not fragment as it grows.
+        fhos_i64 file_size = fhos_get_size_of_file(handle);
+        if(file_size >= buffer_capacity) { fhos_preallocate_file(builder->handle, (fhos_i64)entry->offset + file_size); }
+        
+        for(;;) {
+            fhos_i64 bytes_read = fhos_read_file(ctx, handle, buffer, buffer_capacity);
+            if(bytes_read < 0) {
+                builder->has_failed = FHOS_TRUE;
+                result = (fhos_error)bytes_read;
+            }
+            if(bytes_read <= 0) { break; }
+            
+            fhos__write_pack(builder, buffer, bytes_read);
+            entry->size += (fhos_u64)bytes_read;
+        }
+        if(builder->has_failed && result >= 0) { result = FHOS_ERROR_GENERIC_ERROR; }
+    }
+    
+    fhos_context_temp_free(ctx, buffer);
+    fhos_close_file(handle);
+    return result;
+}
+
+FHOS_API fhos_error
+fhos_end_pack(FHOS_Context *ctx, FHOS_Pack_Builder *builder) {
+    if(!builder) {
+        FHOS_LOG_ERROR("fhos_end_pack -> The parameter builder is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    fhos_i64 *indices = 0;
+    FHOS_Pack_Entry *sorted_entries = 0;
+    if(!builder->has_failed && builder->count > 0) {
+        indices = (fhos_i64 *)fhos_context_temp_alloc_non_zero(ctx, 2 * builder->count * sizeof(fhos_i64));
+        sorted_entries = (FHOS_Pack_Entry *)fhos_context_temp_alloc_non_zero(ctx, builder->count * sizeof(FHOS_Pack_Entry));
+        if(!indices || !sorted_entries) {
+            FHOS_LOG_ERROR("Could not allocate memory for the pack table of contents.\n");
+            builder->has_failed = FHOS_TRUE;
+        } else {
+            for(fhos_i64 i = 0; i < builder->count; i += 1) { indices[i] = i; }
+            fhos__sort_indices(indices, indices + builder->count, builder->count, fhos__is_pack_entry_less, builder);
+            
+            for(fhos_i64 i = 0; i < builder->count; i += 1) {
+                sorted_entries[i] = builder->entries[indices[i]];
+                if(i > 0 && !fhos__is_pack_entry_less(builder, indices[i - 1], indices[i])) {
+                    FHOS_LOG_ERROR("The file \"%s\" was added to the pack twice.\n", builder->names + sorted_entries[i].name_offset);
+                    builder->has_failed = FHOS_TRUE;
+                }
+            }
+        }
+    }
+    
+    FHOS_Pack_Header header = {0};
+    header.magic = FHOS_PACK_MAGIC;
+    header.version = FHOS_PACK_VERSION;
+    header.entry_count = (fhos_u64)builder->count;
+    header.alignment = builder->alignment;
+    
+    fhos__pad_pack(builder, 8);
+    header.toc_offset = builder->offset;
+    if(sorted_entries) { fhos__write_pack(builder, sorted_entries, builder->count * sizeof(FHOS_Pack_Entry)); }
+    header.names_offset = builder->offset;
+    header.names_size = (fhos_u64)builder->names_length;
+    fhos__write_pack(builder, builder->names, builder->names_length);
+    
+    if(!builder->has_failed && !fhos__write_file_at(builder->handle, 0, (const fhos_u8 *)&header, sizeof(header))) {
+        builder->has_failed = FHOS_TRUE;
+    }
+    
+    fhos_error result = FHOS_TRUE;
+    if(builder->has_failed) { result = FHOS_ERROR_GENERIC_ERROR; }
+    if(indices) { fhos_context_temp_free(ctx, indices); }
+    if(sorted_entries) { fhos_context_temp_free(ctx, sorted_entries); }
+    if(fhos_is_file_handle_valid(builder->handle)) { fhos_close_file(builder->handle); }
+    if(builder->entries) { fhos_context_free(ctx, builder->entries); }
+    if(builder->names) { fhos_context_free(ctx, builder->names); }
+    
+    FHOS_Pack_Builder zero_builder = {0};
+    *builder = zero_builder;
+    return result;
+}
+
+static fhos_bool
+fhos__is_walk_entry_less(void *context, fhos_i64 a, fhos_i64 b) {
+    FHOS_Walk_Entry **entries = (FHOS_Walk_Entry **)context;
+    return fhos__compare_pack_names(entries[a]->path, entries[a]->path_length, entries[b]->path, entries[b]->path_length) < 0;
+}
+
+FHOS_API fhos_i64
+fhos_build_pack_from_directory(FHOS_Context *ctx, const char *pack_path_data, fhos_i32 pack_path_length,
+                               const char *directory_path_data, fhos_i32 directory_path_length, fhos_i64 alignment)
+{
+    if(!directory_path_data) {
+        FHOS_LOG_ERROR("fhos_build_pack_from_directory -> The parameter directory_path_data is null.\n");
         return FHOS_ERROR_PATH_IS_NULL;
-    } else if(to_path_length == 0) {
-        FHOS_LOG_ERROR("fhos_move_file -> The parameter to_path_length is zero.\n");
-        return FHOS_ERROR_PATH_IS_EMPTY;
+    }
+    if(directory_path_length < 0) { FHOS__GET_NTSTRING_LENGTH(directory_path_data, directory_path_length); }
+    directory_path_length = fhos__trim_path(directory_path_data, directory_path_length);
+    
+    FHOS_Walk_Options options = {0};
+    options.flags = FHOS_DIRECTORY_FLAG_SKIP_DIRECTORY;
+    options.collect_entries = FHOS_TRUE;
+    FHOS_Walk_Result walk = fhos_walk_directory(ctx, directory_path_data, directory_path_length, &options);
+    if(walk.error_count > 0) {
+        fhos_free_walk_result(&walk);
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    fhos_i64 file_count = 0;
+    for(fhos_i32 i = 0; i < walk.list_count; i += 1) { file_count += walk.lists[i].count; }
+    
+    // NOTE(Patrik): The walk order depends on the threads, sort by name so the same directory always gives the same pack.
+    FHOS_Walk_Entry **entries = (FHOS_Walk_Entry **)fhos_context_temp_alloc_non_zero(ctx, file_count * sizeof(FHOS_Walk_Entry *) + 1);
+    fhos_i64 *indices = (fhos_i64 *)fhos_context_temp_alloc_non_zero(ctx, 2 * file_count * sizeof(fhos_i64) + 1);
+    
+    fhos_i64 result = FHOS_ERROR_OUT_OF_MEMORY;
+    if(!entries || !indices) {
+        FHOS_LOG_ERROR("Could not allocate memory for building the pack.\n");
+    } else {
+        // NOTE(Patrik): Only regular files are packed, a symbolic link or a FIFO has no data of its own to store.
+        fhos_i64 count = 0;
+        for(fhos_i32 i = 0; i < walk.list_count; i += 1) {
+            for(fhos_i64 j = 0; j < walk.lists[i].count; j += 1) {
+                if(walk.lists[i].entries[j].type != FHOS_DIRECTORY_ENTRY_TYPE_FILE) { continue; }
+                entries[count] = walk.lists[i].entries + j;
+                indices[count] = count;
+                count += 1;
+            }
+        }
+        file_count = count;
+        fhos__sort_indices(indices, indices + file_count, file_count, fhos__is_walk_entry_less, entries);
+        
+        FHOS_Pack_Builder builder;
+        result = fhos_begin_pack(ctx, &builder, pack_path_data, pack_path_length, alignment);
+        if(result >= 0) {
+            for(fhos_i64 i = 0; i < file_count; i += 1) {
+                FHOS_Walk_Entry *entry = entries[indices[i]];
+                const char *name = entry->path + directory_path_length + 1;
+                fhos_i32 name_length = entry->path_length - directory_path_length - 1;
+                fhos_error add_result = fhos_add_file_to_pack(ctx, &builder, name, name_length, entry->path, entry->path_length);
+                if(add_result < 0) {
+                    // NOTE(Patrik): Otherwise fhos_end_pack would finish a pack that is missing the rest of the files.
+                    builder.has_failed = FHOS_TRUE;
+                    result = add_result;
+                    break;
+                }
+            }
+            fhos_error end_result = fhos_end_pack(ctx, &builder);
+            if(result >= 0) { result = (end_result < 0) ? end_result : file_count; }
+        }
+    }
+    
+    if(entries) { fhos_context_temp_free(ctx, entries); }
+    if(indices) { fhos_context_temp_free(ctx, indices); }
+    fhos_free_walk_result(&walk);
+    return result;
+}
+
+FHOS_API fhos_error
+fhos_mount_pack(FHOS_Context *ctx, FHOS_Pack *pack, const char *path_data, fhos_i32 path_length,
+                const char *loose_root_data, fhos_i32 loose_root_length)
+{
+    if(!pack) {
+        FHOS_LOG_ERROR("fhos_mount_pack -> The parameter pack is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    FHOS_Pack zero_pack = {0};
+    *pack = zero_pack;
+    
+    if(loose_root_data) {
+        if(loose_root_length < 0) { FHOS__GET_NTSTRING_LENGTH(loose_root_data, loose_root_length); }
+        loose_root_length = fhos__trim_path(loose_root_data, loose_root_length);
+        
+        pack->loose_root = (char *)fhos_context_alloc_non_zero(ctx, loose_root_length + 1);
+        if(!pack->loose_root) {
+            FHOS_LOG_ERROR("Could not allocate memory for the loose root.\n");
+            return FHOS_ERROR_OUT_OF_MEMORY;
+        }
+        for(fhos_i32 i = 0; i < loose_root_length; i += 1) { pack->loose_root[i] = loose_root_data[i]; }
+        pack->loose_root[loose_root_length] = 0;
+        pack->loose_root_length = loose_root_length;
+    }
+    
+    FHOS_File_Handle handle = fhos_get_invalid_file_handle();
+    if(path_data) { handle = fhos_open_file_for_reading(ctx, path_data, path_length); }
+    if(!fhos_is_file_handle_valid(handle)) {
+        if(pack->loose_root) { return FHOS_TRUE; }
+        fhos_unmount_pack(ctx, pack);
+        return FHOS_ERROR_NOT_FOUND;
+    }
+    
+    fhos_i64 size = fhos_get_size_of_file(handle);
+    if(size < (fhos_i64)sizeof(FHOS_Pack_Header)) {
+        FHOS_LOG_ERROR("The pack is too small to have a header.\n");
+        fhos_close_file(handle);
+        fhos_unmount_pack(ctx, pack);
+        return FHOS_ERROR_INVALID_FORMAT;
+    }
+    
+    // NOTE(Patrik): The mapping keeps the file alive, the handle is not needed after this.
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE mapping = CreateFileMappingA((HANDLE)handle.data, 0, PAGE_READONLY, 0, 0, 0);
+    if(mapping) {
+        pack->data = (const fhos_u8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if(pack->data) {
+            pack->mapping = mapping;
+        } else {
+            CloseHandle(mapping);
+        }
+    }
+    if(!pack->data) { FHOS_LOG_ERROR("(%lu) Could not map the pack.\n", GetLastError()); }
+#elif defined(__linux__)
+    void *view = mmap(0, (size_t)size, PROT_READ, MAP_SHARED, (int)(fhos_isize)handle.data, 0);
+    if(view != MAP_FAILED) {
+        pack->data = (const fhos_u8 *)view;
+    } else {
+        FHOS_LOG_ERROR("(%d) Could not map the pack.\n", errno);
+    }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    fhos_close_file(handle);
+    if(!pack->data) {
+        fhos_unmount_pack(ctx, pack);
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    pack->size = size;
+    
+    // NOTE(Patrik): Lookups jump around the pack, so readahead around each fault only pulls in other files.
+    // fhos_read_pack_file asks for each entry's pages explicitly instead.
+    fhos_advise_memory(pack->data, size, FHOS_ACCESS_HINT_RANDOM);
+    
+    // NOTE(Patrik): Everything is checked once here so lookups can trust the table of contents.
+    const FHOS_Pack_Header *header = (const FHOS_Pack_Header *)pack->data;
+    fhos_u64 file_size = (fhos_u64)size;
+    fhos_bool is_valid = (header->magic == FHOS_PACK_MAGIC && header->version == FHOS_PACK_VERSION &&
+                          header->toc_offset <= file_size && (header->toc_offset & 7) == 0 &&
+                          header->entry_count <= (file_size - header->toc_offset) / sizeof(FHOS_Pack_Entry) &&
+                          header->names_offset <= file_size && header->names_size <= file_size - header->names_offset);
+    if(is_valid) {
+        pack->entries = (const FHOS_Pack_Entry *)(pack->data + header->toc_offset);
+        pack->names = (const char *)(pack->data + header->names_offset);
+        pack->count = (fhos_i64)header->entry_count;
+        
+        for(fhos_i64 i = 0; i < pack->count && is_valid; i += 1) {
+            const FHOS_Pack_Entry *entry = pack->entries + i;
+            is_valid = (entry->offset <= file_size && entry->size <= file_size - entry->offset &&
+                        (fhos_u64)entry->name_offset + entry->name_length < header->names_size &&
+                        pack->names[entry->name_offset + entry->name_length] == 0 &&
+                        (i == 0 || pack->entries[i - 1].hash <= entry->hash));
+        }
+    }
+    
+    if(!is_valid) {
+        FHOS_LOG_ERROR("The pack is corrupt or was written by another version.\n");
+        fhos_unmount_pack(ctx, pack);
+        return FHOS_ERROR_INVALID_FORMAT;
+    }
+    return FHOS_TRUE;
+}
+
+FHOS_API void
+fhos_unmount_pack(FHOS_Context *ctx, FHOS_Pack *pack) {
+    if(!pack) { return; }
+    
+    if(pack->data) {
+#if defined(_WIN32) || defined(_WIN64)
+        UnmapViewOfFile(pack->data);
+        CloseHandle((HANDLE)pack->mapping);
+#elif defined(__linux__)
+        munmap((void *)pack->data, (size_t)pack->size);
+#else
+#  error Unimplemented on this platform.
+#endif
+    }
+    if(pack->loose_root) { fhos_context_free(ctx, pack->loose_root); }
+    
+    FHOS_Pack zero_pack = {0};
+    *pack = zero_pack;
+}
+
+FHOS_API const FHOS_Pack_Entry *
+fhos_find_pack_entry(FHOS_Pack *pack, const char *name_data, fhos_i32 name_length) {
+    if(!pack || !name_data || pack->count == 0) { return 0; }
+    
+    name_data = fhos__trim_pack_name(name_data, &name_length);
+    fhos_u64 hash = fhos__hash_path(name_data, name_length);
+    
+    fhos_i64 low = 0;
+    fhos_i64 high = pack->count;
+    while(low < high) {
+        fhos_i64 middle = low + (high - low) / 2;
+        if(pack->entries[middle].hash < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    
+    for(fhos_i64 i = low; i < pack->count && pack->entries[i].hash == hash; i += 1) {
+        const FHOS_Pack_Entry *entry = pack->entries + i;
+        if((fhos_i32)entry->name_length == name_length && fhos__is_same_path(pack->names + entry->name_offset, name_data, name_length)) {
+            return entry;
+        }
+    }
+    return 0;
+}
+
+FHOS_API FHOS_List
+fhos_read_pack_file(FHOS_Context *ctx, FHOS_Pack *pack, const char *name_data, fhos_i32 name_length, fhos_bool use_temp_allocator) {
+    FHOS_List result = {0};
+    if(!pack || !name_data) {
+        FHOS_LOG_ERROR("fhos_read_pack_file -> The parameter pack or name_data is null.\n");
+        return result;
+    }
+    
+    name_data = fhos__trim_pack_name(name_data, &name_length);
+    
+    if(pack->loose_root) {
+        fhos_i32 path_length = pack->loose_root_length + 1 + name_length;
+        char stack_path[FHOS_STACK_PATH_CAPACITY];
+        char *path = stack_path;
+        if(path_length >= FHOS_STACK_PATH_CAPACITY) { path = (char *)fhos_context_temp_alloc_non_zero(ctx, path_length + 1); }
+        
+        if(path) {
+            for(fhos_i32 i = 0; i < pack->loose_root_length; i += 1) { path[i] = pack->loose_root[i]; }
+            path[pack->loose_root_length] = '/';
+            for(fhos_i32 i = 0; i < name_length; i += 1) { path[pack->loose_root_length + 1 + i] = name_data[i]; }
+            path[path_length] = 0;
+            
+            if(fhos_file_exists(ctx, path, path_length)) { result = fhos_read_entire_file(ctx, path, path_length, use_temp_allocator); }
+            if(path != stack_path) { fhos_context_temp_free(ctx, path); }
+            if(result.data) { return result; }
+        }
+    }
+    
+    const FHOS_Pack_Entry *entry = fhos_find_pack_entry(pack, name_data, name_length);
+    if(!entry) {
+        FHOS_LOG_ERROR("Could not find \"%.*s\" in the pack.\n", (int)name_length, name_data);
+        return result;
+    }
+    
+    // NOTE(Patrik): The mapping is read only, writing through data crashes.
+    result.data = (fhos_u8 *)(pack->data + entry->offset);
+    fhos_advise_memory(result.data, (fhos_i64)entry->size, FHOS_ACCESS_HINT_WILLNEED);
+    result.count = (fhos_i64)entry->size;
+    result.capacity = -1;
+    return result;
+}
+
+FHOS_API void
+fhos_free_pack_file(FHOS_Context *ctx, FHOS_List *file, fhos_bool use_temp_allocator) {
+    if(!file) { return; }
+    
+    if(file->data && file->capacity >= 0) {
+        if(use_temp_allocator) {
+            fhos_context_temp_free(ctx, file->data);
+        } else {
+            fhos_context_free(ctx, file->data);
+        }
+    }
+    
+    FHOS_List zero_file = {0};
+    *file = zero_file;
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// COMPRESSION
+//
+// NOTE(Patrik): The LZ4 block format is a list of sequences. Each starts with a token, the high four bits are the
+// literal length and the low four the match length minus four, 15 meaning more length bytes follow.
+// Then the literals, then a two byte offset back into the output. The last sequence is only literals.
+#define FHOS__LZ4_HASH_LOG 14
+#define FHOS__LZ4_MIN_MATCH 4
+#define FHOS__LZ4_LAST_LITERALS 5
+#define FHOS__LZ4_MATCH_FIND_LIMIT 12
+#define FHOS__LZ4_MAX_OFFSET 65535
+#define FHOS__LZ4_MAX_INPUT_SIZE 0x7E000000
+#define FHOS__COMPRESSED_BLOCK_IS_STORED 0x80000000u
+
+static fhos_u32
+fhos__read_u32_le(const fhos_u8 *data) {
+    return ((fhos_u32)data[0]) | ((fhos_u32)data[1] << 8) | ((fhos_u32)data[2] << 16) | ((fhos_u32)data[3] << 24);
+}
+
+// NOTE(Patrik): One unaligned eight byte load and store. A byte loop is not merged into one
+// since the compiler has to assume the two pointers overlap.
+#if defined(_MSC_VER) && !defined(__clang__)
+#  define FHOS__COPY_8(to, from) (*(__unaligned fhos_u64 *)(to) = *(const __unaligned fhos_u64 *)(from))
+#else
+#  define FHOS__COPY_8(to, from) __builtin_memcpy((to), (from), 8)
+#endif
+
+static void
+fhos__copy_bytes(fhos_u8 *to, const fhos_u8 *from, fhos_i64 count) {
+    while(count >= 8) {
+        FHOS__COPY_8(to, from);
+        to += 8;
+        from += 8;
+        count -= 8;
+    }
+    for(fhos_i64 i = 0; i < count; i += 1) { to[i] = from[i]; }
+}
+
+// NOTE(Patrik): Copies in eight byte steps and may write up to seven bytes past count,
+// the caller makes sure there is room for that.
+static void
+fhos__copy_bytes_wild(fhos_u8 *to, const fhos_u8 *from, fhos_i64 count) {
+    fhos_u8 *end = to + count;
+    do {
+        FHOS__COPY_8(to, from);
+        to += 8;
+        from += 8;
+    } while(to < end);
+}
+
+static fhos_i32
+fhos__count_trailing_zeros_u64(fhos_u64 value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index = 0;
+    _BitScanForward64(&index, value);
+    return (fhos_i32)index;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+static fhos_u8 *
+fhos__write_lz4_length(fhos_u8 *output, fhos_i64 length) {
+    for(; length >= 255; length -= 255) {
+        *output = 255;
+        output += 1;
+    }
+    *output = (fhos_u8)length;
+    return output + 1;
+}
+
+FHOS_API fhos_i64
+fhos_get_compress_bound(fhos_i64 size_in_bytes) {
+    if(size_in_bytes < 0 || size_in_bytes > FHOS__LZ4_MAX_INPUT_SIZE) { return 0; }
+    return size_in_bytes + size_in_bytes / 255 + 16;
+}
+
+FHOS_API fhos_i64
+fhos_compress_block(const fhos_u8 *data, fhos_i64 size_in_bytes, fhos_u8 *output, fhos_i64 output_capacity) {
+    if((!data && size_in_bytes > 0) || !output) {
+        FHOS_LOG_ERROR("fhos_compress_block -> The parameter data or output is null.\n");
+        return FHOS_ERROR_BUFFER_IS_NULL;
+    }
+    if(size_in_bytes < 0 || size_in_bytes > FHOS__LZ4_MAX_INPUT_SIZE) {
+        FHOS_LOG_ERROR("fhos_compress_block -> Can not compress a block of %lld bytes.\n", (long long)size_in_bytes);
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    // NOTE(Patrik): Positions of the last time each hashed four byte sequence was seen.
+    fhos_u32 table[1 << FHOS__LZ4_HASH_LOG];
+    for(fhos_i32 i = 0; i < (1 << FHOS__LZ4_HASH_LOG); i += 1) { table[i] = 0; }
+    
+    const fhos_u8 *at = data;
+    const fhos_u8 *anchor = data;
+    const fhos_u8 *end = data + size_in_bytes;
+    fhos_u8 *out = output;
+    fhos_u8 *out_end = output + output_capacity;
+    
+    if(size_in_bytes >= FHOS__LZ4_MATCH_FIND_LIMIT + 1) {
+        const fhos_u8 *match_limit = end - FHOS__LZ4_LAST_LITERALS;
+        const fhos_u8 *find_limit = end - FHOS__LZ4_MATCH_FIND_LIMIT;
+        at += 1;
+        
+        while(at <= find_limit) {
+            // NOTE(Patrik): Step further the longer nothing matches, so incompressible data goes by quickly.
+            const fhos_u8 *match = 0;
+            fhos_u32 attempts = 1 << 6;
+            while(at <= find_limit) {
+                fhos_u32 sequence = fhos__read_u32_le(at);
+                fhos_u32 hash = (sequence * 2654435761u) >> (32 - FHOS__LZ4_HASH_LOG);
+                const fhos_u8 *candidate = data + table[hash];
+                table[hash] = (fhos_u32)(at - data);
+                if(candidate < at && at - candidate <= FHOS__LZ4_MAX_OFFSET && fhos__read_u32_le(candidate) == sequence) {
+                    match = candidate;
+                    break;
+                }
+                at += attempts >> 6;
+                attempts += 1;
+            }
+            if(!match) { break; }
+            
+            while(at > anchor && match > data && at[-1] == match[-1]) {
+                at -= 1;
+                match -= 1;
+            }
+            
+            // NOTE(Patrik): Compare eight bytes at a time, the lowest differing bit says where the match ends.
+            const fhos_u8 *match_end = at + FHOS__LZ4_MIN_MATCH;
+            const fhos_u8 *reference = match + FHOS__LZ4_MIN_MATCH;
+            fhos_bool is_match_done = FHOS_FALSE;
+            while(!is_match_done && match_end + 8 <= match_limit) {
+                fhos_u64 difference = fhos__read_u64_le(match_end) ^ fhos__read_u64_le(reference);
+                if(difference) {
+                    match_end += fhos__count_trailing_zeros_u64(difference) / 8;
+                    is_match_done = FHOS_TRUE;
+                } else {
+                    match_end += 8;
+                    reference += 8;
+                }
+            }
+            while(!is_match_done && match_end < match_limit && *match_end == *reference) {
+                match_end += 1;
+                reference += 1;
+            }
+            
+            fhos_i64 literal_length = at - anchor;
+            fhos_i64 match_length = (match_end - at) - FHOS__LZ4_MIN_MATCH;
+            if(out_end - out < 1 + literal_length / 255 + 1 + literal_length + 2 + match_length / 255 + 1) { return 0; }
+            
+            fhos_u8 *token = out;
+            out += 1;
+            *token = (fhos_u8)(((literal_length < 15) ? literal_length : 15) << 4);
+            if(literal_length >= 15) { out = fhos__write_lz4_length(out, literal_length - 15); }
+            fhos__copy_bytes(out, anchor, literal_length);
+            out += literal_length;
+            
+            fhos_u32 offset = (fhos_u32)(at - match);
+            out[0] = (fhos_u8)offset;
+            out[1] = (fhos_u8)(offset >> 8);
+            out += 2;
+            
+            *token |= (fhos_u8)((match_length < 15) ? match_length : 15);
+            if(match_length >= 15) { out = fhos__write_lz4_length(out, match_length - 15); }
+            
+            at = match_end;
+            anchor = at;
+            
+            // NOTE(Patrik): Remember a position inside the match as well, matches often continue from there.
+            if(at <= find_limit) {
+                const fhos_u8 *inside = at - 2;
+                table[(fhos_u32)(fhos__read_u32_le(inside) * 2654435761u) >> (32 - FHOS__LZ4_HASH_LOG)] = (fhos_u32)(inside - data);
+            }
+        }
+    }
+    
+    fhos_i64 literal_length = end - anchor;
+    if(out_end - out < 1 + literal_length / 255 + 1 + literal_length) { return 0; }
+    
+    *out = (fhos_u8)(((literal_length < 15) ? literal_length : 15) << 4);
+    out += 1;
+    if(literal_length >= 15) { out = fhos__write_lz4_length(out, literal_length - 15); }
+    fhos__copy_bytes(out, anchor, literal_length);
+    out += literal_length;
+    
+    return out - output;
+}
+
+FHOS_API fhos_i64
+fhos_decompress_block(const fhos_u8 *data, fhos_i64 size_in_bytes, fhos_u8 *output, fhos_i64 output_capacity) {
+    if((!data && size_in_bytes > 0) || (!output && output_capacity > 0)) {
+        FHOS_LOG_ERROR("fhos_decompress_block -> The parameter data or output is null.\n");
+        return FHOS_ERROR_BUFFER_IS_NULL;
+    }
+    
+    const fhos_u8 *at = data;
+    const fhos_u8 *end = data + size_in_bytes;
+    fhos_u8 *out = output;
+    fhos_u8 *out_end = output + output_capacity;
+    
+    while(at < end) {
+        fhos_u32 token = *at;
+        at += 1;
+        
+        fhos_i64 literal_length = token >> 4;
+        if(literal_length == 15) {
+            fhos_u8 length_byte = 255;
+            while(length_byte == 255) {
+                if(at >= end) { return FHOS_ERROR_INVALID_FORMAT; }
+                length_byte = *at;
+                at += 1;
+                literal_length += length_byte;
+            }
+        }
+        if(literal_length > end - at || literal_length > out_end - out) { return FHOS_ERROR_INVALID_FORMAT; }
+        
+        if(literal_length + 8 <= end - at && literal_length + 8 <= out_end - out) {
+            fhos__copy_bytes_wild(out, at, literal_length);
+        } else {
+            fhos__copy_bytes(out, at, literal_length);
+        }
+        at += literal_length;
+        out += literal_length;
+        
+        // NOTE(Patrik): The last sequence has no match.
+        if(at == end) { break; }
+        
+        if(end - at < 2) { return FHOS_ERROR_INVALID_FORMAT; }
+        fhos_i64 offset = (fhos_i64)at[0] | ((fhos_i64)at[1] << 8);
+        at += 2;
+        if(offset == 0 || offset > out - output) { return FHOS_ERROR_INVALID_FORMAT; }
+        
+        fhos_i64 match_length = token & 15;
+        if(match_length == 15) {
+            fhos_u8 length_byte = 255;
+            while(length_byte == 255) {
+                if(at >= end) { return FHOS_ERROR_INVALID_FORMAT; }
+                length_byte = *at;
+                at += 1;
+                match_length += length_byte;
+            }
+        }
+        match_length += FHOS__LZ4_MIN_MATCH;
+        if(match_length > out_end - out) { return FHOS_ERROR_INVALID_FORMAT; }
+        
+        // NOTE(Patrik): The match may overlap the bytes it produces, that is how runs are encoded.
+        // With an offset of at least eight, every eight byte copy reads only bytes that are already written.
+        const fhos_u8 *match = out - offset;
+        if(offset >= 8 && match_length + 8 <= out_end - out) {
+            fhos__copy_bytes_wild(out, match, match_length);
+        } else if(offset >= 8) {
+            fhos__copy_bytes(out, match, match_length);
+        } else {
+            for(fhos_i64 i = 0; i < match_length; i += 1) { out[i] = match[i]; }
+        }
+        out += match_length;
+    }
+    
+    return out - output;
+}
+
+typedef struct FHOS__Block_Job {
+    fhos_bool is_compressing;
+    const fhos_u8 *input;
+    fhos_u8 *output;
+    // NOTE(Patrik): Where each compressed block starts in input when decompressing, block_count + 1 of them.
+    const fhos_u64 *offsets;
+    fhos_u32 *sizes;
+    
+    fhos_i64 content_size;
+    fhos_i64 block_size;
+    fhos_i64 block_count;
+    
+    FHOS_Atomic_I64 next_block;
+    FHOS_Atomic_I64 error_count;
+} FHOS__Block_Job;
+
+static void
+fhos__block_job_proc(void *data) {
+    FHOS__Block_Job *job = (FHOS__Block_Job *)data;
+    for(;;) {
+        fhos_i64 block = fhos_atomic_fetch_add_i64(&job->next_block, 1, FHOS_MEMORY_ORDER_RELAXED);
+        if(block >= job->block_count) { break; }
+        
+        fhos_i64 start = block * job->block_size;
+        fhos_i64 length = (job->content_size - start < job->block_size) ? job->content_size - start : job->block_size;
+        
+        if(job->is_compressing) {
+            // NOTE(Patrik): Only keep the compressed block if it is smaller, otherwise store it as is.
+            fhos_u8 *output = job->output + start;
+            fhos_i64 compressed_size = fhos_compress_block(job->input + start, length, output, length - 1);
+            if(compressed_size > 0) {
+                job->sizes[block] = (fhos_u32)compressed_size;
+            } else {
+                fhos__copy_bytes(output, job->input + start, length);
+                job->sizes[block] = FHOS__COMPRESSED_BLOCK_IS_STORED | (fhos_u32)length;
+            }
+        } else {
+            const fhos_u8 *input = job->input + job->offsets[block];
+            fhos_i64 input_size = (fhos_i64)(job->offsets[block + 1] - job->offsets[block]);
+            fhos_i64 decompressed_size = FHOS_ERROR_INVALID_FORMAT;
+            if(!(job->sizes[block] & FHOS__COMPRESSED_BLOCK_IS_STORED)) {
+                decompressed_size = fhos_decompress_block(input, input_size, job->output + start, length);
+            } else if(input_size == length) {
+                fhos__copy_bytes(job->output + start, input, length);
+                decompressed_size = length;
+            }
+            
+            if(decompressed_size != length) { fhos_atomic_fetch_add_i64(&job->error_count, 1, FHOS_MEMORY_ORDER_RELAXED); }
+        }
+    }
+}
+
+static void
+fhos__run_block_job(FHOS__Block_Job *job) {
+    fhos_i32 thread_count = fhos__get_processor_count();
+    if(thread_count > job->block_count) { thread_count = (fhos_i32)job->block_count; }
+    fhos__run_on_threads(fhos__block_job_proc, job, thread_count);
+}
+
+FHOS_API FHOS_List
+fhos_read_entire_file_compressed(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, fhos_bool use_temp_allocator) {
+    FHOS_List result = {0};
+    
+    FHOS_File_Handle handle = fhos_open_file_for_reading_with_hint(ctx, path_data, path_length, FHOS_ACCESS_HINT_SEQUENTIAL);
+    if(!fhos_is_file_handle_valid(handle)) { return result; }
+    
+    fhos_i64 file_size = fhos_get_size_of_file(handle);
+    fhos_u8 *input = 0;
+    if(file_size >= (fhos_i64)sizeof(FHOS_Compressed_Header)) {
+        input = (fhos_u8 *)fhos_context_temp_alloc_non_zero(ctx, file_size);
+        if(!input) {
+            FHOS_LOG_ERROR("Could not allocate memory for reading the compressed file.\n");
+        } else if(fhos_read_file(ctx, handle, input, file_size) != file_size) {
+            fhos_context_temp_free(ctx, input);
+            input = 0;
+        }
+    } else {
+        FHOS_LOG_ERROR("The file is too small to be compressed.\n");
+    }
+    fhos_close_file(handle);
+    if(!input) { return result; }
+    
+    FHOS_Compressed_Header header;
+    fhos__copy_bytes((fhos_u8 *)&header, input, sizeof(header));
+    
+    fhos_u64 table_end = sizeof(header) + header.block_count * sizeof(fhos_u32);
+    fhos_bool is_valid = (header.magic == FHOS_COMPRESSED_MAGIC && header.block_size > 0 && header.block_size < FHOS__COMPRESSED_BLOCK_IS_STORED &&
+                          header.block_count <= ((fhos_u64)file_size - sizeof(header)) / sizeof(fhos_u32) &&
+                          header.block_count == header.content_size / header.block_size + ((header.content_size % header.block_size) != 0));
+    
+    fhos_u64 *offsets = 0;
+    if(is_valid) {
+        offsets = (fhos_u64 *)fhos_context_temp_alloc_non_zero(ctx, (header.block_count + 1) * sizeof(fhos_u64));
+        if(!offsets) {
+            FHOS_LOG_ERROR("Could not allocate memory for reading the compressed file.\n");
+            is_valid = FHOS_FALSE;
+        }
+    }
+    
+    fhos_u32 *sizes = (fhos_u32 *)(input + sizeof(header));
+    if(is_valid) {
+        offsets[0] = table_end;
+        for(fhos_u64 i = 0; i < header.block_count; i += 1) {
+            offsets[i + 1] = offsets[i] + (sizes[i] & ~FHOS__COMPRESSED_BLOCK_IS_STORED);
+        }
+        is_valid = (offsets[header.block_count] <= (fhos_u64)file_size);
+    }
+    
+    if(is_valid) {
+        fhos_i64 capacity = (header.content_size > 0) ? (fhos_i64)header.content_size : 1;
+        if(use_temp_allocator) {
+            result.data = (fhos_u8 *)fhos_context_temp_alloc_non_zero(ctx, capacity);
+        } else {
+            result.data = (fhos_u8 *)fhos_context_alloc_non_zero(ctx, capacity);
+        }
+        
+        if(!result.data) {
+            FHOS_LOG_ERROR("Could not allocate memory for the decompressed file.\n");
+        } else {
+            FHOS__Block_Job job = {0};
+            job.input = input;
+            job.output = result.data;
+            job.offsets = offsets;
+            job.sizes = sizes;
+            job.content_size = (fhos_i64)header.content_size;
+            job.block_size = (fhos_i64)header.block_size;
+            job.block_count = (fhos_i64)header.block_count;
+            fhos__run_block_job(&job);
+            
+            if(fhos_atomic_load_i64(&job.error_count, FHOS_MEMORY_ORDER_RELAXED) == 0) {
+                result.count = (fhos_i64)header.content_size;
+                result.capacity = capacity;
+            } else {
+                is_valid = FHOS_FALSE;
+                if(use_temp_allocator) {
+                    fhos_context_temp_free(ctx, result.data);
+                } else {
+                    fhos_context_free(ctx, result.data);
+                }
+                result.data = 0;
+            }
+        }
+    }
+    
+    if(!is_valid) { FHOS_LOG_ERROR("The compressed file is corrupt.\n"); }
+    if(offsets) { fhos_context_temp_free(ctx, offsets); }
+    fhos_context_temp_free(ctx, input);
+    return result;
+}
+
+FHOS_API fhos_bool
+fhos_write_entire_file_compressed(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length,
+                                  const fhos_u8 *data, fhos_i64 write_amount)
+{
+    if(write_amount < 0 || (!data && write_amount > 0)) { return FHOS_FALSE; }
+    
+    FHOS_Compressed_Header header = {0};
+    header.magic = FHOS_COMPRESSED_MAGIC;
+    header.block_size = FHOS_COMPRESSION_BLOCK_SIZE;
+    header.content_size = (fhos_u64)write_amount;
+    header.block_count = (header.content_size + header.block_size - 1) / header.block_size;
+    
+    // NOTE(Patrik): Each block is compressed into the space it takes uncompressed, so this is always enough.
+    fhos_i64 table_end = (fhos_i64)(sizeof(header) + header.block_count * sizeof(fhos_u32));
+    fhos_u8 *output = (fhos_u8 *)fhos_context_temp_alloc_non_zero(ctx, table_end + write_amount);
+    if(!output) {
+        FHOS_LOG_ERROR("Could not allocate memory for compressing the file.\n");
+        return FHOS_FALSE;
+    }
+    
+    fhos_u32 *sizes = (fhos_u32 *)(output + sizeof(header));
+    FHOS__Block_Job job = {0};
+    job.is_compressing = FHOS_TRUE;
+    job.input = data;
+    job.output = output + table_end;
+    job.sizes = sizes;
+    job.content_size = write_amount;
+    job.block_size = (fhos_i64)header.block_size;
+    job.block_count = (fhos_i64)header.block_count;
+    fhos__run_block_job(&job);
+    fhos__copy_bytes(output, (const fhos_u8 *)&header, sizeof(header));
+    
+    // NOTE(Patrik): The blocks are written straight from where they were compressed, the gaps between them are skipped.
+    fhos_i32 buffer_count = 0;
+    FHOS_IO_Vector *buffers = (FHOS_IO_Vector *)fhos_context_temp_alloc_non_zero(ctx, (job.block_count + 1) * sizeof(FHOS_IO_Vector));
+    if(!buffers) {
+        FHOS_LOG_ERROR("Could not allocate memory for compressing the file.\n");
+        fhos_context_temp_free(ctx, output);
+        return FHOS_FALSE;
+    }
+    
+    buffers[buffer_count].data = output;
+    buffers[buffer_count].size = table_end;
+    buffer_count += 1;
+    fhos_i64 output_size = table_end;
+    for(fhos_i64 i = 0; i < job.block_count; i += 1) {
+        buffers[buffer_count].data = job.output + i * job.block_size;
+        buffers[buffer_count].size = (fhos_i64)(sizes[i] & ~FHOS__COMPRESSED_BLOCK_IS_STORED);
+        output_size += buffers[buffer_count].size;
+        buffer_count += 1;
+    }
+    
+    fhos_bool result = FHOS_FALSE;
+    FHOS_File_Handle handle = fhos_open_file_for_writing_with_size_hint(ctx, path_data, path_length, output_size);
+    if(fhos_is_file_handle_valid(handle)) {
+        result = (fhos_write_file_vectored(handle, buffers, buffer_count) == output_size);
+        fhos_close_file(handle);
+    }
+    
+    fhos_context_temp_free(ctx, buffers);
+    fhos_context_temp_free(ctx, output);
+    return result;
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// SHARED RING
+//
+#define FHOS__SHARED_RING_MAGIC 0x474E4952u // NOTE(Patrik): "RING"
+#define FHOS__SHARED_RING_MIN_CAPACITY 4096
+// NOTE(Patrik): Record headers store the message size in 32 bits, this is the largest power of two below that.
+#define FHOS__SHARED_RING_MAX_CAPACITY ((fhos_i64)1 << 31)
+#define FHOS__SHARED_RING_RECORD_HEADER_SIZE 8
+
+// NOTE(Patrik): Lives at the start of the shared memory, the ring data follows it. Each group of fields is
+// written by a different side, so they get their own cache lines. The atomics are a single word each,
+// so every process sees the same layout.
+typedef struct FHOS__Shared_Ring_Header {
+    FHOS_Atomic_I32 magic;
+    fhos_u32 mode;
+    fhos_i64 capacity;
+    fhos_u8 padding0[48];
+    
+    // NOTE(Patrik): Producers claim space by moving reserve_position and make it visible to the consumer by
+    // moving write_position, in the same order as they claimed it.
+    FHOS_Atomic_I64 reserve_position;
+    FHOS_Atomic_I64 write_position;
+    fhos_u8 padding1[48];
+    
+    FHOS_Atomic_I64 read_position;
+    fhos_u8 padding2[56];
+    
+    // NOTE(Patrik): Sleepers wait for the sequence to change, wakers bump it and only make the system call
+    // when someone is actually waiting.
+    FHOS_Atomic_I32 data_sequence;
+    FHOS_Atomic_I32 data_waiter_count;
+    FHOS_Atomic_I32 space_sequence;
+    FHOS_Atomic_I32 space_waiter_count;
+    fhos_u8 padding3[48];
+} FHOS__Shared_Ring_Header;
+
+static fhos_i32
+fhos__build_shared_ring_name(FHOS_Context *ctx, FHOS_Shared_Ring *ring, const char *name_data, fhos_i32 name_length) {
+    if(name_length < 0) { FHOS__GET_NTSTRING_LENGTH(name_data, name_length); }
+    if(name_length == 0) {
+        FHOS_LOG_ERROR("The shared ring name is empty.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    for(fhos_i32 i = 0; i < name_length; i += 1) {
+        if(name_data[i] == '/' || name_data[i] == '\\') {
+            FHOS_LOG_ERROR("The shared ring name \"%.*s\" can not contain slashes.\n", (int)name_length, name_data);
+            return FHOS_ERROR_GENERIC_ERROR;
+        }
+    }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    const char prefix[] = "Local\\fhos_";
+#elif defined(__linux__)
+    // NOTE(Patrik): /dev/shm is what shm_open uses underneath, going there directly saves linking librt on older glibc.
+    const char prefix[] = "/dev/shm/fhos_";
+#else
+#  error Unimplemented on this platform.
+#endif
+    fhos_i32 prefix_length = (fhos_i32)sizeof(prefix) - 1;
+    
+    // NOTE(Patrik): Room for the longest suffix the Windows semaphores add.
+    ring->name = (char *)fhos_context_alloc(ctx, prefix_length + name_length + 16);
+    if(!ring->name) {
+        FHOS_LOG_ERROR("Could not allocate memory for the shared ring name.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    for(fhos_i32 i = 0; i < prefix_length; i += 1) { ring->name[i] = prefix[i]; }
+    for(fhos_i32 i = 0; i < name_length; i += 1) { ring->name[prefix_length + i] = name_data[i]; }
+    ring->name_length = prefix_length + name_length;
+    ring->name[ring->name_length] = 0;
+    return FHOS_TRUE;
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+static HANDLE
+fhos__open_shared_ring_semaphore(FHOS_Shared_Ring *ring, const char *suffix, fhos_bool create) {
+    fhos_i32 length = ring->name_length;
+    for(fhos_i32 i = 0; suffix[i]; i += 1) { ring->name[length] = suffix[i]; length += 1; }
+    ring->name[length] = 0;
+    
+    HANDLE result = (create) ? CreateSemaphoreA(0, 0, 0x7FFFFFFF, ring->name) : OpenSemaphoreA(SEMAPHORE_ALL_ACCESS, FALSE, ring->name);
+    ring->name[ring->name_length] = 0;
+    return result;
+}
+#endif
+
+static void
+fhos__wake_shared_ring(FHOS_Atomic_I32 *sequence, FHOS_Atomic_I32 *waiter_count, void *semaphore) {
+    fhos_atomic_fetch_add_i32(sequence, 1, FHOS_MEMORY_ORDER_RELAXED);
+    fhos_atomic_fence(FHOS_MEMORY_ORDER_SEQ_CST);
+    fhos_i32 waiting = fhos_atomic_load_i32(waiter_count, FHOS_MEMORY_ORDER_RELAXED);
+    if(waiting <= 0) { return; }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    ReleaseSemaphore((HANDLE)semaphore, waiting, 0);
+#elif defined(__linux__)
+    (void)semaphore;
+    syscall(SYS_futex, &sequence->value, FUTEX_WAKE, 0x7FFFFFFF, (struct timespec *)0, (fhos_u32 *)0, 0);
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+// NOTE(Patrik): Sleeps until the sequence moves on from seen_sequence, the timeout runs out or the wait is
+// interrupted. The caller checks its condition again either way.
+static void
+fhos__sleep_on_shared_ring(FHOS_Atomic_I32 *sequence, fhos_i32 seen_sequence, void *semaphore, fhos_i64 timeout_milliseconds) {
+#if defined(_WIN32) || defined(_WIN64)
+    (void)sequence;
+    (void)seen_sequence;
+    WaitForSingleObject((HANDLE)semaphore, (timeout_milliseconds < 0) ? INFINITE : (DWORD)timeout_milliseconds);
+#elif defined(__linux__)
+    (void)semaphore;
+    struct timespec timeout;
+    struct timespec *timeout_pointer = 0;
+    if(timeout_milliseconds >= 0) {
+        timeout.tv_sec = (time_t)(timeout_milliseconds / 1000);
+        timeout.tv_nsec = (long)(timeout_milliseconds % 1000) * 1000000;
+        timeout_pointer = &timeout;
+    }
+    syscall(SYS_futex, &sequence->value, FUTEX_WAIT, seen_sequence, timeout_pointer, (fhos_u32 *)0, 0);
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+static fhos_error
+fhos__map_shared_ring(FHOS_Shared_Ring *ring, fhos_i64 capacity, fhos_i32 mode, fhos_bool create) {
+    fhos_i64 map_size = (fhos_i64)sizeof(FHOS__Shared_Ring_Header) + capacity;
+    
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE mapping = 0;
+    if(create) {
+        mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, 0, PAGE_READWRITE, (DWORD)((fhos_u64)map_size >> 32), (DWORD)map_size, ring->name);
+        if(mapping && GetLastError() == ERROR_ALREADY_EXISTS) {
+            FHOS_LOG_ERROR("The shared ring \"%s\" already exists.\n", ring->name);
+            CloseHandle(mapping);
+            return FHOS_ERROR_ALREADY_EXISTS;
+        }
+    } else {
+        mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, ring->name);
+    }
+    if(!mapping) {
+        DWORD last_error = GetLastError();
+        if(create || last_error != ERROR_FILE_NOT_FOUND) { FHOS_LOG_ERROR("(%lu) Could not map the shared ring \"%s\".\n", last_error, ring->name); }
+        return (last_error == ERROR_FILE_NOT_FOUND) ? FHOS_ERROR_NOT_FOUND : FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    ring->is_owner = create;
+    ring->mapping = (void *)mapping;
+    ring->header = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if(!ring->header) {
+        FHOS_LOG_ERROR("(%lu) Could not map the shared ring \"%s\".\n", GetLastError(), ring->name);
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    ring->data_semaphore = (void *)fhos__open_shared_ring_semaphore(ring, "_data", create);
+    ring->space_semaphore = (void *)fhos__open_shared_ring_semaphore(ring, "_space", create);
+    if(!ring->data_semaphore || !ring->space_semaphore) {
+        FHOS_LOG_ERROR("(%lu) Could not open the semaphores of the shared ring \"%s\".\n", GetLastError(), ring->name);
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+#elif defined(__linux__)
+    int flags = (create) ? (O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC) : (O_RDWR | O_CLOEXEC);
+    int fd = open(ring->name, flags, 0600);
+    if(fd < 0) {
+        if(errno == EEXIST) {
+            FHOS_LOG_ERROR("The shared ring \"%s\" already exists.\n", ring->name);
+            return FHOS_ERROR_ALREADY_EXISTS;
+        }
+        if(create || errno != ENOENT) { FHOS_LOG_ERROR("(%d) Could not open the shared ring \"%s\".\n", errno, ring->name); }
+        return (errno == ENOENT) ? FHOS_ERROR_NOT_FOUND : FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    if(create) {
+        ring->is_owner = FHOS_TRUE;
+        if(ftruncate(fd, (off_t)map_size) != 0) {
+            FHOS_LOG_ERROR("(%d) Could not size the shared ring \"%s\".\n", errno, ring->name);
+            close(fd);
+            return FHOS_ERROR_GENERIC_ERROR;
+        }
+    } else {
+        struct stat file_stat;
+        if(fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t)sizeof(FHOS__Shared_Ring_Header)) {
+            FHOS_LOG_ERROR("The shared ring \"%s\" is not ready.\n", ring->name);
+            close(fd);
+            return FHOS_ERROR_INVALID_FORMAT;
+        }
+        map_size = (fhos_i64)file_stat.st_size;
+    }
+    
+    // NOTE(Patrik): The mapping keeps the memory alive, the descriptor is not needed after this.
+    void *view = mmap(0, (size_t)map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(view == MAP_FAILED) {
+        FHOS_LOG_ERROR("(%d) Could not map the shared ring \"%s\".\n", errno, ring->name);
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    ring->header = view;
+    ring->map_size = map_size;
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    FHOS__Shared_Ring_Header *header = (FHOS__Shared_Ring_Header *)ring->header;
+    if(create) {
+        header->mode = (fhos_u32)mode;
+        header->capacity = capacity;
+        // NOTE(Patrik): The magic goes in last, it tells openers the rest of the header is ready.
+        fhos_atomic_store_i32(&header->magic, (fhos_i32)FHOS__SHARED_RING_MAGIC, FHOS_MEMORY_ORDER_RELEASE);
+    } else if(fhos_atomic_load_i32(&header->magic, FHOS_MEMORY_ORDER_ACQUIRE) != (fhos_i32)FHOS__SHARED_RING_MAGIC ||
+              header->capacity < FHOS__SHARED_RING_MIN_CAPACITY || header->capacity > FHOS__SHARED_RING_MAX_CAPACITY ||
+              (header->capacity & (header->capacity - 1)) != 0
+#if defined(__linux__)
+              || (fhos_i64)sizeof(FHOS__Shared_Ring_Header) + header->capacity > ring->map_size
+#endif
+              ) {
+        FHOS_LOG_ERROR("The shared ring \"%s\" is not ready or was made by another version.\n", ring->name);
+        return FHOS_ERROR_INVALID_FORMAT;
+    }
+    
+    ring->data = (fhos_u8 *)ring->header + sizeof(FHOS__Shared_Ring_Header);
+    ring->capacity = header->capacity;
+    ring->mode = (fhos_i32)header->mode;
+    return FHOS_TRUE;
+}
+
+FHOS_API fhos_error
+fhos_create_shared_ring(FHOS_Context *ctx, FHOS_Shared_Ring *ring, const char *name_data, fhos_i32 name_length,
+                        fhos_i64 capacity, FHOS_Shared_Ring_Mode mode)
+{
+    if(!ring || !name_data) {
+        FHOS_LOG_ERROR("fhos_create_shared_ring -> The parameter ring or name_data is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    FHOS_Shared_Ring zero_ring = {0};
+    *ring = zero_ring;
+    
+    if(capacity > FHOS__SHARED_RING_MAX_CAPACITY) {
+        FHOS_LOG_ERROR("fhos_create_shared_ring -> A capacity of %lld bytes is more than a shared ring can hold.\n", (long long)capacity);
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    fhos_i64 rounded_capacity = FHOS__SHARED_RING_MIN_CAPACITY;
+    while(rounded_capacity < capacity) { rounded_capacity *= 2; }
+    
+    fhos_error result = fhos__build_shared_ring_name(ctx, ring, name_data, name_length);
+    if(result < 0) { return result; }
+    
+    result = fhos__map_shared_ring(ring, rounded_capacity, (fhos_i32)mode, FHOS_TRUE);
+    if(result < 0) { fhos_close_shared_ring(ctx, ring); }
+    return result;
+}
+
+FHOS_API fhos_error
+fhos_open_shared_ring(FHOS_Context *ctx, FHOS_Shared_Ring *ring, const char *name_data, fhos_i32 name_length) {
+    if(!ring || !name_data) {
+        FHOS_LOG_ERROR("fhos_open_shared_ring -> The parameter ring or name_data is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    FHOS_Shared_Ring zero_ring = {0};
+    *ring = zero_ring;
+    
+    fhos_error result = fhos__build_shared_ring_name(ctx, ring, name_data, name_length);
+    if(result < 0) { return result; }
+    
+    result = fhos__map_shared_ring(ring, 0, 0, FHOS_FALSE);
+    if(result < 0) { fhos_close_shared_ring(ctx, ring); }
+    return result;
+}
+
+FHOS_API fhos_error
+fhos_write_shared_ring(FHOS_Shared_Ring *ring, const void *data, fhos_i64 size, fhos_i64 timeout_milliseconds) {
+    if(!ring || !ring->header || (!data && size > 0) || size < 0) {
+        FHOS_LOG_ERROR("fhos_write_shared_ring -> The ring is not open or the data is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    FHOS__Shared_Ring_Header *header = (FHOS__Shared_Ring_Header *)ring->header;
+    fhos_i64 mask = ring->capacity - 1;
+    if(size > ring->capacity - FHOS__SHARED_RING_RECORD_HEADER_SIZE) {
+        FHOS_LOG_ERROR("A message of %lld bytes does not fit in the shared ring.\n", (long long)size);
+        return FHOS_ERROR_BUFFER_TOO_SMALL;
+    }
+    fhos_i64 record_size = (FHOS__SHARED_RING_RECORD_HEADER_SIZE + size + 7) & ~(fhos_i64)7;
+    
+    // NOTE(Patrik): Claim the space first. With one producer nobody else moves reserve_position, so there
+    // is no need to compare and swap.
+    fhos_i64 deadline = (timeout_milliseconds > 0) ? fhos__get_milliseconds() + timeout_milliseconds : 0;
+    fhos_i64 position = 0;
+    for(;;) {
+        position = fhos_atomic_load_i64(&header->reserve_position, FHOS_MEMORY_ORDER_ACQUIRE);
+        fhos_i64 read_position = fhos_atomic_load_i64(&header->read_position, FHOS_MEMORY_ORDER_ACQUIRE);
+        if(position + record_size - read_position <= ring->capacity) {
+            if(ring->mode == FHOS_SHARED_RING_MODE_SPSC) {
+                fhos_atomic_store_i64(&header->reserve_position, position + record_size, FHOS_MEMORY_ORDER_RELEASE);
+                break;
+            }
+            if(fhos_atomic_compare_exchange_i64(&header->reserve_position, &position, position + record_size, FHOS_MEMORY_ORDER_ACQ_REL)) { break; }
+            continue;
+        }
+        
+        fhos_i64 remaining = (timeout_milliseconds > 0) ? deadline - fhos__get_milliseconds() : timeout_milliseconds;
+        if(timeout_milliseconds >= 0 && remaining <= 0) { return FHOS_ERROR_TIMED_OUT; }
+        
+        fhos_i32 seen_sequence = fhos_atomic_load_i32(&header->space_sequence, FHOS_MEMORY_ORDER_ACQUIRE);
+        fhos_atomic_fetch_add_i32(&header->space_waiter_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+        fhos_atomic_fence(FHOS_MEMORY_ORDER_SEQ_CST);
+        if(fhos_atomic_load_i64(&header->read_position, FHOS_MEMORY_ORDER_ACQUIRE) == read_position) {
+            fhos__sleep_on_shared_ring(&header->space_sequence, seen_sequence, ring->space_semaphore, remaining);
+        }
+        fhos_atomic_fetch_add_i32(&header->space_waiter_count, -1, FHOS_MEMORY_ORDER_RELAXED);
+    }
+    
+    // NOTE(Patrik): The header never wraps since records are 8 byte aligned, the payload can.
+    fhos_u8 record_header[FHOS__SHARED_RING_RECORD_HEADER_SIZE] = {0};
+    fhos_u64 size_u64 = (fhos_u64)size;
+    for(fhos_i32 i = 0; i < 4; i += 1) { record_header[i] = (fhos_u8)(size_u64 >> (8 * i)); }
+    fhos_u8 *record = ring->data + (position & mask);
+    for(fhos_i32 i = 0; i < FHOS__SHARED_RING_RECORD_HEADER_SIZE; i += 1) { record[i] = record_header[i]; }
+    
+    fhos_i64 payload_start = (position + FHOS__SHARED_RING_RECORD_HEADER_SIZE) & mask;
+    fhos_i64 first_part = ring->capacity - payload_start;
+    if(first_part > size) { first_part = size; }
+    const fhos_u8 *bytes = (const fhos_u8 *)data;
+    for(fhos_i64 i = 0; i < first_part; i += 1) { ring->data[payload_start + i] = bytes[i]; }
+    for(fhos_i64 i = first_part; i < size; i += 1) { ring->data[i - first_part] = bytes[i]; }
+    
+    // NOTE(Patrik): Producers that claimed space earlier have to publish first, otherwise the consumer
+    // could read over a record that is still being copied.
+    if(ring->mode != FHOS_SHARED_RING_MODE_SPSC) {
+        fhos_i32 spin_count = 0;
+        while(fhos_atomic_load_i64(&header->write_position, FHOS_MEMORY_ORDER_ACQUIRE) != position) {
+            spin_count += 1;
+            if(spin_count > 64) { fhos__thread_yield(); }
+        }
+    }
+    fhos_atomic_store_i64(&header->write_position, position + record_size, FHOS_MEMORY_ORDER_RELEASE);
+    
+    fhos__wake_shared_ring(&header->data_sequence, &header->data_waiter_count, ring->data_semaphore);
+    return FHOS_TRUE;
+}
+
+FHOS_API fhos_i64
+fhos_read_shared_ring(FHOS_Shared_Ring *ring, void *buffer, fhos_i64 buffer_capacity, fhos_i64 timeout_milliseconds) {
+    if(!ring || !ring->header || (!buffer && buffer_capacity > 0)) {
+        FHOS_LOG_ERROR("fhos_read_shared_ring -> The ring is not open or the buffer is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    FHOS__Shared_Ring_Header *header = (FHOS__Shared_Ring_Header *)ring->header;
+    fhos_i64 mask = ring->capacity - 1;
+    fhos_i64 read_position = fhos_atomic_load_i64(&header->read_position, FHOS_MEMORY_ORDER_ACQUIRE);
+    
+    fhos_i64 deadline = (timeout_milliseconds > 0) ? fhos__get_milliseconds() + timeout_milliseconds : 0;
+    while(fhos_atomic_load_i64(&header->write_position, FHOS_MEMORY_ORDER_ACQUIRE) == read_position) {
+        fhos_i64 remaining = (timeout_milliseconds > 0) ? deadline - fhos__get_milliseconds() : timeout_milliseconds;
+        if(timeout_milliseconds >= 0 && remaining <= 0) { return FHOS_ERROR_TIMED_OUT; }
+        
+        fhos_i32 seen_sequence = fhos_atomic_load_i32(&header->data_sequence, FHOS_MEMORY_ORDER_ACQUIRE);
+        fhos_atomic_fetch_add_i32(&header->data_waiter_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+        fhos_atomic_fence(FHOS_MEMORY_ORDER_SEQ_CST);
+        if(fhos_atomic_load_i64(&header->write_position, FHOS_MEMORY_ORDER_ACQUIRE) == read_position) {
+            fhos__sleep_on_shared_ring(&header->data_sequence, seen_sequence, ring->data_semaphore, remaining);
+        }
+        fhos_atomic_fetch_add_i32(&header->data_waiter_count, -1, FHOS_MEMORY_ORDER_RELAXED);
+    }
+    
+    const fhos_u8 *record = ring->data + (read_position & mask);
+    fhos_i64 size = (fhos_i64)((fhos_u32)record[0] | ((fhos_u32)record[1] << 8) | ((fhos_u32)record[2] << 16) | ((fhos_u32)record[3] << 24));
+    fhos_i64 record_size = (FHOS__SHARED_RING_RECORD_HEADER_SIZE + size + 7) & ~(fhos_i64)7;
+    if(record_size > ring->capacity) {
+        FHOS_LOG_ERROR("The shared ring is corrupt.\n");
+        return FHOS_ERROR_INVALID_FORMAT;
+    }
+    if(size > buffer_capacity) { return FHOS_ERROR_BUFFER_TOO_SMALL; }
+    
+    fhos_i64 payload_start = (read_position + FHOS__SHARED_RING_RECORD_HEADER_SIZE) & mask;
+    fhos_i64 first_part = ring->capacity - payload_start;
+    if(first_part > size) { first_part = size; }
+    fhos_u8 *bytes = (fhos_u8 *)buffer;
+    for(fhos_i64 i = 0; i < first_part; i += 1) { bytes[i] = ring->data[payload_start + i]; }
+    for(fhos_i64 i = first_part; i < size; i += 1) { bytes[i] = ring->data[i - first_part]; }
+    
+    fhos_atomic_store_i64(&header->read_position, read_position + record_size, FHOS_MEMORY_ORDER_RELEASE);
+    fhos__wake_shared_ring(&header->space_sequence, &header->space_waiter_count, ring->space_semaphore);
+    return size;
+}
+
+FHOS_API void
+fhos_close_shared_ring(FHOS_Context *ctx, FHOS_Shared_Ring *ring) {
+    if(!ring) { return; }
+    
+#if defined(_WIN32) || defined(_WIN64)
+    // NOTE(Patrik): Windows removes the name once the last handle is closed.
+    if(ring->header) { UnmapViewOfFile(ring->header); }
+    if(ring->mapping) { CloseHandle((HANDLE)ring->mapping); }
+    if(ring->data_semaphore) { CloseHandle((HANDLE)ring->data_semaphore); }
+    if(ring->space_semaphore) { CloseHandle((HANDLE)ring->space_semaphore); }
+#elif defined(__linux__)
+    // NOTE(Patrik): Processes that already opened the ring keep it alive, new ones can no longer find it.
+    if(ring->header) { munmap(ring->header, (size_t)ring->map_size); }
+    if(ring->is_owner && ring->name) { unlink(ring->name); }
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    if(ring->name) { fhos_context_free(ctx, ring->name); }
+    
+    FHOS_Shared_Ring zero_ring = {0};
+    *ring = zero_ring;
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// TIME
+//
+FHOS_API FHOS_Date_And_Time
+fhos_get_date_and_time(void) {
+    FHOS_Date_And_Time result = {0};
+    
+#if defined(_WIN32) || defined(_WIN64)
+    SYSTEMTIME system = {0};
+    GetSystemTime(&system);
+    
+    result.year         = (fhos_u32)system.wYear;
+    result.milliseconds = (fhos_u16)system.wMilliseconds;
+    result.month        = (fhos_u8)system.wMonth;
+    result.day          = (fhos_u8)system.wDay;
+    result.weekday      = (fhos_u8)system.wDayOfWeek;
+    result.hour         = (fhos_u8)system.wHour;
+    result.minutes      = (fhos_u8)system.wMinute;
+    result.seconds      = (fhos_u8)system.wSecond;
+#elif defined(__linux__)
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    
+    struct tm system;
+    gmtime_r(&now.tv_sec, &system);
+    
+    result.year         = (fhos_u32)(system.tm_year + 1900);
+    result.milliseconds = (fhos_u16)(now.tv_nsec / 1000000);
+    result.month        = (fhos_u8)(system.tm_mon + 1);
+    result.day          = (fhos_u8)system.tm_mday;
+    result.weekday      = (fhos_u8)system.tm_wday;
+    result.hour         = (fhos_u8)system.tm_hour;
+    result.minutes      = (fhos_u8)system.tm_min;
+    result.seconds      = (fhos_u8)system.tm_sec;
+#else
+#  error Unimplemented on this platform.
+#endif
+    
+    return result;
+}
+
+FHOS_API fhos_u64
+fhos_get_unix_timestamp(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    fhos_u64 unix_time_start = 0x019DB1DED53E8000ULL;
+    fhos_u64 ticks_per_second = 10000000;
+    
+    FILETIME file_time;
+    GetSystemTimeAsFileTime(&file_time);
+    
+    LARGE_INTEGER large;
+    large.LowPart = file_time.dwLowDateTime;
+    large.HighPart = file_time.dwHighDateTime;
+    
+    return (large.QuadPart - unix_time_start) / ticks_per_second;
+#elif defined(__linux__)
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (fhos_u64)now.tv_sec;
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+// NOTE(Patrik): Each thread keeps the calendar for the last second it asked about. Within that second only
+// the milliseconds change, and the date is only worked out again when the day changes.
+typedef struct FHOS__Calendar_Cache {
+    fhos_i64 second;
+    fhos_i64 day;
+    fhos_bool is_valid;
+    FHOS_Date_And_Time date_and_time;
+} FHOS__Calendar_Cache;
+
+static FHOS__THREAD_LOCAL FHOS__Calendar_Cache fhos__calendar_cache;
+
+// NOTE(Patrik): Reads the clock the scheduler updates on every tick, no better than a few milliseconds on
+// Linux and around 16 ms on Windows, but only a memory read away.
+static fhos_i64
+fhos__get_coarse_unix_milliseconds(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    fhos_u64 unix_time_start = 0x019DB1DED53E8000ULL;
+    
+    FILETIME file_time;
+    GetSystemTimeAsFileTime(&file_time);
+    
+    LARGE_INTEGER large;
+    large.LowPart = file_time.dwLowDateTime;
+    large.HighPart = file_time.dwHighDateTime;
+    
+    return (fhos_i64)((large.QuadPart - unix_time_start) / 10000);
+#elif defined(__linux__)
+    struct timespec now;
+    if(clock_gettime(CLOCK_REALTIME_COARSE, &now) != 0) { clock_gettime(CLOCK_REALTIME, &now); }
+    return (fhos_i64)now.tv_sec * 1000 + (fhos_i64)(now.tv_nsec / 1000000);
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+// NOTE(Patrik): Days since 1970-01-01 to a date in the proleptic Gregorian calendar, counted in 400 year eras
+// that all have the same number of days. The years start in March so the leap day comes last.
+static void
+fhos__set_date_from_days(FHOS_Date_And_Time *date_and_time, fhos_i64 days) {
+    fhos_i64 shifted = days + 719468;
+    fhos_i64 era = ((shifted >= 0) ? shifted : shifted - 146096) / 146097;
+    fhos_i64 day_of_era = shifted - era * 146097;
+    fhos_i64 year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    fhos_i64 day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    fhos_i64 month_from_march = (5 * day_of_year + 2) / 153;
+    fhos_i64 month = (month_from_march < 10) ? month_from_march + 3 : month_from_march - 9;
+    fhos_i64 weekday = (days + 4) % 7;
+    
+    date_and_time->year    = (fhos_u32)(year_of_era + era * 400 + ((month <= 2) ? 1 : 0));
+    date_and_time->month   = (fhos_u8)month;
+    date_and_time->day     = (fhos_u8)(day_of_year - (153 * month_from_march + 2) / 5 + 1);
+    date_and_time->weekday = (fhos_u8)((weekday < 0) ? weekday + 7 : weekday);
+}
+
+FHOS_API FHOS_Date_And_Time
+fhos_get_coarse_date_and_time(void) {
+    fhos_i64 milliseconds = fhos__get_coarse_unix_milliseconds();
+    fhos_i64 second = milliseconds / 1000;
+    FHOS__Calendar_Cache *cache = &fhos__calendar_cache;
+    
+    if(!cache->is_valid || second != cache->second) {
+        fhos_i64 day = second / 86400;
+        fhos_i64 second_of_day = second - day * 86400;
+        if(second_of_day < 0) {
+            day -= 1;
+            second_of_day += 86400;
+        }
+        
+        if(!cache->is_valid || day != cache->day) {
+            fhos__set_date_from_days(&cache->date_and_time, day);
+            cache->day = day;
+        }
+        
+        cache->date_and_time.hour    = (fhos_u8)(second_of_day / 3600);
+        cache->date_and_time.minutes = (fhos_u8)((second_of_day / 60) % 60);
+        cache->date_and_time.seconds = (fhos_u8)(second_of_day % 60);
+        cache->second = second;
+        cache->is_valid = FHOS_TRUE;
+    }
+    
+    FHOS_Date_And_Time result = cache->date_and_time;
+    result.milliseconds = (fhos_u16)(milliseconds - second * 1000);
+    return result;
+}
+
+FHOS_API fhos_u64
+fhos_get_coarse_unix_timestamp(void) {
+    return (fhos_u64)(fhos__get_coarse_unix_milliseconds() / 1000);
+}
+
+// NOTE(Patrik): The invariant TSC runs at a constant rate in every power state and is synchronized between
+// cores, so it can be used as a clock directly. Reading it costs a few nanoseconds, a clock_gettime
+// or QueryPerformanceCounter call costs several times that.
+enum {
+    FHOS__TICK_SOURCE_UNKNOWN = 0,
+    FHOS__TICK_SOURCE_CALIBRATING = 1,
+    FHOS__TICK_SOURCE_OS = 2,
+    FHOS__TICK_SOURCE_TSC = 3,
+};
+
+static FHOS_Atomic_I32 fhos__tick_source;
+static fhos_u64 fhos__tick_frequency;
+
+static fhos_u64
+fhos__get_os_ticks(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (fhos_u64)counter.QuadPart;
+#elif defined(__linux__)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (fhos_u64)now.tv_sec * 1000000000ull + (fhos_u64)now.tv_nsec;
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+static fhos_u64
+fhos__get_os_tick_frequency(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return (fhos_u64)frequency.QuadPart;
+#elif defined(__linux__)
+    return 1000000000ull;
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+#if defined(FHOS__TICKS_X64)
+static fhos_bool
+fhos__cpu_has_invariant_tsc(void) {
+#  if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0x80000000);
+    if((unsigned int)info[0] < 0x80000007u) { return FHOS_FALSE; }
+    __cpuid(info, 0x80000007);
+    return ((info[3] & (1 << 8)) != 0);
+#  else
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if(!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) { return FHOS_FALSE; }
+    return ((edx & (1u << 8)) != 0);
+#  endif
+}
+#endif
+
+// NOTE(Patrik): The TSC rate is measured against the OS clock over a couple of milliseconds the first time
+// ticks are asked for, which puts it within a few parts per million.
+static void
+fhos__pick_tick_source(void) {
+    if(fhos_atomic_load_i32(&fhos__tick_source, FHOS_MEMORY_ORDER_ACQUIRE) >= FHOS__TICK_SOURCE_OS) { return; }
+    fhos_i32 expected = FHOS__TICK_SOURCE_UNKNOWN;
+    if(!fhos_atomic_compare_exchange_i32(&fhos__tick_source, &expected, FHOS__TICK_SOURCE_CALIBRATING, FHOS_MEMORY_ORDER_ACQ_REL)) {
+        while(fhos_atomic_load_i32(&fhos__tick_source, FHOS_MEMORY_ORDER_ACQUIRE) == FHOS__TICK_SOURCE_CALIBRATING) { fhos__thread_yield(); }
+        return;
+    }
+    
+    fhos_i32 source = FHOS__TICK_SOURCE_OS;
+    fhos__tick_frequency = fhos__get_os_tick_frequency();
+    
+#if defined(FHOS__TICKS_X64) && !defined(FHOS_NO_TSC)
+    if(fhos__cpu_has_invariant_tsc()) {
+        fhos_u64 os_frequency = fhos__tick_frequency;
+        fhos_u64 os_start = fhos__get_os_ticks();
+        fhos_u64 tsc_start = __rdtsc();
+        fhos_u64 os_wait = os_frequency / 500;
+        
+        fhos_u64 os_end = os_start;
+        while(os_end - os_start < os_wait) { os_end = fhos__get_os_ticks(); }
+        fhos_u64 tsc_end = __rdtsc();
+        
+        fhos_u64 os_elapsed = os_end - os_start;
+        fhos_u64 tsc_elapsed = tsc_end - tsc_start;
+        if(os_elapsed > 0 && tsc_elapsed > os_elapsed / 16) {
+            fhos__tick_frequency = (fhos_u64)((double)tsc_elapsed * (double)os_frequency / (double)os_elapsed);
+            source = FHOS__TICK_SOURCE_TSC;
+        }
+    }
+#endif
+    
+    fhos_atomic_store_i32(&fhos__tick_source, source, FHOS_MEMORY_ORDER_RELEASE);
+}
+
+FHOS_API fhos_u64
+fhos_get_ticks(void) {
+    fhos_i32 source = fhos_atomic_load_i32(&fhos__tick_source, FHOS_MEMORY_ORDER_ACQUIRE);
+    if(source < FHOS__TICK_SOURCE_OS) {
+        fhos__pick_tick_source();
+        source = fhos_atomic_load_i32(&fhos__tick_source, FHOS_MEMORY_ORDER_ACQUIRE);
+    }
+    
+#if defined(FHOS__TICKS_X64)
+    if(source == FHOS__TICK_SOURCE_TSC) { return __rdtsc(); }
+#endif
+    return fhos__get_os_ticks();
+}
+
+FHOS_API fhos_u64
+fhos_get_tick_frequency(void) {
+    fhos__pick_tick_source();
+    return fhos__tick_frequency;
+}
+
+// NOTE(Patrik): Split into whole seconds and the rest so the multiplication can not overflow.
+FHOS_API fhos_u64
+fhos_ticks_to_nanoseconds(fhos_u64 ticks) {
+    fhos_u64 frequency = fhos_get_tick_frequency();
+    return (ticks / frequency) * 1000000000ull + ((ticks % frequency) * 1000000000ull) / frequency;
+}
+
+FHOS_API fhos_u64
+fhos_nanoseconds_to_ticks(fhos_u64 nanoseconds) {
+    fhos_u64 frequency = fhos_get_tick_frequency();
+    return (nanoseconds / 1000000000ull) * frequency + ((nanoseconds % 1000000000ull) * frequency) / 1000000000ull;
+}
+
+// NOTE(Patrik): A sleep comes back late by however long the scheduler takes to run the thread again. Each
+// thread keeps its worst recent overshoot and stops sleeping that far before the deadline, the rest
+// is spun off. The estimate jumps to a new worst case right away and eases back down slowly.
+#define FHOS__MAX_SLEEP_OVERSHOOT_NANOSECONDS 4000000ull
+
+static FHOS__THREAD_LOCAL fhos_bool fhos__has_tuned_sleep;
+static FHOS__THREAD_LOCAL fhos_u64 fhos__sleep_overshoot_nanoseconds;
+#if defined(_WIN32) || defined(_WIN64)
+static FHOS__THREAD_LOCAL HANDLE fhos__sleep_timer;
+static FHOS__Thread_Exit_Hook fhos__sleep_timer_exit_hook;
+
+static FHOS__THREAD_EXIT_PROC(fhos__close_sleep_timer) {
+    if(data) { CloseHandle((HANDLE)data); }
+}
+#endif
+
+static void
+fhos__sleep_nanoseconds(fhos_u64 nanoseconds) {
+#if defined(_WIN32) || defined(_WIN64)
+    // NOTE(Patrik): High resolution waitable timers are not bound to the 1 ms scheduler tick. Older Windows
+    // versions do not have them, those use Sleep and spin off the rest.
+#  if !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+#    define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#  endif
+    if(!fhos__sleep_timer) {
+        fhos__sleep_timer = CreateWaitableTimerExW(0, 0, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if(!fhos__sleep_timer) {
+            fhos__sleep_timer = INVALID_HANDLE_VALUE;
+        } else if(!fhos__set_thread_exit_data(&fhos__sleep_timer_exit_hook, fhos__close_sleep_timer, fhos__sleep_timer)) {
+            // NOTE(Patrik): The timer would leak when the thread exits, so this thread goes without it.
+            CloseHandle(fhos__sleep_timer);
+            fhos__sleep_timer = INVALID_HANDLE_VALUE;
+        }
+    }
+    
+    if(fhos__sleep_timer != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER due_time;
+        due_time.QuadPart = -(LONGLONG)(nanoseconds / 100);
+        if(SetWaitableTimer(fhos__sleep_timer, &due_time, 0, 0, 0, FALSE)) {
+            WaitForSingleObject(fhos__sleep_timer, INFINITE);
+            return;
+        }
+    }
+    Sleep((DWORD)(nanoseconds / 1000000));
+#elif defined(__linux__)
+    struct timespec duration;
+    duration.tv_sec = (time_t)(nanoseconds / 1000000000ull);
+    duration.tv_nsec = (long)(nanoseconds % 1000000000ull);
+    nanosleep(&duration, 0);
+#else
+#  error Unimplemented on this platform.
+#endif
+}
+
+FHOS_API void
+fhos_sleep_until(fhos_u64 deadline_ticks) {
+    if(!fhos__has_tuned_sleep) {
+#if defined(__linux__)
+        // NOTE(Patrik): The timer slack is how much later than asked the kernel may wake the thread so it
+        // can batch timers, 50 us by default. It only applies to the calling thread.
+        prctl(PR_SET_TIMERSLACK, (unsigned long)FHOS_SLEEP_TIMER_SLACK_NANOSECONDS, 0, 0, 0);
+#endif
+        fhos__sleep_overshoot_nanoseconds = FHOS_SLEEP_SPIN_NANOSECONDS;
+        fhos__has_tuned_sleep = FHOS_TRUE;
+    }
+    
+    for(;;) {
+        fhos_u64 now = fhos_get_ticks();
+        if(now >= deadline_ticks) { return; }
+        
+        fhos_u64 remaining = fhos_ticks_to_nanoseconds(deadline_ticks - now);
+        fhos_u64 margin = fhos__sleep_overshoot_nanoseconds + FHOS_SLEEP_SPIN_NANOSECONDS;
+        if(remaining <= margin) { break; }
+        
+        fhos_u64 request = remaining - margin;
+        fhos__sleep_nanoseconds(request);
+        
+        fhos_u64 slept = fhos_ticks_to_nanoseconds(fhos_get_ticks() - now);
+        fhos_u64 overshoot = (slept > request) ? slept - request : 0;
+        if(overshoot > FHOS__MAX_SLEEP_OVERSHOOT_NANOSECONDS) { overshoot = FHOS__MAX_SLEEP_OVERSHOOT_NANOSECONDS; }
+        if(overshoot > fhos__sleep_overshoot_nanoseconds) {
+            fhos__sleep_overshoot_nanoseconds = overshoot;
+        } else {
+            fhos__sleep_overshoot_nanoseconds -= (fhos__sleep_overshoot_nanoseconds - overshoot) / 8;
+        }
+    }
+    
+    while(fhos_get_ticks() < deadline_ticks) { FHOS__CPU_PAUSE(); }
+}
+
+FHOS_API void
+fhos_init_frame_pacer(FHOS_Frame_Pacer *pacer, fhos_u64 frame_nanoseconds) {
+    if(!pacer) {
+        FHOS_LOG_ERROR("fhos_init_frame_pacer -> The parameter pacer is null.\n");
+        return;
+    }
+    
+    FHOS_Frame_Pacer zero_pacer = {0};
+    *pacer = zero_pacer;
+    pacer->frame_ticks = fhos_nanoseconds_to_ticks(frame_nanoseconds);
+    pacer->next_deadline = fhos_get_ticks() + pacer->frame_ticks;
+}
+
+// NOTE(Patrik): Deadlines stay on a fixed grid so small errors do not add up over frames. A frame that ends
+// after its deadline counts as missed, and when it is a whole frame or more behind the grid starts
+// over from now instead of rushing through frames to catch up.
+FHOS_API fhos_u64
+fhos_wait_for_next_frame(FHOS_Frame_Pacer *pacer) {
+    if(!pacer) {
+        FHOS_LOG_ERROR("fhos_wait_for_next_frame -> The parameter pacer is null.\n");
+        return 0;
+    }
+    
+    fhos_u64 deadline = pacer->next_deadline;
+    fhos_u64 now = fhos_get_ticks();
+    pacer->frame_count += 1;
+    
+    if(now > deadline) {
+        pacer->missed_count += 1;
+        pacer->next_deadline = (now - deadline >= pacer->frame_ticks) ? now + pacer->frame_ticks : deadline + pacer->frame_ticks;
+        return now;
+    }
+    
+    fhos_sleep_until(deadline);
+    now = fhos_get_ticks();
+    
+    fhos_u64 overshoot = fhos_ticks_to_nanoseconds(now - deadline);
+    pacer->last_overshoot_nanoseconds = overshoot;
+    pacer->total_overshoot_nanoseconds += overshoot;
+    if(overshoot > pacer->max_overshoot_nanoseconds) { pacer->max_overshoot_nanoseconds = overshoot; }
+    
+    pacer->next_deadline = deadline + pacer->frame_ticks;
+    return now;
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// PROFILE
+//
+#define FHOS__PROFILE_MAX_DEPTH 64
+#define FHOS__PROFILE_MAGIC 0x52504846u // NOTE(Patrik): "FHPR"
+#define FHOS__PROFILE_VERSION 1
+
+typedef struct FHOS__Profile_Event {
+    const char *name;
+    fhos_u64 start;
+    fhos_u64 end;
+} FHOS__Profile_Event;
+
+// NOTE(Patrik): Only the owning thread writes events, fhos_write_profile reads them. Zones that are still
+// open live on the stack and become events when they end. When its thread exits the buffer is marked
+// free and the next new thread takes it over, keeping the thread id.
+typedef struct FHOS__Profile_Buffer {
+    struct FHOS__Profile_Buffer *next;
+    FHOS__Profile_Event *events;
+    fhos_u32 thread_id;
+    fhos_i32 depth;
+    FHOS_Atomic_I32 is_free;
+    fhos_u8 padding0[36];
+    
+    FHOS_Atomic_I64 write_position;
+    fhos_u8 padding1[56];
+    
+    FHOS_Atomic_I64 read_position;
+    FHOS_Atomic_I32 dropped_count;
+    fhos_u8 padding2[52];
+    
+    const char *stack_names[FHOS__PROFILE_MAX_DEPTH];
+    fhos_u64 stack_starts[FHOS__PROFILE_MAX_DEPTH];
+} FHOS__Profile_Buffer;
+
+static FHOS__THREAD_LOCAL FHOS__Profile_Buffer *fhos__thread_profile_buffer;
+static FHOS_Atomic_Pointer fhos__profile_buffers;
+static FHOS_Atomic_I32 fhos__profile_thread_count;
+static FHOS_Atomic_I32 fhos__profile_write_lock;
+static FHOS__Thread_Exit_Hook fhos__profile_exit_hook;
+
+static FHOS__THREAD_EXIT_PROC(fhos__release_thread_profile_buffer) {
+    FHOS__Profile_Buffer *buffer = (FHOS__Profile_Buffer *)data;
+    if(fhos__thread_profile_buffer == buffer) { fhos__thread_profile_buffer = 0; }
+    fhos_atomic_store_i32(&buffer->is_free, 1, FHOS_MEMORY_ORDER_RELEASE);
+}
+
+static FHOS__Profile_Buffer *
+fhos__get_thread_profile_buffer(void) {
+    FHOS__Profile_Buffer *buffer = fhos__thread_profile_buffer;
+    if(buffer) { return buffer; }
+    
+    // NOTE(Patrik): Buffers are never freed, fhos_write_profile could be reading one when its thread exits.
+    // They are handed to the next new thread instead, zones the old thread left open are forgotten.
+    for(buffer = (FHOS__Profile_Buffer *)fhos_atomic_load_pointer(&fhos__profile_buffers, FHOS_MEMORY_ORDER_ACQUIRE); buffer; buffer = buffer->next) {
+        fhos_i32 expected = 1;
+        if(fhos_atomic_load_i32(&buffer->is_free, FHOS_MEMORY_ORDER_RELAXED) && fhos_atomic_compare_exchange_i32(&buffer->is_free, &expected, 0, FHOS_MEMORY_ORDER_ACQUIRE)) {
+            buffer->depth = 0;
+            break;
+        }
     }
     
-    FHOS__ALLOC_FROM_TO_PATH(ctx, from_path_data, from_path_length, to_path_data, to_path_length);
-    if(!from_path) {
-        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
+    if(!buffer) {
+        buffer = (FHOS__Profile_Buffer *)fhos_allocate_memory(sizeof(FHOS__Profile_Buffer) + FHOS_PROFILE_EVENT_CAPACITY * sizeof(FHOS__Profile_Event));
+        if(!buffer) { return 0; }
+        buffer->events = (FHOS__Profile_Event *)(buffer + 1);
+        buffer->thread_id = (fhos_u32)fhos_atomic_fetch_add_i32(&fhos__profile_thread_count, 1, FHOS_MEMORY_ORDER_RELAXED) + 1;
+        
+        void *head = fhos_atomic_load_pointer(&fhos__profile_buffers, FHOS_MEMORY_ORDER_RELAXED);
+        do {
+            buffer->next = (FHOS__Profile_Buffer *)head;
+        } while(!fhos_atomic_compare_exchange_pointer(&fhos__profile_buffers, &head, buffer, FHOS_MEMORY_ORDER_RELEASE));
+    }
+    
+    fhos__thread_profile_buffer = buffer;
+    fhos__set_thread_exit_data(&fhos__profile_exit_hook, fhos__release_thread_profile_buffer, buffer);
+    return buffer;
+}
+
+FHOS_API void
+fhos_begin_profile_zone(const char *name) {
+    FHOS__Profile_Buffer *buffer = fhos__get_thread_profile_buffer();
+    if(!buffer) { return; }
+    
+    // NOTE(Patrik): Zones nested deeper than the stack are counted so their ends still match up, but not recorded.
+    fhos_i32 depth = buffer->depth;
+    buffer->depth = depth + 1;
+    if(depth < FHOS__PROFILE_MAX_DEPTH) {
+        buffer->stack_names[depth] = name;
+        buffer->stack_starts[depth] = fhos_get_ticks();
+    }
+}
+
+FHOS_API void
+fhos_end_profile_zone(void) {
+    fhos_u64 end = fhos_get_ticks();
+    FHOS__Profile_Buffer *buffer = fhos__thread_profile_buffer;
+    if(!buffer || buffer->depth <= 0) { return; }
+    
+    buffer->depth -= 1;
+    fhos_i32 depth = buffer->depth;
+    if(depth >= FHOS__PROFILE_MAX_DEPTH) { return; }
+    
+    fhos_i64 position = fhos_atomic_load_i64(&buffer->write_position, FHOS_MEMORY_ORDER_RELAXED);
+    if(position - fhos_atomic_load_i64(&buffer->read_position, FHOS_MEMORY_ORDER_ACQUIRE) >= FHOS_PROFILE_EVENT_CAPACITY) {
+        fhos_atomic_fetch_add_i32(&buffer->dropped_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+        return;
+    }
+    
+    FHOS__Profile_Event *event = buffer->events + (position & (FHOS_PROFILE_EVENT_CAPACITY - 1));
+    event->name = buffer->stack_names[depth];
+    event->start = buffer->stack_starts[depth];
+    event->end = end;
+    fhos_atomic_store_i64(&buffer->write_position, position + 1, FHOS_MEMORY_ORDER_RELEASE);
+}
+
+typedef struct FHOS__Profile_Writer {
+    FHOS_File_Handle handle;
+    fhos_u8 *buffer;
+    fhos_i64 length;
+    fhos_i64 capacity;
+    fhos_bool has_failed;
+} FHOS__Profile_Writer;
+
+static void
+fhos__flush_profile_writer(FHOS__Profile_Writer *writer) {
+    if(writer->length > 0 && !writer->has_failed) {
+        writer->has_failed = (fhos_write_file(writer->handle, writer->buffer, writer->length) != writer->length);
+    }
+    writer->length = 0;
+}
+
+static void
+fhos__write_profile_bytes(FHOS__Profile_Writer *writer, const void *data, fhos_i64 size) {
+    const fhos_u8 *bytes = (const fhos_u8 *)data;
+    for(fhos_i64 i = 0; i < size; i += 1) {
+        if(writer->length == writer->capacity) { fhos__flush_profile_writer(writer); }
+        writer->buffer[writer->length] = bytes[i];
+        writer->length += 1;
+    }
+}
+
+static void
+fhos__write_profile_string(FHOS__Profile_Writer *writer, const char *string) {
+    fhos_i32 length = 0;
+    FHOS__GET_NTSTRING_LENGTH(string, length);
+    fhos__write_profile_bytes(writer, string, length);
+}
+
+static void
+fhos__write_profile_u64(FHOS__Profile_Writer *writer, fhos_u64 value) {
+    char digits[20];
+    fhos_i32 count = 0;
+    do {
+        digits[19 - count] = (char)('0' + (value % 10));
+        value /= 10;
+        count += 1;
+    } while(value > 0);
+    fhos__write_profile_bytes(writer, digits + 20 - count, count);
+}
+
+// NOTE(Patrik): Chrome wants microseconds, nanoseconds are kept as three decimals.
+static void
+fhos__write_profile_microseconds(FHOS__Profile_Writer *writer, fhos_u64 nanoseconds) {
+    fhos__write_profile_u64(writer, nanoseconds / 1000);
+    char decimals[4] = { '.', (char)('0' + (nanoseconds / 100) % 10), (char)('0' + (nanoseconds / 10) % 10), (char)('0' + nanoseconds % 10) };
+    fhos__write_profile_bytes(writer, decimals, 4);
+}
+
+static void
+fhos__write_profile_json_string(FHOS__Profile_Writer *writer, const char *string) {
+    fhos__write_profile_bytes(writer, "\"", 1);
+    for(const char *at = (string) ? string : "(null)"; *at; at += 1) {
+        fhos_u8 character = (fhos_u8)*at;
+        if(character == '"' || character == '\\') {
+            fhos__write_profile_bytes(writer, "\\", 1);
+            fhos__write_profile_bytes(writer, at, 1);
+        } else if(character < 0x20) {
+            char escaped[6] = { '\\', 'u', '0', '0', "0123456789abcdef"[character >> 4], "0123456789abcdef"[character & 15] };
+            fhos__write_profile_bytes(writer, escaped, 6);
+        } else {
+            fhos__write_profile_bytes(writer, at, 1);
+        }
+    }
+    fhos__write_profile_bytes(writer, "\"", 1);
+}
+
+// NOTE(Patrik): Names are string pointers, the same name is only written once in the binary format.
+static fhos_u32
+fhos__get_profile_name_index(const char **table, fhos_u32 *indices, const char **ordered, fhos_i64 table_mask, const char *name, fhos_u32 *name_count) {
+    fhos_u64 hash = (fhos_u64)(fhos_isize)name * 0x9E3779B97F4A7C15ull;
+    fhos_i64 slot = (fhos_i64)(hash >> 32) & table_mask;
+    while(table[slot] && table[slot] != name) { slot = (slot + 1) & table_mask; }
+    if(!table[slot]) {
+        table[slot] = name;
+        indices[slot] = *name_count;
+        ordered[*name_count] = name;
+        *name_count += 1;
+    }
+    return indices[slot];
+}
+
+FHOS_API fhos_error
+fhos_write_profile(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length, FHOS_Profile_Format format) {
+    // NOTE(Patrik): Only one writer at a time, each buffer has a single reader.
+    fhos_i32 expected = 0;
+    while(!fhos_atomic_compare_exchange_i32(&fhos__profile_write_lock, &expected, 1, FHOS_MEMORY_ORDER_ACQUIRE)) {
+        expected = 0;
+        fhos__thread_yield();
+    }
+    
+    FHOS__Profile_Writer writer = {0};
+    writer.capacity = 64 * 1024;
+    writer.buffer = (fhos_u8 *)fhos_context_temp_alloc_non_zero(ctx, writer.capacity);
+    writer.handle = fhos_get_invalid_file_handle();
+    if(writer.buffer) { writer.handle = fhos_open_file_for_writing(ctx, path_data, path_length); }
+    if(!writer.buffer || !fhos_is_file_handle_valid(writer.handle)) {
+        if(!writer.buffer) { FHOS_LOG_ERROR("Could not allocate memory for writing the profile.\n"); }
+        if(writer.buffer) { fhos_context_temp_free(ctx, writer.buffer); }
+        fhos_atomic_store_i32(&fhos__profile_write_lock, 0, FHOS_MEMORY_ORDER_RELEASE);
+        return (writer.buffer) ? FHOS_ERROR_INVALID_FILE_HANDLE : FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    // NOTE(Patrik): Everything up to these positions gets written, events added meanwhile wait for the next call.
+    fhos_i64 event_count = 0;
+    fhos_u64 dropped_count = 0;
+    fhos_u64 base_ticks = ~(fhos_u64)0;
+    FHOS__Profile_Buffer *buffers = (FHOS__Profile_Buffer *)fhos_atomic_load_pointer(&fhos__profile_buffers, FHOS_MEMORY_ORDER_ACQUIRE);
+    fhos_i32 buffer_count = 0;
+    for(FHOS__Profile_Buffer *buffer = buffers; buffer; buffer = buffer->next) { buffer_count += 1; }
+    
+    fhos_i64 *end_positions = (fhos_i64 *)fhos_context_temp_alloc_non_zero(ctx, (buffer_count + 1) * sizeof(fhos_i64));
+    if(!end_positions) {
+        FHOS_LOG_ERROR("Could not allocate memory for writing the profile.\n");
+        fhos_close_file(writer.handle);
+        fhos_context_temp_free(ctx, writer.buffer);
+        fhos_atomic_store_i32(&fhos__profile_write_lock, 0, FHOS_MEMORY_ORDER_RELEASE);
         return FHOS_ERROR_OUT_OF_MEMORY;
     }
     
-    fhos_error result = FHOS_FALSE;
+    fhos_i32 buffer_index = 0;
+    for(FHOS__Profile_Buffer *buffer = buffers; buffer && buffer_index < buffer_count; buffer = buffer->next) {
+        end_positions[buffer_index] = fhos_atomic_load_i64(&buffer->write_position, FHOS_MEMORY_ORDER_ACQUIRE);
+        for(fhos_i64 i = fhos_atomic_load_i64(&buffer->read_position, FHOS_MEMORY_ORDER_RELAXED); i < end_positions[buffer_index]; i += 1) {
+            fhos_u64 start = buffer->events[i & (FHOS_PROFILE_EVENT_CAPACITY - 1)].start;
+            if(start < base_ticks) { base_ticks = start; }
+        }
+        event_count += end_positions[buffer_index] - fhos_atomic_load_i64(&buffer->read_position, FHOS_MEMORY_ORDER_RELAXED);
+        
+        fhos_u32 dropped = (fhos_u32)fhos_atomic_exchange_i32(&buffer->dropped_count, 0, FHOS_MEMORY_ORDER_RELAXED);
+        dropped_count += dropped;
+        buffer_index += 1;
+    }
+    if(event_count == 0) { base_ticks = 0; }
     
-#if defined(_WIN32) || defined(_WIN64)
-    DWORD move_flags = (MOVEFILE_COPY_ALLOWED | MOVEFILE_REPLACE_EXISTING);
-    if(MoveFileExA(from_path, to_path, move_flags)) {
-        result = FHOS_TRUE;
+    if(format == FHOS_PROFILE_FORMAT_CHROME_JSON) {
+        fhos__write_profile_string(&writer, "{\"traceEvents\":[\n");
+        fhos_bool is_first = FHOS_TRUE;
+        buffer_index = 0;
+        for(FHOS__Profile_Buffer *buffer = buffers; buffer && buffer_index < buffer_count; buffer = buffer->next) {
+            for(fhos_i64 i = fhos_atomic_load_i64(&buffer->read_position, FHOS_MEMORY_ORDER_RELAXED); i < end_positions[buffer_index]; i += 1) {
+                const FHOS__Profile_Event *event = buffer->events + (i & (FHOS_PROFILE_EVENT_CAPACITY - 1));
+                fhos__write_profile_string(&writer, (is_first) ? "{\"name\":" : ",\n{\"name\":");
+                fhos__write_profile_json_string(&writer, event->name);
+                fhos__write_profile_string(&writer, ",\"ph\":\"X\",\"pid\":1,\"tid\":");
+                fhos__write_profile_u64(&writer, buffer->thread_id);
+                fhos__write_profile_string(&writer, ",\"ts\":");
+                fhos__write_profile_microseconds(&writer, fhos_ticks_to_nanoseconds(event->start - base_ticks));
+                fhos__write_profile_string(&writer, ",\"dur\":");
+                fhos__write_profile_microseconds(&writer, fhos_ticks_to_nanoseconds(event->end - event->start));
+                fhos__write_profile_string(&writer, "}");
+                is_first = FHOS_FALSE;
+            }
+            buffer_index += 1;
+        }
+        fhos__write_profile_string(&writer, "\n],\"otherData\":{\"dropped_events\":");
+        fhos__write_profile_u64(&writer, dropped_count);
+        fhos__write_profile_string(&writer, "}}\n");
     } else {
-        DWORD last_error = GetLastError();
-        FHOS_LOG_ERROR("(%lu) Could not move \"%s\" to \"%s\".\n", last_error, from_path, to_path);
-        result = -1;
+        // NOTE(Patrik): A header, then one record per event and last the names they point into, each one null terminated.
+        fhos_i64 table_capacity = 16;
+        while(table_capacity < 2 * event_count) { table_capacity *= 2; }
+        const char **names = (const char **)fhos_context_temp_alloc(ctx, table_capacity * (2 * sizeof(const char *) + sizeof(fhos_u32)));
+        if(!names) {
+            FHOS_LOG_ERROR("Could not allocate memory for writing the profile.\n");
+            writer.has_failed = FHOS_TRUE;
+        } else {
+            const char **ordered = names + table_capacity;
+            fhos_u32 *indices = (fhos_u32 *)(ordered + table_capacity);
+            fhos_u32 name_count = 0;
+            FHOS_Profile_Binary_Header header = {0};
+            header.magic = FHOS__PROFILE_MAGIC;
+            header.version = FHOS__PROFILE_VERSION;
+            header.tick_frequency = fhos_get_tick_frequency();
+            header.base_ticks = base_ticks;
+            header.event_count = (fhos_u64)event_count;
+            header.dropped_count = dropped_count;
+            fhos__write_profile_bytes(&writer, &header, sizeof(header));
+            
+            buffer_index = 0;
+            for(FHOS__Profile_Buffer *buffer = buffers; buffer && buffer_index < buffer_count; buffer = buffer->next) {
+                for(fhos_i64 i = fhos_atomic_load_i64(&buffer->read_position, FHOS_MEMORY_ORDER_RELAXED); i < end_positions[buffer_index]; i += 1) {
+                    const FHOS__Profile_Event *event = buffer->events + (i & (FHOS_PROFILE_EVENT_CAPACITY - 1));
+                    FHOS_Profile_Binary_Event record;
+                    record.name_index = fhos__get_profile_name_index(names, indices, ordered, table_capacity - 1, (event->name) ? event->name : "(null)", &name_count);
+                    record.thread_id = buffer->thread_id;
+                    record.start = event->start - base_ticks;
+                    record.duration = event->end - event->start;
+                    fhos__write_profile_bytes(&writer, &record, sizeof(record));
+                }
+                buffer_index += 1;
+            }
+            
+            fhos__write_profile_bytes(&writer, &name_count, sizeof(name_count));
+            for(fhos_u32 index = 0; index < name_count; index += 1) {
+                fhos__write_profile_string(&writer, ordered[index]);
+                fhos__write_profile_bytes(&writer, "", 1);
+            }
+            fhos_context_temp_free(ctx, names);
+        }
     }
-#else
-#  error Unimplemented on this platform.
-#endif
     
-    FHOS__FREE_FROM_TO_PATH(ctx, from_path_data, from_path_length, to_path_data, to_path_length);
-    return result;
+    fhos__flush_profile_writer(&writer);
+    fhos_close_file(writer.handle);
+    
+    // NOTE(Patrik): The events are handed back to their threads only once they are written out.
+    buffer_index = 0;
+    for(FHOS__Profile_Buffer *buffer = buffers; buffer && buffer_index < buffer_count; buffer = buffer->next) {
+        fhos_atomic_store_i64(&buffer->read_position, end_positions[buffer_index], FHOS_MEMORY_ORDER_RELEASE);
+        buffer_index += 1;
+    }
+    
+    fhos_context_temp_free(ctx, end_positions);
+    fhos_context_temp_free(ctx, writer.buffer);
+    fhos_atomic_store_i32(&fhos__profile_write_lock, 0, FHOS_MEMORY_ORDER_RELEASE);
+    if(writer.has_failed) { return FHOS_ERROR_GENERIC_ERROR; }
+    return FHOS_TRUE;
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// PERF COUNTERS
+//
+#if defined(__linux__)
+static fhos_i32
+fhos__open_perf_event(fhos_i32 counter, fhos_i32 group_descriptor) {
+    static const fhos_u64 configs[FHOS_PERF_COUNTER_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+    
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = configs[counter];
+    attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    // NOTE(Patrik): Only the leader starts disabled, the rest follow it when the group is enabled.
+    attributes.disabled = (group_descriptor < 0) ? 1 : 0;
+    
+    return (fhos_i32)syscall(__NR_perf_event_open, &attributes, 0, -1, group_descriptor, PERF_FLAG_FD_CLOEXEC);
 }
+#endif
 
 FHOS_API fhos_error
-fhos_copy_file(FHOS_Context *ctx, const char *from_path_data, fhos_i32 from_path_length,
-               const char *to_path_data, fhos_i32 to_path_length)
-{
-    if(!from_path_data) {
-        FHOS_LOG_ERROR("fhos_move_file -> The parameter from_path_data is null.\n");
-        return -1;
-    } else if(from_path_length == 0) {
-        FHOS_LOG_ERROR("fhos_move_file -> The parameter from_path_length is zero.\n");
-        return -1;
+fhos_open_perf_counters(FHOS_Perf_Counters *counters) {
+    if(!counters) {
+        FHOS_LOG_ERROR("fhos_open_perf_counters -> The parameter counters is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
     }
     
-    if(!to_path_data) {
-        FHOS_LOG_ERROR("fhos_move_file -> The parameter to_path_data is null.\n");
-        return -1;
-    } else if(to_path_length == 0) {
-        FHOS_LOG_ERROR("fhos_move_file -> The parameter to_path_length is zero.\n");
-        return -1;
+    FHOS_Perf_Counters zero_counters = {0};
+    *counters = zero_counters;
+    counters->leader = -1;
+    for(fhos_i32 i = 0; i < FHOS_PERF_COUNTER_COUNT; i += 1) { counters->descriptors[i] = -1; }
+    
+#if defined(__linux__)
+    // NOTE(Patrik): Virtual machines, containers and perf_event_paranoid can all take some or every counter
+    // away. The counters that open are read as one group so they cover the same instructions.
+    for(fhos_i32 i = 0; i < FHOS_PERF_COUNTER_COUNT; i += 1) {
+        counters->descriptors[i] = fhos__open_perf_event(i, counters->leader);
+        if(counters->descriptors[i] < 0) { continue; }
+        
+        if(counters->leader < 0) { counters->leader = counters->descriptors[i]; }
+        counters->available_mask |= (1u << i);
     }
+#endif
     
-    FHOS__ALLOC_FROM_TO_PATH(ctx, from_path_data, from_path_length, to_path_data, to_path_length);
-    if(!from_path) {
-        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
-        return -1;
+    return FHOS_TRUE;
+}
+
+FHOS_API void
+fhos_close_perf_counters(FHOS_Perf_Counters *counters) {
+    if(!counters) { return; }
+    
+#if defined(__linux__)
+    // NOTE(Patrik): The leader goes last, closing it first would break up the group.
+    for(fhos_i32 i = FHOS_PERF_COUNTER_COUNT - 1; i >= 0; i -= 1) {
+        if(counters->descriptors[i] >= 0 && counters->descriptors[i] != counters->leader) { close(counters->descriptors[i]); }
     }
+    if(counters->leader >= 0) { close(counters->leader); }
+#endif
     
-    fhos_error result = FHOS_FALSE;
+    FHOS_Perf_Counters zero_counters = {0};
+    *counters = zero_counters;
+    counters->leader = -1;
+    for(fhos_i32 i = 0; i < FHOS_PERF_COUNTER_COUNT; i += 1) { counters->descriptors[i] = -1; }
+}
+
+FHOS_API void
+fhos_start_perf_counters(FHOS_Perf_Counters *counters) {
+    if(!counters) { return; }
     
-#if defined(_WIN32) || defined(_WIN64)
-    if(CopyFileA(from_path, to_path, 0)) {
-        result = FHOS_TRUE;
-    } else {
-        DWORD last_error = GetLastError();
-        FHOS_LOG_ERROR("(%lu) Could not move \"%s\" to \"%s\".\n", last_error, from_path, to_path);
-        result = -1;
+#if defined(__linux__)
+    if(counters->leader >= 0) {
+        ioctl(counters->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(counters->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+    
+    counters->is_running = FHOS_TRUE;
+    counters->start_ticks = fhos_get_ticks();
+}
+
+FHOS_API void
+fhos_stop_perf_counters(FHOS_Perf_Counters *counters) {
+    if(!counters || !counters->is_running) { return; }
+    
+    counters->stop_ticks = fhos_get_ticks();
+#if defined(__linux__)
+    if(counters->leader >= 0) { ioctl(counters->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP); }
+#endif
+    counters->is_running = FHOS_FALSE;
+}
+
+// NOTE(Patrik): Can be called while the counters run. When the kernel had to share the hardware between more
+// counters than it has, the values are scaled up from the time the group was actually counting.
+FHOS_API fhos_bool
+fhos_read_perf_counters(FHOS_Perf_Counters *counters, FHOS_Perf_Sample *sample) {
+    if(!counters || !sample) {
+        FHOS_LOG_ERROR("fhos_read_perf_counters -> The parameter %s is null.\n", (!counters) ? "counters" : "sample");
+        return FHOS_FALSE;
+    }
+    
+    FHOS_Perf_Sample zero_sample = {0};
+    *sample = zero_sample;
+    fhos_u64 end_ticks = (counters->is_running) ? fhos_get_ticks() : counters->stop_ticks;
+    sample->nanoseconds = fhos_ticks_to_nanoseconds(end_ticks - counters->start_ticks);
+    
+#if defined(__linux__)
+    if(counters->leader >= 0) {
+        fhos_u64 values[3 + FHOS_PERF_COUNTER_COUNT];
+        ssize_t read_size = read(counters->leader, values, sizeof(values));
+        if(read_size < (ssize_t)(3 * sizeof(fhos_u64))) {
+            FHOS_LOG_ERROR("(%d) Could not read the performance counters.\n", errno);
+            return FHOS_FALSE;
+        }
+        
+        // NOTE(Patrik): The group is read as the count, the time enabled, the time running and then the
+        // values in the order the counters were opened.
+        fhos_u64 time_enabled = values[1];
+        fhos_u64 time_running = values[2];
+        if(time_running > 0) {
+            fhos_u64 index = 0;
+            for(fhos_i32 i = 0; i < FHOS_PERF_COUNTER_COUNT && index < values[0]; i += 1) {
+                if(!(counters->available_mask & (1u << i))) { continue; }
+                
+                fhos_u64 value = values[3 + index];
+                if(time_running < time_enabled) { value = (fhos_u64)((double)value * (double)time_enabled / (double)time_running); }
+                sample->values[i] = value;
+                sample->valid_mask |= (1u << i);
+                index += 1;
+            }
+        }
     }
+#endif
+    
+    return FHOS_TRUE;
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// HISTOGRAM
+//
+// NOTE(Patrik): Values below 2^FHOS__HISTOGRAM_SUB_BUCKET_BITS get a bucket each. Above that every power of
+// two is split into as many equal buckets, so a value is off by at most 1/64th of itself.
+#define FHOS__HISTOGRAM_SUB_BUCKET_BITS 6
+#define FHOS__HISTOGRAM_SUB_BUCKET_COUNT (1 << FHOS__HISTOGRAM_SUB_BUCKET_BITS)
+#define FHOS__HISTOGRAM_BUCKET_COUNT (FHOS__HISTOGRAM_SUB_BUCKET_COUNT * (65 - FHOS__HISTOGRAM_SUB_BUCKET_BITS))
+
+typedef struct FHOS__Histogram_Shard {
+    FHOS_Atomic_I64 buckets[FHOS__HISTOGRAM_BUCKET_COUNT];
+    FHOS_Atomic_I64 total;
+    FHOS_Atomic_I64 min;
+    FHOS_Atomic_I64 max;
+    fhos_u8 padding[40];
+} FHOS__Histogram_Shard;
+
+static FHOS__THREAD_LOCAL fhos_u32 fhos__histogram_shard_index;
+static FHOS_Atomic_I32 fhos__histogram_thread_count;
+
+static fhos_i32
+fhos__get_histogram_bucket(fhos_u64 value) {
+    if(value < FHOS__HISTOGRAM_SUB_BUCKET_COUNT) { return (fhos_i32)value; }
+    
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long top_bit = 0;
+    _BitScanReverse64(&top_bit, value);
 #else
-#  error Unimplemented on this platform.
+    fhos_i32 top_bit = 63 - __builtin_clzll(value);
 #endif
+    fhos_i32 shift = (fhos_i32)top_bit - FHOS__HISTOGRAM_SUB_BUCKET_BITS;
+    return (shift + 1) * FHOS__HISTOGRAM_SUB_BUCKET_COUNT + (fhos_i32)(value >> shift) - FHOS__HISTOGRAM_SUB_BUCKET_COUNT;
+}
+
+// NOTE(Patrik): The largest value that lands in the bucket, so percentiles never come out below the truth.
+static fhos_u64
+fhos__get_histogram_bucket_value(fhos_i32 bucket) {
+    if(bucket < FHOS__HISTOGRAM_SUB_BUCKET_COUNT) { return (fhos_u64)bucket; }
     
-    FHOS__FREE_FROM_TO_PATH(ctx, from_path_data, from_path_length, to_path_data, to_path_length);
-    return result;
+    fhos_i32 shift = bucket / FHOS__HISTOGRAM_SUB_BUCKET_COUNT - 1;
+    fhos_u64 sub_bucket = (fhos_u64)(bucket % FHOS__HISTOGRAM_SUB_BUCKET_COUNT) + FHOS__HISTOGRAM_SUB_BUCKET_COUNT;
+    fhos_u64 width = (fhos_u64)1 << shift;
+    return (sub_bucket << shift) + (width - 1);
 }
 
 FHOS_API fhos_error
-fhos_is_file_newer(FHOS_Context *ctx, const char *this_path_data, fhos_i32 this_path_length,
-                   const char *other_path_data, fhos_i32 other_path_length)
-{
-    if(!this_path_data) {
-        FHOS_LOG_ERROR("fhos_is_file_newer -> The parameter this_path_data is null.\n");
-        return -1;
-    } else if(this_path_length == 0) {
-        FHOS_LOG_ERROR("fhos_is_file_newer -> The parameter this_path_length is zero.\n");
-        return -1;
+fhos_init_histogram(FHOS_Context *ctx, FHOS_Histogram *histogram) {
+    if(!histogram) {
+        FHOS_LOG_ERROR("fhos_init_histogram -> The parameter histogram is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
     }
     
-    if(!other_path_data) {
-        FHOS_LOG_ERROR("fhos_is_file_newer -> The parameter other_path_data is null.\n");
-        return -1;
-    } else if(other_path_length == 0) {
-        FHOS_LOG_ERROR("fhos_is_file_newer -> The parameter other_path_length is zero.\n");
-        return -1;
-    }
+    FHOS_Histogram zero_histogram = {0};
+    *histogram = zero_histogram;
     
-    FHOS__ALLOC_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
-    if(!this_path_data) {
-        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
-        return -1;
+    histogram->shards = fhos_context_alloc(ctx, FHOS_HISTOGRAM_SHARD_COUNT * sizeof(FHOS__Histogram_Shard));
+    if(!histogram->shards) {
+        FHOS_LOG_ERROR("Could not allocate memory for the histogram.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
     }
     
-    HANDLE other_handle = CreateFileA(to_path, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_READONLY, 0);
-    if(other_handle == INVALID_HANDLE_VALUE) {
-        FHOS__FREE_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
-        
-        DWORD last_error = GetLastError();
-        if(last_error != ERROR_FILE_NOT_FOUND) {
-            FHOS_LOG_ERROR("Could not open other_path..\n");
-            return -1;
+    fhos_reset_histogram(histogram);
+    return FHOS_TRUE;
+}
+
+FHOS_API void
+fhos_free_histogram(FHOS_Context *ctx, FHOS_Histogram *histogram) {
+    if(!histogram) { return; }
+    if(histogram->shards) { fhos_context_free(ctx, histogram->shards); }
+    
+    FHOS_Histogram zero_histogram = {0};
+    *histogram = zero_histogram;
+}
+
+// NOTE(Patrik): Not safe while other threads record, their values may or may not survive it.
+FHOS_API void
+fhos_reset_histogram(FHOS_Histogram *histogram) {
+    if(!histogram || !histogram->shards) { return; }
+    
+    FHOS__Histogram_Shard *shards = (FHOS__Histogram_Shard *)histogram->shards;
+    for(fhos_i32 i = 0; i < FHOS_HISTOGRAM_SHARD_COUNT; i += 1) {
+        FHOS__Histogram_Shard *shard = shards + i;
+        for(fhos_i32 bucket = 0; bucket < FHOS__HISTOGRAM_BUCKET_COUNT; bucket += 1) {
+            fhos_atomic_store_i64(&shard->buckets[bucket], 0, FHOS_MEMORY_ORDER_RELAXED);
         }
-        return FHOS_TRUE;
+        fhos_atomic_store_i64(&shard->total, 0, FHOS_MEMORY_ORDER_RELAXED);
+        fhos_atomic_store_i64(&shard->min, (fhos_i64)~(fhos_u64)0, FHOS_MEMORY_ORDER_RELAXED);
+        fhos_atomic_store_i64(&shard->max, 0, FHOS_MEMORY_ORDER_RELAXED);
+    }
+}
+
+// NOTE(Patrik): Every thread sticks to one shard, so unless there are more threads than shards nothing is
+// contended. The adds are still atomic because shards can be shared.
+FHOS_API void
+fhos_record_histogram(FHOS_Histogram *histogram, fhos_u64 value) {
+    fhos_u32 shard_index = fhos__histogram_shard_index;
+    if(!shard_index) {
+        shard_index = (fhos_u32)fhos_atomic_fetch_add_i32(&fhos__histogram_thread_count, 1, FHOS_MEMORY_ORDER_RELAXED) + 1;
+        fhos__histogram_shard_index = shard_index;
     }
     
-    HANDLE this_handle = CreateFileA(from_path, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_READONLY, 0);
-    if(this_handle == INVALID_HANDLE_VALUE) {
-        DWORD last_error = GetLastError();
-        FHOS__FREE_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
+    FHOS__Histogram_Shard *shard = (FHOS__Histogram_Shard *)histogram->shards + ((shard_index - 1) % FHOS_HISTOGRAM_SHARD_COUNT);
+    fhos_atomic_fetch_add_i64(&shard->buckets[fhos__get_histogram_bucket(value)], 1, FHOS_MEMORY_ORDER_RELAXED);
+    fhos_atomic_fetch_add_i64(&shard->total, (fhos_i64)value, FHOS_MEMORY_ORDER_RELAXED);
+    
+    // NOTE(Patrik): A failed exchange leaves the current value in max and min, the loops go again only while
+    // this value still beats it.
+    fhos_i64 max = fhos_atomic_load_i64(&shard->max, FHOS_MEMORY_ORDER_RELAXED);
+    while(value > (fhos_u64)max && !fhos_atomic_compare_exchange_i64(&shard->max, &max, (fhos_i64)value, FHOS_MEMORY_ORDER_RELAXED)) {}
+    fhos_i64 min = fhos_atomic_load_i64(&shard->min, FHOS_MEMORY_ORDER_RELAXED);
+    while(value < (fhos_u64)min && !fhos_atomic_compare_exchange_i64(&shard->min, &min, (fhos_i64)value, FHOS_MEMORY_ORDER_RELAXED)) {}
+}
+
+// NOTE(Patrik): Adds the shards together into buckets, which must have room for every bucket.
+static void
+fhos__merge_histogram(FHOS_Histogram *histogram, fhos_u64 *buckets, FHOS_Histogram_Stats *stats) {
+    FHOS_Histogram_Stats zero_stats = {0};
+    *stats = zero_stats;
+    stats->min = ~(fhos_u64)0;
+    
+    fhos_u64 total = 0;
+    FHOS__Histogram_Shard *shards = (FHOS__Histogram_Shard *)histogram->shards;
+    for(fhos_i32 bucket = 0; bucket < FHOS__HISTOGRAM_BUCKET_COUNT; bucket += 1) { buckets[bucket] = 0; }
+    for(fhos_i32 i = 0; i < FHOS_HISTOGRAM_SHARD_COUNT; i += 1) {
+        FHOS__Histogram_Shard *shard = shards + i;
+        for(fhos_i32 bucket = 0; bucket < FHOS__HISTOGRAM_BUCKET_COUNT; bucket += 1) {
+            fhos_u64 count = (fhos_u64)fhos_atomic_load_i64(&shard->buckets[bucket], FHOS_MEMORY_ORDER_RELAXED);
+            buckets[bucket] += count;
+            stats->count += count;
+        }
+        total += (fhos_u64)fhos_atomic_load_i64(&shard->total, FHOS_MEMORY_ORDER_RELAXED);
         
-        if(last_error != ERROR_FILE_NOT_FOUND) {
-            FHOS_LOG_ERROR("Could not open this_path..\n");
-            return -1;
+        fhos_u64 min = (fhos_u64)fhos_atomic_load_i64(&shard->min, FHOS_MEMORY_ORDER_RELAXED);
+        fhos_u64 max = (fhos_u64)fhos_atomic_load_i64(&shard->max, FHOS_MEMORY_ORDER_RELAXED);
+        if(min < stats->min) { stats->min = min; }
+        if(max > stats->max) { stats->max = max; }
+    }
+    
+    if(stats->count == 0) {
+        stats->min = 0;
+        return;
+    }
+    stats->mean = (double)total / (double)stats->count;
+    
+    // NOTE(Patrik): A percentile is the first bucket where the running count reaches that share of the total.
+    fhos_u64 targets[4];
+    fhos_u64 *results[4] = { &stats->p50, &stats->p90, &stats->p99, &stats->p999 };
+    targets[0] = (stats->count * 500 + 999) / 1000;
+    targets[1] = (stats->count * 900 + 999) / 1000;
+    targets[2] = (stats->count * 990 + 999) / 1000;
+    targets[3] = (stats->count * 999 + 999) / 1000;
+    
+    fhos_u64 running_count = 0;
+    fhos_i32 target_index = 0;
+    for(fhos_i32 bucket = 0; bucket < FHOS__HISTOGRAM_BUCKET_COUNT && target_index < 4; bucket += 1) {
+        running_count += buckets[bucket];
+        while(target_index < 4 && running_count >= targets[target_index] && running_count > 0) {
+            fhos_u64 value = fhos__get_histogram_bucket_value(bucket);
+            *results[target_index] = (value > stats->max) ? stats->max : value;
+            target_index += 1;
         }
-        return FHOS_TRUE;
+    }
+}
+
+FHOS_API fhos_bool
+fhos_get_histogram_stats(FHOS_Histogram *histogram, FHOS_Histogram_Stats *stats) {
+    if(!histogram || !histogram->shards || !stats) {
+        FHOS_LOG_ERROR("fhos_get_histogram_stats -> The parameter %s is null.\n", (!stats) ? "stats" : "histogram");
+        return FHOS_FALSE;
     }
     
-    FILETIME other_time = {0};
-    if(!GetFileTime(to_path, 0, 0, &other_time)) {
-        DWORD last_error = GetLastError();
-        FHOS__FREE_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
-        
-        FHOS_LOG_ERROR("Could not get filetime of other_path.\n");
-        CloseHandle(this_handle);
-        CloseHandle(other_handle);
-        return -1;
+    fhos_u64 *buckets = (fhos_u64 *)fhos_allocate_memory_non_zero(FHOS__HISTOGRAM_BUCKET_COUNT * sizeof(fhos_u64));
+    if(!buckets) {
+        FHOS_LOG_ERROR("Could not allocate memory for merging the histogram.\n");
+        return FHOS_FALSE;
+    }
+    
+    fhos__merge_histogram(histogram, buckets, stats);
+    fhos_free_memory(buckets);
+    return FHOS_TRUE;
+}
+
+// NOTE(Patrik): Writes the summary and then one line per non empty bucket with its value, the share of the
+// values at or below it and the running count, which plots as the usual latency curve.
+FHOS_API fhos_error
+fhos_write_histogram(FHOS_Context *ctx, FHOS_Histogram *histogram, const char *path_data, fhos_i32 path_length) {
+    if(!histogram || !histogram->shards) {
+        FHOS_LOG_ERROR("fhos_write_histogram -> The parameter histogram is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    
+    FHOS__Profile_Writer writer = {0};
+    writer.capacity = 64 * 1024;
+    writer.buffer = (fhos_u8 *)fhos_context_temp_alloc_non_zero(ctx, writer.capacity + FHOS__HISTOGRAM_BUCKET_COUNT * sizeof(fhos_u64));
+    if(!writer.buffer) {
+        FHOS_LOG_ERROR("Could not allocate memory for writing the histogram.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    
+    writer.handle = fhos_open_file_for_writing(ctx, path_data, path_length);
+    if(!fhos_is_file_handle_valid(writer.handle)) {
+        fhos_context_temp_free(ctx, writer.buffer);
+        return FHOS_ERROR_INVALID_FILE_HANDLE;
+    }
+    
+    fhos_u64 *buckets = (fhos_u64 *)(writer.buffer + writer.capacity);
+    FHOS_Histogram_Stats stats;
+    fhos__merge_histogram(histogram, buckets, &stats);
+    
+    const char *names[7] = { "# count ", "\n# min ", "\n# p50 ", "\n# p90 ", "\n# p99 ", "\n# p999 ", "\n# max " };
+    fhos_u64 values[7] = { stats.count, stats.min, stats.p50, stats.p90, stats.p99, stats.p999, stats.max };
+    for(fhos_i32 i = 0; i < 7; i += 1) {
+        fhos__write_profile_string(&writer, names[i]);
+        fhos__write_profile_u64(&writer, values[i]);
     }
+    fhos__write_profile_string(&writer, "\n# value percentile count\n");
     
-    FILETIME this_time = {0};
-    if(!GetFileTime(from_path, 0, 0, &this_time)) {
-        DWORD last_error = GetLastError();
-        FHOS__FREE_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
+    fhos_u64 running_count = 0;
+    for(fhos_i32 bucket = 0; bucket < FHOS__HISTOGRAM_BUCKET_COUNT; bucket += 1) {
+        if(buckets[bucket] == 0) { continue; }
+        running_count += buckets[bucket];
         
-        FHOS_LOG_ERROR("Could not get filetime of this_path.\n");
-        CloseHandle(this_handle);
-        CloseHandle(other_handle);
-        return -1;
+        // NOTE(Patrik): The percentile is printed with six decimals, from millionths of a percent.
+        fhos_u64 fraction = (fhos_u64)((double)running_count * 100000000.0 / (double)stats.count);
+        char decimals[7] = { '.' };
+        for(fhos_i32 digit = 6; digit >= 1; digit -= 1) {
+            decimals[digit] = (char)('0' + fraction % 10);
+            fraction /= 10;
+        }
+        
+        fhos_u64 value = fhos__get_histogram_bucket_value(bucket);
+        fhos__write_profile_u64(&writer, (value > stats.max) ? stats.max : value);
+        fhos__write_profile_string(&writer, " ");
+        fhos__write_profile_u64(&writer, fraction);
+        fhos__write_profile_bytes(&writer, decimals, 7);
+        fhos__write_profile_string(&writer, " ");
+        fhos__write_profile_u64(&writer, running_count);
+        fhos__write_profile_string(&writer, "\n");
     }
     
-    FHOS__FREE_FROM_TO_PATH(ctx, this_path_data, this_path_length, other_path_data, other_path_length);
-    CloseHandle(this_handle);
-    CloseHandle(other_handle);
-    
-    return (CompareFileTime(&this_time, &other_time) > 0);
+    fhos__flush_profile_writer(&writer);
+    fhos_close_file(writer.handle);
+    fhos_context_temp_free(ctx, writer.buffer);
+    if(writer.has_failed) { return FHOS_ERROR_GENERIC_ERROR; }
+    return FHOS_TRUE;
 }
 
-//
 
-FHOS_API fhos_bool
-fhos_directory_exists(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
-    fhos_bool result = FHOS_FALSE;
-    FHOS__ALLOC_PATH(ctx, path_data, path_length);
-    if(!path) {
-        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
-        return result;
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// TASK GRAPH
+//
+FHOS_API fhos_i32
+fhos_add_task(FHOS_Context *ctx, FHOS_Task_Graph *graph, const char *name, FHOS_Job_Proc *proc, void *data, fhos_i64 cost) {
+    if(!graph || !proc) {
+        FHOS_LOG_ERROR("fhos_add_task -> The parameter %s is null.\n", (!graph) ? "graph" : "proc");
+        return FHOS_ERROR_GENERIC_ERROR;
     }
     
-#if defined(_WIN32) || defined(_WIN64)
-    WIN32_FILE_ATTRIBUTE_DATA attribute = {0};
-    if(GetFileAttributesExA(path, GetFileExInfoStandard, &attribute)) {
-        if((attribute.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY) {
-            result = FHOS_TRUE;
-        }
+    void *new_tasks = fhos_context_maybe_grow(ctx, graph->tasks, &graph->task_capacity, (graph->task_count + 1) * sizeof(FHOS_Task));
+    if(!new_tasks) {
+        FHOS_LOG_ERROR("Could not allocate memory for the task.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
     }
+    graph->tasks = (FHOS_Task *)new_tasks;
     
-#else
-#  error Unimplemented on this platform.
-#endif
+    FHOS_Task zero_task = {0};
+    FHOS_Task *task = graph->tasks + graph->task_count;
+    *task = zero_task;
+    task->name = name;
+    task->proc = proc;
+    task->data = data;
+    task->cost = (cost > 0) ? cost : 1;
+    task->worker_index = -1;
     
-    FHOS__FREE_PATH(ctx, path_data, path_length);
-    return result;
+    graph->task_count += 1;
+    return graph->task_count - 1;
 }
 
-FHOS_API fhos_i32
-fhos_count_directory_files(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
-    if(!path_data) {
-        FHOS_LOG_ERROR("Cannot remove a directory with a null path.\n");
-        return -1;
+FHOS_API fhos_error
+fhos_add_task_dependency(FHOS_Context *ctx, FHOS_Task_Graph *graph, fhos_i32 task, fhos_i32 depends_on) {
+    if(!graph) {
+        FHOS_LOG_ERROR("fhos_add_task_dependency -> The parameter graph is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    if(task < 0 || task >= graph->task_count || depends_on < 0 || depends_on >= graph->task_count || task == depends_on) {
+        FHOS_LOG_ERROR("fhos_add_task_dependency -> The task %d can not depend on the task %d.\n", task, depends_on);
+        return FHOS_ERROR_GENERIC_ERROR;
     }
     
-    fhos_i32 result = 0;
-#if defined(_WIN32) || defined(_WIN64)
+    void *new_edges = fhos_context_maybe_grow(ctx, graph->edges, &graph->edge_capacity, (graph->edge_count + 1) * 2 * sizeof(fhos_i32));
+    if(!new_edges) {
+        FHOS_LOG_ERROR("Could not allocate memory for the task dependency.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
+    graph->edges = (fhos_i32 *)new_edges;
     
-#else
-#  error Unimplemented on this platform.
-#endif
+    graph->edges[graph->edge_count * 2 + 0] = depends_on;
+    graph->edges[graph->edge_count * 2 + 1] = task;
+    graph->edge_count += 1;
+    return FHOS_TRUE;
+}
+
+FHOS_API void
+fhos_free_task_graph(FHOS_Context *ctx, FHOS_Task_Graph *graph) {
+    if(!graph) { return; }
     
-    return result;
+    if(graph->tasks) { fhos_context_free(ctx, graph->tasks); }
+    if(graph->edges) { fhos_context_free(ctx, graph->edges); }
+    
+    FHOS_Task_Graph zero_graph = {0};
+    *graph = zero_graph;
 }
 
-FHOS_API fhos_error
-fhos_create_directory_if_new(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
-    fhos_error result = 0;
-    FHOS__ALLOC_PATH(ctx, path_data, path_length);
-    if(!path) {
-        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
-        return -1;
-    }
+typedef struct FHOS__Task_Graph_Run {
+    FHOS_Task_Graph *graph;
+    fhos_i32 *successor_offsets;
+    fhos_i32 *successors;
+    FHOS_Atomic_I32 *remaining_counts;
     
-#if defined(_WIN32) || defined(_WIN64)
-    result = (fhos_error)CreateDirectoryA(path, 0);
-    if(!result) {
-        DWORD last_error = GetLastError();
-        if(last_error != ERROR_ALREADY_EXISTS) {
-            FHOS_LOG_ERROR("(%lu) Could not create directory %s\n", last_error, path);
-            result = -((fhos_error)last_error);
-        }
-    }
-#else
-#  error Unimplemented on this platform.
-#endif
+    // NOTE(Patrik): Ready tasks wait in a max heap on priority, ties go to whichever became ready first.
+    FHOS_Mutex mutex;
+    fhos_i32 *ready;
+    fhos_i64 *ready_keys;
+    fhos_i32 ready_count;
+    fhos_i64 ready_sequence;
     
-    FHOS__FREE_PATH(ctx, path_data, path_length);
-    return result;
+    FHOS_Job_Counter counter;
+} FHOS__Task_Graph_Run;
+
+static fhos_bool
+fhos__is_task_before(FHOS__Task_Graph_Run *run, fhos_i32 a, fhos_i32 b) {
+    fhos_i64 priority_a = run->graph->tasks[run->ready[a]].priority;
+    fhos_i64 priority_b = run->graph->tasks[run->ready[b]].priority;
+    if(priority_a != priority_b) { return priority_a > priority_b; }
+    return run->ready_keys[a] < run->ready_keys[b];
 }
 
-FHOS_API fhos_error
-fhos_remove_directory_recursively(FHOS_Context *ctx, const char *path_data, fhos_i32 path_length) {
-    if(!path_data) {
-        FHOS_LOG_ERROR("Cannot remove a directory with a null path.\n");
-        return -1;
+static void
+fhos__swap_ready_tasks(FHOS__Task_Graph_Run *run, fhos_i32 a, fhos_i32 b) {
+    fhos_i32 task = run->ready[a];
+    fhos_i64 key = run->ready_keys[a];
+    run->ready[a] = run->ready[b];
+    run->ready_keys[a] = run->ready_keys[b];
+    run->ready[b] = task;
+    run->ready_keys[b] = key;
+}
+
+static void fhos__task_graph_job_proc(FHOS_Context *ctx, void *data);
+
+// NOTE(Patrik): Every ready task gets a job, but the job runs whichever ready task is most urgent once it
+// starts rather than the one that made it.
+static void
+fhos__push_ready_task(FHOS_Context *ctx, FHOS__Task_Graph_Run *run, fhos_i32 task) {
+    fhos_lock_mutex(&run->mutex);
+    fhos_i32 index = run->ready_count;
+    run->ready[index] = task;
+    run->ready_keys[index] = run->ready_sequence;
+    run->ready_sequence += 1;
+    run->ready_count += 1;
+    while(index > 0 && fhos__is_task_before(run, index, (index - 1) / 2)) {
+        fhos__swap_ready_tasks(run, index, (index - 1) / 2);
+        index = (index - 1) / 2;
     }
+    fhos_unlock_mutex(&run->mutex);
     
-#if defined(_WIN32) || defined(_WIN64)
-    if(path_length < 0) {
-        path_length = 0;
-        while(path_data[path_length]) { path_length += 1; }
-    }
+    fhos_run_job(ctx, fhos__task_graph_job_proc, run, &run->counter);
+}
+
+static fhos_i32
+fhos__pop_ready_task(FHOS__Task_Graph_Run *run) {
+    fhos_lock_mutex(&run->mutex);
+    fhos_i32 task = run->ready[0];
+    run->ready_count -= 1;
+    fhos__swap_ready_tasks(run, 0, run->ready_count);
     
-    FHOS_List path = {0};
-    path.capacity = 256;
-    while(path_length + 3 >= path.capacity) { path.capacity += 256; }
-    path.data = (fhos_u8 *)fhos_context_temp_alloc(ctx, path.capacity);
-    if(!path.data) {
-        FHOS_LOG_ERROR("Could not allocate memory for the path.\n");
-        return -1;
+    fhos_i32 index = 0;
+    for(;;) {
+        fhos_i32 best = index;
+        fhos_i32 left = index * 2 + 1;
+        fhos_i32 right = left + 1;
+        if(left < run->ready_count && fhos__is_task_before(run, left, best)) { best = left; }
+        if(right < run->ready_count && fhos__is_task_before(run, right, best)) { best = right; }
+        if(best == index) { break; }
+        fhos__swap_ready_tasks(run, index, best);
+        index = best;
     }
+    fhos_unlock_mutex(&run->mutex);
+    return task;
+}
+
+static void
+fhos__task_graph_job_proc(FHOS_Context *ctx, void *data) {
+    FHOS__Task_Graph_Run *run = (FHOS__Task_Graph_Run *)data;
+    fhos_i32 index = fhos__pop_ready_task(run);
+    FHOS_Task *task = run->graph->tasks + index;
     
-    for(fhos_i32 i = 0; i < path_length; i += 1) {
-        if(path_data[i] == '/') {
-            path.data[i] = '\\';
-        } else {
-            path.data[i] = ((fhos_u8 *)path_data)[i];
-        }
-        path.length += 1;
-    }
-    path.data[path.length] = 0;
+    task->worker_index = fhos_get_job_worker_index();
+    task->start_ticks = fhos_get_ticks();
+    task->proc(ctx, task->data);
+    task->end_ticks = fhos_get_ticks();
     
-    DWORD attributes = GetFileAttributesA((char *)path.data);
-    if((attributes & FILE_ATTRIBUTE_DIRECTORY) != FILE_ATTRIBUTE_DIRECTORY) {
-        FHOS_LOG_ERROR("The path \"%s\" is not a directory.\n", (char *)path.data);
-        fhos_context_temp_free(ctx, path.data);
-        return -1;
+    for(fhos_i32 i = run->successor_offsets[index]; i < run->successor_offsets[index + 1]; i += 1) {
+        fhos_i32 successor = run->successors[i];
+        if(fhos_atomic_fetch_add_i32(&run->remaining_counts[successor], -1, FHOS_MEMORY_ORDER_ACQ_REL) == 1) { fhos__push_ready_task(ctx, run, successor); }
     }
+}
+
+// NOTE(Patrik): The graph is sorted first, which finds cycles before anything runs. With the critical path
+// flag a task's priority is its cost plus the most costly chain of tasks that waits on it.
+FHOS_API fhos_error
+fhos_run_task_graph(FHOS_Context *ctx, FHOS_Task_Graph *graph, FHOS_Task_Graph_Flags flags) {
+    if(!graph) {
+        FHOS_LOG_ERROR("fhos_run_task_graph -> The parameter graph is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
+    if(graph->task_count == 0) { return FHOS_TRUE; }
     
-    if(path.data[path.length - 1] != '/' && path.data[path.length - 1] != '\\') {
-        path.data[path.length] = '\\';
-        path.length += 1;
+    fhos_i32 task_count = graph->task_count;
+    fhos_i64 edge_count = graph->edge_count;
+    fhos_i64 memory_size = (fhos_i64)(task_count + 1) * sizeof(fhos_i32) + edge_count * sizeof(fhos_i32) + (fhos_i64)task_count * (3 * sizeof(fhos_i32) + sizeof(fhos_i64));
+    fhos_u8 *memory = (fhos_u8 *)fhos_context_temp_alloc(ctx, memory_size);
+    if(!memory) {
+        FHOS_LOG_ERROR("Could not allocate memory for running the task graph.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
     }
-    path.data[path.length] = '*';
-    path.data[path.length + 1] = 0;
-    path_length = (fhos_i32)path.length;
     
-    fhos_i32 handle_count = 1;
-    HANDLE handle_stack[128];
-    WIN32_FIND_DATAA find_data = {0};
-    handle_stack[0] = FindFirstFileA((char *)path.data, &find_data);
+    FHOS__Task_Graph_Run run = {0};
+    run.graph = graph;
+    run.ready_keys = (fhos_i64 *)memory;
+    run.successor_offsets = (fhos_i32 *)(run.ready_keys + task_count);
+    run.successors = run.successor_offsets + task_count + 1;
+    run.remaining_counts = (FHOS_Atomic_I32 *)(run.successors + edge_count);
+    run.ready = (fhos_i32 *)(run.remaining_counts + task_count);
+    fhos_i32 *order = run.ready + task_count;
     
-    if(handle_stack[0] == INVALID_HANDLE_VALUE) {
-        DWORD last_error = GetLastError();
-        FHOS_LOG_ERROR("(%lu) Could not find the first file in the directory %s\n", last_error, path.data);
-        fhos_context_temp_free(ctx, path.data);
-        return -1;
+    // NOTE(Patrik): The edges are counted into offsets and then placed, which lists each task's successors together.
+    for(fhos_i64 i = 0; i < edge_count; i += 1) {
+        run.successor_offsets[graph->edges[i * 2 + 0] + 1] += 1;
+        fhos_atomic_fetch_add_i32(&run.remaining_counts[graph->edges[i * 2 + 1]], 1, FHOS_MEMORY_ORDER_RELAXED);
+    }
+    for(fhos_i32 i = 0; i < task_count; i += 1) { run.successor_offsets[i + 1] += run.successor_offsets[i]; }
+    for(fhos_i64 i = 0; i < edge_count; i += 1) {
+        fhos_i32 from = graph->edges[i * 2 + 0];
+        run.successors[run.successor_offsets[from] + order[from]] = graph->edges[i * 2 + 1];
+        order[from] += 1;
     }
     
-    fhos_error error = 1;
-    while(handle_count > 0) {
-        fhos_bool should_process = FHOS_TRUE;
-        if(find_data.cFileName[0] == '.' &&
-           (find_data.cFileName[1] == 0 || (find_data.cFileName[1] == '.' && find_data.cFileName[2] == 0)))
-        {
-            should_process = FHOS_FALSE;
+    fhos_i32 order_count = 0;
+    for(fhos_i32 i = 0; i < task_count; i += 1) {
+        run.ready[i] = fhos_atomic_load_i32(&run.remaining_counts[i], FHOS_MEMORY_ORDER_RELAXED);
+        if(run.ready[i] == 0) {
+            order[order_count] = i;
+            order_count += 1;
         }
-        
-        if(should_process) {
-            fhos_i32 ntstring_length = 0;
-            while(find_data.cFileName[ntstring_length]) { ntstring_length += 1; }
-            
-            if(path.length + ntstring_length + 3 >= path.capacity) {
-                while(path.length + ntstring_length >= path.capacity) { path.capacity += 256; }
-                path.data = (fhos_u8 *)fhos_context_temp_realloc(ctx, path.data, path.capacity);
-            }
-            
-            for(fhos_i32 i = 0; i < ntstring_length; i += 1) { path.data[path.length + i] = find_data.cFileName[i]; }
-            
-            if((find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY) {
-                path.length += ntstring_length;
-                path.data[path.length] = '\\';
-                path.data[path.length + 1] = '*';
-                path.data[path.length + 2] = 0;
-                path.length += 1;
-                
-                handle_stack[handle_count] = FindFirstFileA((char *)path.data, &find_data);
-                handle_count += 1;
-                continue;
-            } else {
-                path.data[path.length + ntstring_length] = 0;
-                DeleteFile((char *)path.data);
+    }
+    fhos_i32 root_count = order_count;
+    for(fhos_i32 i = 0; i < order_count; i += 1) {
+        fhos_i32 task = order[i];
+        for(fhos_i32 j = run.successor_offsets[task]; j < run.successor_offsets[task + 1]; j += 1) {
+            fhos_i32 successor = run.successors[j];
+            run.ready[successor] -= 1;
+            if(run.ready[successor] == 0) {
+                order[order_count] = successor;
+                order_count += 1;
             }
         }
+    }
+    if(order_count < task_count) {
+        FHOS_LOG_ERROR("The task graph has a cycle, %d of its tasks can never run.\n", task_count - order_count);
+        fhos_context_temp_free(ctx, memory);
+        return FHOS_ERROR_INVALID_FORMAT;
+    }
+    
+    for(fhos_i32 i = task_count - 1; i >= 0; i -= 1) {
+        FHOS_Task *task = graph->tasks + order[i];
+        task->priority = 0;
+        task->start_ticks = 0;
+        task->end_ticks = 0;
+        task->worker_index = -1;
+        if(!(flags & FHOS_TASK_GRAPH_FLAG_CRITICAL_PATH)) { continue; }
         
-        while(!FindNextFileA(handle_stack[handle_count - 1], &find_data)) {
-            FindClose(handle_stack[handle_count - 1]);
-            handle_count -= 1;
-            
-            path.data[path.length] = 0;
-            if(!RemoveDirectory((char *)path.data)) {
-                FHOS_LOG_ERROR("(%lu) Could not remove the directory: \"%s\"\n", GetLastError(), path.data);
-                error = -1;
-                
-                for(fhos_i32 i = 0; i < handle_count; i += 1) { FindClose(handle_stack[i]); }
-                handle_count = 0;
-            }
-            
-            if(handle_count <= 0) { break; }
-            
-            // NOTE(Patrik): The last character is '/' or '\\' so we don't count it
-            for(fhos_i64 i = path.length - 2; i >= 0; i -= 1) {
-                if(path.data[i] == '\\' || path.data[i] == '/') {
-                    path.length = i + 1;
-                    break;
-                }
-            }
+        fhos_i64 longest = 0;
+        for(fhos_i32 j = run.successor_offsets[order[i]]; j < run.successor_offsets[order[i] + 1]; j += 1) {
+            fhos_i64 priority = graph->tasks[run.successors[j]].priority;
+            if(priority > longest) { longest = priority; }
         }
+        task->priority = task->cost + longest;
     }
     
-    fhos_context_temp_free(ctx, path.data);
-    return error;
-#else
-#  error Unimplemented on this platform.
-#endif
+    // NOTE(Patrik): The roots are the start of the order. Their counts can not be checked again here, the first
+    // ones queued may already have brought others down to zero, and those get queued by whoever did it.
+    for(fhos_i32 i = 0; i < root_count; i += 1) { fhos__push_ready_task(ctx, &run, order[i]); }
+    // NOTE(Patrik): A task queues its successors before its own job counts as done, so the counter only reaches
+    // zero after the last job is through with run. Once the wait returns nothing can reach run anymore.
+    fhos_wait_for_jobs(ctx, &run.counter);
+    
+    fhos_context_temp_free(ctx, memory);
+    return FHOS_TRUE;
 }
 
-
-//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//
-// TIME
-//
-FHOS_API FHOS_Date_And_Time
-fhos_get_date_and_time(void) {
-    FHOS_Date_And_Time result = {0};
-    
-#if defined(_WIN32) || defined(_WIN64)
-    SYSTEMTIME system = {0};
-    GetSystemTime(&system);
+// NOTE(Patrik): Tasks run by the thread that called fhos_run_task_graph are on thread 0, the workers follow.
+FHOS_API fhos_error
+fhos_write_task_graph_timings(FHOS_Context *ctx, FHOS_Task_Graph *graph, const char *path_data, fhos_i32 path_length) {
+    if(!graph) {
+        FHOS_LOG_ERROR("fhos_write_task_graph_timings -> The parameter graph is null.\n");
+        return FHOS_ERROR_GENERIC_ERROR;
+    }
     
-    result.year         = (fhos_u32)system.wYear;
-    result.milliseconds = (fhos_u16)system.wMilliseconds;
-    result.month        = (fhos_u8)system.wMonth;
-    result.day          = (fhos_u8)system.wDay;
-    result.weekday      = (fhos_u8)system.wDayOfWeek;
-    result.hour         = (fhos_u8)system.wHour;
-    result.minutes      = (fhos_u8)system.wMinute;
-    result.seconds      = (fhos_u8)system.wSecond;
-#else
-#  error Unimplemented on this platform.
-#endif
+    FHOS__Profile_Writer writer = {0};
+    writer.capacity = 64 * 1024;
+    writer.buffer = (fhos_u8 *)fhos_context_temp_alloc_non_zero(ctx, writer.capacity);
+    if(!writer.buffer) {
+        FHOS_LOG_ERROR("Could not allocate memory for writing the task timings.\n");
+        return FHOS_ERROR_OUT_OF_MEMORY;
+    }
     
-    return result;
-}
-
-FHOS_API fhos_u64
-fhos_get_unix_timestamp(void) {
-#if defined(_WIN32) || defined(_WIN64)
-    fhos_u64 unix_time_start = 0x019DB1DED53E8000ULL;
-    fhos_u64 ticks_per_second = 10000000;
+    writer.handle = fhos_open_file_for_writing(ctx, path_data, path_length);
+    if(!fhos_is_file_handle_valid(writer.handle)) {
+        fhos_context_temp_free(ctx, writer.buffer);
+        return FHOS_ERROR_INVALID_FILE_HANDLE;
+    }
     
-    FILETIME file_time;
-    GetSystemTimeAsFileTime(&file_time);
+    fhos_u64 base_ticks = ~(fhos_u64)0;
+    for(fhos_i32 i = 0; i < graph->task_count; i += 1) {
+        if(graph->tasks[i].end_ticks && graph->tasks[i].start_ticks < base_ticks) { base_ticks = graph->tasks[i].start_ticks; }
+    }
     
-    LARGE_INTEGER large;
-    large.LowPart = file_time.dwLowDateTime;
-    large.HighPart = file_time.dwHighDateTime;
+    fhos__write_profile_string(&writer, "{\"traceEvents\":[\n");
+    fhos_bool is_first = FHOS_TRUE;
+    for(fhos_i32 i = 0; i < graph->task_count; i += 1) {
+        FHOS_Task *task = graph->tasks + i;
+        if(!task->end_ticks) { continue; }
+        
+        fhos__write_profile_string(&writer, (is_first) ? "{\"name\":" : ",\n{\"name\":");
+        fhos__write_profile_json_string(&writer, task->name);
+        fhos__write_profile_string(&writer, ",\"ph\":\"X\",\"pid\":1,\"tid\":");
+        fhos__write_profile_u64(&writer, (fhos_u64)(task->worker_index + 1));
+        fhos__write_profile_string(&writer, ",\"ts\":");
+        fhos__write_profile_microseconds(&writer, fhos_ticks_to_nanoseconds(task->start_ticks - base_ticks));
+        fhos__write_profile_string(&writer, ",\"dur\":");
+        fhos__write_profile_microseconds(&writer, fhos_ticks_to_nanoseconds(task->end_ticks - task->start_ticks));
+        fhos__write_profile_string(&writer, ",\"args\":{\"task\":");
+        fhos__write_profile_u64(&writer, (fhos_u64)i);
+        fhos__write_profile_string(&writer, ",\"priority\":");
+        fhos__write_profile_u64(&writer, (fhos_u64)task->priority);
+        fhos__write_profile_string(&writer, "}}");
+        is_first = FHOS_FALSE;
+    }
+    fhos__write_profile_string(&writer, "\n]}\n");
     
-    return (large.QuadPart - unix_time_start) / ticks_per_second;
-#else
-#  error Unimplemented on this platform.
-#endif
+    fhos__flush_profile_writer(&writer);
+    fhos_close_file(writer.handle);
+    fhos_context_temp_free(ctx, writer.buffer);
+    if(writer.has_failed) { return FHOS_ERROR_GENERIC_ERROR; }
+    return FHOS_TRUE;
 }
 
 
-
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //
 // END IMPLEMENTATION GUARD
@@ -0,0 +1,475 @@
+/*
+** Tests for fhos.h. Build and run from the repository root:
+**     cc -std=gnu11 -O1 -g -I. tests/fhos_test.c -o fhos_test -pthread && ./fhos_test
+** Files are written below fhos_test_output in the working directory, which is removed again at the end.
+** See end of fhos.h for license information.
+*/
+#define FHOS_IMPLEMENTATION
+#include "fhos.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FHOS_TEST_OUTPUT "fhos_test_output"
+
+static fhos_i32 fhos_test_failure_count;
+
+#define FHOS_TEST_EXPECT(condition) do {\
+    if(!(condition)) {\
+        fprintf(stderr, "%s(%d): [FAILED] %s\n", __FILE__, __LINE__, #condition);\
+        fhos_test_failure_count += 1;\
+    }\
+} while(0)
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// HELPERS
+//
+typedef struct Fhos_Test_Paths {
+    char paths[128][256];
+    FHOS_Directory_Entry_Type types[128];
+    fhos_i32 count;
+} Fhos_Test_Paths;
+
+static void
+fhos_test_write_text(const char *path, const char *text) {
+    fhos_bool was_written = fhos_write_entire_file(0, path, -1, (const fhos_u8 *)text, (fhos_i64)strlen(text));
+    FHOS_TEST_EXPECT(was_written);
+}
+
+static void
+fhos_test_add_path(Fhos_Test_Paths *paths, const char *path, fhos_i32 path_length, FHOS_Directory_Entry_Type type) {
+    FHOS_TEST_EXPECT(paths->count < 128 && path_length < 256);
+    if(paths->count >= 128 || path_length >= 256) { return; }
+    
+    memcpy(paths->paths[paths->count], path, path_length);
+    paths->paths[paths->count][path_length] = 0;
+    paths->types[paths->count] = type;
+    paths->count += 1;
+}
+
+// NOTE(Patrik): Sorts the paths and their types together, the walk reports them in no particular order.
+static void
+fhos_test_sort_paths(Fhos_Test_Paths *paths) {
+    for(fhos_i32 i = 1; i < paths->count; i += 1) {
+        for(fhos_i32 j = i; j > 0 && strcmp(paths->paths[j - 1], paths->paths[j]) > 0; j -= 1) {
+            char path[256];
+            memcpy(path, paths->paths[j], sizeof(path));
+            memcpy(paths->paths[j], paths->paths[j - 1], sizeof(path));
+            memcpy(paths->paths[j - 1], path, sizeof(path));
+            
+            FHOS_Directory_Entry_Type type = paths->types[j];
+            paths->types[j] = paths->types[j - 1];
+            paths->types[j - 1] = type;
+        }
+    }
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// DIRECTORY
+//
+static void
+fhos_test_collect_with_iterator(Fhos_Test_Paths *paths, const char *path) {
+    FHOS_Directory_Iterator iterator;
+    fhos_error error = fhos_open_directory(0, &iterator, path, -1, 0);
+    FHOS_TEST_EXPECT(error == FHOS_TRUE);
+    if(error != FHOS_TRUE) { return; }
+    
+    FHOS_Directory_Entry entry;
+    while((error = fhos_next_directory_entry(&iterator, &entry)) == FHOS_TRUE) {
+        char child_path[256];
+        fhos_i32 child_length = snprintf(child_path, sizeof(child_path), "%s/%s", path, entry.name);
+        fhos_test_add_path(paths, child_path, child_length, entry.type);
+        if(entry.type == FHOS_DIRECTORY_ENTRY_TYPE_DIRECTORY) { fhos_test_collect_with_iterator(paths, child_path); }
+    }
+    FHOS_TEST_EXPECT(error == FHOS_FALSE);
+    fhos_close_directory(0, &iterator);
+}
+
+static void
+fhos_test_directory_iterator_matches_walk(void) {
+    const char *root = FHOS_TEST_OUTPUT "/tree";
+    fhos_create_directory_if_new(0, root, -1);
+    fhos_create_directory_if_new(0, FHOS_TEST_OUTPUT "/tree/a", -1);
+    fhos_create_directory_if_new(0, FHOS_TEST_OUTPUT "/tree/a/b", -1);
+    fhos_create_directory_if_new(0, FHOS_TEST_OUTPUT "/tree/empty", -1);
+    fhos_test_write_text(FHOS_TEST_OUTPUT "/tree/.hidden", "hidden");
+    fhos_test_write_text(FHOS_TEST_OUTPUT "/tree/a/b/deep.txt", "deep");
+    for(fhos_i32 i = 0; i < 40; i += 1) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s/a/file_%02d.txt", root, i);
+        fhos_test_write_text(path, path);
+    }
+    
+    Fhos_Test_Paths *iterated = (Fhos_Test_Paths *)calloc(1, sizeof(Fhos_Test_Paths));
+    Fhos_Test_Paths *walked = (Fhos_Test_Paths *)calloc(1, sizeof(Fhos_Test_Paths));
+    fhos_test_collect_with_iterator(iterated, root);
+    
+    FHOS_Walk_Options options = {0};
+    options.thread_count = 3;
+    options.collect_entries = FHOS_TRUE;
+    FHOS_Walk_Result result = fhos_walk_directory(0, root, -1, &options);
+    FHOS_TEST_EXPECT(result.error_count == 0);
+    for(fhos_i32 i = 0; i < result.list_count; i += 1) {
+        for(fhos_i64 j = 0; j < result.lists[i].count; j += 1) {
+            FHOS_Walk_Entry *entry = result.lists[i].entries + j;
+            fhos_test_add_path(walked, entry->path, entry->path_length, entry->type);
+        }
+    }
+    FHOS_TEST_EXPECT(result.file_count == 42 && result.directory_count == 3);
+    fhos_free_walk_result(&result);
+    
+    fhos_test_sort_paths(iterated);
+    fhos_test_sort_paths(walked);
+    FHOS_TEST_EXPECT(iterated->count == 45 && walked->count == iterated->count);
+    for(fhos_i32 i = 0; i < iterated->count && i < walked->count; i += 1) {
+        FHOS_TEST_EXPECT(strcmp(iterated->paths[i], walked->paths[i]) == 0);
+        FHOS_TEST_EXPECT(iterated->types[i] == walked->types[i]);
+    }
+    
+    free(iterated);
+    free(walked);
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// HASH
+//
+static FHOS_Hash128
+fhos_test_hash_with_kernel(const FHOS__Hash_Kernel *kernel, const fhos_u8 *data, fhos_i64 size) {
+    fhos_atomic_store_pointer(&fhos__hash_kernel, (void *)kernel, FHOS_MEMORY_ORDER_RELEASE);
+    FHOS_Hash128 hash = fhos_hash_memory(data, size);
+    fhos_atomic_store_pointer(&fhos__hash_kernel, 0, FHOS_MEMORY_ORDER_RELEASE);
+    return hash;
+}
+
+// NOTE(Patrik): The sizes land on, just before and just after the stripe and block edges.
+static void
+fhos_test_hash_kernels_agree(void) {
+    fhos_i64 data_size = 1 << 18;
+    fhos_u8 *data = (fhos_u8 *)malloc(data_size);
+    fhos_u32 random = 12345;
+    for(fhos_i64 i = 0; i < data_size; i += 1) {
+        random = random * 1103515245 + 12345;
+        data[i] = (fhos_u8)(random >> 16);
+    }
+    
+    fhos_i64 sizes[] = { 0, 1, 7, 31, 32, 33, 63, 64, 65, 1023, 1024, 1025, 3000, 65536 + 17, 1 << 18 };
+    for(fhos_i32 i = 0; i < (fhos_i32)(sizeof(sizes) / sizeof(sizes[0])); i += 1) {
+        FHOS_Hash128 expected = fhos_test_hash_with_kernel(&fhos__hash_kernel_scalar, data, sizes[i]);
+#if defined(FHOS__HASH_X64)
+        FHOS_TEST_EXPECT(fhos_hashes_are_equal(expected, fhos_test_hash_with_kernel(&fhos__hash_kernel_sse2, data, sizes[i])));
+        if(fhos__cpu_has_avx2()) {
+            FHOS_TEST_EXPECT(fhos_hashes_are_equal(expected, fhos_test_hash_with_kernel(&fhos__hash_kernel_avx2, data, sizes[i])));
+        }
+#endif
+        
+        // NOTE(Patrik): Fed in uneven pieces the state has to carry partial stripes between the updates.
+        FHOS_Hash_State state;
+        fhos_begin_hash(&state);
+        fhos_i64 offset = 0;
+        fhos_i64 piece_size = 1;
+        while(offset < sizes[i]) {
+            fhos_i64 size = (piece_size < sizes[i] - offset) ? piece_size : sizes[i] - offset;
+            fhos_update_hash(&state, data + offset, size);
+            offset += size;
+            piece_size = (piece_size * 3 + 1) % 5000 + 1;
+        }
+        FHOS_TEST_EXPECT(fhos_hashes_are_equal(expected, fhos_end_hash(&state)));
+    }
+    
+    FHOS_Hash128 hash = fhos_hash_memory(data, data_size);
+    data[data_size / 2] ^= 1;
+    FHOS_TEST_EXPECT(!fhos_hashes_are_equal(hash, fhos_hash_memory(data, data_size)));
+    
+    free(data);
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// PACK
+//
+static fhos_bool
+fhos_test_pack_file_equals(FHOS_Pack *pack, const char *name, const fhos_u8 *data, fhos_i64 size) {
+    FHOS_List file = fhos_read_pack_file(0, pack, name, -1, FHOS_FALSE);
+    fhos_bool is_equal = (file.count == size && (size == 0 || (file.data && memcmp(file.data, data, size) == 0)));
+    fhos_free_pack_file(0, &file, FHOS_FALSE);
+    return is_equal;
+}
+
+static void
+fhos_test_pack_round_trip(void) {
+    fhos_i64 big_size = 100000;
+    fhos_u8 *big = (fhos_u8 *)malloc(big_size);
+    for(fhos_i64 i = 0; i < big_size; i += 1) { big[i] = (fhos_u8)(i * 7 + (i >> 9)); }
+    
+    const char *pack_path = FHOS_TEST_OUTPUT "/built.pack";
+    FHOS_Pack_Builder builder = {0};
+    FHOS_TEST_EXPECT(fhos_begin_pack(0, &builder, pack_path, -1, 0) == FHOS_TRUE);
+    FHOS_TEST_EXPECT(fhos_add_data_to_pack(0, &builder, "textures/stone.png", -1, (const fhos_u8 *)"stone", 5) == FHOS_TRUE);
+    FHOS_TEST_EXPECT(fhos_add_data_to_pack(0, &builder, "textures\\sub\\big.bin", -1, big, big_size) == FHOS_TRUE);
+    FHOS_TEST_EXPECT(fhos_add_data_to_pack(0, &builder, "empty", -1, 0, 0) == FHOS_TRUE);
+    FHOS_TEST_EXPECT(fhos_end_pack(0, &builder) == FHOS_TRUE);
+    
+    FHOS_Pack pack;
+    FHOS_TEST_EXPECT(fhos_mount_pack(0, &pack, pack_path, -1, 0, 0) == FHOS_TRUE);
+    FHOS_TEST_EXPECT(pack.count == 3);
+    FHOS_TEST_EXPECT(fhos_test_pack_file_equals(&pack, "textures/stone.png", (const fhos_u8 *)"stone", 5));
+    FHOS_TEST_EXPECT(fhos_test_pack_file_equals(&pack, "/textures/sub/big.bin", big, big_size));
+    FHOS_TEST_EXPECT(fhos_test_pack_file_equals(&pack, "empty", 0, 0));
+    FHOS_TEST_EXPECT(fhos_find_pack_entry(&pack, "textures/missing.png", -1) == 0);
+    fhos_unmount_pack(0, &pack);
+    
+    // NOTE(Patrik): The same files again, packed from a directory and then shadowed by a loose file.
+    fhos_create_directory_if_new(0, FHOS_TEST_OUTPUT "/pack_source", -1);
+    fhos_create_directory_if_new(0, FHOS_TEST_OUTPUT "/pack_source/textures", -1);
+    fhos_create_directory_if_new(0, FHOS_TEST_OUTPUT "/pack_source/textures/sub", -1);
+    fhos_create_directory_if_new(0, FHOS_TEST_OUTPUT "/pack_loose", -1);
+    fhos_create_directory_if_new(0, FHOS_TEST_OUTPUT "/pack_loose/textures", -1);
+    fhos_test_write_text(FHOS_TEST_OUTPUT "/pack_source/textures/stone.png", "stone");
+    fhos_test_write_text(FHOS_TEST_OUTPUT "/pack_loose/textures/stone.png", "loose stone");
+    FHOS_TEST_EXPECT(fhos_write_entire_file(0, FHOS_TEST_OUTPUT "/pack_source/textures/sub/big.bin", -1, big, big_size));
+    
+    pack_path = FHOS_TEST_OUTPUT "/directory.pack";
+    FHOS_TEST_EXPECT(fhos_build_pack_from_directory(0, pack_path, -1, FHOS_TEST_OUTPUT "/pack_source", -1, 0) == 2);
+    FHOS_TEST_EXPECT(fhos_mount_pack(0, &pack, pack_path, -1, 0, 0) == FHOS_TRUE);
+    FHOS_TEST_EXPECT(fhos_test_pack_file_equals(&pack, "textures/stone.png", (const fhos_u8 *)"stone", 5));
+    FHOS_TEST_EXPECT(fhos_test_pack_file_equals(&pack, "textures/sub/big.bin", big, big_size));
+    fhos_unmount_pack(0, &pack);
+    
+    FHOS_TEST_EXPECT(fhos_mount_pack(0, &pack, pack_path, -1, FHOS_TEST_OUTPUT "/pack_loose", -1) == FHOS_TRUE);
+    FHOS_TEST_EXPECT(fhos_test_pack_file_equals(&pack, "textures/stone.png", (const fhos_u8 *)"loose stone", 11));
+    FHOS_TEST_EXPECT(fhos_test_pack_file_equals(&pack, "textures/sub/big.bin", big, big_size));
+    fhos_unmount_pack(0, &pack);
+    
+    free(big);
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// COMPRESSION
+//
+static void
+fhos_test_compression_round_trip(void) {
+    fhos_i64 data_size = 3 * FHOS_COMPRESSION_BLOCK_SIZE + 123;
+    fhos_u8 *data = (fhos_u8 *)malloc(data_size);
+    fhos_u8 *output = (fhos_u8 *)malloc(data_size);
+    fhos_u8 *compressed = (fhos_u8 *)malloc(fhos_get_compress_bound(data_size));
+    
+    // NOTE(Patrik): Random bytes are stored as literals, the repeating text and the slow ramp make long and overlapping matches.
+    fhos_u32 random = 12345;
+    fhos_i64 sizes[] = { 0, 1, 12, 13, 100, 4096, 65536 + 5, data_size };
+    for(fhos_i32 kind = 0; kind < 3; kind += 1) {
+        for(fhos_i64 i = 0; i < data_size; i += 1) {
+            random = random * 1103515245 + 12345;
+            if(kind == 0) { data[i] = (fhos_u8)(random >> 16); }
+            if(kind == 1) { data[i] = (fhos_u8)"abcabcabd"[i % 9]; }
+            if(kind == 2) { data[i] = (fhos_u8)(i / 97 + ((random >> 16) % 4 == 0)); }
+        }
+        
+        for(fhos_i32 i = 0; i < (fhos_i32)(sizeof(sizes) / sizeof(sizes[0])); i += 1) {
+            fhos_i64 compressed_size = fhos_compress_block(data, sizes[i], compressed, fhos_get_compress_bound(sizes[i]));
+            FHOS_TEST_EXPECT(compressed_size > 0);
+            fhos_i64 output_size = fhos_decompress_block(compressed, compressed_size, output, sizes[i]);
+            FHOS_TEST_EXPECT(output_size == sizes[i] && memcmp(output, data, sizes[i]) == 0);
+            if(sizes[i] > 0) { FHOS_TEST_EXPECT(fhos_decompress_block(compressed, compressed_size, output, sizes[i] - 1) < 0); }
+            
+            // NOTE(Patrik): Corrupt or cut off blocks may decode to garbage, but must stay in bounds.
+            for(fhos_i32 j = 0; j < 16 && compressed_size > 0; j += 1) {
+                random = random * 1103515245 + 12345;
+                fhos_i64 offset = (random >> 8) % compressed_size;
+                compressed[offset] ^= (fhos_u8)(1 + (random >> 24) % 255);
+                fhos_decompress_block(compressed, compressed_size - (j & 1), output, sizes[i]);
+                compressed[offset] ^= (fhos_u8)(1 + (random >> 24) % 255);
+            }
+        }
+    }
+    
+    const char *path = FHOS_TEST_OUTPUT "/compressed.fhz";
+    FHOS_TEST_EXPECT(fhos_write_entire_file_compressed(0, path, -1, data, data_size));
+    FHOS_List file = fhos_read_entire_file_compressed(0, path, -1, FHOS_FALSE);
+    FHOS_TEST_EXPECT(file.count == data_size && file.data && memcmp(file.data, data, data_size) == 0);
+    if(file.data) { fhos_context_free(0, file.data); }
+    
+    free(compressed);
+    free(output);
+    free(data);
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// HISTOGRAM
+//
+static void
+fhos_test_histogram_buckets(void) {
+    for(fhos_u64 value = 0; value < 2 * FHOS__HISTOGRAM_SUB_BUCKET_COUNT; value += 1) {
+        FHOS_TEST_EXPECT(fhos__get_histogram_bucket_value(fhos__get_histogram_bucket(value)) == value);
+    }
+    
+    // NOTE(Patrik): Every power of two starts a new bucket, whose largest value is at most 1/64th above anything in it.
+    for(fhos_i32 bit = FHOS__HISTOGRAM_SUB_BUCKET_BITS; bit < 64; bit += 1) {
+        fhos_u64 edge = (fhos_u64)1 << bit;
+        fhos_u64 values[4] = { edge - 1, edge, edge + 1, edge + edge / 3 };
+        FHOS_TEST_EXPECT(fhos__get_histogram_bucket(edge - 1) + 1 == fhos__get_histogram_bucket(edge));
+        for(fhos_i32 i = 0; i < 4; i += 1) {
+            fhos_i32 bucket = fhos__get_histogram_bucket(values[i]);
+            fhos_u64 bucket_value = fhos__get_histogram_bucket_value(bucket);
+            FHOS_TEST_EXPECT(bucket_value >= values[i] && bucket_value - values[i] <= values[i] / FHOS__HISTOGRAM_SUB_BUCKET_COUNT);
+            FHOS_TEST_EXPECT(fhos__get_histogram_bucket(bucket_value) == bucket);
+            if(bucket_value != ~(fhos_u64)0) { FHOS_TEST_EXPECT(fhos__get_histogram_bucket(bucket_value + 1) == bucket + 1); }
+        }
+    }
+    FHOS_TEST_EXPECT(fhos__get_histogram_bucket(~(fhos_u64)0) == FHOS__HISTOGRAM_BUCKET_COUNT - 1);
+}
+
+static void
+fhos_test_histogram_percentiles(void) {
+    FHOS_Histogram histogram;
+    FHOS_Histogram_Stats stats;
+    FHOS_TEST_EXPECT(fhos_init_histogram(0, &histogram) == FHOS_TRUE);
+    
+    // NOTE(Patrik): Values below 128 have a bucket each, so these percentiles are exact.
+    for(fhos_u64 value = 0; value < 100; value += 1) { fhos_record_histogram(&histogram, value); }
+    FHOS_TEST_EXPECT(fhos_get_histogram_stats(&histogram, &stats));
+    FHOS_TEST_EXPECT(stats.count == 100 && stats.min == 0 && stats.max == 99 && stats.mean == 49.5);
+    FHOS_TEST_EXPECT(stats.p50 == 49 && stats.p90 == 89 && stats.p99 == 98 && stats.p999 == 99);
+    
+    fhos_reset_histogram(&histogram);
+    FHOS_TEST_EXPECT(fhos_get_histogram_stats(&histogram, &stats));
+    FHOS_TEST_EXPECT(stats.count == 0 && stats.min == 0 && stats.max == 0 && stats.p50 == 0);
+    
+    // NOTE(Patrik): Larger ones are rounded up to the end of their bucket, but never past the largest value recorded.
+    for(fhos_u64 value = 1; value <= 100000; value += 1) { fhos_record_histogram(&histogram, value); }
+    FHOS_TEST_EXPECT(fhos_get_histogram_stats(&histogram, &stats));
+    FHOS_TEST_EXPECT(stats.count == 100000 && stats.min == 1 && stats.max == 100000 && stats.mean == 50000.5);
+    FHOS_TEST_EXPECT(stats.p50 >= 50000 && stats.p50 <= 50000 + 50000 / 64);
+    FHOS_TEST_EXPECT(stats.p90 >= 90000 && stats.p90 <= 90000 + 90000 / 64);
+    FHOS_TEST_EXPECT(stats.p99 >= 99000 && stats.p99 <= 99000 + 99000 / 64);
+    FHOS_TEST_EXPECT(stats.p999 >= 99900 && stats.p999 <= 100000);
+    
+    fhos_free_histogram(0, &histogram);
+}
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// TASK GRAPH
+//
+#define FHOS_TEST_TASK_COUNT 200
+
+typedef struct Fhos_Test_Task {
+    fhos_i32 index;
+    fhos_i32 dependencies[4];
+    fhos_i32 dependency_count;
+} Fhos_Test_Task;
+
+static Fhos_Test_Task fhos_test_tasks[FHOS_TEST_TASK_COUNT];
+static FHOS_Atomic_I32 fhos_test_task_is_done[FHOS_TEST_TASK_COUNT];
+static FHOS_Atomic_I32 fhos_test_task_run_count;
+static FHOS_Atomic_I32 fhos_test_task_early_count;
+
+static void
+fhos_test_task_proc(FHOS_Context *ctx, void *data) {
+    (void)ctx;
+    Fhos_Test_Task *task = (Fhos_Test_Task *)data;
+    for(fhos_i32 i = 0; i < task->dependency_count; i += 1) {
+        if(!fhos_atomic_load_i32(&fhos_test_task_is_done[task->dependencies[i]], FHOS_MEMORY_ORDER_ACQUIRE)) {
+            fhos_atomic_fetch_add_i32(&fhos_test_task_early_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+        }
+    }
+    fhos_atomic_fetch_add_i32(&fhos_test_task_run_count, 1, FHOS_MEMORY_ORDER_RELAXED);
+    fhos_atomic_store_i32(&fhos_test_task_is_done[task->index], 1, FHOS_MEMORY_ORDER_RELEASE);
+}
+
+static void
+fhos_test_task_graph(void) {
+    FHOS_TEST_EXPECT(fhos_start_job_system(0, 3));
+    
+    // NOTE(Patrik): Every task depends on up to four earlier ones, so the graph has many roots and joins.
+    FHOS_Task_Graph graph = {0};
+    fhos_u32 random = 12345;
+    for(fhos_i32 i = 0; i < FHOS_TEST_TASK_COUNT; i += 1) {
+        Fhos_Test_Task *task = fhos_test_tasks + i;
+        task->index = i;
+        FHOS_TEST_EXPECT(fhos_add_task(0, &graph, "task", fhos_test_task_proc, task, 1 + i % 7) == i);
+        
+        random = random * 1103515245 + 12345;
+        fhos_i32 dependency_count = (i > 0) ? (fhos_i32)((random >> 16) % 5) : 0;
+        for(fhos_i32 j = 0; j < dependency_count; j += 1) {
+            random = random * 1103515245 + 12345;
+            task->dependencies[j] = (fhos_i32)((random >> 16) % i);
+            FHOS_TEST_EXPECT(fhos_add_task_dependency(0, &graph, i, task->dependencies[j]) == FHOS_TRUE);
+        }
+        task->dependency_count = dependency_count;
+    }
+    
+    for(fhos_i32 pass = 0; pass < 2; pass += 1) {
+        for(fhos_i32 i = 0; i < FHOS_TEST_TASK_COUNT; i += 1) { fhos_atomic_store_i32(&fhos_test_task_is_done[i], 0, FHOS_MEMORY_ORDER_RELAXED); }
+        fhos_atomic_store_i32(&fhos_test_task_run_count, 0, FHOS_MEMORY_ORDER_RELAXED);
+        fhos_atomic_store_i32(&fhos_test_task_early_count, 0, FHOS_MEMORY_ORDER_RELAXED);
+        
+        FHOS_Task_Graph_Flags flags = (pass == 1) ? FHOS_TASK_GRAPH_FLAG_CRITICAL_PATH : 0;
+        FHOS_TEST_EXPECT(fhos_run_task_graph(0, &graph, flags) == FHOS_TRUE);
+        FHOS_TEST_EXPECT(fhos_atomic_load_i32(&fhos_test_task_run_count, FHOS_MEMORY_ORDER_RELAXED) == FHOS_TEST_TASK_COUNT);
+        FHOS_TEST_EXPECT(fhos_atomic_load_i32(&fhos_test_task_early_count, FHOS_MEMORY_ORDER_RELAXED) == 0);
+    }
+    fhos_free_task_graph(0, &graph);
+    
+    // NOTE(Patrik): Nothing in a graph with a cycle may run, not even the task outside the cycle.
+    FHOS_Task_Graph cycle = {0};
+    for(fhos_i32 i = 0; i < 4; i += 1) {
+        fhos_test_tasks[i].dependency_count = 0;
+        fhos_add_task(0, &cycle, "cycle", fhos_test_task_proc, fhos_test_tasks + i, 1);
+    }
+    FHOS_TEST_EXPECT(fhos_add_task_dependency(0, &cycle, 0, 0) < 0);
+    FHOS_TEST_EXPECT(fhos_add_task_dependency(0, &cycle, 1, 0) == FHOS_TRUE);
+    FHOS_TEST_EXPECT(fhos_add_task_dependency(0, &cycle, 2, 1) == FHOS_TRUE);
+    FHOS_TEST_EXPECT(fhos_add_task_dependency(0, &cycle, 3, 2) == FHOS_TRUE);
+    FHOS_TEST_EXPECT(fhos_add_task_dependency(0, &cycle, 2, 3) == FHOS_TRUE);
+    fhos_atomic_store_i32(&fhos_test_task_run_count, 0, FHOS_MEMORY_ORDER_RELAXED);
+    FHOS_TEST_EXPECT(fhos_run_task_graph(0, &cycle, 0) == FHOS_ERROR_INVALID_FORMAT);
+    FHOS_TEST_EXPECT(fhos_atomic_load_i32(&fhos_test_task_run_count, FHOS_MEMORY_ORDER_RELAXED) == 0);
+    fhos_free_task_graph(0, &cycle);
+    
+    fhos_stop_job_system();
+}
+
+
+
+
+
+
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// MAIN
+//
+int
+main(void) {
+    if(fhos_directory_exists(0, FHOS_TEST_OUTPUT, -1)) { fhos_remove_directory_recursively(0, FHOS_TEST_OUTPUT, -1); }
+    fhos_create_directory_if_new(0, FHOS_TEST_OUTPUT, -1);
+    
+    fhos_test_directory_iterator_matches_walk();
+    fhos_test_hash_kernels_agree();
+    fhos_test_pack_round_trip();
+    fhos_test_compression_round_trip();
+    fhos_test_histogram_buckets();
+    fhos_test_histogram_percentiles();
+    fhos_test_task_graph();
+    
+    fhos_remove_directory_recursively(0, FHOS_TEST_OUTPUT, -1);
+    if(fhos_test_failure_count) {
+        fprintf(stderr, "%d checks failed.\n", fhos_test_failure_count);
+        return 1;
+    }
+    printf("All checks passed.\n");
+    return 0;
+}